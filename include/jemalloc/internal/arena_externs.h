@@ -9,12 +9,28 @@
 
 extern ssize_t opt_dirty_decay_ms;
 extern ssize_t opt_muzzy_decay_ms;
+extern bool opt_dirty_decay_adaptive;
+extern size_t opt_dirty_decay_refault_target;
+extern size_t opt_empty_slab_cache_max;
+extern bool opt_extent_steal;
+extern size_t opt_extent_steal_threshold;
+extern size_t opt_retain_trim_threshold;
+extern size_t opt_retain_trim_ratio;
+extern unsigned opt_freeze_narenas_max;
+extern const char *purge_policy_names[];
+extern purge_policy_t opt_purge_policy;
+extern size_t opt_purge_max_dirty;
+extern size_t opt_purge_dirty_ratio;
+extern size_t opt_purge_floor;
+extern const char *purge_select_names[];
+extern purge_select_t opt_purge_select;
 
 extern percpu_arena_mode_t opt_percpu_arena;
 extern const char *percpu_arena_mode_names[];
 
 extern const uint64_t h_steps[SMOOTHSTEP_NSTEPS];
 extern malloc_mutex_t arenas_lock;
+extern atomic_b_t arena_heap_frozen;
 
 void arena_basic_stats_merge(tsdn_t *tsdn, arena_t *arena,
     unsigned *nthreads, const char **dss, ssize_t *dirty_decay_ms,
@@ -40,12 +56,28 @@ ssize_t arena_dirty_decay_ms_get(arena_t *arena);
 bool arena_dirty_decay_ms_set(tsdn_t *tsdn, arena_t *arena, ssize_t decay_ms);
 ssize_t arena_muzzy_decay_ms_get(arena_t *arena);
 bool arena_muzzy_decay_ms_set(tsdn_t *tsdn, arena_t *arena, ssize_t decay_ms);
+bool arena_dirty_decay_adaptive_get(arena_t *arena);
+void arena_dirty_decay_adaptive_set(tsdn_t *tsdn, arena_t *arena,
+    bool adaptive);
+ssize_t arena_dirty_decay_ms_effective_get(arena_t *arena);
+uint64_t arena_decay_reuse_stamp(arena_t *arena, size_t npages);
+void arena_decay_reuse_sample(tsdn_t *tsdn, arena_t *arena, uint64_t stamp,
+    size_t npages);
+void arena_latency_record(tsdn_t *tsdn, arena_t *arena, latency_op_t op,
+    const nstime_t *start);
+size_t arena_decay_cap_npages_limit(arena_t *arena, arena_decay_t *decay);
 void arena_decay(tsdn_t *tsdn, arena_t *arena, bool is_background_thread,
     bool all);
+void arena_decay_accelerate(tsdn_t *tsdn, arena_t *arena, unsigned lg_shrink);
 void arena_reset(tsd_t *tsd, arena_t *arena);
+bool arena_retained_trim(tsdn_t *tsdn, arena_t *arena, size_t need);
 void arena_destroy(tsd_t *tsd, arena_t *arena);
+void arena_freeze(tsdn_t *tsdn, arena_t *arena, arena_t *successor);
+arena_t *arena_freeze_reusable_get(tsdn_t *tsdn, arena_t *active);
 void arena_tcache_fill_small(tsdn_t *tsdn, arena_t *arena, tcache_t *tcache,
     cache_bin_t *tbin, szind_t binind, uint64_t prof_accumbytes);
+void arena_cache_bin_fill_small(tsdn_t *tsdn, arena_t *arena, cache_bin_t *tbin,
+    szind_t binind, unsigned nfill, uint64_t prof_accumbytes);
 void arena_alloc_junk_small(void *ptr, const bin_info_t *bin_info,
     bool zero);
 
@@ -68,6 +100,25 @@ void *arena_ralloc(tsdn_t *tsdn, arena_t *arena, void *ptr, size_t oldsize,
     size_t size, size_t alignment, bool zero, tcache_t *tcache);
 dss_prec_t arena_dss_prec_get(arena_t *arena);
 bool arena_dss_prec_set(arena_t *arena, dss_prec_t dss_prec);
+extent_reuse_t arena_extent_reuse_get(arena_t *arena);
+void arena_extent_reuse_set(arena_t *arena, extent_reuse_t extent_reuse);
+purge_policy_t arena_purge_policy_get(arena_t *arena);
+void arena_purge_policy_set(tsdn_t *tsdn, arena_t *arena,
+    purge_policy_t policy);
+size_t arena_purge_max_dirty_get(arena_t *arena);
+void arena_purge_max_dirty_set(tsdn_t *tsdn, arena_t *arena, size_t max_dirty);
+size_t arena_purge_dirty_ratio_get(arena_t *arena);
+void arena_purge_dirty_ratio_set(tsdn_t *tsdn, arena_t *arena,
+    size_t dirty_ratio);
+size_t arena_purge_floor_get(arena_t *arena);
+void arena_purge_floor_set(tsdn_t *tsdn, arena_t *arena, size_t floor);
+purge_select_t arena_purge_select_get(arena_t *arena);
+void arena_purge_select_set(arena_t *arena, purge_select_t purge_select);
+bool arena_prefault_get(arena_t *arena);
+void arena_prefault_set(arena_t *arena, bool prefault);
+bool arena_mlock_get(arena_t *arena);
+void arena_mlock_set(arena_t *arena, bool mlock);
+void arena_extent_populate(tsdn_t *tsdn, arena_t *arena, extent_t *extent);
 ssize_t arena_dirty_decay_ms_default_get(void);
 bool arena_dirty_decay_ms_default_set(ssize_t decay_ms);
 ssize_t arena_muzzy_decay_ms_default_get(void);
@@ -79,7 +130,11 @@ void arena_nthreads_inc(arena_t *arena, bool internal);
 void arena_nthreads_dec(arena_t *arena, bool internal);
 size_t arena_extent_sn_next(arena_t *arena);
 arena_t *arena_new(tsdn_t *tsdn, unsigned ind, extent_hooks_t *extent_hooks);
+bool arena_reattach(tsdn_t *tsdn, unsigned ind, arena_t *arena,
+    extent_hooks_t *extent_hooks);
+void arena_quiesce(tsd_t *tsd, arena_t *arena);
 void arena_boot(void);
+bool arena_fork_used(arena_t *arena, size_t epoch);
 void arena_prefork0(tsdn_t *tsdn, arena_t *arena);
 void arena_prefork1(tsdn_t *tsdn, arena_t *arena);
 void arena_prefork2(tsdn_t *tsdn, arena_t *arena);
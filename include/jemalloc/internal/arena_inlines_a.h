@@ -6,6 +6,16 @@ arena_ind_get(const arena_t *arena) {
 	return base_ind_get(arena->base);
 }
 
+static inline arena_t *
+arena_successor_get(arena_t *arena) {
+	return (arena_t *)atomic_load_p(&arena->successor, ATOMIC_ACQUIRE);
+}
+
+static inline bool
+arena_is_frozen(arena_t *arena) {
+	return arena_successor_get(arena) != NULL;
+}
+
 static inline void
 arena_internal_add(arena_t *arena, size_t size) {
 	atomic_fetch_add_zu(&arena->stats.internal, size, ATOMIC_RELAXED);
@@ -186,6 +186,22 @@ arena_dalloc_no_tcache(tsdn_t *tsdn, void *ptr) {
 	}
 }
 
+/*
+ * Once the heap has been frozen, looks ptr up for both alloc_ctx and whether
+ * it belongs to a frozen arena.  Frees into a frozen arena have to bypass the
+ * tcache, which would otherwise hand the regions out again.
+ */
+JEMALLOC_ALWAYS_INLINE bool
+arena_dalloc_ctx_frozen(tsdn_t *tsdn, void *ptr, alloc_ctx_t *alloc_ctx) {
+	rtree_ctx_t rtree_ctx_fallback;
+	rtree_ctx_t *rtree_ctx = tsdn_rtree_ctx(tsdn, &rtree_ctx_fallback);
+	extent_t *extent;
+	rtree_extent_szind_read(tsdn, &extents_rtree, rtree_ctx,
+	    (uintptr_t)ptr, true, &extent, &alloc_ctx->szind);
+	alloc_ctx->slab = extent_slab_get(extent);
+	return arena_is_frozen(extent_arena_get(extent));
+}
+
 JEMALLOC_ALWAYS_INLINE void
 arena_dalloc(tsdn_t *tsdn, void *ptr, tcache_t *tcache,
     alloc_ctx_t *alloc_ctx, bool slow_path) {
@@ -196,6 +212,16 @@ arena_dalloc(tsdn_t *tsdn, void *ptr, tcache_t *tcache,
 		arena_dalloc_no_tcache(tsdn, ptr);
 		return;
 	}
+	/* Callers passing alloc_ctx have checked for frozen arenas. */
+	alloc_ctx_t local_ctx;
+	if (unlikely(atomic_load_b(&arena_heap_frozen, ATOMIC_RELAXED)) &&
+	    alloc_ctx == NULL) {
+		if (arena_dalloc_ctx_frozen(tsdn, ptr, &local_ctx)) {
+			arena_dalloc_no_tcache(tsdn, ptr);
+			return;
+		}
+		alloc_ctx = &local_ctx;
+	}
 
 	szind_t szind;
 	bool slab;
@@ -294,10 +320,19 @@ arena_sdalloc(tsdn_t *tsdn, void *ptr, size_t size, tcache_t *tcache,
 		arena_sdalloc_no_tcache(tsdn, ptr, size);
 		return;
 	}
+	/* Callers passing alloc_ctx have checked for frozen arenas. */
+	UNUSED alloc_ctx_t local_ctx;
+	if (unlikely(atomic_load_b(&arena_heap_frozen, ATOMIC_RELAXED)) &&
+	    alloc_ctx == NULL) {
+		if (arena_dalloc_ctx_frozen(tsdn, ptr, &local_ctx)) {
+			arena_sdalloc_no_tcache(tsdn, ptr, size);
+			return;
+		}
+		alloc_ctx = &local_ctx;
+	}
 
 	szind_t szind;
 	bool slab;
-	UNUSED alloc_ctx_t local_ctx;
 	if (config_prof && opt_prof) {
 		if (alloc_ctx == NULL) {
 			/* Uncommon case and should be a static check. */
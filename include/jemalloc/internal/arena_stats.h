@@ -44,6 +44,8 @@ struct arena_stats_decay_s {
 	arena_stats_u64_t	npurge;
 	/* Total number of madvise calls made. */
 	arena_stats_u64_t	nmadvise;
+	/* Total number of madvise calls avoided by batching. */
+	arena_stats_u64_t	nmadvise_saved;
 	/* Total number of pages purged. */
 	arena_stats_u64_t	purged;
 };
@@ -68,10 +70,54 @@ struct arena_stats_s {
 	 * but they are excluded from the mapped statistic (above).
 	 */
 	atomic_zu_t		retained; /* Derived. */
+	/* Highest retained byte count reached. */
+	atomic_zu_t		retained_peak; /* Derived. */
+	/*
+	 * Number of times retained memory was trimmed, and the bytes unmapped
+	 * (see opt.retain_trim_threshold).
+	 */
+	arena_stats_u64_t	retained_ntrims;
+	arena_stats_u64_t	retained_trimmed;
 
 	arena_stats_decay_t	decay_dirty;
 	arena_stats_decay_t	decay_muzzy;
 
+	/*
+	 * Number of dirty extents, and their total size in bytes, taken from
+	 * sibling arenas instead of mapping new memory.
+	 */
+	arena_stats_u64_t	nsteals;
+	arena_stats_u64_t	stolen;
+
+	/* Number of bytes prefaulted and mlock()ed (see arena.<i>.prefault). */
+	arena_stats_u64_t	prefaulted;
+	arena_stats_u64_t	mlocked;
+
+	/*
+	 * Pages reused from previously dirtied extents, by age at reuse (see
+	 * REUSE_AGE_NBUCKETS).  Only sampled while adaptive dirty decay is on.
+	 */
+	arena_stats_u64_t	reuse_ages[REUSE_AGE_NBUCKETS];
+
+	/*
+	 * Number of dirty purge batches for which lazy or forced purging was
+	 * selected, and the bytes purged by each.  Forced purging reclaims its
+	 * bytes right away; lazy_reclaimed counts the lazily purged bytes
+	 * found already reclaimed by the kernel (only sampled with adaptive
+	 * selection).
+	 */
+	arena_stats_u64_t	lazy_nselected;
+	arena_stats_u64_t	forced_nselected;
+	arena_stats_u64_t	lazy_purged;
+	arena_stats_u64_t	lazy_reclaimed;
+	arena_stats_u64_t	forced_purged;
+
+	/*
+	 * Latency histograms (see LATENCY_NBUCKETS), indexed by latency_op_t
+	 * and by whether the work was done by a background thread.
+	 */
+	arena_stats_u64_t	latency[latency_op_limit][2][LATENCY_NBUCKETS];
+
 	atomic_zu_t		base; /* Derived. */
 	atomic_zu_t		internal;
 	atomic_zu_t		resident; /* Derived. */
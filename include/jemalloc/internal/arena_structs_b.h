@@ -9,6 +9,7 @@
 #include "jemalloc/internal/jemalloc_internal_types.h"
 #include "jemalloc/internal/mutex.h"
 #include "jemalloc/internal/nstime.h"
+#include "jemalloc/internal/ph.h"
 #include "jemalloc/internal/ql.h"
 #include "jemalloc/internal/size_classes.h"
 #include "jemalloc/internal/smoothstep.h"
@@ -55,6 +56,12 @@ struct arena_decay_s {
 	 * pages, if any, were generated.
 	 */
 	size_t			nunpurged;
+	/*
+	 * Once an epoch advance reaches this deadline, the bins' empty slabs
+	 * that have been idle since the previous one are released, and the
+	 * deadline moves one decay time past the epoch.
+	 */
+	nstime_t		empty_slabs_deadline;
 	/*
 	 * Trailing log of how many unused dirty pages were generated during
 	 * each of the past SMOOTHSTEP_NSTEPS decay epochs, where the last
@@ -62,6 +69,33 @@ struct arena_decay_s {
 	 * relative to epoch.
 	 */
 	size_t			backlog[SMOOTHSTEP_NSTEPS];
+	/*
+	 * Purge policy (purge_policy_t, but atomically) and its parameters.
+	 * Caps are in bytes, except for dirty_ratio, which is a percentage of
+	 * the arena's active pages.  No policy purges below floor bytes.
+	 */
+	atomic_u_t		policy;
+	atomic_zu_t		max_dirty;
+	atomic_zu_t		dirty_ratio;
+	atomic_zu_t		floor;
+	/*
+	 * Pages that the last purge left above the purge limit because the
+	 * purge budget ran out.
+	 */
+	size_t			npages_debt;
+	/*
+	 * Adaptive decay, only used for dirty pages.  When enabled, interval
+	 * is derived from the ages at which dirtied pages get reused, with
+	 * time_ms as the upper bound; adaptive_ms holds the decay time in
+	 * effect.  The reuse and dirtied windows are halved after each
+	 * adjustment, which happens at most every DECAY_ADAPT_PERIOD_MS, at
+	 * adapt_epoch.
+	 */
+	atomic_b_t		adaptive;
+	atomic_zd_t		adaptive_ms;
+	nstime_t		adapt_epoch;
+	atomic_zu_t		reuse_npages[REUSE_AGE_NBUCKETS];
+	atomic_zu_t		dirtied_npages;
 
 	/*
 	 * Pointer to associated stats.  These stats are embedded directly in
@@ -97,6 +131,23 @@ struct arena_s {
 	 */
 	tsdn_t		*last_thd;
 
+	/*
+	 * The arena that took over from this one when heap.freeze froze it, or
+	 * NULL.  Threads never choose a frozen arena for new allocations, and
+	 * frees into it bypass the tcache, so that the memory it held at the
+	 * time of the freeze is not written to again.
+	 *
+	 * Synchronization: atomic.
+	 */
+	atomic_p_t		successor;
+	/*
+	 * Whether the arena was created by heap.freeze to take over from an
+	 * automatic arena, and is hence automatic as well.
+	 *
+	 * Synchronization: set before the arena is first made a successor.
+	 */
+	bool			auto_successor;
+
 	/* Synchronization: internal. */
 	arena_stats_t		stats;
 
@@ -137,6 +188,38 @@ struct arena_s {
 	 */
 	atomic_u_t		dss_prec;
 
+	/*
+	 * Extent reuse policy for dirty extents.  Represents an
+	 * extent_reuse_t, but atomically.
+	 *
+	 * Synchronization: atomic.
+	 */
+	atomic_u_t		extent_reuse;
+
+	/*
+	 * How dirty pages are purged.  Represents a purge_select_t, but
+	 * atomically.  For adaptive selection, the pages sampled from lazily
+	 * purged (muzzy) extents, those of them the kernel had already
+	 * reclaimed, and the forced purges since the last resampling one.
+	 *
+	 * Synchronization: atomic.
+	 */
+	atomic_u_t		purge_select;
+	atomic_zu_t		lazy_nsampled;
+	atomic_zu_t		lazy_nreclaimed;
+	atomic_u_t		lazy_nforced;
+
+	/*
+	 * Whether memory that may not be resident is prefaulted and/or
+	 * mlock()ed as it is handed out, and whether mlock was ever enabled
+	 * (in which case extents must be unlocked before they can be purged).
+	 *
+	 * Synchronization: atomic.
+	 */
+	atomic_b_t		prefault;
+	atomic_b_t		mlock;
+	atomic_b_t		mlocked;
+
 	/*
 	 * Number of pages in active extents.
 	 *
@@ -172,6 +255,17 @@ struct arena_s {
 	arena_decay_t		decay_dirty; /* dirty --> muzzy */
 	arena_decay_t		decay_muzzy; /* muzzy --> retained */
 
+	/*
+	 * Linkage into the owning background thread's deadline heap, and the
+	 * time (in ns) at which the thread should next run decay for this
+	 * arena.
+	 *
+	 * Synchronization: background_thread_info_t's mtx.
+	 */
+	phn(arena_t)		bg_link;
+	uint64_t		bg_deadline;
+	bool			bg_queued;
+
 	/*
 	 * Next extent size class in a growing series to use when satisfying a
 	 * request via the extent hooks (only if opt_retain).  This limits the
@@ -198,6 +292,18 @@ struct arena_s {
 	extent_tree_t		extent_avail;
 	malloc_mutex_t		extent_avail_mtx;
 
+	/*
+	 * The fork epoch in which the arena was last used (see
+	 * malloc_mutex_fork_begin()), and whether jemalloc_prefork() locked
+	 * the arena for the fork in progress.  Unless opt_fork_skip_quiescent,
+	 * the epoch is unused and every arena is locked.
+	 *
+	 * Synchronization: atomic (fork_epoch); fork_locked is only accessed
+	 * by the forking thread.
+	 */
+	atomic_zu_t		fork_epoch;
+	bool			fork_locked;
+
 	/*
 	 * bins is used to store heaps of free regions.
 	 *
@@ -13,8 +13,34 @@
 #define DIRTY_DECAY_MS_DEFAULT	ZD(10 * 1000)
 #define MUZZY_DECAY_MS_DEFAULT	ZD(10 * 1000)
 #endif
+/* Default maximum number of bytes of empty slabs retained per bin. */
+#define EMPTY_SLAB_CACHE_MAX_DEFAULT	(ZU(32) << 10)
+/*
+ * Default minimum number of dirty bytes an arena must hold before siblings may
+ * steal from it.
+ */
+#define EXTENT_STEAL_THRESHOLD_DEFAULT	(ZU(4) << 20)
+/* Default caps used by the max_dirty, ratio and hybrid purge policies. */
+#define PURGE_MAX_DIRTY_DEFAULT		(ZU(64) << 20)
+#define PURGE_DIRTY_RATIO_DEFAULT	ZU(25)
 /* Number of event ticks between time checks. */
 #define DECAY_NTICKS_PER_UPDATE	1000
+/*
+ * Adaptive dirty decay: reuse ages are binned in powers of two of
+ * milliseconds; bucket 0 holds ages below 1 ms, bucket j ages in
+ * [2^(j-1), 2^j) ms, and the last bucket everything older.
+ */
+#define REUSE_AGE_NBUCKETS		24
+/*
+ * Adaptive decay reconsiders the decay time at most this often, once at least
+ * DECAY_ADAPT_NPAGES_MIN pages were dirtied, and never goes below
+ * DECAY_ADAPT_MS_MIN.
+ */
+#define DECAY_ADAPT_PERIOD_MS		1000
+#define DECAY_ADAPT_NPAGES_MIN		64
+#define DECAY_ADAPT_MS_MIN		100
+/* Default percentage of dirtied pages that may be refaulted. */
+#define DIRTY_DECAY_REFAULT_TARGET_DEFAULT	ZU(5)
 
 typedef struct arena_slab_data_s arena_slab_data_t;
 typedef struct arena_decay_s arena_decay_t;
@@ -42,6 +68,70 @@ typedef enum {
 	per_phycpu_arena               = 4  /* Hyper threads share arena. */
 } percpu_arena_mode_t;
 
+typedef enum {
+	/* Time-based smoothstep decay, driven by {dirty,muzzy}_decay_ms. */
+	purge_policy_smoothstep = 0,
+	/* Keep at most purge_max_dirty bytes unpurged. */
+	purge_policy_max_dirty  = 1,
+	/* Keep at most purge_dirty_ratio percent of active pages unpurged. */
+	purge_policy_ratio      = 2,
+	/* Smoothstep decay, additionally bounded by both caps above. */
+	purge_policy_hybrid     = 3,
+
+	purge_policy_limit      = 4
+} purge_policy_t;
+#define PURGE_POLICY_DEFAULT	purge_policy_smoothstep
+
+typedef enum {
+	/* Always purge lazily first, unless muzzy_decay_ms is 0. */
+	purge_select_static   = 0,
+	/* Purge forcibly while the process is short on memory. */
+	purge_select_adaptive = 1,
+
+	purge_select_limit    = 2
+} purge_select_t;
+#define PURGE_SELECT_DEFAULT	purge_select_static
+/*
+ * Under memory pressure, adaptive selection still purges lazily if at least
+ * PURGE_SELECT_RECLAIM_RATIO percent of the previously lazily purged pages were
+ * found already reclaimed by the kernel, over a window of at least
+ * PURGE_SELECT_NSAMPLED_MIN sampled pages.  The window is halved once it
+ * exceeds PURGE_SELECT_NSAMPLED_MAX pages, so that old samples fade out.
+ */
+#define PURGE_SELECT_RECLAIM_RATIO	50
+#define PURGE_SELECT_NSAMPLED_MIN	64
+#define PURGE_SELECT_NSAMPLED_MAX	4096
+/* At most this many pages of each muzzy extent are sampled. */
+#define PURGE_SELECT_SAMPLE_NPAGES	64
+/*
+ * Every PURGE_SELECT_RESAMPLE_INTERVAL-th dirty purge that would be forced is
+ * done lazily instead, so that the samples keep being refreshed.
+ */
+#define PURGE_SELECT_RESAMPLE_INTERVAL	32
+
+/*
+ * Latency histograms, per operation and for background and application
+ * threads separately: bucket 0 counts operations that took less than 1 us,
+ * bucket j those that took [2^(j-1), 2^j) us, and the last bucket everything
+ * longer.
+ *
+ *   decay: a decay run (arena_decay_to_limit()).
+ *   purge: a single purge call, or batch of them (pages_purge_batch()).
+ *   map:   mapping new memory for an arena.
+ */
+#define LATENCY_NBUCKETS	24
+#define LATENCY_OPS							\
+    OP(decay)								\
+    OP(purge)								\
+    OP(map)
+
+typedef enum {
+#define OP(op) latency_op_##op,
+	LATENCY_OPS
+#undef OP
+	latency_op_limit
+} latency_op_t;
+
 #define PERCPU_ARENA_ENABLED(m)	((m) >= percpu_arena_mode_enabled_base)
 #define PERCPU_ARENA_DEFAULT	percpu_arena_disabled
 
@@ -3,6 +3,21 @@
 
 extern bool opt_background_thread;
 extern size_t opt_max_background_threads;
+extern char opt_background_thread_cpus[
+#ifdef JEMALLOC_BACKGROUND_THREAD
+    BACKGROUND_THREAD_CPUS_MAXLEN +
+#endif
+    1];
+extern bool opt_background_thread_sched_idle;
+extern ssize_t opt_background_thread_nice;
+extern bool opt_psi_purge;
+extern char opt_psi_path[
+#ifdef JEMALLOC_BACKGROUND_THREAD
+    PATH_MAX +
+#endif
+    1];
+extern size_t opt_psi_stall_us;
+extern size_t opt_psi_window_us;
 extern malloc_mutex_t background_thread_lock;
 extern atomic_b_t background_thread_enabled_state;
 extern size_t n_background_threads;
@@ -15,6 +30,8 @@ bool background_threads_enable(tsd_t *tsd);
 bool background_threads_disable(tsd_t *tsd);
 void background_thread_interval_check(tsdn_t *tsdn, arena_t *arena,
     arena_decay_t *decay, size_t npages_new);
+void background_thread_arena_new(tsdn_t *tsdn, arena_t *arena);
+void background_thread_arena_unschedule(tsdn_t *tsdn, arena_t *arena);
 void background_thread_prefork0(tsdn_t *tsdn);
 void background_thread_prefork1(tsdn_t *tsdn);
 void background_thread_postfork_parent(tsdn_t *tsdn);
@@ -22,6 +39,7 @@ void background_thread_postfork_child(tsdn_t *tsdn);
 bool background_thread_stats_read(tsdn_t *tsdn,
     background_thread_stats_t *stats);
 void background_thread_ctl_init(tsdn_t *tsdn);
+unsigned background_thread_pressure_level(void);
 
 #ifdef JEMALLOC_PTHREAD_CREATE_WRAPPER
 extern int pthread_create_wrapper(pthread_t *__restrict, const pthread_attr_t *,
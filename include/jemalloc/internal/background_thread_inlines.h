@@ -15,7 +15,7 @@ background_thread_enabled_set(tsdn_t *tsdn, bool state) {
 JEMALLOC_ALWAYS_INLINE background_thread_info_t *
 arena_background_thread_info_get(arena_t *arena) {
 	unsigned arena_ind = arena_ind_get(arena);
-	return &background_thread_info[arena_ind % ncpus];
+	return &background_thread_info[arena_ind % max_background_threads];
 }
 
 JEMALLOC_ALWAYS_INLINE uint64_t
@@ -40,6 +40,13 @@ background_thread_indefinite_sleep(background_thread_info_t *info) {
 	return atomic_load_b(&info->indefinite_sleep, ATOMIC_ACQUIRE);
 }
 
+/* Whether the calling thread is one of the background threads. */
+JEMALLOC_ALWAYS_INLINE bool
+background_thread_is_current(tsdn_t *tsdn) {
+	bool *in_background_thread = tsdn_in_background_threadp_get(tsdn);
+	return (in_background_thread != NULL && *in_background_thread);
+}
+
 JEMALLOC_ALWAYS_INLINE void
 arena_background_thread_inactivity_check(tsdn_t *tsdn, arena_t *arena,
     bool is_background_thread) {
@@ -48,7 +55,12 @@ arena_background_thread_inactivity_check(tsdn_t *tsdn, arena_t *arena,
 	}
 	background_thread_info_t *info =
 	    arena_background_thread_info_get(arena);
-	if (background_thread_indefinite_sleep(info)) {
+	/*
+	 * An arena out of the thread's deadline heap would not be visited
+	 * again, even if the thread wakes up for other arenas.  bg_queued is
+	 * read racily here, and rechecked under info->mtx.
+	 */
+	if (background_thread_indefinite_sleep(info) || !arena->bg_queued) {
 		background_thread_interval_check(tsdn, arena,
 		    &arena->decay_dirty, 0);
 	}
@@ -10,6 +10,21 @@
 #define BACKGROUND_THREAD_INDEFINITE_SLEEP UINT64_MAX
 #define MAX_BACKGROUND_THREAD_LIMIT MALLOCX_ARENA_LIMIT
 
+/* Memory pressure (PSI) monitoring defaults. */
+#define PSI_PATH_DEFAULT "/proc/pressure/memory"
+#define PSI_STALL_US_DEFAULT ZU(100000)
+#define PSI_WINDOW_US_DEFAULT ZU(1000000)
+/*
+ * Pressure levels 1 .. PSI_LEVEL_MAX-1 halve the unused pages kept per level;
+ * PSI_LEVEL_MAX purges everything.
+ */
+#define PSI_LEVEL_MAX 3
+/* Maximal length of opt.background_thread_cpus. */
+#define BACKGROUND_THREAD_CPUS_MAXLEN 256
+
+/* Arenas served by a background thread, ordered by next decay deadline. */
+typedef ph(arena_t) bg_arena_heap_t;
+
 typedef enum {
 	background_thread_stopped,
 	background_thread_started,
@@ -36,8 +51,16 @@ struct background_thread_info_s {
 	 *  background thread to wake up earlier.
 	 */
 	size_t			npages_to_purge_new;
+	/*
+	 * Arenas with pending decay work, keyed by arena->bg_deadline.  Arenas
+	 * with nothing to purge are not queued, so a wakeup only visits the
+	 * arenas that are due.
+	 */
+	bg_arena_heap_t		arenas;
 	/* Stats: total number of runs since started. */
 	uint64_t		tot_n_runs;
+	/* Stats: total number of arenas processed since started. */
+	uint64_t		tot_n_arena_runs;
 	/* Stats: total sleep time since started. */
 	nstime_t		tot_sleep_time;
 };
@@ -46,7 +69,9 @@ typedef struct background_thread_info_s background_thread_info_t;
 struct background_thread_stats_s {
 	size_t num_threads;
 	uint64_t num_runs;
+	uint64_t num_arena_runs;
 	nstime_t run_interval;
+	uint64_t pressure_events;
 };
 typedef struct background_thread_stats_s background_thread_stats_t;
 
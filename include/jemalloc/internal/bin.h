@@ -74,6 +74,20 @@ struct bin_s {
 	/* List used to track full slabs. */
 	extent_list_t		slabs_full;
 
+	/*
+	 * Empty slabs retained for direct reuse, most recently emptied last.
+	 * These stay registered and active, and their bitmaps are already in
+	 * the all-free state, so reuse needs no extent or rtree operations.
+	 */
+	extent_list_t		slabs_empty;
+	size_t			nslabs_empty;
+	/*
+	 * Number of slabs at the head of slabs_empty that have been unused
+	 * since the previous walk of the bins; the next one, a dirty decay time
+	 * later, releases them.
+	 */
+	size_t			nslabs_empty_idle;
+
 	/* Bin statistics. */
 	bin_stats_t	stats;
 };
@@ -100,6 +114,7 @@ bin_stats_merge(tsdn_t *tsdn, bin_stats_t *dst_bin_stats, bin_t *bin) {
 	dst_bin_stats->nslabs += bin->stats.nslabs;
 	dst_bin_stats->reslabs += bin->stats.reslabs;
 	dst_bin_stats->curslabs += bin->stats.curslabs;
+	dst_bin_stats->curslabs_empty += bin->stats.curslabs_empty;
 	malloc_mutex_unlock(tsdn, &bin->lock);
 }
 
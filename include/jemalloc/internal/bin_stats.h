@@ -45,6 +45,9 @@ struct bin_stats_s {
 	/* Current number of slabs in this bin. */
 	size_t		curslabs;
 
+	/* Current number of empty slabs retained by this bin for reuse. */
+	size_t		curslabs_empty;
+
 	mutex_prof_data_t mutex_data;
 };
 
@@ -0,0 +1,68 @@
+#ifndef JEMALLOC_INTERNAL_CGROUP_H
+#define JEMALLOC_INTERNAL_CGROUP_H
+
+#include "jemalloc/internal/atomic.h"
+#include "jemalloc/internal/nstime.h"
+#include "jemalloc/internal/tsd_types.h"
+
+/*
+ * Derives a ceiling on unpurged (dirty + muzzy) memory from the memory limit
+ * of the cgroup the process runs in, so that pages we are merely caching do
+ * not push the container into reclaim or the OOM killer.
+ *
+ * Both cgroup v2 (memory.max / memory.current) and v1
+ * (memory.limit_in_bytes / memory.usage_in_bytes) are supported.  The
+ * hierarchy is walked from the process's own cgroup up to the root, and the
+ * tightest level wins.
+ */
+
+#define CGROUP_ROOT_DEFAULT		"/sys/fs/cgroup"
+/* Percentage of the cgroup limit that may be left unpurged. */
+#define CGROUP_UNPURGED_RATIO_DEFAULT	10
+/* Minimum time between two reads of the cgroup hierarchy. */
+#define CGROUP_REFRESH_INTERVAL_S	1
+
+extern bool opt_cgroup_aware;
+extern char opt_cgroup_root[PATH_MAX + 1];
+extern size_t opt_cgroup_unpurged_ratio;
+
+/* Both in bytes; SIZE_T_MAX if no limit applies. */
+extern atomic_zu_t cgroup_limit;
+extern atomic_zu_t cgroup_unpurged_ceiling;
+/* Per-arena share of the ceiling, in pages. */
+extern atomic_zu_t cgroup_arena_unpurged_npages;
+/*
+ * Whether the cgroup headroom has shrunk below the share of the limit that may
+ * be left unpurged, i.e. whether the ceiling is bounded by the headroom.
+ */
+extern atomic_b_t cgroup_headroom_low;
+
+void cgroup_boot(void);
+void cgroup_refresh(tsdn_t *tsdn);
+/*
+ * Refreshes at most once per CGROUP_REFRESH_INTERVAL_S, by a single caller at
+ * a time.  This reads files, so callers must not hold decay or extent mutexes.
+ */
+void cgroup_maybe_refresh(tsdn_t *tsdn);
+
+static inline size_t
+cgroup_limit_get(void) {
+	return atomic_load_zu(&cgroup_limit, ATOMIC_RELAXED);
+}
+
+static inline size_t
+cgroup_unpurged_ceiling_get(void) {
+	return atomic_load_zu(&cgroup_unpurged_ceiling, ATOMIC_RELAXED);
+}
+
+static inline size_t
+cgroup_arena_unpurged_npages_get(void) {
+	return atomic_load_zu(&cgroup_arena_unpurged_npages, ATOMIC_RELAXED);
+}
+
+static inline bool
+cgroup_headroom_low_get(void) {
+	return atomic_load_b(&cgroup_headroom_low, ATOMIC_RELAXED);
+}
+
+#endif /* JEMALLOC_INTERNAL_CGROUP_H */
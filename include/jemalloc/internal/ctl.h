@@ -4,6 +4,8 @@
 #include "jemalloc/internal/jemalloc_internal_types.h"
 #include "jemalloc/internal/malloc_io.h"
 #include "jemalloc/internal/mutex_prof.h"
+#include "jemalloc/internal/percpu_cache.h"
+#include "jemalloc/internal/purge_budget.h"
 #include "jemalloc/internal/ql.h"
 #include "jemalloc/internal/size_classes.h"
 #include "jemalloc/internal/stats.h"
@@ -52,7 +54,11 @@ typedef struct ctl_stats_s {
 	size_t resident;
 	size_t mapped;
 	size_t retained;
+	size_t cgroup_limit;
+	size_t unpurged_ceiling;
 
+	purge_budget_stats_t purge_budget;
+	percpu_cache_stats_t percpu_cache;
 	background_thread_stats_t background_thread;
 	mutex_prof_data_t mutex_prof_data[mutex_prof_num_global_mutexes];
 } ctl_stats_t;
@@ -68,6 +74,8 @@ struct ctl_arena_s {
 	const char *dss;
 	ssize_t dirty_decay_ms;
 	ssize_t muzzy_decay_ms;
+	/* Dirty decay time in effect, which adaptive decay may shorten. */
+	ssize_t dirty_decay_ms_effective;
 	size_t pactive;
 	size_t pdirty;
 	size_t pmuzzy;
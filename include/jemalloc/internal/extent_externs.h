@@ -7,6 +7,8 @@
 #include "jemalloc/internal/rtree.h"
 
 extern size_t opt_lg_extent_max_active_fit;
+extern extent_reuse_t opt_extent_reuse;
+extern const char *extent_reuse_names[];
 
 extern rtree_t extents_rtree;
 extern const extent_hooks_t extent_hooks_default;
@@ -14,27 +16,34 @@ extern mutex_pool_t extent_mutex_pool;
 
 extent_t *extent_alloc(tsdn_t *tsdn, arena_t *arena);
 void extent_dalloc(tsdn_t *tsdn, arena_t *arena, extent_t *extent);
+void extent_cache_flush(tsd_t *tsd);
 
 extent_hooks_t *extent_hooks_get(arena_t *arena);
 extent_hooks_t *extent_hooks_set(tsd_t *tsd, arena_t *arena,
     extent_hooks_t *extent_hooks);
+bool extent_attach(tsdn_t *tsdn, extent_t *extent);
+void extent_detach(tsdn_t *tsdn, extent_t *extent);
 
 #ifdef JEMALLOC_JET
 size_t extent_size_quantize_floor(size_t size);
 size_t extent_size_quantize_ceil(size_t size);
 #endif
 
-rb_proto(, extent_avail_, extent_tree_t, extent_t)
+ph_proto(, extent_avail_, extent_tree_t, extent_t)
 ph_proto(, extent_heap_, extent_heap_t, extent_t)
 
 bool extents_init(tsdn_t *tsdn, extents_t *extents, extent_state_t state,
     bool delay_coalesce);
 extent_state_t extents_state_get(const extents_t *extents);
 size_t extents_npages_get(extents_t *extents);
+size_t extents_npages_peak_get(extents_t *extents);
 extent_t *extents_alloc(tsdn_t *tsdn, arena_t *arena,
     extent_hooks_t **r_extent_hooks, extents_t *extents, void *new_addr,
     size_t size, size_t pad, size_t alignment, bool slab, szind_t szind,
     bool *zero, bool *commit);
+extent_t *extents_steal(tsdn_t *tsdn, arena_t *arena, arena_t *victim,
+    size_t size, size_t pad, size_t alignment, bool slab, szind_t szind,
+    bool *zero, bool *commit);
 void extents_dalloc(tsdn_t *tsdn, arena_t *arena,
     extent_hooks_t **r_extent_hooks, extents_t *extents, extent_t *extent);
 extent_t *extents_evict(tsdn_t *tsdn, arena_t *arena,
@@ -48,8 +57,14 @@ extent_t *extent_alloc_wrapper(tsdn_t *tsdn, arena_t *arena,
 void extent_dalloc_gap(tsdn_t *tsdn, arena_t *arena, extent_t *extent);
 void extent_dalloc_wrapper(tsdn_t *tsdn, arena_t *arena,
     extent_hooks_t **r_extent_hooks, extent_t *extent);
+bool extent_dalloc_batchable(arena_t *arena, extent_hooks_t **r_extent_hooks,
+    extent_t *extent);
+void extent_dalloc_purged_wrapper(tsdn_t *tsdn, arena_t *arena,
+    extent_hooks_t **r_extent_hooks, extent_t *extent);
 void extent_destroy_wrapper(tsdn_t *tsdn, arena_t *arena,
     extent_hooks_t **r_extent_hooks, extent_t *extent);
+size_t extent_retained_trim(tsdn_t *tsdn, arena_t *arena,
+    extent_hooks_t **r_extent_hooks, size_t npages_max);
 bool extent_commit_wrapper(tsdn_t *tsdn, arena_t *arena,
     extent_hooks_t **r_extent_hooks, extent_t *extent, size_t offset,
     size_t length);
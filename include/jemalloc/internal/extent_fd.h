@@ -0,0 +1,61 @@
+#ifndef JEMALLOC_INTERNAL_EXTENT_FD_H
+#define JEMALLOC_INTERNAL_EXTENT_FD_H
+
+/*
+ * Extent hooks that back an arena with a file descriptor (a memfd unless the
+ * caller supplies one), so that its memory can be mapped by other processes.
+ *
+ * The whole file is mapped shared into a single window up front, and extents
+ * are carved out of it with a bump pointer, so an extent's file offset is its
+ * distance from the window base and any two adjacent extents can be split and
+ * merged.  Extents are never unmapped; unused ones are retained by the arena,
+ * and purged by punching holes into the file.  Retained extents are not
+ * trimmed either, since the bump pointer would never hand them out again.
+ *
+ * A persistent provider additionally keeps a header at the start of the window
+ * that records where the window is mapped and which arena lives in it.  Since
+ * the arena's metadata is allocated through the same hooks, the whole arena
+ * survives in the file once quiesced, and can be attached again by mapping the
+ * window back at the same address.
+ */
+
+extern size_t opt_persistent_addr;
+
+/* Window size used for files that are empty when the arena is created. */
+#define EXTENT_FD_SIZE_DEFAULT	(ZU(1) << (LG_SIZEOF_PTR == 3 ? 36 : 28))
+
+/*
+ * Returns the hooks of a new provider backed by fd, or a new memfd if fd is
+ * -1.  A non-empty file is used as is; an empty one is extended to
+ * EXTENT_FD_SIZE_DEFAULT.
+ */
+extent_hooks_t *extent_fd_new(int fd);
+/*
+ * Returns the hooks of a persistent provider backed by fd, and sets *r_arena to
+ * the arena quiesced into the file, or NULL if there is none yet.  On error,
+ * *r_err is set to EINVAL if the file was written by an incompatible build,
+ * EFAULT if its arena is still attached, and EAGAIN otherwise.
+ */
+extent_hooks_t *extent_fd_persistent_new(int fd, arena_t **r_arena,
+    int *r_err);
+void extent_fd_persistent_arena_set(extent_hooks_t *extent_hooks,
+    arena_t *arena);
+/*
+ * Returns the application's root pointer stored in the header, or NULL if
+ * extent_hooks are not those of a persistent provider.
+ */
+void **extent_fd_persistent_root(extent_hooks_t *extent_hooks);
+/* Writes back and releases the provider of a quiesced arena. */
+void extent_fd_persistent_quiesce(extent_hooks_t *extent_hooks);
+/*
+ * Releases the hooks of a destroyed arena, if they belong to a provider.  A
+ * persistent file is left empty for a later attach.
+ */
+void extent_fd_delete(extent_hooks_t *extent_hooks);
+/*
+ * Returns the file descriptor and window base of the provider, or true if
+ * extent_hooks are not those of a provider.
+ */
+bool extent_fd_get(extent_hooks_t *extent_hooks, int *r_fd, void **r_base);
+
+#endif /* JEMALLOC_INTERNAL_EXTENT_FD_H */
@@ -176,6 +176,15 @@ extent_prof_tctx_get(const extent_t *extent) {
 	    ATOMIC_ACQUIRE);
 }
 
+static inline uint64_t
+extent_dirtied_ns_get(const extent_t *extent) {
+	if ((extent->e_bits & EXTENT_BITS_DIRTIED_MASK) == 0) {
+		/* The union holds slab data or a prof tctx, if anything. */
+		return 0;
+	}
+	return extent->e_dirtied_ns;
+}
+
 static inline void
 extent_arena_set(extent_t *extent, arena_t *arena) {
 	unsigned arena_ind = (arena != NULL) ? arena_ind_get(arena) : ((1U <<
@@ -299,6 +308,13 @@ extent_prof_tctx_set(extent_t *extent, prof_tctx_t *tctx) {
 	atomic_store_p(&extent->e_prof_tctx, tctx, ATOMIC_RELEASE);
 }
 
+static inline void
+extent_dirtied_ns_set(extent_t *extent, uint64_t dirtied_ns) {
+	extent->e_bits = (extent->e_bits & ~EXTENT_BITS_DIRTIED_MASK) |
+	    ((uint64_t)(dirtied_ns != 0) << EXTENT_BITS_DIRTIED_SHIFT);
+	extent->e_dirtied_ns = dirtied_ns;
+}
+
 static inline void
 extent_init(extent_t *extent, arena_t *arena, void *addr, size_t size,
     bool slab, szind_t szind, size_t sn, extent_state_t state, bool zeroed,
@@ -316,9 +332,8 @@ extent_init(extent_t *extent, arena_t *arena, void *addr, size_t size,
 	extent_committed_set(extent, committed);
 	extent_dumpable_set(extent, dumpable);
 	ql_elm_new(extent, ql_link);
-	if (config_prof) {
-		extent_prof_tctx_set(extent, NULL);
-	}
+	/* Also clears e_prof_tctx. */
+	extent_dirtied_ns_set(extent, 0);
 }
 
 static inline void
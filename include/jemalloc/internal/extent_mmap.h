@@ -2,7 +2,15 @@
 #define JEMALLOC_INTERNAL_EXTENT_MMAP_EXTERNS_H
 
 extern bool opt_retain;
+extern size_t opt_reserve_va;
 
+/*
+ * Reserves the region for opt.reserve_va, and returns its bounds.  Called
+ * once at boot.
+ */
+bool extent_mmap_reserve(void **r_base, size_t *r_size);
+/* Whether addr lies in the reserved region. */
+bool extent_mmap_reserved(const void *addr);
 void *extent_alloc_mmap(void *new_addr, size_t size, size_t alignment,
     bool *zero, bool *commit);
 bool extent_dalloc_mmap(void *addr, size_t size);
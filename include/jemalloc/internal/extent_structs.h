@@ -26,11 +26,12 @@ struct extent_s {
 	 * d: dumpable
 	 * z: zeroed
 	 * t: state
+	 * r: dirtied
 	 * i: szind
 	 * f: nfree
 	 * n: sn
 	 *
-	 * nnnnnnnn ... nnnnffff ffffffii iiiiiitt zdcbaaaa aaaaaaaa
+	 * nnnnnnnn ... nnnfffff fffffiii iiiiirtt zdcbaaaa aaaaaaaa
 	 *
 	 * arena_ind: Arena from which this extent came, or all 1 bits if
 	 *            unassociated.
@@ -67,6 +68,11 @@ struct extent_s {
 	 *
 	 * state: The state flag is an extent_state_t.
 	 *
+	 * dirtied: The dirtied flag indicates whether e_dirtied_ns holds a
+	 *          time stamp.  The union it lives in is reused once the
+	 *          extent is handed out, so the flag is cleared on every path
+	 *          that hands an extent out.
+	 *
 	 * szind: The szind flag indicates usable size class index for
 	 *        allocations residing in this extent, regardless of whether the
 	 *        extent is a slab.  Extent size and usable size often differ
@@ -112,8 +118,12 @@ struct extent_s {
 #define EXTENT_BITS_STATE_SHIFT  (EXTENT_BITS_ZEROED_WIDTH + EXTENT_BITS_ZEROED_SHIFT)
 #define EXTENT_BITS_STATE_MASK  MASK(EXTENT_BITS_STATE_WIDTH, EXTENT_BITS_STATE_SHIFT)
 
+#define EXTENT_BITS_DIRTIED_WIDTH  1
+#define EXTENT_BITS_DIRTIED_SHIFT  (EXTENT_BITS_STATE_WIDTH + EXTENT_BITS_STATE_SHIFT)
+#define EXTENT_BITS_DIRTIED_MASK  MASK(EXTENT_BITS_DIRTIED_WIDTH, EXTENT_BITS_DIRTIED_SHIFT)
+
 #define EXTENT_BITS_SZIND_WIDTH  LG_CEIL_NSIZES
-#define EXTENT_BITS_SZIND_SHIFT  (EXTENT_BITS_STATE_WIDTH + EXTENT_BITS_STATE_SHIFT)
+#define EXTENT_BITS_SZIND_SHIFT  (EXTENT_BITS_DIRTIED_WIDTH + EXTENT_BITS_DIRTIED_SHIFT)
 #define EXTENT_BITS_SZIND_MASK  MASK(EXTENT_BITS_SZIND_WIDTH, EXTENT_BITS_SZIND_SHIFT)
 
 #define EXTENT_BITS_NFREE_WIDTH  (LG_SLAB_MAXREGS + 1)
@@ -165,6 +175,14 @@ struct extent_s {
 		 * prof_tctx_t.
 		 */
 		atomic_p_t		e_prof_tctx;
+
+		/*
+		 * Time at which an inactive extent was last returned dirty, in
+		 * nanoseconds.  Only valid while the dirtied bit is set, which
+		 * only happens for arenas with adaptive dirty decay; see
+		 * arena_decay_reuse_stamp().
+		 */
+		uint64_t		e_dirtied_ns;
 	};
 };
 typedef ql_head(extent_t) extent_list_t;
@@ -206,6 +224,9 @@ struct extents_s {
 	 */
 	atomic_zu_t		npages;
 
+	/* Highest value npages has reached; synchronized the same way. */
+	atomic_zu_t		npages_peak;
+
 	/* All stored extents must be in the same state. */
 	extent_state_t		state;
 
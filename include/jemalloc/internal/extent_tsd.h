@@ -0,0 +1,30 @@
+#ifndef JEMALLOC_INTERNAL_EXTENT_TSD_H
+#define JEMALLOC_INTERNAL_EXTENT_TSD_H
+
+#include "jemalloc/internal/arena_types.h"
+#include "jemalloc/internal/extent_types.h"
+
+/*
+ * Per thread magazine of unused extent_t structures, which fronts the arena's
+ * extent_avail heap so that slab and large allocation/deallocation do not have
+ * to acquire extent_avail_mtx for every extent_t.  The magazine only caches
+ * structures belonging to the thread's bound application arena; that binding
+ * prevents the arena (and hence the base that backs the structures) from being
+ * destroyed, and the magazine is flushed whenever the binding changes.
+ */
+#define EXTENT_CACHE_NCACHED 16
+/* Number of structures moved to/from extent_avail per fill/flush. */
+#define EXTENT_CACHE_NBATCH (EXTENT_CACHE_NCACHED >> 1)
+
+typedef struct extent_cache_s extent_cache_t;
+struct extent_cache_s {
+	/* Arena that the cached structures belong to, if any. */
+	arena_t			*arena;
+	unsigned		ncached;
+	/* Stack of cached structures; cached[ncached - 1] is the top. */
+	extent_t		*cached[EXTENT_CACHE_NCACHED];
+};
+
+#define EXTENT_CACHE_ZERO_INITIALIZER {NULL, 0, {NULL}}
+
+#endif /* JEMALLOC_INTERNAL_EXTENT_TSD_H */
@@ -14,4 +14,22 @@ typedef struct extents_s extents_t;
  */
 #define LG_EXTENT_MAX_ACTIVE_FIT_DEFAULT 6
 
+/* Policy used to pick which cached dirty extent satisfies a request. */
+typedef enum {
+	/* Oldest/lowest first-fit (extent_snad_comp order). */
+	extent_reuse_fit   = 0,
+	/* Most recently deallocated adequately sized extent (cache-warm). */
+	extent_reuse_lifo  = 1,
+	extent_reuse_limit = 2
+} extent_reuse_t;
+#define EXTENT_REUSE_DEFAULT extent_reuse_fit
+
+/*
+ * Maximum number of LRU entries examined by the LIFO reuse policy before
+ * falling back to first-fit.
+ */
+#define EXTENT_REUSE_LIFO_NSCAN 32
+/* Max ratio (lg) between a LIFO-selected extent's size and the request. */
+#define LG_EXTENT_REUSE_LIFO_MAX_FIT 1
+
 #endif /* JEMALLOC_INTERNAL_EXTENT_TYPES_H */
@@ -18,6 +18,7 @@ extern bool opt_utrace;
 extern bool opt_xmalloc;
 extern bool opt_zero;
 extern unsigned opt_narenas;
+extern bool opt_fork_skip_quiescent;
 
 /* Number of CPUs. */
 extern unsigned ncpus;
@@ -39,8 +40,11 @@ void bootstrap_free(void *ptr);
 void arena_set(unsigned ind, arena_t *arena);
 unsigned narenas_total_get(void);
 arena_t *arena_init(tsdn_t *tsdn, unsigned ind, extent_hooks_t *extent_hooks);
+bool arena_attach(tsdn_t *tsdn, unsigned ind, arena_t *arena,
+    extent_hooks_t *extent_hooks);
 arena_tdata_t *arena_tdata_get_hard(tsd_t *tsd, unsigned ind);
 arena_t *arena_choose_hard(tsd_t *tsd, bool internal);
+arena_t *arena_choose_frozen(tsd_t *tsd, arena_t *arena, bool internal);
 void arena_migrate(tsd_t *tsd, unsigned oldind, unsigned newind);
 void iarena_cleanup(tsd_t *tsd);
 void arena_cleanup(tsd_t *tsd);
@@ -4,6 +4,7 @@
 #include "jemalloc/internal/atomic.h"
 #include "jemalloc/internal/bit_util.h"
 #include "jemalloc/internal/jemalloc_internal_types.h"
+#include "jemalloc/internal/rseq.h"
 #include "jemalloc/internal/size_classes.h"
 #include "jemalloc/internal/ticker.h"
 
@@ -18,12 +19,33 @@ malloc_getcpu(void) {
 #endif
 }
 
+/*
+ * Whether the current cpu can be read from the thread's rseq area, i.e. for
+ * the cost of a load rather than of sched_getcpu().
+ */
+JEMALLOC_ALWAYS_INLINE bool
+malloc_getcpu_cheap(tsd_t *tsd) {
+	return have_rseq && rseq_cpu_id_get(rseq_area_get(tsd)) >= 0;
+}
+
+/* Like malloc_getcpu(), but reads the thread's rseq area if possible. */
+JEMALLOC_ALWAYS_INLINE malloc_cpuid_t
+malloc_getcpu_tsd(tsd_t *tsd) {
+	if (have_rseq) {
+		int32_t cpuid = rseq_cpu_id_get(rseq_area_get(tsd));
+		if (likely(cpuid >= 0)) {
+			return (malloc_cpuid_t)cpuid;
+		}
+	}
+	return malloc_getcpu();
+}
+
 /* Return the chosen arena index based on current cpu. */
 JEMALLOC_ALWAYS_INLINE unsigned
-percpu_arena_choose(void) {
+percpu_arena_choose(tsd_t *tsd) {
 	assert(have_percpu_arena && PERCPU_ARENA_ENABLED(opt_percpu_arena));
 
-	malloc_cpuid_t cpuid = malloc_getcpu();
+	malloc_cpuid_t cpuid = malloc_getcpu_tsd(tsd);
 	assert(cpuid >= 0);
 
 	unsigned arena_ind;
@@ -41,13 +41,15 @@ arena_choose_impl(tsd_t *tsd, arena_t *arena, bool internal) {
 	/*
 	 * Note that for percpu arena, if the current arena is outside of the
 	 * auto percpu arena range, (i.e. thread is assigned to a manually
-	 * managed arena), then percpu arena is skipped.
+	 * managed arena), then percpu arena is skipped.  Unless the cpu is
+	 * cheap to read, it is only checked once another thread has used the
+	 * arena, which misses migrations between uses.
 	 */
 	if (have_percpu_arena && PERCPU_ARENA_ENABLED(opt_percpu_arena) &&
 	    !internal && (arena_ind_get(ret) <
 	    percpu_arena_ind_limit(opt_percpu_arena)) && (ret->last_thd !=
-	    tsd_tsdn(tsd))) {
-		unsigned ind = percpu_arena_choose();
+	    tsd_tsdn(tsd) || malloc_getcpu_cheap(tsd))) {
+		unsigned ind = percpu_arena_choose(tsd);
 		if (arena_ind_get(ret) != ind) {
 			percpu_arena_update(tsd, ind);
 			ret = tsd_arena_get(tsd);
@@ -55,6 +57,11 @@ arena_choose_impl(tsd_t *tsd, arena_t *arena, bool internal) {
 		ret->last_thd = tsd_tsdn(tsd);
 	}
 
+	if (unlikely(atomic_load_b(&arena_heap_frozen, ATOMIC_RELAXED)) &&
+	    arena_is_frozen(ret)) {
+		ret = arena_choose_frozen(tsd, ret, internal);
+	}
+
 	return ret;
 }
 
@@ -71,7 +78,8 @@ arena_ichoose(tsd_t *tsd, arena_t *arena) {
 static inline bool
 arena_is_auto(arena_t *arena) {
 	assert(narenas_auto > 0);
-	return (arena_ind_get(arena) < narenas_auto);
+	return (arena_ind_get(arena) < narenas_auto) ||
+	    unlikely(arena->auto_successor);
 }
 
 JEMALLOC_ALWAYS_INLINE extent_t *
@@ -161,6 +161,14 @@ static const bool config_log =
     false
 #endif
     ;
+/* Per-thread rtree_ctx cache counters, see thread.rtree_cache.*. */
+static const bool config_rtree_ctx_stats =
+#ifdef ANDROID_RTREE_CTX_STATS
+    true
+#else
+    false
+#endif
+    ;
 #ifdef JEMALLOC_HAVE_SCHED_GETCPU
 /* Currently percpu_arena depends on sched_getcpu. */
 #define JEMALLOC_PERCPU_ARENA
@@ -62,6 +62,12 @@ struct malloc_mutex_s {
 	witness_t			witness;
 	malloc_mutex_lock_order_t	lock_order;
 #endif
+
+	/*
+	 * With opt_fork_skip_quiescent, the fork epoch of the arena this mutex
+	 * belongs to; NULL for all other mutexes.  See malloc_mutex_fork_begin().
+	 */
+	atomic_zu_t			*fork_epoch;
 };
 
 /*
@@ -134,6 +140,17 @@ void malloc_mutex_postfork_child(tsdn_t *tsdn, malloc_mutex_t *mutex);
 bool malloc_mutex_boot(void);
 void malloc_mutex_prof_data_reset(tsdn_t *tsdn, malloc_mutex_t *mutex);
 
+/*
+ * Even between forks, odd while jemalloc_prefork() is deciding which arenas to
+ * skip.
+ */
+extern atomic_zu_t malloc_mutex_fork_epoch;
+
+void malloc_mutex_fork_track(malloc_mutex_t *mutex, atomic_zu_t *fork_epoch);
+size_t malloc_mutex_fork_begin(void);
+void malloc_mutex_fork_end(void);
+bool malloc_mutex_fork_enter_slow(tsdn_t *tsdn, malloc_mutex_t *mutex);
+
 void malloc_mutex_lock_slow(malloc_mutex_t *mutex);
 
 static inline void
@@ -158,6 +175,37 @@ mutex_owner_stats_update(tsdn_t *tsdn, malloc_mutex_t *mutex) {
 	}
 }
 
+/*
+ * Called with a tracked mutex just acquired.  Records the arena as used in the
+ * current fork epoch, and returns true if the mutex had to be released again
+ * because a fork that may skip the arena was in progress; the fork is over by
+ * then.
+ */
+static inline bool
+malloc_mutex_fork_enter(tsdn_t *tsdn, malloc_mutex_t *mutex) {
+	/*
+	 * fork_nheld lives in the tsd.  Without one, a thread already holding
+	 * tracked mutexes would wait for the fork in
+	 * malloc_mutex_fork_enter_slow(), while the fork waits for them.
+	 */
+	assert(!tsdn_null(tsdn));
+	/* The arena's epoch must be read first; see malloc_mutex_fork_begin(). */
+	if (atomic_load_zu(mutex->fork_epoch, ATOMIC_SEQ_CST) !=
+	    atomic_load_zu(&malloc_mutex_fork_epoch, ATOMIC_SEQ_CST) &&
+	    malloc_mutex_fork_enter_slow(tsdn, mutex)) {
+		return true;
+	}
+	(*tsd_fork_nheldp_get_unsafe(tsdn_tsd(tsdn)))++;
+	return false;
+}
+
+static inline void
+malloc_mutex_fork_exit(tsdn_t *tsdn) {
+	unsigned *nheld = tsd_fork_nheldp_get_unsafe(tsdn_tsd(tsdn));
+	assert(*nheld > 0);
+	(*nheld)--;
+}
+
 /* Trylock: return false if the lock is successfully acquired. */
 static inline bool
 malloc_mutex_trylock(tsdn_t *tsdn, malloc_mutex_t *mutex) {
@@ -166,6 +214,10 @@ malloc_mutex_trylock(tsdn_t *tsdn, malloc_mutex_t *mutex) {
 		if (malloc_mutex_trylock_final(mutex)) {
 			return true;
 		}
+		if (unlikely(mutex->fork_epoch != NULL) &&
+		    malloc_mutex_fork_enter(tsdn, mutex)) {
+			return true;
+		}
 		mutex_owner_stats_update(tsdn, mutex);
 	}
 	witness_lock(tsdn_witness_tsdp_get(tsdn), &mutex->witness);
@@ -197,26 +249,47 @@ malloc_mutex_prof_merge(mutex_prof_data_t *sum, mutex_prof_data_t *data) {
 	sum->n_lock_ops += data->n_lock_ops;
 }
 
+/*
+ * The forking thread bypasses fork epoch tracking (fork_track == false), since
+ * it acquires arena mutexes on behalf of the fork rather than to use them.
+ */
 static inline void
-malloc_mutex_lock(tsdn_t *tsdn, malloc_mutex_t *mutex) {
+malloc_mutex_lock_impl(tsdn_t *tsdn, malloc_mutex_t *mutex, bool fork_track) {
 	witness_assert_not_owner(tsdn_witness_tsdp_get(tsdn), &mutex->witness);
 	if (isthreaded) {
-		if (malloc_mutex_trylock_final(mutex)) {
-			malloc_mutex_lock_slow(mutex);
-		}
+		do {
+			if (malloc_mutex_trylock_final(mutex)) {
+				malloc_mutex_lock_slow(mutex);
+			}
+		} while (fork_track && unlikely(mutex->fork_epoch != NULL) &&
+		    malloc_mutex_fork_enter(tsdn, mutex));
 		mutex_owner_stats_update(tsdn, mutex);
 	}
 	witness_lock(tsdn_witness_tsdp_get(tsdn), &mutex->witness);
 }
 
 static inline void
-malloc_mutex_unlock(tsdn_t *tsdn, malloc_mutex_t *mutex) {
+malloc_mutex_unlock_impl(tsdn_t *tsdn, malloc_mutex_t *mutex,
+    bool fork_track) {
 	witness_unlock(tsdn_witness_tsdp_get(tsdn), &mutex->witness);
 	if (isthreaded) {
+		if (fork_track && unlikely(mutex->fork_epoch != NULL)) {
+			malloc_mutex_fork_exit(tsdn);
+		}
 		MALLOC_MUTEX_UNLOCK(mutex);
 	}
 }
 
+static inline void
+malloc_mutex_lock(tsdn_t *tsdn, malloc_mutex_t *mutex) {
+	malloc_mutex_lock_impl(tsdn, mutex, true);
+}
+
+static inline void
+malloc_mutex_unlock(tsdn_t *tsdn, malloc_mutex_t *mutex) {
+	malloc_mutex_unlock_impl(tsdn, mutex, true);
+}
+
 static inline void
 malloc_mutex_assert_owner(tsdn_t *tsdn, malloc_mutex_t *mutex) {
 	witness_assert_owner(tsdn_witness_tsdp_get(tsdn), &mutex->witness);
@@ -30,5 +30,6 @@ extern nstime_monotonic_t *JET_MUTABLE nstime_monotonic;
 
 typedef bool (nstime_update_t)(nstime_t *);
 extern nstime_update_t *JET_MUTABLE nstime_update;
+bool nstime_update_precise(nstime_t *time);
 
 #endif /* JEMALLOC_INTERNAL_NSTIME_H */
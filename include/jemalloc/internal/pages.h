@@ -58,6 +58,15 @@ static const bool pages_can_purge_forced =
 #endif
     ;
 
+/* Maximum number of ranges pages_purge_batch() accepts. */
+#define PAGES_PURGE_BATCH_MAX	64
+
+typedef struct pages_range_s pages_range_t;
+struct pages_range_s {
+	void	*addr;
+	size_t	size;
+};
+
 typedef enum {
 	thp_mode_default       = 0, /* Do not change hugepage settings. */
 	thp_mode_always        = 1, /* Always set MADV_HUGEPAGE. */
@@ -78,11 +87,19 @@ bool pages_commit(void *addr, size_t size);
 bool pages_decommit(void *addr, size_t size);
 bool pages_purge_lazy(void *addr, size_t size);
 bool pages_purge_forced(void *addr, size_t size);
+bool pages_purge_batch_enabled(bool lazy);
+bool pages_purge_batch(const pages_range_t *ranges, size_t nranges, bool lazy);
+bool pages_nresident(void *addr, size_t size, size_t *r_nresident);
+bool pages_decommit_enabled(void);
 bool pages_huge(void *addr, size_t size);
 bool pages_nohuge(void *addr, size_t size);
 bool pages_dontdump(void *addr, size_t size);
 bool pages_dodump(void *addr, size_t size);
+void pages_prefault(void *addr, size_t size);
+bool pages_mlock(void *addr, size_t size);
+bool pages_munlock(void *addr, size_t size);
 bool pages_boot(void);
+void pages_postfork_child(void);
 void pages_set_thp_state (void *ptr, size_t size);
 
 #endif /* JEMALLOC_INTERNAL_PAGES_EXTERNS_H */
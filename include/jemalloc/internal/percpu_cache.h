@@ -0,0 +1,290 @@
+#ifndef JEMALLOC_INTERNAL_PERCPU_CACHE_H
+#define JEMALLOC_INTERNAL_PERCPU_CACHE_H
+
+#include "jemalloc/internal/atomic.h"
+#include "jemalloc/internal/cache_bin.h"
+#include "jemalloc/internal/rseq.h"
+#include "jemalloc/internal/size_classes.h"
+
+/*
+ * Per-CPU caches of small objects, an alternative front end to the per-thread
+ * tcache for processes with many mostly idle threads: the memory held in
+ * caches is bounded by the number of CPUs rather than threads, and a thread
+ * that wakes up finds its CPU's cache warm.
+ *
+ * Each CPU has a cache_bin_t per small size class, with room for as many
+ * objects as a tcache bin.  Objects are pushed and popped by rseq critical
+ * sections that commit with their store to ncached, so only the thread
+ * currently running on a CPU ever modifies that CPU's bins.  A bin that runs
+ * empty is refilled with half its capacity from the thread's arena, and a bin
+ * that fills up has half its objects flushed.
+ *
+ * The caches take over allocations and deallocations that would otherwise go
+ * through the thread's automatic tcache (or straight to the arena if the
+ * tcache is disabled), and only hold objects from automatic arenas, which are
+ * never reset or destroyed.  Threads that cannot use rseq, and CPUs numbered
+ * ncpus or higher, take the regular path.
+ */
+
+typedef struct percpu_cache_s percpu_cache_t;
+struct percpu_cache_s {
+	/* The objects' stacks follow, as for tcache_t. */
+	cache_bin_t	bins[NBINS];
+};
+
+typedef struct percpu_cache_cpu_stats_s percpu_cache_cpu_stats_t;
+struct percpu_cache_cpu_stats_s {
+	/* Number of cached objects, and their size in bytes. */
+	size_t		ncached;
+	size_t		bytes;
+};
+
+typedef struct percpu_cache_stats_s percpu_cache_stats_t;
+struct percpu_cache_stats_s {
+	size_t		ncached;
+	size_t		bytes;
+	/* Number of aborted rseq critical sections. */
+	uint64_t	naborts;
+	/* Number of bins filled from and flushed to arenas. */
+	uint64_t	nfills;
+	uint64_t	nflushes;
+	/* Occupancy of each of the percpu_cache_ncpus caches. */
+	percpu_cache_cpu_stats_t *cpus;
+};
+
+typedef enum {
+	percpu_cache_op_done,
+	/* The bin was empty (pop) or full (push). */
+	percpu_cache_op_bin_limit,
+	percpu_cache_op_aborted
+} percpu_cache_op_t;
+
+extern bool opt_percpu_cache;
+
+/* Whether the caches are in use; only set once booted successfully. */
+extern bool percpu_cache_enabled;
+extern unsigned percpu_cache_ncpus;
+/* The caches of all CPUs, percpu_cache_stride bytes apart. */
+extern uintptr_t percpu_cache_base;
+extern size_t percpu_cache_stride;
+extern atomic_u64_t percpu_cache_naborts;
+
+bool percpu_cache_boot(tsd_t *tsd);
+void *percpu_cache_alloc_hard(tsd_t *tsd, rseq_area_t *area, szind_t binind);
+bool percpu_cache_dalloc_hard(tsd_t *tsd, rseq_area_t *area, void *ptr,
+    szind_t binind);
+void percpu_cache_flush_all(tsd_t *tsd);
+void percpu_cache_stats_read(percpu_cache_stats_t *stats);
+
+/* Returns the cache of the given CPU, or NULL if it has none. */
+JEMALLOC_ALWAYS_INLINE percpu_cache_t *
+percpu_cache_get(int32_t cpu) {
+	if (unlikely((uint32_t)cpu >= percpu_cache_ncpus)) {
+		return NULL;
+	}
+	return (percpu_cache_t *)(percpu_cache_base + (uintptr_t)cpu *
+	    percpu_cache_stride);
+}
+
+JEMALLOC_ALWAYS_INLINE void
+percpu_cache_abort_record(void) {
+	if (config_stats) {
+		atomic_fetch_add_u64(&percpu_cache_naborts, 1, ATOMIC_RELAXED);
+	}
+}
+
+#ifdef JEMALLOC_HAVE_RSEQ
+/*
+ * Emits the rseq_cs descriptor of a critical section running from label 1 to
+ * label 2 (exclusive), points the thread's area at it, and emits the abort
+ * handler (label 4, preceded by the signature) out of line, jumping to
+ * abort_label.
+ */
+#define PERCPU_CACHE_RSEQ_START						\
+	".pushsection __rseq_cs, \"aw\"\n\t"				\
+	".balign 32\n\t"						\
+	"3:\n\t"							\
+	".long 0x0, 0x0\n\t"						\
+	".quad 1f, (2f - 1f), 4f\n\t"					\
+	".popsection\n\t"						\
+	"leaq 3b(%%rip), %%rax\n\t"					\
+	"movq %%rax, %[rseq_cs]\n\t"					\
+	"1:\n\t"							\
+	"cmpl %[cpu], %[cpu_id]\n\t"					\
+	"jnz %l[aborted]\n\t"
+#define PERCPU_CACHE_RSEQ_END						\
+	"2:\n\t"							\
+	".pushsection __rseq_failure, \"ax\"\n\t"			\
+	".byte 0x0f, 0xb9, 0x3d\n\t"					\
+	".long " STRINGIFY(RSEQ_SIG) "\n\t"				\
+	"4:\n\t"							\
+	"jmp %l[aborted]\n\t"						\
+	".popsection\n\t"
+#endif
+
+/* Pops the most recently pushed object of bin, which belongs to cpu. */
+JEMALLOC_ALWAYS_INLINE percpu_cache_op_t
+percpu_cache_bin_pop(rseq_area_t *area, int32_t cpu, cache_bin_t *bin,
+    void **ret) {
+#ifdef JEMALLOC_HAVE_RSEQ
+	__asm__ goto (
+	    PERCPU_CACHE_RSEQ_START
+	    "movslq %[ncached], %%rax\n\t"
+	    "testq %%rax, %%rax\n\t"
+	    "jz %l[bin_limit]\n\t"
+	    "movq %%rax, %%rcx\n\t"
+	    "negq %%rcx\n\t"
+	    "movq %[avail], %%rdx\n\t"
+	    "movq (%%rdx, %%rcx, 8), %%rdx\n\t"
+	    "movq %%rdx, (%[ret])\n\t"
+	    "decl %%eax\n\t"
+	    /* Commit. */
+	    "movl %%eax, %[ncached]\n\t"
+	    PERCPU_CACHE_RSEQ_END
+	    : /* No outputs. */
+	    : [rseq_cs] "m" (area->rseq_cs), [cpu_id] "m" (area->cpu_id),
+	      [cpu] "r" (cpu), [ncached] "m" (bin->ncached),
+	      [avail] "m" (bin->avail), [ret] "r" (ret)
+	    : "memory", "cc", "rax", "rcx", "rdx"
+	    : bin_limit, aborted);
+	return percpu_cache_op_done;
+bin_limit:
+	return percpu_cache_op_bin_limit;
+aborted:
+	return percpu_cache_op_aborted;
+#else
+	not_reached();
+	return percpu_cache_op_aborted;
+#endif
+}
+
+/* Pushes ptr onto bin, which belongs to cpu and holds up to ncached_max. */
+JEMALLOC_ALWAYS_INLINE percpu_cache_op_t
+percpu_cache_bin_push(rseq_area_t *area, int32_t cpu, cache_bin_t *bin,
+    cache_bin_sz_t ncached_max, void *ptr) {
+#ifdef JEMALLOC_HAVE_RSEQ
+	__asm__ goto (
+	    PERCPU_CACHE_RSEQ_START
+	    "movslq %[ncached], %%rax\n\t"
+	    "cmpl %[ncached_max], %%eax\n\t"
+	    "jge %l[bin_limit]\n\t"
+	    "incq %%rax\n\t"
+	    "movq %%rax, %%rcx\n\t"
+	    "negq %%rcx\n\t"
+	    "movq %[avail], %%rdx\n\t"
+	    "movq %[ptr], (%%rdx, %%rcx, 8)\n\t"
+	    /* Commit. */
+	    "movl %%eax, %[ncached]\n\t"
+	    PERCPU_CACHE_RSEQ_END
+	    : /* No outputs. */
+	    : [rseq_cs] "m" (area->rseq_cs), [cpu_id] "m" (area->cpu_id),
+	      [cpu] "r" (cpu), [ncached] "m" (bin->ncached),
+	      [avail] "m" (bin->avail), [ncached_max] "r" (ncached_max),
+	      [ptr] "r" (ptr)
+	    : "memory", "cc", "rax", "rcx", "rdx"
+	    : bin_limit, aborted);
+	return percpu_cache_op_done;
+bin_limit:
+	return percpu_cache_op_bin_limit;
+aborted:
+	return percpu_cache_op_aborted;
+#else
+	not_reached();
+	return percpu_cache_op_aborted;
+#endif
+}
+
+/*
+ * Whether tcache is the one that the thread uses implicitly, i.e. whether the
+ * per-CPU caches may stand in for it.
+ */
+JEMALLOC_ALWAYS_INLINE bool
+percpu_cache_tcache_is_auto(tsd_t *tsd, tcache_t *tcache) {
+	if (tcache != NULL) {
+		return tcache == tsd_tcachep_get(tsd);
+	}
+	return tsd_nominal(tsd) && !tsd_tcache_enabled_get(tsd) &&
+	    tsd_reentrancy_level_get(tsd) == 0;
+}
+
+/* Returns NULL if the allocation should take the regular path. */
+JEMALLOC_ALWAYS_INLINE void *
+percpu_cache_alloc(tsd_t *tsd, szind_t binind, bool zero, bool slow_path) {
+	assert(binind < NBINS);
+	rseq_area_t *area = rseq_area_get(tsd);
+	void *ret;
+	while (true) {
+		int32_t cpu = rseq_cpu_id_get(area);
+		percpu_cache_t *cache = percpu_cache_get(cpu);
+		if (unlikely(cache == NULL)) {
+			return NULL;
+		}
+		percpu_cache_op_t op = percpu_cache_bin_pop(area, cpu,
+		    &cache->bins[binind], &ret);
+		if (likely(op == percpu_cache_op_done)) {
+			break;
+		}
+		if (op == percpu_cache_op_bin_limit) {
+			ret = percpu_cache_alloc_hard(tsd, area, binind);
+			if (ret == NULL) {
+				return NULL;
+			}
+			break;
+		}
+		percpu_cache_abort_record();
+	}
+	assert(ret != NULL);
+
+	/* As in tcache_alloc_small(). */
+	if (likely(!zero)) {
+		if (slow_path && config_fill) {
+			if (unlikely(opt_junk_alloc)) {
+				arena_alloc_junk_small(ret, &bin_infos[binind],
+				    false);
+			} else if (unlikely(opt_zero)) {
+				memset(ret, 0, sz_index2size(binind));
+			}
+		}
+	} else {
+		if (slow_path && config_fill && unlikely(opt_junk_alloc)) {
+			arena_alloc_junk_small(ret, &bin_infos[binind], true);
+		}
+		memset(ret, 0, sz_index2size(binind));
+	}
+	return ret;
+}
+
+/* Returns false if the deallocation should take the regular path. */
+JEMALLOC_ALWAYS_INLINE bool
+percpu_cache_dalloc(tsd_t *tsd, void *ptr, szind_t binind, bool slow_path) {
+	assert(binind < NBINS);
+	rseq_area_t *area = rseq_area_get(tsd);
+	if (unlikely(percpu_cache_get(rseq_cpu_id_get(area)) == NULL) ||
+	    !arena_is_auto(iaalloc(tsd_tsdn(tsd), ptr))) {
+		return false;
+	}
+
+	if (slow_path && config_fill && unlikely(opt_junk_free)) {
+		arena_dalloc_junk_small(ptr, &bin_infos[binind]);
+	}
+
+	while (true) {
+		int32_t cpu = rseq_cpu_id_get(area);
+		percpu_cache_t *cache = percpu_cache_get(cpu);
+		if (unlikely(cache == NULL)) {
+			return false;
+		}
+		percpu_cache_op_t op = percpu_cache_bin_push(area, cpu,
+		    &cache->bins[binind], tcache_bin_info[binind].ncached_max,
+		    ptr);
+		if (likely(op == percpu_cache_op_done)) {
+			return true;
+		}
+		if (op == percpu_cache_op_bin_limit) {
+			return percpu_cache_dalloc_hard(tsd, area, ptr, binind);
+		}
+		percpu_cache_abort_record();
+	}
+}
+
+#endif /* JEMALLOC_INTERNAL_PERCPU_CACHE_H */
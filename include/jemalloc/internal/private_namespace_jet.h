@@ -1,5 +1,6 @@
 #define a0dalloc JEMALLOC_N(a0dalloc)
 #define a0malloc JEMALLOC_N(a0malloc)
+#define arena_attach JEMALLOC_N(arena_attach)
 #define arena_choose_hard JEMALLOC_N(arena_choose_hard)
 #define arena_cleanup JEMALLOC_N(arena_cleanup)
 #define arena_init JEMALLOC_N(arena_init)
@@ -27,6 +28,7 @@
 #define opt_junk_alloc JEMALLOC_N(opt_junk_alloc)
 #define opt_junk_free JEMALLOC_N(opt_junk_free)
 #define opt_narenas JEMALLOC_N(opt_narenas)
+#define opt_fork_skip_quiescent JEMALLOC_N(opt_fork_skip_quiescent)
 #define opt_utrace JEMALLOC_N(opt_utrace)
 #define opt_xmalloc JEMALLOC_N(opt_xmalloc)
 #define opt_zero JEMALLOC_N(opt_zero)
@@ -38,10 +40,17 @@
 #define arena_dalloc_promoted JEMALLOC_N(arena_dalloc_promoted)
 #define arena_dalloc_small JEMALLOC_N(arena_dalloc_small)
 #define arena_decay JEMALLOC_N(arena_decay)
+#define arena_decay_accelerate JEMALLOC_N(arena_decay_accelerate)
 #define arena_destroy JEMALLOC_N(arena_destroy)
 #define arena_dirty_decay_ms_default_get JEMALLOC_N(arena_dirty_decay_ms_default_get)
 #define arena_dirty_decay_ms_default_set JEMALLOC_N(arena_dirty_decay_ms_default_set)
 #define arena_dirty_decay_ms_get JEMALLOC_N(arena_dirty_decay_ms_get)
+#define arena_dirty_decay_adaptive_get JEMALLOC_N(arena_dirty_decay_adaptive_get)
+#define arena_dirty_decay_adaptive_set JEMALLOC_N(arena_dirty_decay_adaptive_set)
+#define arena_dirty_decay_ms_effective_get JEMALLOC_N(arena_dirty_decay_ms_effective_get)
+#define arena_decay_reuse_stamp JEMALLOC_N(arena_decay_reuse_stamp)
+#define arena_decay_reuse_sample JEMALLOC_N(arena_decay_reuse_sample)
+#define arena_latency_record JEMALLOC_N(arena_latency_record)
 #define arena_dirty_decay_ms_set JEMALLOC_N(arena_dirty_decay_ms_set)
 #define arena_dss_prec_get JEMALLOC_N(arena_dss_prec_get)
 #define arena_dss_prec_set JEMALLOC_N(arena_dss_prec_set)
@@ -50,7 +59,30 @@
 #define arena_extent_ralloc_large_expand JEMALLOC_N(arena_extent_ralloc_large_expand)
 #define arena_extent_ralloc_large_shrink JEMALLOC_N(arena_extent_ralloc_large_shrink)
 #define arena_extents_dirty_dalloc JEMALLOC_N(arena_extents_dirty_dalloc)
+#define arena_extent_reuse_get JEMALLOC_N(arena_extent_reuse_get)
+#define arena_extent_reuse_set JEMALLOC_N(arena_extent_reuse_set)
+#define arena_purge_policy_get JEMALLOC_N(arena_purge_policy_get)
+#define arena_purge_policy_set JEMALLOC_N(arena_purge_policy_set)
+#define arena_purge_max_dirty_get JEMALLOC_N(arena_purge_max_dirty_get)
+#define arena_purge_max_dirty_set JEMALLOC_N(arena_purge_max_dirty_set)
+#define arena_purge_dirty_ratio_get JEMALLOC_N(arena_purge_dirty_ratio_get)
+#define arena_purge_dirty_ratio_set JEMALLOC_N(arena_purge_dirty_ratio_set)
+#define arena_purge_floor_get JEMALLOC_N(arena_purge_floor_get)
+#define arena_purge_floor_set JEMALLOC_N(arena_purge_floor_set)
+#define arena_purge_select_get JEMALLOC_N(arena_purge_select_get)
+#define arena_purge_select_set JEMALLOC_N(arena_purge_select_set)
+#define arena_prefault_get JEMALLOC_N(arena_prefault_get)
+#define arena_prefault_set JEMALLOC_N(arena_prefault_set)
+#define arena_mlock_get JEMALLOC_N(arena_mlock_get)
+#define arena_mlock_set JEMALLOC_N(arena_mlock_set)
+#define arena_extent_populate JEMALLOC_N(arena_extent_populate)
+#define arena_decay_cap_npages_limit JEMALLOC_N(arena_decay_cap_npages_limit)
 #define arena_extent_sn_next JEMALLOC_N(arena_extent_sn_next)
+#define arena_freeze_reusable_get JEMALLOC_N(arena_freeze_reusable_get)
+#define arena_freeze JEMALLOC_N(arena_freeze)
+#define arena_heap_frozen JEMALLOC_N(arena_heap_frozen)
+#define arena_choose_frozen JEMALLOC_N(arena_choose_frozen)
+#define arena_fork_used JEMALLOC_N(arena_fork_used)
 #define arena_malloc_hard JEMALLOC_N(arena_malloc_hard)
 #define arena_muzzy_decay_ms_default_get JEMALLOC_N(arena_muzzy_decay_ms_default_get)
 #define arena_muzzy_decay_ms_default_set JEMALLOC_N(arena_muzzy_decay_ms_default_set)
@@ -72,22 +104,42 @@
 #define arena_prefork6 JEMALLOC_N(arena_prefork6)
 #define arena_prefork7 JEMALLOC_N(arena_prefork7)
 #define arena_prof_promote JEMALLOC_N(arena_prof_promote)
+#define arena_quiesce JEMALLOC_N(arena_quiesce)
 #define arena_ralloc JEMALLOC_N(arena_ralloc)
 #define arena_ralloc_no_move JEMALLOC_N(arena_ralloc_no_move)
+#define arena_reattach JEMALLOC_N(arena_reattach)
 #define arena_reset JEMALLOC_N(arena_reset)
 #define arena_retain_grow_limit_get_set JEMALLOC_N(arena_retain_grow_limit_get_set)
+#define arena_retained_trim JEMALLOC_N(arena_retained_trim)
 #define arena_slab_regind JEMALLOC_N(arena_slab_regind)
 #define arena_stats_merge JEMALLOC_N(arena_stats_merge)
 #define arena_tcache_fill_small JEMALLOC_N(arena_tcache_fill_small)
+#define arena_cache_bin_fill_small JEMALLOC_N(arena_cache_bin_fill_small)
 #define h_steps JEMALLOC_N(h_steps)
 #define opt_dirty_decay_ms JEMALLOC_N(opt_dirty_decay_ms)
+#define opt_dirty_decay_adaptive JEMALLOC_N(opt_dirty_decay_adaptive)
+#define opt_dirty_decay_refault_target JEMALLOC_N(opt_dirty_decay_refault_target)
+#define opt_empty_slab_cache_max JEMALLOC_N(opt_empty_slab_cache_max)
+#define opt_extent_steal JEMALLOC_N(opt_extent_steal)
+#define opt_extent_steal_threshold JEMALLOC_N(opt_extent_steal_threshold)
+#define opt_freeze_narenas_max JEMALLOC_N(opt_freeze_narenas_max)
+#define purge_policy_names JEMALLOC_N(purge_policy_names)
+#define opt_purge_policy JEMALLOC_N(opt_purge_policy)
+#define opt_purge_max_dirty JEMALLOC_N(opt_purge_max_dirty)
+#define opt_purge_dirty_ratio JEMALLOC_N(opt_purge_dirty_ratio)
+#define opt_purge_floor JEMALLOC_N(opt_purge_floor)
+#define purge_select_names JEMALLOC_N(purge_select_names)
+#define opt_purge_select JEMALLOC_N(opt_purge_select)
 #define opt_muzzy_decay_ms JEMALLOC_N(opt_muzzy_decay_ms)
 #define opt_percpu_arena JEMALLOC_N(opt_percpu_arena)
 #define percpu_arena_mode_names JEMALLOC_N(percpu_arena_mode_names)
 #define background_thread_boot0 JEMALLOC_N(background_thread_boot0)
 #define background_thread_boot1 JEMALLOC_N(background_thread_boot1)
+#define background_thread_arena_unschedule JEMALLOC_N(background_thread_arena_unschedule)
+#define background_thread_arena_new JEMALLOC_N(background_thread_arena_new)
 #define background_thread_create JEMALLOC_N(background_thread_create)
 #define background_thread_ctl_init JEMALLOC_N(background_thread_ctl_init)
+#define background_thread_pressure_level JEMALLOC_N(background_thread_pressure_level)
 #define background_thread_enabled_state JEMALLOC_N(background_thread_enabled_state)
 #define background_thread_info JEMALLOC_N(background_thread_info)
 #define background_thread_interval_check JEMALLOC_N(background_thread_interval_check)
@@ -104,6 +156,13 @@
 #define n_background_threads JEMALLOC_N(n_background_threads)
 #define opt_background_thread JEMALLOC_N(opt_background_thread)
 #define opt_max_background_threads JEMALLOC_N(opt_max_background_threads)
+#define opt_background_thread_cpus JEMALLOC_N(opt_background_thread_cpus)
+#define opt_background_thread_sched_idle JEMALLOC_N(opt_background_thread_sched_idle)
+#define opt_background_thread_nice JEMALLOC_N(opt_background_thread_nice)
+#define opt_psi_purge JEMALLOC_N(opt_psi_purge)
+#define opt_psi_path JEMALLOC_N(opt_psi_path)
+#define opt_psi_stall_us JEMALLOC_N(opt_psi_stall_us)
+#define opt_psi_window_us JEMALLOC_N(opt_psi_window_us)
 #define pthread_create_wrapper JEMALLOC_N(pthread_create_wrapper)
 #define b0get JEMALLOC_N(b0get)
 #define base_alloc JEMALLOC_N(base_alloc)
@@ -127,6 +186,16 @@
 #define bitmap_info_init JEMALLOC_N(bitmap_info_init)
 #define bitmap_init JEMALLOC_N(bitmap_init)
 #define bitmap_size JEMALLOC_N(bitmap_size)
+#define cgroup_arena_unpurged_npages JEMALLOC_N(cgroup_arena_unpurged_npages)
+#define cgroup_boot JEMALLOC_N(cgroup_boot)
+#define cgroup_limit JEMALLOC_N(cgroup_limit)
+#define cgroup_headroom_low JEMALLOC_N(cgroup_headroom_low)
+#define cgroup_maybe_refresh JEMALLOC_N(cgroup_maybe_refresh)
+#define cgroup_refresh JEMALLOC_N(cgroup_refresh)
+#define cgroup_unpurged_ceiling JEMALLOC_N(cgroup_unpurged_ceiling)
+#define opt_cgroup_aware JEMALLOC_N(opt_cgroup_aware)
+#define opt_cgroup_root JEMALLOC_N(opt_cgroup_root)
+#define opt_cgroup_unpurged_ratio JEMALLOC_N(opt_cgroup_unpurged_ratio)
 #define ckh_count JEMALLOC_N(ckh_count)
 #define ckh_delete JEMALLOC_N(ckh_delete)
 #define ckh_insert JEMALLOC_N(ckh_insert)
@@ -148,6 +217,7 @@
 #define div_init JEMALLOC_N(div_init)
 #define extent_alloc JEMALLOC_N(extent_alloc)
 #define extent_alloc_wrapper JEMALLOC_N(extent_alloc_wrapper)
+#define extent_attach JEMALLOC_N(extent_attach)
 #define extent_avail_any JEMALLOC_N(extent_avail_any)
 #define extent_avail_empty JEMALLOC_N(extent_avail_empty)
 #define extent_avail_first JEMALLOC_N(extent_avail_first)
@@ -157,12 +227,16 @@
 #define extent_avail_remove_any JEMALLOC_N(extent_avail_remove_any)
 #define extent_avail_remove_first JEMALLOC_N(extent_avail_remove_first)
 #define extent_boot JEMALLOC_N(extent_boot)
+#define extent_cache_flush JEMALLOC_N(extent_cache_flush)
 #define extent_commit_wrapper JEMALLOC_N(extent_commit_wrapper)
 #define extent_dalloc JEMALLOC_N(extent_dalloc)
 #define extent_dalloc_gap JEMALLOC_N(extent_dalloc_gap)
 #define extent_dalloc_wrapper JEMALLOC_N(extent_dalloc_wrapper)
+#define extent_dalloc_batchable JEMALLOC_N(extent_dalloc_batchable)
+#define extent_dalloc_purged_wrapper JEMALLOC_N(extent_dalloc_purged_wrapper)
 #define extent_decommit_wrapper JEMALLOC_N(extent_decommit_wrapper)
 #define extent_destroy_wrapper JEMALLOC_N(extent_destroy_wrapper)
+#define extent_detach JEMALLOC_N(extent_detach)
 #define extent_heap_any JEMALLOC_N(extent_heap_any)
 #define extent_heap_empty JEMALLOC_N(extent_heap_empty)
 #define extent_heap_first JEMALLOC_N(extent_heap_first)
@@ -178,13 +252,16 @@
 #define extent_mutex_pool JEMALLOC_N(extent_mutex_pool)
 #define extent_purge_forced_wrapper JEMALLOC_N(extent_purge_forced_wrapper)
 #define extent_purge_lazy_wrapper JEMALLOC_N(extent_purge_lazy_wrapper)
+#define extent_retained_trim JEMALLOC_N(extent_retained_trim)
 #define extents_alloc JEMALLOC_N(extents_alloc)
+#define extents_steal JEMALLOC_N(extents_steal)
 #define extents_dalloc JEMALLOC_N(extents_dalloc)
 #define extents_evict JEMALLOC_N(extents_evict)
 #define extents_init JEMALLOC_N(extents_init)
 #define extent_size_quantize_ceil JEMALLOC_N(extent_size_quantize_ceil)
 #define extent_size_quantize_floor JEMALLOC_N(extent_size_quantize_floor)
 #define extents_npages_get JEMALLOC_N(extents_npages_get)
+#define extents_npages_peak_get JEMALLOC_N(extents_npages_peak_get)
 #define extent_split_wrapper JEMALLOC_N(extent_split_wrapper)
 #define extents_postfork_child JEMALLOC_N(extents_postfork_child)
 #define extents_postfork_parent JEMALLOC_N(extents_postfork_parent)
@@ -192,6 +269,8 @@
 #define extents_rtree JEMALLOC_N(extents_rtree)
 #define extents_state_get JEMALLOC_N(extents_state_get)
 #define opt_lg_extent_max_active_fit JEMALLOC_N(opt_lg_extent_max_active_fit)
+#define opt_extent_reuse JEMALLOC_N(opt_extent_reuse)
+#define extent_reuse_names JEMALLOC_N(extent_reuse_names)
 #define dss_prec_names JEMALLOC_N(dss_prec_names)
 #define extent_alloc_dss JEMALLOC_N(extent_alloc_dss)
 #define extent_dss_boot JEMALLOC_N(extent_dss_boot)
@@ -200,8 +279,19 @@
 #define extent_dss_prec_set JEMALLOC_N(extent_dss_prec_set)
 #define extent_in_dss JEMALLOC_N(extent_in_dss)
 #define opt_dss JEMALLOC_N(opt_dss)
+#define extent_fd_delete JEMALLOC_N(extent_fd_delete)
+#define extent_fd_get JEMALLOC_N(extent_fd_get)
+#define extent_fd_new JEMALLOC_N(extent_fd_new)
+#define extent_fd_persistent_arena_set JEMALLOC_N(extent_fd_persistent_arena_set)
+#define extent_fd_persistent_new JEMALLOC_N(extent_fd_persistent_new)
+#define extent_fd_persistent_quiesce JEMALLOC_N(extent_fd_persistent_quiesce)
+#define extent_fd_persistent_root JEMALLOC_N(extent_fd_persistent_root)
+#define opt_persistent_addr JEMALLOC_N(opt_persistent_addr)
 #define extent_alloc_mmap JEMALLOC_N(extent_alloc_mmap)
 #define extent_dalloc_mmap JEMALLOC_N(extent_dalloc_mmap)
+#define extent_mmap_reserve JEMALLOC_N(extent_mmap_reserve)
+#define extent_mmap_reserved JEMALLOC_N(extent_mmap_reserved)
+#define opt_reserve_va JEMALLOC_N(opt_reserve_va)
 #define opt_retain JEMALLOC_N(opt_retain)
 #define hooks_arena_new_hook JEMALLOC_N(hooks_arena_new_hook)
 #define hooks_libc_hook JEMALLOC_N(hooks_libc_hook)
@@ -230,6 +320,11 @@
 #define malloc_vsnprintf JEMALLOC_N(malloc_vsnprintf)
 #define malloc_write JEMALLOC_N(malloc_write)
 #define malloc_mutex_boot JEMALLOC_N(malloc_mutex_boot)
+#define malloc_mutex_fork_begin JEMALLOC_N(malloc_mutex_fork_begin)
+#define malloc_mutex_fork_end JEMALLOC_N(malloc_mutex_fork_end)
+#define malloc_mutex_fork_enter_slow JEMALLOC_N(malloc_mutex_fork_enter_slow)
+#define malloc_mutex_fork_epoch JEMALLOC_N(malloc_mutex_fork_epoch)
+#define malloc_mutex_fork_track JEMALLOC_N(malloc_mutex_fork_track)
 #define malloc_mutex_init JEMALLOC_N(malloc_mutex_init)
 #define malloc_mutex_lock_slow JEMALLOC_N(malloc_mutex_lock_slow)
 #define malloc_mutex_postfork_child JEMALLOC_N(malloc_mutex_postfork_child)
@@ -254,6 +349,7 @@
 #define nstime_sec JEMALLOC_N(nstime_sec)
 #define nstime_subtract JEMALLOC_N(nstime_subtract)
 #define nstime_update JEMALLOC_N(nstime_update)
+#define nstime_update_precise JEMALLOC_N(nstime_update_precise)
 #define init_system_thp_mode JEMALLOC_N(init_system_thp_mode)
 #define opt_thp JEMALLOC_N(opt_thp)
 #define pages_boot JEMALLOC_N(pages_boot)
@@ -263,12 +359,31 @@
 #define pages_dontdump JEMALLOC_N(pages_dontdump)
 #define pages_huge JEMALLOC_N(pages_huge)
 #define pages_map JEMALLOC_N(pages_map)
+#define pages_mlock JEMALLOC_N(pages_mlock)
+#define pages_munlock JEMALLOC_N(pages_munlock)
 #define pages_nohuge JEMALLOC_N(pages_nohuge)
+#define pages_prefault JEMALLOC_N(pages_prefault)
 #define pages_purge_forced JEMALLOC_N(pages_purge_forced)
+#define pages_purge_batch JEMALLOC_N(pages_purge_batch)
+#define pages_nresident JEMALLOC_N(pages_nresident)
+#define pages_purge_batch_enabled JEMALLOC_N(pages_purge_batch_enabled)
+#define pages_decommit_enabled JEMALLOC_N(pages_decommit_enabled)
+#define pages_postfork_child JEMALLOC_N(pages_postfork_child)
 #define pages_purge_lazy JEMALLOC_N(pages_purge_lazy)
 #define pages_set_thp_state JEMALLOC_N(pages_set_thp_state)
 #define pages_unmap JEMALLOC_N(pages_unmap)
 #define thp_mode_names JEMALLOC_N(thp_mode_names)
+#define opt_percpu_cache JEMALLOC_N(opt_percpu_cache)
+#define percpu_cache_alloc_hard JEMALLOC_N(percpu_cache_alloc_hard)
+#define percpu_cache_base JEMALLOC_N(percpu_cache_base)
+#define percpu_cache_boot JEMALLOC_N(percpu_cache_boot)
+#define percpu_cache_dalloc_hard JEMALLOC_N(percpu_cache_dalloc_hard)
+#define percpu_cache_flush_all JEMALLOC_N(percpu_cache_flush_all)
+#define percpu_cache_enabled JEMALLOC_N(percpu_cache_enabled)
+#define percpu_cache_naborts JEMALLOC_N(percpu_cache_naborts)
+#define percpu_cache_ncpus JEMALLOC_N(percpu_cache_ncpus)
+#define percpu_cache_stats_read JEMALLOC_N(percpu_cache_stats_read)
+#define percpu_cache_stride JEMALLOC_N(percpu_cache_stride)
 #define bt2gctx_mtx JEMALLOC_N(bt2gctx_mtx)
 #define bt_init JEMALLOC_N(bt_init)
 #define lg_prof_sample JEMALLOC_N(lg_prof_sample)
@@ -321,7 +436,19 @@
 #define prof_thread_active_set JEMALLOC_N(prof_thread_active_set)
 #define prof_thread_name_get JEMALLOC_N(prof_thread_name_get)
 #define prof_thread_name_set JEMALLOC_N(prof_thread_name_set)
+#define opt_purge_call_max JEMALLOC_N(opt_purge_call_max)
+#define opt_purge_inline_share JEMALLOC_N(opt_purge_inline_share)
+#define opt_purge_rate JEMALLOC_N(opt_purge_rate)
+#define purge_budget_boot JEMALLOC_N(purge_budget_boot)
+#define purge_budget_debt_update JEMALLOC_N(purge_budget_debt_update)
+#define purge_budget_duration_record JEMALLOC_N(purge_budget_duration_record)
+#define purge_budget_settle JEMALLOC_N(purge_budget_settle)
+#define purge_budget_stats_read JEMALLOC_N(purge_budget_stats_read)
+#define purge_budget_take JEMALLOC_N(purge_budget_take)
+#define rseq_area_register JEMALLOC_N(rseq_area_register)
+#define rseq_boot JEMALLOC_N(rseq_boot)
 #define rtree_ctx_data_init JEMALLOC_N(rtree_ctx_data_init)
+#define rtree_flat_init JEMALLOC_N(rtree_flat_init)
 #define rtree_delete JEMALLOC_N(rtree_delete)
 #define rtree_leaf_alloc JEMALLOC_N(rtree_leaf_alloc)
 #define rtree_leaf_dalloc JEMALLOC_N(rtree_leaf_dalloc)
@@ -345,6 +472,7 @@
 #define tcache_arena_reassociate JEMALLOC_N(tcache_arena_reassociate)
 #define tcache_bin_flush_large JEMALLOC_N(tcache_bin_flush_large)
 #define tcache_bin_flush_small JEMALLOC_N(tcache_bin_flush_small)
+#define tcache_bin_flush_small_arena JEMALLOC_N(tcache_bin_flush_small_arena)
 #define tcache_bin_info JEMALLOC_N(tcache_bin_info)
 #define tcache_boot JEMALLOC_N(tcache_boot)
 #define tcache_cleanup JEMALLOC_N(tcache_cleanup)
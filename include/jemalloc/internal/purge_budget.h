@@ -0,0 +1,58 @@
+#ifndef JEMALLOC_INTERNAL_PURGE_BUDGET_H
+#define JEMALLOC_INTERNAL_PURGE_BUDGET_H
+
+#include "jemalloc/internal/atomic.h"
+
+/*
+ * Process-wide purge budget, shared by application and background threads.
+ *
+ * The budget is a token bucket holding up to one second's worth of
+ * opt_purge_rate bytes.  Each non-exhaustive purge takes what it is about to
+ * purge from the bucket before it starts and returns whatever it did not use
+ * afterwards; an extent larger than the grant still gets purged whole, so the
+ * bucket may briefly go negative and later purges wait for it to refill.
+ * Exhaustive purges (arena.<i>.purge, arena destruction, maximal memory
+ * pressure) bypass the budget.
+ *
+ * When background threads are enabled, application threads may only take
+ * opt_purge_inline_share percent of the tokens currently available, leaving
+ * the bulk of the work to the background threads.
+ */
+
+/* Percentage of the budget that an application thread may take at once. */
+#define PURGE_INLINE_SHARE_DEFAULT	10
+
+typedef struct purge_budget_stats_s purge_budget_stats_t;
+struct purge_budget_stats_s {
+	/* Bytes above the purge limits that the budget currently holds back. */
+	size_t debt;
+	/* Number of purges that were cut short by the budget. */
+	uint64_t nthrottled;
+	/* Duration of the longest single purge, in nanoseconds. */
+	uint64_t max_duration;
+};
+
+/* Both in bytes; 0 means unlimited. */
+extern size_t opt_purge_rate;
+extern size_t opt_purge_call_max;
+extern size_t opt_purge_inline_share;
+
+void purge_budget_boot(void);
+/*
+ * Returns how many of the wanted bytes may be purged now, and takes them from
+ * the budget.  The grant is a multiple of the page size.
+ */
+size_t purge_budget_take(size_t wanted, bool is_background_thread);
+/* Settles a grant once the number of bytes actually purged is known. */
+void purge_budget_settle(size_t granted, size_t purged);
+/* Adjusts the global debt by the change in one decay state's debt. */
+void purge_budget_debt_update(size_t debt_old, size_t debt_new);
+void purge_budget_duration_record(uint64_t duration);
+void purge_budget_stats_read(purge_budget_stats_t *stats);
+
+static inline bool
+purge_budget_enabled(void) {
+	return (opt_purge_rate != 0 || opt_purge_call_max != 0);
+}
+
+#endif /* JEMALLOC_INTERNAL_PURGE_BUDGET_H */
@@ -0,0 +1,50 @@
+#ifndef JEMALLOC_INTERNAL_RSEQ_H
+#define JEMALLOC_INTERNAL_RSEQ_H
+
+#include "jemalloc/internal/rseq_tsd.h"
+#include "jemalloc/internal/tsd.h"
+
+/*
+ * Restartable sequences give each thread the number of the CPU it runs on for
+ * the cost of a load, and let short critical sections operate on per-CPU data
+ * without atomics: the kernel restarts a sequence at its abort handler instead
+ * of resuming it if the thread was preempted, migrated or signaled.
+ *
+ * glibc 2.35 and later register an area for every thread, which we then use;
+ * otherwise each thread registers one of its own on first use.  Only Linux on
+ * x86-64 is supported.  Elsewhere, and for threads whose registration failed,
+ * the area reads as RSEQ_CPU_ID_REGISTRATION_FAILED.
+ */
+#if defined(__linux__) && defined(__x86_64__) && defined(JEMALLOC_TLS) && \
+    defined(SYS_rseq)
+#  define JEMALLOC_HAVE_RSEQ
+#endif
+
+#ifdef JEMALLOC_HAVE_RSEQ
+static const bool have_rseq = true;
+#else
+static const bool have_rseq = false;
+#endif
+
+/* Signature that precedes every abort handler; the same as glibc's. */
+#define RSEQ_SIG	0x53053053
+
+void rseq_boot(void);
+rseq_area_t *rseq_area_register(tsd_t *tsd);
+
+JEMALLOC_ALWAYS_INLINE rseq_area_t *
+rseq_area_get(tsd_t *tsd) {
+	rseq_area_t *area = tsd_rseq_area_get(tsd);
+	if (unlikely(area == NULL)) {
+		area = rseq_area_register(tsd);
+	}
+	return area;
+}
+
+/* Returns the current CPU, or a negative value if rseq is unavailable. */
+JEMALLOC_ALWAYS_INLINE int32_t
+rseq_cpu_id_get(const rseq_area_t *area) {
+	return (int32_t)*(const volatile uint32_t *)&area->cpu_id;
+}
+
+#endif /* JEMALLOC_INTERNAL_RSEQ_H */
@@ -0,0 +1,23 @@
+#ifndef JEMALLOC_INTERNAL_RSEQ_TSD_H
+#define JEMALLOC_INTERNAL_RSEQ_TSD_H
+
+/*
+ * Per thread area shared with the kernel by rseq(2) (restartable sequences).
+ * Its layout is the kernel ABI (struct rseq in linux/rseq.h); only the fields
+ * that every kernel version provides are declared.  The kernel keeps cpu_id
+ * up to date whenever the thread returns to user space, and aborts the
+ * critical section that rseq_cs points to if the thread gets preempted,
+ * migrated or signaled before reaching its end.
+ */
+#define RSEQ_CPU_ID_UNINITIALIZED	((uint32_t)-1)
+#define RSEQ_CPU_ID_REGISTRATION_FAILED	((uint32_t)-2)
+
+typedef struct rseq_area_s rseq_area_t;
+struct rseq_area_s {
+	uint32_t	cpu_id_start;
+	uint32_t	cpu_id;
+	uint64_t	rseq_cs;
+	uint32_t	flags;
+} JEMALLOC_ALIGNED(32);
+
+#endif /* JEMALLOC_INTERNAL_RSEQ_TSD_H */
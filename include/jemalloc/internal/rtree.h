@@ -85,6 +85,15 @@ struct rtree_s {
 #else
 	rtree_leaf_elm_t	root[1U << (RTREE_NSB/RTREE_HEIGHT)];
 #endif
+	/*
+	 * Leaf with one element per page of [flat_base, flat_base + flat_size),
+	 * which keys in that range index directly instead of going through the
+	 * tree and the rtree_ctx caches.  Empty unless set up via
+	 * rtree_flat_init().
+	 */
+	uintptr_t		flat_base;
+	size_t			flat_size;
+	rtree_leaf_elm_t	*flat;
 };
 
 /*
@@ -110,6 +119,7 @@ static const rtree_level_t rtree_levels[] = {
 };
 
 bool rtree_new(rtree_t *rtree, bool zeroed);
+bool rtree_flat_init(rtree_t *rtree, void *base, size_t size);
 
 typedef rtree_node_elm_t *(rtree_node_alloc_t)(tsdn_t *, rtree_t *, size_t);
 extern rtree_node_alloc_t *JET_MUTABLE rtree_node_alloc;
@@ -329,25 +339,58 @@ rtree_leaf_elm_lookup(tsdn_t *tsdn, rtree_t *rtree, rtree_ctx_t *rtree_ctx,
 	assert(key != 0);
 	assert(!dependent || !init_missing);
 
+	/* Fastest path: the flat leaf, if key lies in its range. */
+	if (key - rtree->flat_base < rtree->flat_size) {
+		return &rtree->flat[(key - rtree->flat_base) >> LG_PAGE];
+	}
+
 	size_t slot = rtree_cache_direct_map(key);
 	uintptr_t leafkey = rtree_leafkey(key);
 	assert(leafkey != RTREE_LEAFKEY_INVALID);
+	rtree_ctx_cache_elm_t *set = &rtree_ctx->cache[slot * RTREE_CTX_NWAYS];
 
-	/* Fast path: L1 direct mapped cache. */
-	if (likely(rtree_ctx->cache[slot].leafkey == leafkey)) {
-		rtree_leaf_elm_t *leaf = rtree_ctx->cache[slot].leaf;
+	/* Fast path: the most recently used way of the L1 set. */
+	if (likely(set[0].leafkey == leafkey)) {
+		rtree_leaf_elm_t *leaf = set[0].leaf;
 		/* ANDROID CHANGE: Bad pointers return NULL */
 		/* assert(leaf != NULL); */
 		if (leaf == NULL) {
 			return NULL;
 		}
 		/* ANDROID END CHANGE */
+#ifdef ANDROID_RTREE_CTX_STATS
+		rtree_ctx->nhits++;
+#endif
 		uintptr_t subkey = rtree_subkey(key, RTREE_HEIGHT-1);
 		return &leaf[subkey];
 	}
+	/* Search the remaining ways, and move the matching one to the front. */
+	for (unsigned i = 1; i < RTREE_CTX_NWAYS; i++) {
+		if (set[i].leafkey == leafkey) {
+			rtree_leaf_elm_t *leaf = set[i].leaf;
+			/* ANDROID CHANGE: Bad pointers return NULL */
+			if (leaf == NULL) {
+				return NULL;
+			}
+			/* ANDROID END CHANGE */
+			memmove(&set[1], &set[0], sizeof(rtree_ctx_cache_elm_t)
+			    * i);
+			set[0].leafkey = leafkey;
+			set[0].leaf = leaf;
+#ifdef ANDROID_RTREE_CTX_STATS
+			rtree_ctx->nhits++;
+#endif
+			uintptr_t subkey = rtree_subkey(key, RTREE_HEIGHT-1);
+			return &leaf[subkey];
+		}
+	}
+#ifdef ANDROID_RTREE_CTX_STATS
+	rtree_ctx->nmisses++;
+#endif
 	/*
-	 * Search the L2 LRU cache.  On hit, swap the matching element into the
-	 * slot in L1 cache, and move the position in L2 up by 1.
+	 * Search the L2 LRU cache.  On hit, move the matching element to the
+	 * front of the L1 set, evict the set's last way into L2, and move the
+	 * position in L2 up by 1.
 	 */
 #define RTREE_CACHE_CHECK_L2(i) do {					\
 	if (likely(rtree_ctx->l2_cache[i].leafkey == leafkey)) {	\
@@ -358,6 +401,13 @@ rtree_leaf_elm_lookup(tsdn_t *tsdn, rtree_t *rtree, rtree_ctx_t *rtree_ctx,
 			return NULL;					\
 		}							\
 		/* ANDROID END CHANGE */				\
+		rtree_ctx_cache_elm_t victim =				\
+		    set[RTREE_CTX_NWAYS - 1];				\
+		if (RTREE_CTX_NWAYS > 1) {				\
+			memmove(&set[1], &set[0],			\
+			    sizeof(rtree_ctx_cache_elm_t) *		\
+			    (RTREE_CTX_NWAYS - 1));			\
+		}							\
 		if (i > 0) {						\
 			/* Bubble up by one. */				\
 			rtree_ctx->l2_cache[i].leafkey =		\
@@ -365,17 +415,15 @@ rtree_leaf_elm_lookup(tsdn_t *tsdn, rtree_t *rtree, rtree_ctx_t *rtree_ctx,
 			rtree_ctx->l2_cache[i].leaf =			\
 				rtree_ctx->l2_cache[i - 1].leaf;	\
 			rtree_ctx->l2_cache[i - 1].leafkey =		\
-			    rtree_ctx->cache[slot].leafkey;		\
-			rtree_ctx->l2_cache[i - 1].leaf =		\
-			    rtree_ctx->cache[slot].leaf;		\
+			    victim.leafkey;				\
+			rtree_ctx->l2_cache[i - 1].leaf = victim.leaf;	\
 		} else {						\
 			rtree_ctx->l2_cache[0].leafkey =		\
-			    rtree_ctx->cache[slot].leafkey;		\
-			rtree_ctx->l2_cache[0].leaf =			\
-			    rtree_ctx->cache[slot].leaf;		\
+			    victim.leafkey;				\
+			rtree_ctx->l2_cache[0].leaf = victim.leaf;	\
 		}							\
-		rtree_ctx->cache[slot].leafkey = leafkey;		\
-		rtree_ctx->cache[slot].leaf = leaf;			\
+		set[0].leafkey = leafkey;				\
+		set[0].leaf = leaf;					\
 		uintptr_t subkey = rtree_subkey(key, RTREE_HEIGHT-1);	\
 		return &leaf[subkey];					\
 	}								\
@@ -17,16 +17,38 @@
  * on access but suffers no collision.  Note that, the cache will itself suffer
  * cache misses if made overly large, plus the cost of linear search in the LRU
  * cache.
+ *
+ * The L1 cache can be made set associative, to cope with workloads that
+ * alternate between more leaves than it has sets, at the cost of a short
+ * search on misses in the first way.  Each set is kept in LRU order, and the
+ * entries evicted from a set move on to the L2 cache.
  */
+#if defined(ANDROID_RTREE_CTX_LG_NSETS)
+#define RTREE_CTX_LG_NCACHE ANDROID_RTREE_CTX_LG_NSETS
+#else
 #define RTREE_CTX_LG_NCACHE 4
+#endif
+/* Number of sets in the L1 cache. */
 #define RTREE_CTX_NCACHE (1 << RTREE_CTX_LG_NCACHE)
+#if defined(ANDROID_RTREE_CTX_NWAYS)
+#define RTREE_CTX_NWAYS ANDROID_RTREE_CTX_NWAYS
+#else
+#define RTREE_CTX_NWAYS 1
+#endif
+#if RTREE_CTX_NWAYS < 1
+#error "Unsupported number of rtree_ctx cache ways"
+#endif
 #define RTREE_CTX_NCACHE_L2 8
 
 /*
  * Zero initializer required for tsd initialization only.  Proper initialization
  * done via rtree_ctx_data_init().
  */
+#ifdef ANDROID_RTREE_CTX_STATS
+#define RTREE_CTX_ZERO_INITIALIZER {{{0}}, {{0}}, 0, 0, 0}
+#else
 #define RTREE_CTX_ZERO_INITIALIZER {{{0}}, {{0}}}
+#endif
 
 
 typedef struct rtree_leaf_elm_s rtree_leaf_elm_t;
@@ -39,10 +61,22 @@ struct rtree_ctx_cache_elm_s {
 
 typedef struct rtree_ctx_s rtree_ctx_t;
 struct rtree_ctx_s {
-	/* Direct mapped cache. */
-	rtree_ctx_cache_elm_t	cache[RTREE_CTX_NCACHE];
+	/*
+	 * Set associative cache; the ways of set i are cache[i * RTREE_CTX_NWAYS]
+	 * through cache[(i + 1) * RTREE_CTX_NWAYS - 1], most recently used first.
+	 */
+	rtree_ctx_cache_elm_t	cache[RTREE_CTX_NCACHE * RTREE_CTX_NWAYS];
 	/* L2 LRU cache. */
 	rtree_ctx_cache_elm_t	l2_cache[RTREE_CTX_NCACHE_L2];
+#ifdef ANDROID_RTREE_CTX_STATS
+	/*
+	 * Lookups that hit and missed in L1, and the misses that also missed in
+	 * L2 and walked the tree.
+	 */
+	uint64_t		nhits;
+	uint64_t		nmisses;
+	uint64_t		nhard;
+#endif
 };
 
 void rtree_ctx_data_init(rtree_ctx_t *ctx);
@@ -3,9 +3,11 @@
 
 #include "jemalloc/internal/arena_types.h"
 #include "jemalloc/internal/assert.h"
+#include "jemalloc/internal/extent_tsd.h"
 #include "jemalloc/internal/jemalloc_internal_externs.h"
 #include "jemalloc/internal/prof_types.h"
 #include "jemalloc/internal/ql.h"
+#include "jemalloc/internal/rseq_tsd.h"
 #include "jemalloc/internal/rtree_tsd.h"
 #include "jemalloc/internal/tcache_types.h"
 #include "jemalloc/internal/tcache_structs.h"
@@ -74,6 +76,10 @@ typedef void (*test_callback_t)(int *);
     O(arena,			arena_t *,		arena_t *)	\
     O(arenas_tdata,		arena_tdata_t *,	arena_tdata_t *)\
     O(tcache,			tcache_t,		tcache_t)	\
+    O(extent_cache,		extent_cache_t,		extent_cache_t)	\
+    O(in_background_thread,	bool,			bool)		\
+    O(fork_nheld,		unsigned,		unsigned)	\
+    O(rseq_area,		rseq_area_t *,		rseq_area_t *)	\
     O(witness_tsd,              witness_tsd_t,		witness_tsdn_t)	\
     MALLOC_TEST_TSD
 
@@ -92,6 +98,10 @@ typedef void (*test_callback_t)(int *);
     NULL,								\
     NULL,								\
     TCACHE_ZERO_INITIALIZER,						\
+    EXTENT_CACHE_ZERO_INITIALIZER,					\
+    false,								\
+    0,									\
+    NULL,								\
     WITNESS_TSD_INITIALIZER						\
     MALLOC_TEST_TSD_INITIALIZER						\
 }
@@ -329,6 +329,17 @@ struct extent_hooks_s {
 	extent_merge_t		*merge;
 };
 
+/*
+ * Input to arenas.create, for options that must be in effect before the new
+ * arena's first allocation.
+ */
+typedef struct arena_config_s arena_config_t;
+struct arena_config_s {
+	extent_hooks_t	*extent_hooks;	/* NULL for the default hooks. */
+	bool		prefault;
+	bool		mlock;
+};
+
 /*
  * By default application code must explicitly refer to mangled symbol names,
  * so that it is possible to use jemalloc in conjunction with another allocator
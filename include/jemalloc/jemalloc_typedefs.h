@@ -75,3 +75,16 @@ struct extent_hooks_s {
 	extent_split_t		*split;
 	extent_merge_t		*merge;
 };
+
+/*
+ * Input to arenas.create, for options that must be in effect before the new
+ * arena's first allocation.
+ */
+typedef struct arena_config_s arena_config_t;
+struct arena_config_s {
+	extent_hooks_t	*extent_hooks;	/* NULL for the default hooks. */
+	bool		prefault;
+	bool		mlock;
+	bool		fd_backed;	/* Back the arena with a file. */
+	int		fd;		/* -1 for a new memfd. */
+};
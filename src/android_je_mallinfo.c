@@ -32,14 +32,16 @@ static size_t accumulate_large_allocs(arena_t* arena) {
 }
 
 static size_t accumulate_small_allocs(arena_t* arena) {
+  /* Bin locks may be fork tracked, which requires a tsd. */
+  tsdn_t* tsdn = tsdn_fetch();
   size_t total_bytes = 0;
   for (unsigned j = 0; j < NBINS; j++) {
     bin_t* bin = &arena->bins[j];
 
     /* NOTE: This includes allocations cached on every thread. */
-    malloc_mutex_lock(TSDN_NULL, &bin->lock);
+    malloc_mutex_lock(tsdn, &bin->lock);
     total_bytes += bin_infos[j].reg_size * bin->stats.curregs;
-    malloc_mutex_unlock(TSDN_NULL, &bin->lock);
+    malloc_mutex_unlock(tsdn, &bin->lock);
   }
   return total_bytes;
 }
@@ -102,12 +104,13 @@ struct mallinfo je_mallinfo_bin_info(size_t aidx, size_t bidx) {
     arena_t* arena = atomic_load_p(&arenas[aidx], ATOMIC_ACQUIRE);
     if (arena != NULL) {
       bin_t* bin = &arena->bins[bidx];
+      tsdn_t* tsdn = tsdn_fetch();
 
-      malloc_mutex_lock(TSDN_NULL, &bin->lock);
+      malloc_mutex_lock(tsdn, &bin->lock);
       mi.ordblks = bin_infos[bidx].reg_size * bin->stats.curregs;
       mi.uordblks = (size_t) bin->stats.nmalloc;
       mi.fordblks = (size_t) bin->stats.ndalloc;
-      malloc_mutex_unlock(TSDN_NULL, &bin->lock);
+      malloc_mutex_unlock(tsdn, &bin->lock);
     }
   }
   malloc_mutex_unlock(TSDN_NULL, &arenas_lock);
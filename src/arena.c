@@ -3,10 +3,12 @@
 #include "jemalloc/internal/jemalloc_internal_includes.h"
 
 #include "jemalloc/internal/assert.h"
+#include "jemalloc/internal/cgroup.h"
 #include "jemalloc/internal/div.h"
 #include "jemalloc/internal/extent_dss.h"
 #include "jemalloc/internal/extent_mmap.h"
 #include "jemalloc/internal/mutex.h"
+#include "jemalloc/internal/purge_budget.h"
 #include "jemalloc/internal/rtree.h"
 #include "jemalloc/internal/size_classes.h"
 #include "jemalloc/internal/util.h"
@@ -29,10 +31,38 @@ percpu_arena_mode_t opt_percpu_arena = PERCPU_ARENA_DEFAULT;
 
 ssize_t opt_dirty_decay_ms = DIRTY_DECAY_MS_DEFAULT;
 ssize_t opt_muzzy_decay_ms = MUZZY_DECAY_MS_DEFAULT;
+bool opt_dirty_decay_adaptive = false;
+size_t opt_dirty_decay_refault_target = DIRTY_DECAY_REFAULT_TARGET_DEFAULT;
+size_t opt_empty_slab_cache_max = EMPTY_SLAB_CACHE_MAX_DEFAULT;
+bool opt_extent_steal = false;
+size_t opt_extent_steal_threshold = EXTENT_STEAL_THRESHOLD_DEFAULT;
+size_t opt_retain_trim_threshold = 0;
+size_t opt_retain_trim_ratio = 0;
+unsigned opt_freeze_narenas_max = 0;
+
+const char *purge_policy_names[] = {
+	"smoothstep",
+	"max_dirty",
+	"ratio",
+	"hybrid"
+};
+purge_policy_t opt_purge_policy = PURGE_POLICY_DEFAULT;
+size_t opt_purge_max_dirty = PURGE_MAX_DIRTY_DEFAULT;
+size_t opt_purge_dirty_ratio = PURGE_DIRTY_RATIO_DEFAULT;
+size_t opt_purge_floor = 0;
+
+const char *purge_select_names[] = {
+	"static",
+	"adaptive"
+};
+purge_select_t opt_purge_select = PURGE_SELECT_DEFAULT;
 
 static atomic_zd_t dirty_decay_ms_default;
 static atomic_zd_t muzzy_decay_ms_default;
 
+/* Whether heap.freeze has frozen any arena yet. */
+atomic_b_t arena_heap_frozen = ATOMIC_INIT(false);
+
 const uint64_t h_steps[SMOOTHSTEP_NSTEPS] = {
 #define STEP(step, h, x, y)			\
 		h,
@@ -53,10 +83,16 @@ static void arena_decay_to_limit(tsdn_t *tsdn, arena_t *arena,
     size_t npages_decay_max, bool is_background_thread);
 static bool arena_decay_dirty(tsdn_t *tsdn, arena_t *arena,
     bool is_background_thread, bool all);
+static bool arena_decay_muzzy(tsdn_t *tsdn, arena_t *arena,
+    bool is_background_thread, bool all);
 static void arena_dalloc_bin_slab(tsdn_t *tsdn, arena_t *arena, extent_t *slab,
     bin_t *bin);
 static void arena_bin_lower_slab(tsdn_t *tsdn, arena_t *arena, extent_t *slab,
     bin_t *bin);
+static void arena_bins_empty_slabs_release(tsdn_t *tsdn, arena_t *arena,
+    bool all, bool is_background_thread);
+static bool arena_decay_cap_exceeded(arena_t *arena, arena_decay_t *decay,
+    extents_t *extents);
 
 /******************************************************************************/
 
@@ -93,6 +129,14 @@ arena_stats_merge(tsdn_t *tsdn, arena_t *arena, unsigned *nthreads,
 	    + arena_stats_read_zu(tsdn, &arena->stats, &arena->stats.mapped));
 	arena_stats_accum_zu(&astats->retained,
 	    extents_npages_get(&arena->extents_retained) << LG_PAGE);
+	arena_stats_accum_zu(&astats->retained_peak,
+	    extents_npages_peak_get(&arena->extents_retained) << LG_PAGE);
+	arena_stats_accum_u64(&astats->retained_ntrims,
+	    arena_stats_read_u64(tsdn, &arena->stats,
+	    &arena->stats.retained_ntrims));
+	arena_stats_accum_u64(&astats->retained_trimmed,
+	    arena_stats_read_u64(tsdn, &arena->stats,
+	    &arena->stats.retained_trimmed));
 
 	arena_stats_accum_u64(&astats->decay_dirty.npurge,
 	    arena_stats_read_u64(tsdn, &arena->stats,
@@ -100,6 +144,9 @@ arena_stats_merge(tsdn_t *tsdn, arena_t *arena, unsigned *nthreads,
 	arena_stats_accum_u64(&astats->decay_dirty.nmadvise,
 	    arena_stats_read_u64(tsdn, &arena->stats,
 	    &arena->stats.decay_dirty.nmadvise));
+	arena_stats_accum_u64(&astats->decay_dirty.nmadvise_saved,
+	    arena_stats_read_u64(tsdn, &arena->stats,
+	    &arena->stats.decay_dirty.nmadvise_saved));
 	arena_stats_accum_u64(&astats->decay_dirty.purged,
 	    arena_stats_read_u64(tsdn, &arena->stats,
 	    &arena->stats.decay_dirty.purged));
@@ -110,10 +157,53 @@ arena_stats_merge(tsdn_t *tsdn, arena_t *arena, unsigned *nthreads,
 	arena_stats_accum_u64(&astats->decay_muzzy.nmadvise,
 	    arena_stats_read_u64(tsdn, &arena->stats,
 	    &arena->stats.decay_muzzy.nmadvise));
+	arena_stats_accum_u64(&astats->decay_muzzy.nmadvise_saved,
+	    arena_stats_read_u64(tsdn, &arena->stats,
+	    &arena->stats.decay_muzzy.nmadvise_saved));
 	arena_stats_accum_u64(&astats->decay_muzzy.purged,
 	    arena_stats_read_u64(tsdn, &arena->stats,
 	    &arena->stats.decay_muzzy.purged));
 
+	arena_stats_accum_u64(&astats->nsteals,
+	    arena_stats_read_u64(tsdn, &arena->stats, &arena->stats.nsteals));
+	arena_stats_accum_u64(&astats->stolen,
+	    arena_stats_read_u64(tsdn, &arena->stats, &arena->stats.stolen));
+	arena_stats_accum_u64(&astats->prefaulted,
+	    arena_stats_read_u64(tsdn, &arena->stats,
+	    &arena->stats.prefaulted));
+	arena_stats_accum_u64(&astats->mlocked,
+	    arena_stats_read_u64(tsdn, &arena->stats, &arena->stats.mlocked));
+	for (unsigned i = 0; i < REUSE_AGE_NBUCKETS; i++) {
+		arena_stats_accum_u64(&astats->reuse_ages[i],
+		    arena_stats_read_u64(tsdn, &arena->stats,
+		    &arena->stats.reuse_ages[i]));
+	}
+	arena_stats_accum_u64(&astats->lazy_nselected,
+	    arena_stats_read_u64(tsdn, &arena->stats,
+	    &arena->stats.lazy_nselected));
+	arena_stats_accum_u64(&astats->forced_nselected,
+	    arena_stats_read_u64(tsdn, &arena->stats,
+	    &arena->stats.forced_nselected));
+	arena_stats_accum_u64(&astats->lazy_purged,
+	    arena_stats_read_u64(tsdn, &arena->stats,
+	    &arena->stats.lazy_purged));
+	arena_stats_accum_u64(&astats->lazy_reclaimed,
+	    arena_stats_read_u64(tsdn, &arena->stats,
+	    &arena->stats.lazy_reclaimed));
+	arena_stats_accum_u64(&astats->forced_purged,
+	    arena_stats_read_u64(tsdn, &arena->stats,
+	    &arena->stats.forced_purged));
+	for (unsigned op = 0; op < latency_op_limit; op++) {
+		for (unsigned bg = 0; bg < 2; bg++) {
+			for (unsigned i = 0; i < LATENCY_NBUCKETS; i++) {
+				arena_stats_accum_u64(
+				    &astats->latency[op][bg][i],
+				    arena_stats_read_u64(tsdn, &arena->stats,
+				    &arena->stats.latency[op][bg][i]));
+			}
+		}
+	}
+
 	arena_stats_accum_zu(&astats->base, base_allocated);
 	arena_stats_accum_zu(&astats->internal, arena_internal_get(arena));
 	arena_stats_accum_zu(&astats->metadata_thp, metadata_thp);
@@ -213,8 +303,20 @@ arena_extents_dirty_dalloc(tsdn_t *tsdn, arena_t *arena,
 
 	extents_dalloc(tsdn, arena, r_extent_hooks, &arena->extents_dirty,
 	    extent);
+	if (arena_mlock_get(arena)) {
+		/* Locked arenas are only purged on request. */
+		return;
+	}
 	if (arena_dirty_decay_ms_get(arena) == 0) {
 		arena_decay_dirty(tsdn, arena, false, true);
+	} else if (arena_decay_cap_exceeded(arena, &arena->decay_dirty,
+	    &arena->extents_dirty)) {
+		arena_decay_dirty(tsdn, arena, false, false);
+		/* Lazily purged pages may have pushed muzzy over its cap. */
+		if (arena_decay_cap_exceeded(arena, &arena->decay_muzzy,
+		    &arena->extents_muzzy)) {
+			arena_decay_muzzy(tsdn, arena, false, false);
+		}
 	} else {
 		arena_background_thread_inactivity_check(tsdn, arena, false);
 	}
@@ -324,6 +426,67 @@ arena_large_ralloc_stats_update(tsdn_t *tsdn, arena_t *arena, size_t oldusize,
 	arena_large_malloc_stats_update(tsdn, arena, usize);
 }
 
+static bool
+arena_extent_steal_eligible(arena_t *arena) {
+	/*
+	 * Only automatic arenas take part: they are never destroyed, so extent_t
+	 * structures allocated from a victim's base stay valid.  Custom hooks
+	 * may give extents semantics that do not carry over to another arena,
+	 * and so do locked extents, or arenas that want their memory locked.
+	 */
+	return arena_ind_get(arena) < narenas_auto &&
+	    extent_hooks_get(arena) == &extent_hooks_default &&
+	    !atomic_load_b(&arena->mlocked, ATOMIC_RELAXED);
+}
+
+/*
+ * Tries to satisfy an allocation out of a sibling arena's dirty extents, as a
+ * last resort before mapping new memory.  Victims that hold less than
+ * opt_extent_steal_threshold dirty bytes, or whose extents_dirty is busy, are
+ * skipped.
+ */
+static extent_t *
+arena_extent_steal(tsdn_t *tsdn, arena_t *arena, size_t size, size_t pad,
+    size_t alignment, bool slab, szind_t szind, bool *zero, bool *commit) {
+	if (!opt_extent_steal || !arena_extent_steal_eligible(arena)) {
+		return NULL;
+	}
+
+	unsigned ind = arena_ind_get(arena);
+	unsigned narenas = narenas_auto;
+	for (unsigned i = 1; i < narenas; i++) {
+		arena_t *victim = arena_get(tsdn, (ind + i) % narenas, false);
+		if (victim == NULL || !arena_extent_steal_eligible(victim) ||
+		    (extents_npages_get(&victim->extents_dirty) << LG_PAGE) <
+		    opt_extent_steal_threshold) {
+			continue;
+		}
+		extent_t *extent = extents_steal(tsdn, arena, victim, size, pad,
+		    alignment, slab, szind, zero, commit);
+		if (extent == NULL) {
+			continue;
+		}
+		if (config_stats) {
+			size_t esize = extent_size_get(extent);
+			arena_stats_lock(tsdn, &victim->stats);
+			arena_stats_sub_zu(tsdn, &victim->stats,
+			    &victim->stats.mapped, esize);
+			arena_stats_unlock(tsdn, &victim->stats);
+
+			arena_stats_lock(tsdn, &arena->stats);
+			arena_stats_add_zu(tsdn, &arena->stats,
+			    &arena->stats.mapped, esize);
+			arena_stats_add_u64(tsdn, &arena->stats,
+			    &arena->stats.nsteals, 1);
+			arena_stats_add_u64(tsdn, &arena->stats,
+			    &arena->stats.stolen, esize);
+			arena_stats_unlock(tsdn, &arena->stats);
+		}
+		return extent;
+	}
+	return NULL;
+}
+
 extent_t *
 arena_extent_alloc_large(tsdn_t *tsdn, arena_t *arena, size_t usize,
     size_t alignment, bool *zero) {
@@ -343,6 +506,10 @@ arena_extent_alloc_large(tsdn_t *tsdn, arena_t *arena, size_t usize,
 		    &arena->extents_muzzy, NULL, usize, sz_large_pad, alignment,
 		    false, szind, zero, &commit);
 	}
+	if (extent == NULL) {
+		extent = arena_extent_steal(tsdn, arena, usize, sz_large_pad,
+		    alignment, false, szind, zero, &commit);
+	}
 	size_t size = usize + sz_large_pad;
 	if (extent == NULL) {
 		extent = extent_alloc_wrapper(tsdn, arena, &extent_hooks, NULL,
@@ -467,6 +634,119 @@ arena_decay_backlog_npages_limit(const arena_decay_t *decay) {
 	return npages_limit_backlog;
 }
 
+static purge_policy_t
+arena_decay_policy_read(arena_decay_t *decay) {
+	return (purge_policy_t)atomic_load_u(&decay->policy, ATOMIC_RELAXED);
+}
+
+static size_t
+arena_decay_floor_apply(arena_decay_t *decay, size_t npages_limit) {
+	size_t npages_floor = atomic_load_zu(&decay->floor, ATOMIC_RELAXED) >>
+	    LG_PAGE;
+	return (npages_limit < npages_floor) ? npages_floor : npages_limit;
+}
+
+static size_t
+arena_decay_policy_npages_limit(arena_t *arena, arena_decay_t *decay) {
+	purge_policy_t policy = arena_decay_policy_read(decay);
+	if (policy == purge_policy_smoothstep) {
+		return SIZE_T_MAX;
+	}
+
+	size_t npages_max = atomic_load_zu(&decay->max_dirty, ATOMIC_RELAXED) >>
+	    LG_PAGE;
+	uint64_t npages_ratio = (uint64_t)atomic_load_zu(&arena->nactive,
+	    ATOMIC_RELAXED) * atomic_load_zu(&decay->dirty_ratio,
+	    ATOMIC_RELAXED) / 100;
+	if (npages_ratio > SIZE_T_MAX) {
+		npages_ratio = SIZE_T_MAX;
+	}
+
+	size_t npages_limit;
+	switch (policy) {
+	case purge_policy_max_dirty:
+		npages_limit = npages_max;
+		break;
+	case purge_policy_ratio:
+		npages_limit = (size_t)npages_ratio;
+		break;
+	case purge_policy_hybrid:
+		npages_limit = ((uint64_t)npages_max < npages_ratio) ?
+		    npages_max : (size_t)npages_ratio;
+		break;
+	default:
+		not_reached();
+	}
+	return npages_limit;
+}
+
+/*
+ * The arena's share of the cgroup derived ceiling covers dirty and muzzy pages
+ * together; dirty pages get whatever muzzy pages leave over.
+ */
+static size_t
+arena_decay_cgroup_npages_limit(arena_t *arena, arena_decay_t *decay) {
+	size_t npages_share = cgroup_arena_unpurged_npages_get();
+	if (npages_share == SIZE_T_MAX || decay == &arena->decay_muzzy) {
+		return npages_share;
+	}
+	size_t npages_muzzy = extents_npages_get(&arena->extents_muzzy);
+	return (npages_share > npages_muzzy) ? npages_share - npages_muzzy : 0;
+}
+
+/*
+ * Number of pages the policy and cgroup caps allow to remain unpurged,
+ * regardless of the decay backlog, or SIZE_T_MAX if no cap applies.
+ */
+size_t
+arena_decay_cap_npages_limit(arena_t *arena, arena_decay_t *decay) {
+	size_t npages_limit = arena_decay_policy_npages_limit(arena, decay);
+	size_t npages_cgroup = arena_decay_cgroup_npages_limit(arena, decay);
+	if (npages_cgroup < npages_limit) {
+		npages_limit = npages_cgroup;
+	}
+	if (npages_limit == SIZE_T_MAX) {
+		return SIZE_T_MAX;
+	}
+	return arena_decay_floor_apply(decay, npages_limit);
+}
+
+/*
+ * Number of pages that may remain unpurged under the arena's purge policy.
+ * Time based policies are limited by the backlog, which is only stable across
+ * an epoch, so the caller must hold decay->mtx.
+ */
+static size_t
+arena_decay_npages_limit(tsdn_t *tsdn, arena_t *arena, arena_decay_t *decay) {
+	malloc_mutex_assert_owner(tsdn, &decay->mtx);
+
+	purge_policy_t policy = arena_decay_policy_read(decay);
+	size_t npages_limit = arena_decay_cap_npages_limit(arena, decay);
+	if (policy == purge_policy_smoothstep ||
+	    policy == purge_policy_hybrid) {
+		size_t npages_backlog = arena_decay_floor_apply(decay,
+		    arena_decay_backlog_npages_limit(decay));
+		if (npages_backlog < npages_limit) {
+			npages_limit = npages_backlog;
+		}
+	}
+	return npages_limit;
+}
+
+/*
+ * Caps are enforced as soon as they are exceeded, rather than waiting for the
+ * next decay epoch.
+ */
+static bool
+arena_decay_cap_exceeded(arena_t *arena, arena_decay_t *decay,
+    extents_t *extents) {
+	if (arena_decay_ms_read(decay) <= 0) {
+		return false;
+	}
+	return extents_npages_get(extents) > arena_decay_cap_npages_limit(arena,
+	    decay);
+}
+
 static void
 arena_decay_backlog_update_last(arena_decay_t *decay, size_t current_npages) {
 	size_t npages_delta = (current_npages > decay->nunpurged) ?
@@ -542,13 +822,111 @@ arena_decay_epoch_advance_helper(arena_decay_t *decay, const nstime_t *time,
 	arena_decay_backlog_update(decay, nadvance_u64, current_npages);
 }
 
+static bool
+arena_decay_adaptive_read(arena_decay_t *decay) {
+	return atomic_load_b(&decay->adaptive, ATOMIC_RELAXED);
+}
+
+/*
+ * Fixed-point fraction of the pages dirtied age_us ago that smoothstep decay
+ * with the given decay time would already have purged.
+ */
+static uint64_t
+arena_decay_purged_frac(uint64_t age_us, uint64_t decay_ms) {
+	uint64_t nepochs = age_us * SMOOTHSTEP_NSTEPS / (decay_ms * 1000);
+	if (nepochs >= SMOOTHSTEP_NSTEPS) {
+		return KQU(1) << SMOOTHSTEP_BFP;
+	}
+	return (KQU(1) << SMOOTHSTEP_BFP) - h_steps[SMOOTHSTEP_NSTEPS - 1 -
+	    nepochs];
+}
+
+/*
+ * Number of pages, in SMOOTHSTEP_BFP fixed point, that would have been
+ * purged before their reuse with the given decay time.
+ */
+static uint64_t
+arena_decay_refaults(const size_t *reuse_npages, uint64_t decay_ms) {
+	uint64_t sum = 0;
+	for (unsigned i = 1; i < REUSE_AGE_NBUCKETS; i++) {
+		/* Middle of [2^(i-1), 2^i) ms; ages below 1 ms never count. */
+		uint64_t age_us = (KQU(1500) << (i - 1));
+		sum += (uint64_t)reuse_npages[i] *
+		    arena_decay_purged_frac(age_us, decay_ms);
+	}
+	return sum;
+}
+
+/*
+ * Choose the shortest decay time, doubling from DECAY_ADAPT_MS_MIN up to the
+ * configured time_ms, under which at most opt_dirty_decay_refault_target
+ * percent of the recently dirtied pages would have been purged before being
+ * reused.  Only the epoch length changes; the backlog is kept as is.
+ */
+static void
+arena_decay_adapt(arena_decay_t *decay, const nstime_t *time) {
+	ssize_t decay_ms = arena_decay_ms_read(decay);
+	if (!arena_decay_adaptive_read(decay) || decay_ms <= 0) {
+		return;
+	}
+	nstime_t delta;
+	nstime_copy(&delta, time);
+	if (nstime_compare(&delta, &decay->adapt_epoch) < 0) {
+		nstime_copy(&decay->adapt_epoch, time);
+		return;
+	}
+	nstime_subtract(&delta, &decay->adapt_epoch);
+	if (nstime_msec(&delta) < DECAY_ADAPT_PERIOD_MS) {
+		return;
+	}
+	size_t ndirtied = atomic_load_zu(&decay->dirtied_npages,
+	    ATOMIC_RELAXED);
+	if (ndirtied < DECAY_ADAPT_NPAGES_MIN) {
+		return;
+	}
+	nstime_copy(&decay->adapt_epoch, time);
+
+	size_t reuse_npages[REUSE_AGE_NBUCKETS];
+	for (unsigned i = 0; i < REUSE_AGE_NBUCKETS; i++) {
+		reuse_npages[i] = atomic_load_zu(&decay->reuse_npages[i],
+		    ATOMIC_RELAXED);
+	}
+	uint64_t allowed = ((uint64_t)ndirtied *
+	    opt_dirty_decay_refault_target / 100) << SMOOTHSTEP_BFP;
+	uint64_t chosen_ms = (uint64_t)decay_ms;
+	for (uint64_t ms = DECAY_ADAPT_MS_MIN; ms < (uint64_t)decay_ms;
+	    ms <<= 1) {
+		if (arena_decay_refaults(reuse_npages, ms) <= allowed) {
+			chosen_ms = ms;
+			break;
+		}
+	}
+	if ((ssize_t)chosen_ms != atomic_load_zd(&decay->adaptive_ms,
+	    ATOMIC_RELAXED)) {
+		atomic_store_zd(&decay->adaptive_ms, (ssize_t)chosen_ms,
+		    ATOMIC_RELAXED);
+		nstime_init(&decay->interval, chosen_ms * KQU(1000000));
+		nstime_idivide(&decay->interval, SMOOTHSTEP_NSTEPS);
+		arena_decay_deadline_init(decay);
+	}
+
+	/* Age the windows, so that the choice follows phase changes. */
+	for (unsigned i = 0; i < REUSE_AGE_NBUCKETS; i++) {
+		atomic_fetch_sub_zu(&decay->reuse_npages[i], reuse_npages[i] / 2,
+		    ATOMIC_RELAXED);
+	}
+	atomic_fetch_sub_zu(&decay->dirtied_npages, ndirtied / 2,
+	    ATOMIC_RELAXED);
+}
+
 static void
 arena_decay_epoch_advance(tsdn_t *tsdn, arena_t *arena, arena_decay_t *decay,
     extents_t *extents, const nstime_t *time, bool is_background_thread) {
 	size_t current_npages = extents_npages_get(extents);
 	arena_decay_epoch_advance_helper(decay, time, current_npages);
+	arena_decay_adapt(decay, time);
 
-	size_t npages_limit = arena_decay_backlog_npages_limit(decay);
+	size_t npages_limit = arena_decay_npages_limit(tsdn, arena, decay);
 	/* We may unlock decay->mtx when try_purge(). Finish logging first. */
 	decay->nunpurged = (npages_limit > current_npages) ? npages_limit :
 	    current_npages;
@@ -556,12 +934,18 @@ arena_decay_epoch_advance(tsdn_t *tsdn, arena_t *arena, arena_decay_t *decay,
 	if (!background_thread_enabled() || is_background_thread) {
 		arena_decay_try_purge(tsdn, arena, decay, extents,
 		    current_npages, npages_limit, is_background_thread);
+	} else {
+		/* Caps are enforced without waiting for the background thread. */
+		arena_decay_try_purge(tsdn, arena, decay, extents,
+		    current_npages, arena_decay_cap_npages_limit(arena, decay),
+		    is_background_thread);
 	}
 }
 
 static void
 arena_decay_reinit(arena_decay_t *decay, ssize_t decay_ms) {
 	arena_decay_ms_write(decay, decay_ms);
+	atomic_store_zd(&decay->adaptive_ms, decay_ms, ATOMIC_RELAXED);
 	if (decay_ms > 0) {
 		nstime_init(&decay->interval, (uint64_t)decay_ms *
 		    KQU(1000000));
@@ -570,9 +954,11 @@ arena_decay_reinit(arena_decay_t *decay, ssize_t decay_ms) {
 
 	nstime_init(&decay->epoch, 0);
 	nstime_update(&decay->epoch);
+	nstime_copy(&decay->adapt_epoch, &decay->epoch);
 	decay->jitter_state = (uint64_t)(uintptr_t)decay;
 	arena_decay_deadline_init(decay);
 	decay->nunpurged = 0;
+	nstime_copy(&decay->empty_slabs_deadline, &decay->epoch);
 	memset(decay->backlog, 0, SMOOTHSTEP_NSTEPS * sizeof(size_t));
 }
 
@@ -590,7 +976,15 @@ arena_decay_init(arena_decay_t *decay, ssize_t decay_ms,
 		return true;
 	}
 	decay->purging = false;
+	decay->npages_debt = 0;
+	atomic_store_b(&decay->adaptive, false, ATOMIC_RELAXED);
 	arena_decay_reinit(decay, decay_ms);
+	atomic_store_u(&decay->policy, (unsigned)opt_purge_policy,
+	    ATOMIC_RELAXED);
+	atomic_store_zu(&decay->max_dirty, opt_purge_max_dirty, ATOMIC_RELAXED);
+	atomic_store_zu(&decay->dirty_ratio, opt_purge_dirty_ratio,
+	    ATOMIC_RELAXED);
+	atomic_store_zu(&decay->floor, opt_purge_floor, ATOMIC_RELAXED);
 	/* Memory is zeroed, so there is no need to clear stats. */
 	if (config_stats) {
 		decay->stats = stats;
@@ -642,6 +1036,7 @@ arena_maybe_decay(tsdn_t *tsdn, arena_t *arena, arena_decay_t *decay,
 		 */
 		nstime_copy(&decay->epoch, &time);
 		arena_decay_deadline_init(decay);
+		nstime_copy(&decay->empty_slabs_deadline, &decay->epoch);
 	} else {
 		/* Verify that time does not go backwards. */
 		assert(nstime_compare(&decay->epoch, &time) <= 0);
@@ -661,7 +1056,12 @@ arena_maybe_decay(tsdn_t *tsdn, arena_t *arena, arena_decay_t *decay,
 	} else if (is_background_thread) {
 		arena_decay_try_purge(tsdn, arena, decay, extents,
 		    extents_npages_get(extents),
-		    arena_decay_backlog_npages_limit(decay),
+		    arena_decay_npages_limit(tsdn, arena, decay),
+		    is_background_thread);
+	} else {
+		arena_decay_try_purge(tsdn, arena, decay, extents,
+		    extents_npages_get(extents),
+		    arena_decay_cap_npages_limit(arena, decay),
 		    is_background_thread);
 	}
 
@@ -683,6 +1083,109 @@ arena_muzzy_decay_ms_get(arena_t *arena) {
 	return arena_decay_ms_get(&arena->decay_muzzy);
 }
 
+bool
+arena_dirty_decay_adaptive_get(arena_t *arena) {
+	return arena_decay_adaptive_read(&arena->decay_dirty);
+}
+
+/*
+ * Turning adaptive decay off goes back to the configured decay time right
+ * away; turning it on starts from it and adapts once enough reuse has been
+ * observed.
+ */
+void
+arena_dirty_decay_adaptive_set(tsdn_t *tsdn, arena_t *arena, bool adaptive) {
+	arena_decay_t *decay = &arena->decay_dirty;
+	malloc_mutex_lock(tsdn, &decay->mtx);
+	if (adaptive != arena_decay_adaptive_read(decay)) {
+		atomic_store_b(&decay->adaptive, adaptive, ATOMIC_RELAXED);
+		for (unsigned i = 0; i < REUSE_AGE_NBUCKETS; i++) {
+			atomic_store_zu(&decay->reuse_npages[i], 0,
+			    ATOMIC_RELAXED);
+		}
+		atomic_store_zu(&decay->dirtied_npages, 0, ATOMIC_RELAXED);
+		arena_decay_reinit(decay, arena_decay_ms_read(decay));
+		arena_maybe_decay(tsdn, arena, decay, &arena->extents_dirty,
+		    false);
+	}
+	malloc_mutex_unlock(tsdn, &decay->mtx);
+}
+
+ssize_t
+arena_dirty_decay_ms_effective_get(arena_t *arena) {
+	return atomic_load_zd(&arena->decay_dirty.adaptive_ms, ATOMIC_RELAXED);
+}
+
+/*
+ * Called as npages dirty pages are returned to the arena.  Returns the time
+ * to stamp them with, or 0 if reuse ages are not being sampled.
+ */
+uint64_t
+arena_decay_reuse_stamp(arena_t *arena, size_t npages) {
+	arena_decay_t *decay = &arena->decay_dirty;
+	if (!arena_decay_adaptive_read(decay)) {
+		return 0;
+	}
+	atomic_fetch_add_zu(&decay->dirtied_npages, npages, ATOMIC_RELAXED);
+	nstime_t now;
+	nstime_init(&now, 0);
+	nstime_update(&now);
+	return nstime_ns(&now);
+}
+
+/* Called as npages pages stamped at stamp get reused. */
+void
+arena_decay_reuse_sample(tsdn_t *tsdn, arena_t *arena, uint64_t stamp,
+    size_t npages) {
+	arena_decay_t *decay = &arena->decay_dirty;
+	if (!arena_decay_adaptive_read(decay)) {
+		return;
+	}
+	nstime_t now;
+	nstime_init(&now, 0);
+	nstime_update(&now);
+	uint64_t age_ms = (nstime_ns(&now) > stamp) ? (nstime_ns(&now) - stamp)
+	    / KQU(1000000) : 0;
+	unsigned ind;
+	if (age_ms >= (KQU(1) << (REUSE_AGE_NBUCKETS - 2))) {
+		ind = REUSE_AGE_NBUCKETS - 1;
+	} else {
+		ind = (age_ms == 0) ? 0 : lg_floor((size_t)age_ms) + 1;
+	}
+	atomic_fetch_add_zu(&decay->reuse_npages[ind], npages, ATOMIC_RELAXED);
+	if (config_stats) {
+		arena_stats_lock(tsdn, &arena->stats);
+		arena_stats_add_u64(tsdn, &arena->stats,
+		    &arena->stats.reuse_ages[ind], npages);
+		arena_stats_unlock(tsdn, &arena->stats);
+	}
+}
+
+/* Account an operation that started at start to the latency histograms. */
+void
+arena_latency_record(tsdn_t *tsdn, arena_t *arena, latency_op_t op,
+    const nstime_t *start) {
+	assert(config_stats);
+	assert(op < latency_op_limit);
+
+	nstime_t now;
+	nstime_init(&now, 0);
+	nstime_update_precise(&now);
+	uint64_t us = (nstime_compare(&now, start) > 0) ? (nstime_ns(&now) -
+	    nstime_ns(start)) / KQU(1000) : 0;
+	unsigned ind;
+	if (us >= (KQU(1) << (LATENCY_NBUCKETS - 2))) {
+		ind = LATENCY_NBUCKETS - 1;
+	} else {
+		ind = (us == 0) ? 0 : lg_floor((size_t)us) + 1;
+	}
+	unsigned bg = background_thread_is_current(tsdn) ? 1 : 0;
+	arena_stats_lock(tsdn, &arena->stats);
+	arena_stats_add_u64(tsdn, &arena->stats,
+	    &arena->stats.latency[op][bg][ind], 1);
+	arena_stats_unlock(tsdn, &arena->stats);
+}
+
 static bool
 arena_decay_ms_set(tsdn_t *tsdn, arena_t *arena, arena_decay_t *decay,
     extents_t *extents, ssize_t decay_ms) {
@@ -739,54 +1242,252 @@ arena_stash_decayed(tsdn_t *tsdn, arena_t *arena,
 	return nstashed;
 }
 
+/* Purge a single stashed extent and hand it to its next owner. */
+static void
+arena_decay_stashed_extent(tsdn_t *tsdn, arena_t *arena,
+    extent_hooks_t **r_extent_hooks, bool lazy, extent_t *extent,
+    bool is_background_thread, size_t *r_nunmapped) {
+	if (lazy && !extent_purge_lazy_wrapper(tsdn, arena, r_extent_hooks,
+	    extent, 0, extent_size_get(extent))) {
+		extents_dalloc(tsdn, arena, r_extent_hooks,
+		    &arena->extents_muzzy, extent);
+		arena_background_thread_inactivity_check(tsdn, arena,
+		    is_background_thread);
+		return;
+	}
+	size_t npages = extent_size_get(extent) >> LG_PAGE;
+	extent_dalloc_wrapper(tsdn, arena, r_extent_hooks, extent);
+	if (config_stats) {
+		*r_nunmapped += npages;
+	}
+}
+
+static bool
+arena_decay_batchable(arena_t *arena, extent_hooks_t **r_extent_hooks,
+    bool lazy, extent_t *extent) {
+	if (lazy) {
+		return (*r_extent_hooks == &extent_hooks_default &&
+		    pages_purge_batch_enabled(true));
+	}
+	return (pages_purge_batch_enabled(false) &&
+	    extent_dalloc_batchable(arena, r_extent_hooks, extent));
+}
+
+/*
+ * Purge a batch of stashed extents with a single syscall.  The extents are
+ * sorted by address so that adjacent ones can share a range.
+ */
+static void
+arena_decay_stashed_batch(tsdn_t *tsdn, arena_t *arena,
+    extent_hooks_t **r_extent_hooks, bool lazy, extent_t **batch,
+    size_t nbatch, bool is_background_thread, size_t *r_nmadvise,
+    size_t *r_nmadvise_saved, size_t *r_nunmapped) {
+	/* Insertion sort; batches are small and mostly address ordered. */
+	for (size_t i = 1; i < nbatch; i++) {
+		extent_t *extent = batch[i];
+		size_t j;
+		for (j = i; j > 0 && (uintptr_t)extent_base_get(batch[j - 1]) >
+		    (uintptr_t)extent_base_get(extent); j--) {
+			batch[j] = batch[j - 1];
+		}
+		batch[j] = extent;
+	}
+
+	pages_range_t ranges[PAGES_PURGE_BATCH_MAX];
+	size_t nranges = 0;
+	for (size_t i = 0; i < nbatch; i++) {
+		void *addr = extent_base_get(batch[i]);
+		size_t size = extent_size_get(batch[i]);
+		if (nranges > 0 && (uintptr_t)ranges[nranges - 1].addr +
+		    ranges[nranges - 1].size == (uintptr_t)addr) {
+			ranges[nranges - 1].size += size;
+		} else {
+			ranges[nranges].addr = addr;
+			ranges[nranges].size = size;
+			nranges++;
+		}
+	}
+
+	nstime_t start;
+	if (config_stats) {
+		nstime_init(&start, 0);
+		nstime_update_precise(&start);
+	}
+	bool err = pages_purge_batch(ranges, nranges, lazy);
+	if (config_stats && pages_purge_batch_enabled(lazy)) {
+		arena_latency_record(tsdn, arena, latency_op_purge, &start);
+	}
+	if (err) {
+		for (size_t i = 0; i < nbatch; i++) {
+			arena_decay_stashed_extent(tsdn, arena, r_extent_hooks,
+			    lazy, batch[i], is_background_thread, r_nunmapped);
+		}
+		if (config_stats) {
+			*r_nmadvise += nbatch;
+		}
+		return;
+	}
+	if (config_stats) {
+		(*r_nmadvise)++;
+		*r_nmadvise_saved += nbatch - 1;
+	}
+
+	for (size_t i = 0; i < nbatch; i++) {
+		extent_t *extent = batch[i];
+		if (lazy) {
+			extents_dalloc(tsdn, arena, r_extent_hooks,
+			    &arena->extents_muzzy, extent);
+			arena_background_thread_inactivity_check(tsdn, arena,
+			    is_background_thread);
+		} else {
+			size_t npages = extent_size_get(extent) >> LG_PAGE;
+			extent_dalloc_purged_wrapper(tsdn, arena,
+			    r_extent_hooks, extent);
+			if (config_stats) {
+				*r_nunmapped += npages;
+			}
+		}
+	}
+}
+
+/*
+ * Whether to purge a batch of dirty pages lazily.  Lazily purged pages keep
+ * being charged to the process until the kernel reclaims them, so while memory
+ * is short, adaptive selection only keeps purging lazily if the kernel was
+ * seen to reclaim such pages promptly.  Samples only come from lazily purged
+ * pages, so an occasional lazy purge keeps them from going stale.
+ */
+static bool
+arena_decay_lazy_select(arena_t *arena) {
+	if (arena_purge_select_get(arena) == purge_select_static) {
+		return true;
+	}
+	if (background_thread_pressure_level() == 0 &&
+	    !cgroup_headroom_low_get()) {
+		return true;
+	}
+	size_t nsampled = atomic_load_zu(&arena->lazy_nsampled, ATOMIC_RELAXED);
+	size_t nreclaimed = atomic_load_zu(&arena->lazy_nreclaimed,
+	    ATOMIC_RELAXED);
+	if (nsampled >= PURGE_SELECT_NSAMPLED_MIN && nreclaimed * 100 >=
+	    nsampled * PURGE_SELECT_RECLAIM_RATIO) {
+		return true;
+	}
+	if (atomic_fetch_add_u(&arena->lazy_nforced, 1, ATOMIC_RELAXED) + 1 >=
+	    PURGE_SELECT_RESAMPLE_INTERVAL) {
+		atomic_store_u(&arena->lazy_nforced, 0, ATOMIC_RELAXED);
+		return true;
+	}
+	return false;
+}
+
+/*
+ * Sample how much of a lazily purged extent the kernel has already reclaimed,
+ * and return the estimate for the whole extent, in pages.
+ */
+static size_t
+arena_decay_lazy_sample(arena_t *arena, extent_t *extent) {
+	size_t npages = extent_size_get(extent) >> LG_PAGE;
+	size_t nsampled = (npages < PURGE_SELECT_SAMPLE_NPAGES) ? npages :
+	    PURGE_SELECT_SAMPLE_NPAGES;
+	size_t nresident;
+	if (pages_nresident(extent_base_get(extent), nsampled << LG_PAGE,
+	    &nresident)) {
+		return 0;
+	}
+	size_t nreclaimed = nsampled - nresident;
+	if (atomic_fetch_add_zu(&arena->lazy_nsampled, nsampled,
+	    ATOMIC_RELAXED) + nsampled > PURGE_SELECT_NSAMPLED_MAX) {
+		/* Halve the window; racing samples only skew it slightly. */
+		size_t n = atomic_load_zu(&arena->lazy_nsampled,
+		    ATOMIC_RELAXED);
+		atomic_fetch_sub_zu(&arena->lazy_nsampled, n / 2,
+		    ATOMIC_RELAXED);
+		n = atomic_load_zu(&arena->lazy_nreclaimed, ATOMIC_RELAXED);
+		atomic_fetch_sub_zu(&arena->lazy_nreclaimed, n / 2,
+		    ATOMIC_RELAXED);
+	}
+	atomic_fetch_add_zu(&arena->lazy_nreclaimed, nreclaimed,
+	    ATOMIC_RELAXED);
+	return nreclaimed * npages / nsampled;
+}
+
 static size_t
 arena_decay_stashed(tsdn_t *tsdn, arena_t *arena,
     extent_hooks_t **r_extent_hooks, arena_decay_t *decay, extents_t *extents,
     bool all, extent_list_t *decay_extents, bool is_background_thread) {
-	UNUSED size_t nmadvise, nunmapped;
+	UNUSED size_t nmadvise, nmadvise_saved, nunmapped;
 	size_t npurged;
 
 	if (config_stats) {
 		nmadvise = 0;
+		nmadvise_saved = 0;
 		nunmapped = 0;
 	}
 	npurged = 0;
 
-	ssize_t muzzy_decay_ms = arena_muzzy_decay_ms_get(arena);
+	bool lazy, sample;
+	switch (extents_state_get(extents)) {
+	case extent_state_dirty:
+		lazy = (!all && arena_muzzy_decay_ms_get(arena) != 0 &&
+		    arena_decay_lazy_select(arena));
+		sample = false;
+		break;
+	case extent_state_muzzy:
+		lazy = false;
+		/* Custom hooks need not purge lazily with madvise(). */
+		sample = (arena_purge_select_get(arena) ==
+		    purge_select_adaptive && *r_extent_hooks ==
+		    &extent_hooks_default);
+		break;
+	case extent_state_active:
+	case extent_state_retained:
+	default:
+		not_reached();
+	}
+
+	/*
+	 * Extents that the default hooks would purge with plain madvise() are
+	 * collected into batches; everything else is purged one at a time.
+	 */
+	extent_t *batch[PAGES_PURGE_BATCH_MAX];
+	size_t nbatch = 0;
+	size_t nreclaimed = 0;
+	/* madvise() rejects locked pages. */
+	bool munlock = atomic_load_b(&arena->mlocked, ATOMIC_RELAXED);
 	for (extent_t *extent = extent_list_first(decay_extents); extent !=
 	    NULL; extent = extent_list_first(decay_extents)) {
-		if (config_stats) {
-			nmadvise++;
-		}
-		size_t npages = extent_size_get(extent) >> LG_PAGE;
-		npurged += npages;
+		npurged += extent_size_get(extent) >> LG_PAGE;
 		extent_list_remove(decay_extents, extent);
-		switch (extents_state_get(extents)) {
-		case extent_state_active:
-			not_reached();
-		case extent_state_dirty:
-			if (!all && muzzy_decay_ms != 0 &&
-			    !extent_purge_lazy_wrapper(tsdn, arena,
-			    r_extent_hooks, extent, 0,
-			    extent_size_get(extent))) {
-				extents_dalloc(tsdn, arena, r_extent_hooks,
-				    &arena->extents_muzzy, extent);
-				arena_background_thread_inactivity_check(tsdn,
-				    arena, is_background_thread);
-				break;
-			}
-			/* Fall through. */
-		case extent_state_muzzy:
-			extent_dalloc_wrapper(tsdn, arena, r_extent_hooks,
-			    extent);
-			if (config_stats) {
-				nunmapped += npages;
+		if (munlock) {
+			pages_munlock(extent_base_get(extent),
+			    extent_size_get(extent));
+		}
+		if (sample) {
+			nreclaimed += arena_decay_lazy_sample(arena, extent);
+		}
+		if (arena_decay_batchable(arena, r_extent_hooks, lazy,
+		    extent)) {
+			batch[nbatch++] = extent;
+			if (nbatch == PAGES_PURGE_BATCH_MAX) {
+				arena_decay_stashed_batch(tsdn, arena,
+				    r_extent_hooks, lazy, batch, nbatch,
+				    is_background_thread, &nmadvise,
+				    &nmadvise_saved, &nunmapped);
+				nbatch = 0;
 			}
-			break;
-		case extent_state_retained:
-		default:
-			not_reached();
+			continue;
 		}
+		if (config_stats) {
+			nmadvise++;
+		}
+		arena_decay_stashed_extent(tsdn, arena, r_extent_hooks, lazy,
+		    extent, is_background_thread, &nunmapped);
+	}
+	if (nbatch > 0) {
+		arena_decay_stashed_batch(tsdn, arena, r_extent_hooks, lazy,
+		    batch, nbatch, is_background_thread, &nmadvise,
+		    &nmadvise_saved, &nunmapped);
 	}
 
 	if (config_stats) {
@@ -795,10 +1496,22 @@ arena_decay_stashed(tsdn_t *tsdn, arena_t *arena,
 		    1);
 		arena_stats_add_u64(tsdn, &arena->stats,
 		    &decay->stats->nmadvise, nmadvise);
+		arena_stats_add_u64(tsdn, &arena->stats,
+		    &decay->stats->nmadvise_saved, nmadvise_saved);
 		arena_stats_add_u64(tsdn, &arena->stats, &decay->stats->purged,
 		    npurged);
 		arena_stats_sub_zu(tsdn, &arena->stats, &arena->stats.mapped,
 		    nunmapped << LG_PAGE);
+		if (extents_state_get(extents) == extent_state_dirty) {
+			arena_stats_add_u64(tsdn, &arena->stats, lazy ?
+			    &arena->stats.lazy_nselected :
+			    &arena->stats.forced_nselected, 1);
+			arena_stats_add_u64(tsdn, &arena->stats, lazy ?
+			    &arena->stats.lazy_purged :
+			    &arena->stats.forced_purged, npurged << LG_PAGE);
+		}
+		arena_stats_add_u64(tsdn, &arena->stats,
+		    &arena->stats.lazy_reclaimed, nreclaimed << LG_PAGE);
 		arena_stats_unlock(tsdn, &arena->stats);
 	}
 
@@ -820,27 +1533,70 @@ arena_decay_to_limit(tsdn_t *tsdn, arena_t *arena, arena_decay_t *decay,
 	    WITNESS_RANK_CORE, 1);
 	malloc_mutex_assert_owner(tsdn, &decay->mtx);
 
-	if (decay->purging) {
+	/* Locked arenas are only purged exhaustively, i.e. on request. */
+	if (decay->purging || (!all && arena_mlock_get(arena))) {
 		return;
 	}
 	decay->purging = true;
 	malloc_mutex_unlock(tsdn, &decay->mtx);
 
+	nstime_t start;
+	if (config_stats) {
+		nstime_init(&start, 0);
+		nstime_update_precise(&start);
+	}
+
+	/* Exhaustive purges are never held back by the budget. */
+	bool budgeted = (!all && purge_budget_enabled());
+	size_t npages_budget = budgeted ? purge_budget_take(npages_decay_max <<
+	    LG_PAGE, is_background_thread) >> LG_PAGE : npages_decay_max;
+
 	extent_hooks_t *extent_hooks = extent_hooks_get(arena);
 
 	extent_list_t decay_extents;
 	extent_list_init(&decay_extents);
 
-	size_t npurge = arena_stash_decayed(tsdn, arena, &extent_hooks, extents,
-	    npages_limit, npages_decay_max, &decay_extents);
+	size_t npurge = 0;
+	if (npages_budget != 0) {
+		npurge = arena_stash_decayed(tsdn, arena, &extent_hooks,
+		    extents, npages_limit, npages_budget, &decay_extents);
+	}
 	if (npurge != 0) {
 		UNUSED size_t npurged = arena_decay_stashed(tsdn, arena,
 		    &extent_hooks, decay, extents, all, &decay_extents,
 		    is_background_thread);
 		assert(npurged == npurge);
+		if (config_stats) {
+			nstime_t duration;
+			nstime_init(&duration, 0);
+			nstime_update_precise(&duration);
+			if (nstime_compare(&duration, &start) > 0) {
+				nstime_subtract(&duration, &start);
+				purge_budget_duration_record(
+				    nstime_ns(&duration));
+			}
+		}
+	}
+	if (budgeted) {
+		purge_budget_settle(npages_budget << LG_PAGE, npurge <<
+		    LG_PAGE);
+	}
+	if (config_stats) {
+		arena_latency_record(tsdn, arena, latency_op_decay, &start);
 	}
 
+	/*
+	 * Only a purge that used up its whole grant was actually held back; a
+	 * shorter one ran out of extents above the limit.
+	 */
+	size_t npages_debt = (npages_budget < npages_decay_max && npurge >=
+	    npages_budget && npurge < npages_decay_max) ? npages_decay_max -
+	    npurge : 0;
+
 	malloc_mutex_lock(tsdn, &decay->mtx);
+	purge_budget_debt_update(decay->npages_debt << LG_PAGE, npages_debt <<
+	    LG_PAGE);
+	decay->npages_debt = npages_debt;
 	decay->purging = false;
 }
 
@@ -856,6 +1612,11 @@ arena_decay_impl(tsdn_t *tsdn, arena_t *arena, arena_decay_t *decay,
 		return false;
 	}
 
+	/*
+	 * Done before taking decay->mtx, so that the file reads never stall
+	 * threads waiting on it.
+	 */
+	cgroup_maybe_refresh(tsdn);
 	if (malloc_mutex_trylock(tsdn, &decay->mtx)) {
 		/* No need to wait if another thread is in progress. */
 		return true;
@@ -863,17 +1624,36 @@ arena_decay_impl(tsdn_t *tsdn, arena_t *arena, arena_decay_t *decay,
 
 	bool epoch_advanced = arena_maybe_decay(tsdn, arena, decay, extents,
 	    is_background_thread);
-	UNUSED size_t npages_new;
+	UNUSED size_t npages_new = 0;
 	if (epoch_advanced) {
 		/* Backlog is updated on epoch advance. */
 		npages_new = decay->backlog[SMOOTHSTEP_NSTEPS-1];
 	}
+	/* Pages the purge budget held back are left to the background thread. */
+	size_t npages_debt = decay->npages_debt;
+	/*
+	 * Walk the bins' empty slabs once per decay time, rather than on every
+	 * epoch, so that the bin locks are rarely taken.
+	 */
+	bool release_slabs = epoch_advanced && decay == &arena->decay_dirty &&
+	    nstime_compare(&decay->epoch, &decay->empty_slabs_deadline) >= 0;
+	if (release_slabs) {
+		nstime_copy(&decay->empty_slabs_deadline, &decay->interval);
+		nstime_imultiply(&decay->empty_slabs_deadline,
+		    SMOOTHSTEP_NSTEPS);
+		nstime_add(&decay->empty_slabs_deadline, &decay->epoch);
+	}
 	malloc_mutex_unlock(tsdn, &decay->mtx);
 
+	if (release_slabs) {
+		arena_bins_empty_slabs_release(tsdn, arena, false,
+		    is_background_thread);
+	}
+
 	if (have_background_thread && background_thread_enabled() &&
-	    epoch_advanced && !is_background_thread) {
+	    (epoch_advanced || npages_debt > 0) && !is_background_thread) {
 		background_thread_interval_check(tsdn, arena, decay,
-		    npages_new);
+		    npages_new + npages_debt);
 	}
 
 	return false;
@@ -895,12 +1675,54 @@ arena_decay_muzzy(tsdn_t *tsdn, arena_t *arena, bool is_background_thread,
 
 void
 arena_decay(tsdn_t *tsdn, arena_t *arena, bool is_background_thread, bool all) {
+	if (all) {
+		/* Release retained empty slabs so that they get purged too. */
+		arena_bins_empty_slabs_release(tsdn, arena, true,
+		    is_background_thread);
+	}
 	if (arena_decay_dirty(tsdn, arena, is_background_thread, all)) {
 		return;
 	}
 	arena_decay_muzzy(tsdn, arena, is_background_thread, all);
 }
 
+static void
+arena_decay_accelerate_impl(tsdn_t *tsdn, arena_t *arena,
+    arena_decay_t *decay, extents_t *extents, unsigned lg_shrink) {
+	if (malloc_mutex_trylock(tsdn, &decay->mtx)) {
+		return;
+	}
+	/* Keep the epoch and backlog current before purging past them. */
+	arena_maybe_decay(tsdn, arena, decay, extents, true);
+	size_t current_npages = extents_npages_get(extents);
+	size_t npages_limit = arena_decay_floor_apply(decay,
+	    current_npages >> lg_shrink);
+	if (arena_decay_ms_read(decay) > 0) {
+		size_t npages_decay = arena_decay_npages_limit(tsdn, arena,
+		    decay);
+		if (npages_decay < npages_limit) {
+			npages_limit = npages_decay;
+		}
+	}
+	arena_decay_try_purge(tsdn, arena, decay, extents, current_npages,
+	    npages_limit, true);
+	malloc_mutex_unlock(tsdn, &decay->mtx);
+}
+
+/*
+ * Purge faster than decay alone would, e.g. under memory pressure.  Each decay
+ * state keeps at most 1/2^lg_shrink of its current unused pages, subject to
+ * the purge floor.  Only called from background threads.
+ */
+void
+arena_decay_accelerate(tsdn_t *tsdn, arena_t *arena, unsigned lg_shrink) {
+	arena_bins_empty_slabs_release(tsdn, arena, true, true);
+	arena_decay_accelerate_impl(tsdn, arena, &arena->decay_dirty,
+	    &arena->extents_dirty, lg_shrink);
+	arena_decay_accelerate_impl(tsdn, arena, &arena->decay_muzzy,
+	    &arena->extents_muzzy, lg_shrink);
+}
+
 static void
 arena_slab_dalloc(tsdn_t *tsdn, arena_t *arena, extent_t *slab) {
 	arena_nactive_sub(arena, extent_size_get(slab) >> LG_PAGE);
@@ -932,6 +1754,99 @@ arena_bin_slabs_nonfull_tryget(bin_t *bin) {
 	return slab;
 }
 
+/*
+ * Retain an empty slab for direct reuse if the bin's empty slab budget allows
+ * it.  Returns true if the slab was retained.
+ */
+static bool
+arena_bin_slabs_empty_insert(arena_t *arena, bin_t *bin, extent_t *slab) {
+	assert(extent_nfree_get(slab) == bin_infos[extent_szind_get(slab)].nregs);
+	/*
+	 * Retained slabs are only released by decay epochs, which do not occur
+	 * unless decay is time-based.
+	 */
+	if (arena_dirty_decay_ms_get(arena) <= 0) {
+		return false;
+	}
+	if ((bin->nslabs_empty + 1) * extent_size_get(slab) >
+	    opt_empty_slab_cache_max) {
+		return false;
+	}
+	extent_list_append(&bin->slabs_empty, slab);
+	bin->nslabs_empty++;
+	if (config_stats) {
+		bin->stats.curslabs_empty++;
+	}
+	return true;
+}
+
+static extent_t *
+arena_bin_slabs_empty_tryget(bin_t *bin) {
+	/* Reuse the most recently emptied (warmest) slab. */
+	extent_t *slab = extent_list_last(&bin->slabs_empty);
+	if (slab == NULL) {
+		return NULL;
+	}
+	extent_list_remove(&bin->slabs_empty, slab);
+	bin->nslabs_empty--;
+	if (bin->nslabs_empty_idle > bin->nslabs_empty) {
+		bin->nslabs_empty_idle = bin->nslabs_empty;
+	}
+	if (config_stats) {
+		bin->stats.curslabs_empty--;
+		bin->stats.reslabs++;
+	}
+	return slab;
+}
+
+/*
+ * Release the empty slabs that have been idle since the previous call (or all
+ * of them), and mark the remaining ones as idle.
+ */
+static void
+arena_bins_empty_slabs_release(tsdn_t *tsdn, arena_t *arena, bool all,
+    bool is_background_thread) {
+	for (unsigned i = 0; i < NBINS; i++) {
+		bin_t *bin = &arena->bins[i];
+		extent_list_t released;
+		extent_list_init(&released);
+		malloc_mutex_lock(tsdn, &bin->lock);
+		size_t nrelease = all ? bin->nslabs_empty :
+		    bin->nslabs_empty_idle;
+		for (size_t j = 0; j < nrelease; j++) {
+			extent_t *slab = extent_list_first(&bin->slabs_empty);
+			extent_list_remove(&bin->slabs_empty, slab);
+			extent_list_append(&released, slab);
+		}
+		bin->nslabs_empty -= nrelease;
+		bin->nslabs_empty_idle = bin->nslabs_empty;
+		if (config_stats) {
+			bin->stats.curslabs_empty -= nrelease;
+			bin->stats.curslabs -= nrelease;
+		}
+		malloc_mutex_unlock(tsdn, &bin->lock);
+
+		extent_t *slab;
+		while ((slab = extent_list_first(&released)) != NULL) {
+			extent_list_remove(&released, slab);
+			if (!is_background_thread) {
+				arena_slab_dalloc(tsdn, arena, slab);
+				continue;
+			}
+			/*
+			 * The background thread is about to decay anyway, and
+			 * must not wake itself up through the usual dalloc
+			 * checks, which would take its own mutex again.
+			 */
+			arena_nactive_sub(arena, extent_size_get(slab) >>
+			    LG_PAGE);
+			extent_hooks_t *extent_hooks = EXTENT_HOOKS_INITIALIZER;
+			extents_dalloc(tsdn, arena, &extent_hooks,
+			    &arena->extents_dirty, slab);
+		}
+	}
+}
+
 static void
 arena_bin_slabs_full_insert(arena_t *arena, bin_t *bin, extent_t *slab) {
 	assert(extent_nfree_get(slab) == 0);
@@ -1016,6 +1931,14 @@ arena_reset(tsd_t *tsd, arena_t *arena) {
 			arena_slab_dalloc(tsd_tsdn(tsd), arena, slab);
 			malloc_mutex_lock(tsd_tsdn(tsd), &bin->lock);
 		}
+		while ((slab = extent_list_first(&bin->slabs_empty)) != NULL) {
+			extent_list_remove(&bin->slabs_empty, slab);
+			malloc_mutex_unlock(tsd_tsdn(tsd), &bin->lock);
+			arena_slab_dalloc(tsd_tsdn(tsd), arena, slab);
+			malloc_mutex_lock(tsd_tsdn(tsd), &bin->lock);
+		}
+		bin->nslabs_empty = 0;
+		bin->nslabs_empty_idle = 0;
 		for (slab = extent_list_first(&bin->slabs_full); slab != NULL;
 		    slab = extent_list_first(&bin->slabs_full)) {
 			arena_bin_slabs_full_remove(arena, bin, slab);
@@ -1026,11 +1949,96 @@ arena_reset(tsd_t *tsd, arena_t *arena) {
 		if (config_stats) {
 			bin->stats.curregs = 0;
 			bin->stats.curslabs = 0;
+			bin->stats.curslabs_empty = 0;
+		}
+		malloc_mutex_unlock(tsd_tsdn(tsd), &bin->lock);
+	}
+
+	atomic_store_zu(&arena->nactive, 0, ATOMIC_RELAXED);
+}
+
+/*
+ * Number of retained pages the arena may keep under opt.retain_trim_threshold
+ * and opt.retain_trim_ratio, or SIZE_T_MAX if neither is set.
+ */
+static size_t
+arena_retained_npages_limit(arena_t *arena) {
+	size_t limit = SIZE_T_MAX;
+	if (opt_retain_trim_threshold != 0) {
+		limit = opt_retain_trim_threshold >> LG_PAGE;
+	}
+	if (opt_retain_trim_ratio != 0 && opt_retain_trim_ratio < 100) {
+		/*
+		 * Retained pages may make up ratio% of the arena's address
+		 * space; the rest of it is in use or cached (nused pages), so
+		 * nretained <= nused * ratio / (100 - ratio).
+		 */
+		size_t nused = atomic_load_zu(&arena->nactive, ATOMIC_RELAXED) +
+		    extents_npages_get(&arena->extents_dirty) +
+		    extents_npages_get(&arena->extents_muzzy);
+		/* Page counts leave room for the multiplication. */
+		size_t ratio_limit = nused * opt_retain_trim_ratio /
+		    (100 - opt_retain_trim_ratio);
+		if (ratio_limit < limit) {
+			limit = ratio_limit;
 		}
-		malloc_mutex_unlock(tsd_tsdn(tsd), &bin->lock);
 	}
+	return limit;
+}
 
-	atomic_store_zu(&arena->nactive, 0, ATOMIC_RELAXED);
+/*
+ * Unmap the least recently used retained extents while the arena retains more
+ * than its limit or, if need is non-zero (when mapping memory failed), until
+ * need bytes have been given back.  Mappings then start growing from small
+ * again.  Returns whether address space was given back or the next mapping
+ * shrank.
+ */
+bool
+arena_retained_trim(tsdn_t *tsdn, arena_t *arena, size_t need) {
+	if (!opt_retain) {
+		return false;
+	}
+	size_t npages = extents_npages_get(&arena->extents_retained);
+	size_t npages_limit;
+	if (need == 0) {
+		npages_limit = arena_retained_npages_limit(arena);
+	} else {
+		size_t npages_need = need >> LG_PAGE;
+		/*
+		 * Unmapping less than the request would not make room for it,
+		 * so in that case only shrink the next mapping.
+		 */
+		npages_limit = (npages >= npages_need) ? npages - npages_need :
+		    npages;
+	}
+	size_t trimmed = 0;
+	if (npages > npages_limit) {
+		extent_hooks_t *extent_hooks = extent_hooks_get(arena);
+		trimmed = extent_retained_trim(tsdn, arena, &extent_hooks,
+		    npages_limit);
+	}
+	if (trimmed == 0 && need == 0) {
+		return false;
+	}
+
+	bool shrunk = false;
+	pszind_t grow_min = sz_psz2ind(HUGEPAGE);
+	malloc_mutex_lock(tsdn, &arena->extent_grow_mtx);
+	if (arena->extent_grow_next > grow_min) {
+		arena->extent_grow_next = grow_min;
+		shrunk = true;
+	}
+	malloc_mutex_unlock(tsdn, &arena->extent_grow_mtx);
+
+	if (config_stats && trimmed != 0) {
+		arena_stats_lock(tsdn, &arena->stats);
+		arena_stats_add_u64(tsdn, &arena->stats,
+		    &arena->stats.retained_ntrims, 1);
+		arena_stats_add_u64(tsdn, &arena->stats,
+		    &arena->stats.retained_trimmed, trimmed);
+		arena_stats_unlock(tsdn, &arena->stats);
+	}
+	return trimmed != 0 || shrunk;
 }
 
 static void
@@ -1088,6 +2096,67 @@ arena_destroy(tsd_t *tsd, arena_t *arena) {
 	base_delete(tsd_tsdn(tsd), arena->base);
 }
 
+/*
+ * Hands all future allocations that would have chosen the arena over to
+ * successor, so that the memory the arena holds stops being written to.  Its
+ * unused dirty pages are purged, since nothing will reuse them.  successor may
+ * be a frozen arena of the same automatic arena, which serves allocations
+ * again from then on.
+ */
+void
+arena_freeze(tsdn_t *tsdn, arena_t *arena, arena_t *successor) {
+	assert(!arena_is_frozen(arena));
+	assert(arena_is_auto(arena));
+
+	successor->auto_successor = true;
+	atomic_store_p(&successor->successor, NULL, ATOMIC_RELEASE);
+	atomic_store_p(&arena->successor, successor, ATOMIC_RELEASE);
+	atomic_store_b(&arena_heap_frozen, true, ATOMIC_RELEASE);
+	arena_decay(tsdn, arena, false, true);
+}
+
+/*
+ * Returns a frozen arena that can take over from active, the arena currently
+ * serving an automatic arena: one that holds no memory any more, or, once
+ * the automatic arena has opt_freeze_narenas_max arenas, the one holding the
+ * least.  Returns NULL if a new arena should be created instead.
+ */
+arena_t *
+arena_freeze_reusable_get(tsdn_t *tsdn, arena_t *active) {
+	assert(!arena_is_frozen(active));
+
+	arena_t *ret = NULL;
+	size_t ret_nactive = 0;
+	unsigned nslot = 1;
+	unsigned narenas = narenas_total_get();
+	for (unsigned i = 0; i < narenas; i++) {
+		arena_t *arena = arena_get(tsdn, i, false);
+		if (arena == NULL || !arena_is_auto(arena) ||
+		    !arena_is_frozen(arena)) {
+			continue;
+		}
+		arena_t *head = arena;
+		while (arena_is_frozen(head)) {
+			head = arena_successor_get(head);
+		}
+		if (head != active) {
+			continue;
+		}
+		nslot++;
+		size_t nactive = atomic_load_zu(&arena->nactive,
+		    ATOMIC_RELAXED);
+		if (ret == NULL || nactive < ret_nactive) {
+			ret = arena;
+			ret_nactive = nactive;
+		}
+	}
+	if (ret != NULL && (ret_nactive == 0 || (opt_freeze_narenas_max != 0 &&
+	    nslot >= opt_freeze_narenas_max))) {
+		return ret;
+	}
+	return NULL;
+}
+
 static extent_t *
 arena_slab_alloc_hard(tsdn_t *tsdn, arena_t *arena,
     extent_hooks_t **r_extent_hooks, const bin_info_t *bin_info,
@@ -1129,6 +2198,10 @@ arena_slab_alloc(tsdn_t *tsdn, arena_t *arena, szind_t binind,
 		    &arena->extents_muzzy, NULL, bin_info->slab_size, 0, PAGE,
 		    true, binind, &zero, &commit);
 	}
+	if (slab == NULL) {
+		slab = arena_extent_steal(tsdn, arena, bin_info->slab_size, 0,
+		    PAGE, true, binind, &zero, &commit);
+	}
 	if (slab == NULL) {
 		slab = arena_slab_alloc_hard(tsdn, arena, &extent_hooks,
 		    bin_info, szind);
@@ -1159,6 +2232,10 @@ arena_bin_nonfull_slab_get(tsdn_t *tsdn, arena_t *arena, bin_t *bin,
 	if (slab != NULL) {
 		return slab;
 	}
+	slab = arena_bin_slabs_empty_tryget(bin);
+	if (slab != NULL) {
+		return slab;
+	}
 	/* No existing slabs have any space available. */
 
 	bin_info = &bin_infos[binind];
@@ -1222,8 +2299,11 @@ arena_bin_malloc_hard(tsdn_t *tsdn, arena_t *arena, bin_t *bin,
 				 * a region were just deallocated from the slab.
 				 */
 				if (extent_nfree_get(slab) == bin_info->nregs) {
-					arena_dalloc_bin_slab(tsdn, arena, slab,
-					    bin);
+					if (!arena_bin_slabs_empty_insert(arena,
+					    bin, slab)) {
+						arena_dalloc_bin_slab(tsdn,
+						    arena, slab, bin);
+					}
 				} else {
 					arena_bin_lower_slab(tsdn, arena, slab,
 					    bin);
@@ -1249,7 +2329,15 @@ arena_bin_malloc_hard(tsdn_t *tsdn, arena_t *arena, bin_t *bin,
 void
 arena_tcache_fill_small(tsdn_t *tsdn, arena_t *arena, tcache_t *tcache,
     cache_bin_t *tbin, szind_t binind, uint64_t prof_accumbytes) {
-	unsigned i, nfill;
+	arena_cache_bin_fill_small(tsdn, arena, tbin, binind,
+	    tcache_bin_info[binind].ncached_max >> tcache->lg_fill_div[binind],
+	    prof_accumbytes);
+}
+
+void
+arena_cache_bin_fill_small(tsdn_t *tsdn, arena_t *arena, cache_bin_t *tbin,
+    szind_t binind, unsigned nfill, uint64_t prof_accumbytes) {
+	unsigned i;
 	bin_t *bin;
 
 	assert(tbin->ncached == 0);
@@ -1259,8 +2347,7 @@ arena_tcache_fill_small(tsdn_t *tsdn, arena_t *arena, tcache_t *tcache,
 	}
 	bin = &arena->bins[binind];
 	malloc_mutex_lock(tsdn, &bin->lock);
-	for (i = 0, nfill = (tcache_bin_info[binind].ncached_max >>
-	    tcache->lg_fill_div[binind]); i < nfill; i++) {
+	for (i = 0; i < nfill; i++) {
 		extent_t *slab;
 		void *ptr;
 		if ((slab = bin->slabcur) != NULL && extent_nfree_get(slab) >
@@ -1545,7 +2632,9 @@ arena_dalloc_bin_locked_impl(tsdn_t *tsdn, arena_t *arena, extent_t *slab,
 	unsigned nfree = extent_nfree_get(slab);
 	if (nfree == bin_info->nregs) {
 		arena_dissociate_bin_slab(arena, slab, bin);
-		arena_dalloc_bin_slab(tsdn, arena, slab, bin);
+		if (!arena_bin_slabs_empty_insert(arena, bin, slab)) {
+			arena_dalloc_bin_slab(tsdn, arena, slab, bin);
+		}
 	} else if (nfree == 1 && slab != bin->slabcur) {
 		arena_bin_slabs_full_remove(arena, bin, slab);
 		arena_bin_lower_slab(tsdn, arena, slab, bin);
@@ -1687,6 +2776,161 @@ arena_dss_prec_set(arena_t *arena, dss_prec_t dss_prec) {
 	return false;
 }
 
+extent_reuse_t
+arena_extent_reuse_get(arena_t *arena) {
+	return (extent_reuse_t)atomic_load_u(&arena->extent_reuse,
+	    ATOMIC_RELAXED);
+}
+
+void
+arena_extent_reuse_set(arena_t *arena, extent_reuse_t extent_reuse) {
+	assert(extent_reuse < extent_reuse_limit);
+	atomic_store_u(&arena->extent_reuse, (unsigned)extent_reuse,
+	    ATOMIC_RELAXED);
+}
+
+purge_policy_t
+arena_purge_policy_get(arena_t *arena) {
+	return arena_decay_policy_read(&arena->decay_dirty);
+}
+
+/*
+ * Policy changes take effect immediately: both decay states are reevaluated
+ * against the new limits, which may purge pages right away.
+ */
+static void
+arena_purge_policy_update(tsdn_t *tsdn, arena_t *arena) {
+	malloc_mutex_lock(tsdn, &arena->decay_dirty.mtx);
+	arena_maybe_decay(tsdn, arena, &arena->decay_dirty,
+	    &arena->extents_dirty, false);
+	malloc_mutex_unlock(tsdn, &arena->decay_dirty.mtx);
+	malloc_mutex_lock(tsdn, &arena->decay_muzzy.mtx);
+	arena_maybe_decay(tsdn, arena, &arena->decay_muzzy,
+	    &arena->extents_muzzy, false);
+	malloc_mutex_unlock(tsdn, &arena->decay_muzzy.mtx);
+}
+
+void
+arena_purge_policy_set(tsdn_t *tsdn, arena_t *arena, purge_policy_t policy) {
+	assert(policy < purge_policy_limit);
+	atomic_store_u(&arena->decay_dirty.policy, (unsigned)policy,
+	    ATOMIC_RELAXED);
+	atomic_store_u(&arena->decay_muzzy.policy, (unsigned)policy,
+	    ATOMIC_RELAXED);
+	arena_purge_policy_update(tsdn, arena);
+}
+
+size_t
+arena_purge_max_dirty_get(arena_t *arena) {
+	return atomic_load_zu(&arena->decay_dirty.max_dirty, ATOMIC_RELAXED);
+}
+
+void
+arena_purge_max_dirty_set(tsdn_t *tsdn, arena_t *arena, size_t max_dirty) {
+	atomic_store_zu(&arena->decay_dirty.max_dirty, max_dirty,
+	    ATOMIC_RELAXED);
+	atomic_store_zu(&arena->decay_muzzy.max_dirty, max_dirty,
+	    ATOMIC_RELAXED);
+	arena_purge_policy_update(tsdn, arena);
+}
+
+size_t
+arena_purge_dirty_ratio_get(arena_t *arena) {
+	return atomic_load_zu(&arena->decay_dirty.dirty_ratio, ATOMIC_RELAXED);
+}
+
+void
+arena_purge_dirty_ratio_set(tsdn_t *tsdn, arena_t *arena, size_t dirty_ratio) {
+	atomic_store_zu(&arena->decay_dirty.dirty_ratio, dirty_ratio,
+	    ATOMIC_RELAXED);
+	atomic_store_zu(&arena->decay_muzzy.dirty_ratio, dirty_ratio,
+	    ATOMIC_RELAXED);
+	arena_purge_policy_update(tsdn, arena);
+}
+
+size_t
+arena_purge_floor_get(arena_t *arena) {
+	return atomic_load_zu(&arena->decay_dirty.floor, ATOMIC_RELAXED);
+}
+
+void
+arena_purge_floor_set(tsdn_t *tsdn, arena_t *arena, size_t floor) {
+	atomic_store_zu(&arena->decay_dirty.floor, floor, ATOMIC_RELAXED);
+	atomic_store_zu(&arena->decay_muzzy.floor, floor, ATOMIC_RELAXED);
+	arena_purge_policy_update(tsdn, arena);
+}
+
+purge_select_t
+arena_purge_select_get(arena_t *arena) {
+	return (purge_select_t)atomic_load_u(&arena->purge_select,
+	    ATOMIC_RELAXED);
+}
+
+void
+arena_purge_select_set(arena_t *arena, purge_select_t purge_select) {
+	assert(purge_select < purge_select_limit);
+	atomic_store_u(&arena->purge_select, (unsigned)purge_select,
+	    ATOMIC_RELAXED);
+}
+
+bool
+arena_prefault_get(arena_t *arena) {
+	return atomic_load_b(&arena->prefault, ATOMIC_RELAXED);
+}
+
+void
+arena_prefault_set(arena_t *arena, bool prefault) {
+	atomic_store_b(&arena->prefault, prefault, ATOMIC_RELAXED);
+}
+
+bool
+arena_mlock_get(arena_t *arena) {
+	return atomic_load_b(&arena->mlock, ATOMIC_RELAXED);
+}
+
+void
+arena_mlock_set(arena_t *arena, bool mlock) {
+	if (mlock) {
+		/* Set first, so that no locked extent escapes munlock. */
+		atomic_store_b(&arena->mlocked, true, ATOMIC_RELAXED);
+	}
+	atomic_store_b(&arena->mlock, mlock, ATOMIC_RELAXED);
+}
+
+/*
+ * Called on extents that did not come from extents_dirty, whose pages may not
+ * be resident.  Locking comes first, so that prefaulted pages are locked as
+ * they are faulted in.  Failing to lock (e.g. past RLIMIT_MEMLOCK) is not an
+ * error; the pages merely stay pageable.
+ */
+void
+arena_extent_populate(tsdn_t *tsdn, arena_t *arena, extent_t *extent) {
+	bool prefault = arena_prefault_get(arena);
+	bool mlock = arena_mlock_get(arena);
+	if ((!prefault && !mlock) || !extent_committed_get(extent)) {
+		return;
+	}
+
+	void *addr = extent_base_get(extent);
+	size_t size = extent_size_get(extent);
+	bool mlocked = (mlock && !pages_mlock(addr, size));
+	if (prefault) {
+		pages_prefault(addr, size);
+	}
+	if (config_stats) {
+		arena_stats_lock(tsdn, &arena->stats);
+		if (prefault) {
+			arena_stats_add_u64(tsdn, &arena->stats,
+			    &arena->stats.prefaulted, size);
+		}
+		if (mlocked) {
+			arena_stats_add_u64(tsdn, &arena->stats,
+			    &arena->stats.mlocked, size);
+		}
+		arena_stats_unlock(tsdn, &arena->stats);
+	}
+}
+
 ssize_t
 arena_dirty_decay_ms_default_get(void) {
 	return atomic_load_zd(&dirty_decay_ms_default, ATOMIC_RELAXED);
@@ -1762,6 +3006,53 @@ arena_extent_sn_next(arena_t *arena) {
 	return atomic_fetch_add_zu(&arena->extent_sn_next, 1, ATOMIC_RELAXED);
 }
 
+/*
+ * With opt_fork_skip_quiescent, points every mutex that arena_prefork*()
+ * acquires at the arena's fork epoch.  The arena starts out as used; the fork
+ * epoch cannot change while it is being initialized, since arenas_lock and
+ * ctl_mtx are acquired before any fork.
+ *
+ * Arena 0 is never tracked, and thus always locked for forks: a0malloc() and
+ * a0dalloc() lock its mutexes without a tsd, which could not record the
+ * tracked mutexes held (see malloc_mutex_fork_enter()).
+ */
+static void
+arena_fork_track_init(arena_t *arena) {
+	atomic_store_zu(&arena->fork_epoch, atomic_load_zu(
+	    &malloc_mutex_fork_epoch, ATOMIC_RELAXED), ATOMIC_RELAXED);
+	arena->fork_locked = true;
+	if (!opt_fork_skip_quiescent || arena_ind_get(arena) == 0) {
+		return;
+	}
+
+	atomic_zu_t *fork_epoch = &arena->fork_epoch;
+	malloc_mutex_fork_track(&arena->decay_dirty.mtx, fork_epoch);
+	malloc_mutex_fork_track(&arena->decay_muzzy.mtx, fork_epoch);
+	if (config_stats) {
+		malloc_mutex_fork_track(&arena->tcache_ql_mtx, fork_epoch);
+	}
+	malloc_mutex_fork_track(&arena->extent_grow_mtx, fork_epoch);
+	malloc_mutex_fork_track(&arena->extents_dirty.mtx, fork_epoch);
+	malloc_mutex_fork_track(&arena->extents_muzzy.mtx, fork_epoch);
+	malloc_mutex_fork_track(&arena->extents_retained.mtx, fork_epoch);
+	malloc_mutex_fork_track(&arena->extent_avail_mtx, fork_epoch);
+	malloc_mutex_fork_track(&arena->base->mtx, fork_epoch);
+	malloc_mutex_fork_track(&arena->large_mtx, fork_epoch);
+	for (unsigned i = 0; i < NBINS; i++) {
+		malloc_mutex_fork_track(&arena->bins[i].lock, fork_epoch);
+	}
+}
+
+/*
+ * Returns whether the arena has been used in the given fork epoch, i.e. since
+ * the previous fork.  Untracked arenas always count as used.
+ */
+bool
+arena_fork_used(arena_t *arena, size_t epoch) {
+	return arena_ind_get(arena) == 0 ||
+	    atomic_load_zu(&arena->fork_epoch, ATOMIC_SEQ_CST) == epoch;
+}
+
 arena_t *
 arena_new(tsdn_t *tsdn, unsigned ind, extent_hooks_t *extent_hooks) {
 	arena_t *arena;
@@ -1785,6 +3076,8 @@ arena_new(tsdn_t *tsdn, unsigned ind, extent_hooks_t *extent_hooks) {
 	atomic_store_u(&arena->nthreads[0], 0, ATOMIC_RELAXED);
 	atomic_store_u(&arena->nthreads[1], 0, ATOMIC_RELAXED);
 	arena->last_thd = NULL;
+	atomic_store_p(&arena->successor, NULL, ATOMIC_RELAXED);
+	arena->auto_successor = false;
 
 	if (config_stats) {
 		if (arena_stats_init(tsdn, &arena->stats)) {
@@ -1821,6 +3114,16 @@ arena_new(tsdn_t *tsdn, unsigned ind, extent_hooks_t *extent_hooks) {
 
 	atomic_store_u(&arena->dss_prec, (unsigned)extent_dss_prec_get(),
 	    ATOMIC_RELAXED);
+	atomic_store_u(&arena->extent_reuse, (unsigned)opt_extent_reuse,
+	    ATOMIC_RELAXED);
+	atomic_store_u(&arena->purge_select, (unsigned)opt_purge_select,
+	    ATOMIC_RELAXED);
+	atomic_store_zu(&arena->lazy_nsampled, 0, ATOMIC_RELAXED);
+	atomic_store_zu(&arena->lazy_nreclaimed, 0, ATOMIC_RELAXED);
+	atomic_store_u(&arena->lazy_nforced, 0, ATOMIC_RELAXED);
+	atomic_store_b(&arena->prefault, false, ATOMIC_RELAXED);
+	atomic_store_b(&arena->mlock, false, ATOMIC_RELAXED);
+	atomic_store_b(&arena->mlocked, false, ATOMIC_RELAXED);
 
 	atomic_store_zu(&arena->nactive, 0, ATOMIC_RELAXED);
 
@@ -1863,6 +3166,8 @@ arena_new(tsdn_t *tsdn, unsigned ind, extent_hooks_t *extent_hooks) {
 	    arena_dirty_decay_ms_default_get(), &arena->stats.decay_dirty)) {
 		goto label_error;
 	}
+	atomic_store_b(&arena->decay_dirty.adaptive, opt_dirty_decay_adaptive,
+	    ATOMIC_RELAXED);
 	if (arena_decay_init(&arena->decay_muzzy,
 	    arena_muzzy_decay_ms_default_get(), &arena->stats.decay_muzzy)) {
 		goto label_error;
@@ -1890,6 +3195,7 @@ arena_new(tsdn_t *tsdn, unsigned ind, extent_hooks_t *extent_hooks) {
 	}
 
 	arena->base = base;
+	arena_fork_track_init(arena);
 	/* Set arena before creating background threads. */
 	arena_set(ind, arena);
 
@@ -1918,6 +3224,208 @@ label_error:
 	return NULL;
 }
 
+typedef bool (arena_extent_visit_t)(tsdn_t *, arena_t *, extent_t *);
+
+/*
+ * Calls visit on every extent of the arena, i.e. its slabs, large allocations
+ * and cached and retained extents, and stops at the first one for which it
+ * returns true.  Slabs and large allocations are all tracked only for manual
+ * arenas.  Returns the number of extents visited successfully, or SIZE_T_MAX
+ * if all were.  The caller guarantees that the arena has no users.
+ */
+static size_t
+arena_extents_visit(tsdn_t *tsdn, arena_t *arena, arena_extent_visit_t *visit,
+    size_t limit) {
+	assert(base_ind_get(arena->base) >= narenas_auto);
+	size_t n = 0;
+	extent_t *extent;
+#define VISIT(extent) do {						\
+	if (n == limit || visit(tsdn, arena, (extent))) {		\
+		goto label_stop;					\
+	}								\
+	n++;								\
+} while (0)
+	for (unsigned i = 0; i < NBINS; i++) {
+		bin_t *bin = &arena->bins[i];
+		if (bin->slabcur != NULL) {
+			VISIT(bin->slabcur);
+		}
+		ql_foreach(extent, &bin->slabs_full, ql_link) {
+			VISIT(extent);
+		}
+		ql_foreach(extent, &bin->slabs_empty, ql_link) {
+			VISIT(extent);
+		}
+		/* Heaps can only be walked by taking them apart. */
+		extent_heap_t slabs_nonfull;
+		extent_heap_new(&slabs_nonfull);
+		bool stop = false;
+		while ((extent = extent_heap_remove_first(&bin->slabs_nonfull))
+		    != NULL) {
+			if (!stop) {
+				if (n == limit || visit(tsdn, arena, extent)) {
+					stop = true;
+				} else {
+					n++;
+				}
+			}
+			extent_heap_insert(&slabs_nonfull, extent);
+		}
+		bin->slabs_nonfull = slabs_nonfull;
+		if (stop) {
+			return n;
+		}
+	}
+	ql_foreach(extent, &arena->large, ql_link) {
+		VISIT(extent);
+	}
+	ql_foreach(extent, &arena->extents_dirty.lru, ql_link) {
+		VISIT(extent);
+	}
+	ql_foreach(extent, &arena->extents_muzzy.lru, ql_link) {
+		VISIT(extent);
+	}
+	ql_foreach(extent, &arena->extents_retained.lru, ql_link) {
+		VISIT(extent);
+	}
+#undef VISIT
+	return SIZE_T_MAX;
+label_stop:
+	return n;
+}
+
+static bool
+arena_extent_attach(tsdn_t *tsdn, arena_t *arena, extent_t *extent) {
+	/* The arena may not get its previous index back. */
+	extent_arena_set(extent, arena);
+	return extent_attach(tsdn, extent);
+}
+
+static bool
+arena_extent_detach(tsdn_t *tsdn, arena_t *arena, extent_t *extent) {
+	extent_detach(tsdn, extent);
+	return false;
+}
+
+/*
+ * Makes an arena that a previous process quiesced (see arena_quiesce()) usable
+ * again at index ind, now that its memory is mapped back at the same address
+ * by extent_hooks.  Everything that refers to the previous process, i.e. the
+ * mutexes, the thread bookkeeping and the extents' rtree entries, is rebuilt.
+ */
+bool
+arena_reattach(tsdn_t *tsdn, unsigned ind, arena_t *arena,
+    extent_hooks_t *extent_hooks) {
+	base_t *base = arena->base;
+	base->ind = ind;
+	atomic_store_p(&base->extent_hooks, extent_hooks, ATOMIC_RELEASE);
+	if (malloc_mutex_init(&base->mtx, "base", WITNESS_RANK_BASE,
+	    malloc_mutex_rank_exclusive)) {
+		return true;
+	}
+
+	atomic_store_u(&arena->nthreads[0], 0, ATOMIC_RELAXED);
+	atomic_store_u(&arena->nthreads[1], 0, ATOMIC_RELAXED);
+	arena->last_thd = NULL;
+	atomic_store_p(&arena->successor, NULL, ATOMIC_RELAXED);
+	arena->auto_successor = false;
+	if (config_stats) {
+#ifndef JEMALLOC_ATOMIC_U64
+		if (malloc_mutex_init(&arena->stats.mtx, "arena_stats",
+		    WITNESS_RANK_ARENA_STATS, malloc_mutex_rank_exclusive)) {
+			return true;
+		}
+#endif
+		ql_new(&arena->tcache_ql);
+		ql_new(&arena->cache_bin_array_descriptor_ql);
+		if (malloc_mutex_init(&arena->tcache_ql_mtx, "tcache_ql",
+		    WITNESS_RANK_TCACHE_QL, malloc_mutex_rank_exclusive)) {
+			return true;
+		}
+	}
+	if (config_prof) {
+		if (prof_accum_init(tsdn, &arena->prof_accum)) {
+			return true;
+		}
+	}
+
+	if (malloc_mutex_init(&arena->large_mtx, "arena_large",
+	    WITNESS_RANK_ARENA_LARGE, malloc_mutex_rank_exclusive)) {
+		return true;
+	}
+	extents_t *extents[] = {&arena->extents_dirty, &arena->extents_muzzy,
+	    &arena->extents_retained};
+	for (unsigned i = 0; i < sizeof(extents) / sizeof(extents[0]); i++) {
+		if (malloc_mutex_init(&extents[i]->mtx, "extents",
+		    WITNESS_RANK_EXTENTS, malloc_mutex_rank_exclusive)) {
+			return true;
+		}
+	}
+	arena_decay_t *decays[] = {&arena->decay_dirty, &arena->decay_muzzy};
+	for (unsigned i = 0; i < sizeof(decays) / sizeof(decays[0]); i++) {
+		if (malloc_mutex_init(&decays[i]->mtx, "decay",
+		    WITNESS_RANK_DECAY, malloc_mutex_rank_exclusive)) {
+			return true;
+		}
+		/* Decay epochs are based on this process's clock. */
+		decays[i]->purging = false;
+		arena_decay_reinit(decays[i], arena_decay_ms_read(decays[i]));
+	}
+	arena->bg_queued = false;
+	if (malloc_mutex_init(&arena->extent_grow_mtx, "extent_grow",
+	    WITNESS_RANK_EXTENT_GROW, malloc_mutex_rank_exclusive)) {
+		return true;
+	}
+	if (malloc_mutex_init(&arena->extent_avail_mtx, "extent_avail",
+	    WITNESS_RANK_EXTENT_AVAIL, malloc_mutex_rank_exclusive)) {
+		return true;
+	}
+	for (unsigned i = 0; i < NBINS; i++) {
+		if (malloc_mutex_init(&arena->bins[i].lock, "bin",
+		    WITNESS_RANK_BIN, malloc_mutex_rank_exclusive)) {
+			return true;
+		}
+	}
+
+	/* Spare extent structures are not registered, only owned. */
+	extent_tree_t extent_avail;
+	extent_avail_new(&extent_avail);
+	extent_t *extent;
+	while ((extent = extent_avail_remove_first(&arena->extent_avail)) !=
+	    NULL) {
+		extent_arena_set(extent, arena);
+		extent_avail_insert(&extent_avail, extent);
+	}
+	arena->extent_avail = extent_avail;
+
+	size_t n = arena_extents_visit(tsdn, arena, arena_extent_attach,
+	    SIZE_T_MAX);
+	if (n != SIZE_T_MAX) {
+		arena_extents_visit(tsdn, arena, arena_extent_detach, n);
+		return true;
+	}
+
+	nstime_init(&arena->create_time, 0);
+	nstime_update(&arena->create_time);
+	arena_fork_track_init(arena);
+	arena_set(ind, arena);
+	return false;
+}
+
+/*
+ * Removes an arena without users from this process, leaving it intact in its
+ * memory for a later arena_reattach().
+ */
+void
+arena_quiesce(tsd_t *tsd, arena_t *arena) {
+	assert(arena_nthreads_get(arena, false) == 0);
+	assert(arena_nthreads_get(arena, true) == 0);
+
+	arena_extents_visit(tsd_tsdn(tsd), arena, arena_extent_detach,
+	    SIZE_T_MAX);
+	arena_set(base_ind_get(arena->base), NULL);
+}
+
 void
 arena_boot(void) {
 	arena_dirty_decay_ms_default_set(opt_dirty_decay_ms);
@@ -2029,6 +3537,13 @@ arena_postfork_child(tsdn_t *tsdn, arena_t *arena) {
 		}
 	}
 
+	/*
+	 * No thread held any of a skipped arena's mutexes at the time of the
+	 * fork, so they are fine as they are.
+	 */
+	if (!arena->fork_locked) {
+		return;
+	}
 	for (i = 0; i < NBINS; i++) {
 		bin_postfork_child(tsdn, &arena->bins[i]);
 	}
@@ -12,6 +12,22 @@
 /* Read-only after initialization. */
 bool opt_background_thread = BACKGROUND_THREAD_DEFAULT;
 size_t opt_max_background_threads = MAX_BACKGROUND_THREAD_LIMIT;
+#ifdef JEMALLOC_BACKGROUND_THREAD
+char opt_background_thread_cpus[BACKGROUND_THREAD_CPUS_MAXLEN + 1] = "";
+#else
+char opt_background_thread_cpus[1];
+#endif
+bool opt_background_thread_sched_idle = false;
+/* Nice value of the background threads; 0 leaves it unchanged. */
+ssize_t opt_background_thread_nice = 0;
+bool opt_psi_purge = false;
+#ifdef JEMALLOC_BACKGROUND_THREAD
+char opt_psi_path[PATH_MAX + 1] = PSI_PATH_DEFAULT;
+#else
+char opt_psi_path[1];
+#endif
+size_t opt_psi_stall_us = PSI_STALL_US_DEFAULT;
+size_t opt_psi_window_us = PSI_WINDOW_US_DEFAULT;
 
 /* Used for thread creation, termination and stats. */
 malloc_mutex_t background_thread_lock;
@@ -58,6 +74,8 @@ bool background_threads_enable(tsd_t *tsd) NOT_REACHED
 bool background_threads_disable(tsd_t *tsd) NOT_REACHED
 void background_thread_interval_check(tsdn_t *tsdn, arena_t *arena,
     arena_decay_t *decay, size_t npages_new) NOT_REACHED
+void background_thread_arena_unschedule(tsdn_t *tsdn, arena_t *arena)
+    NOT_REACHED
 void background_thread_prefork0(tsdn_t *tsdn) NOT_REACHED
 void background_thread_prefork1(tsdn_t *tsdn) NOT_REACHED
 void background_thread_postfork_parent(tsdn_t *tsdn) NOT_REACHED
@@ -66,16 +84,87 @@ bool background_thread_stats_read(tsdn_t *tsdn,
     background_thread_stats_t *stats) NOT_REACHED
 void background_thread_ctl_init(tsdn_t *tsdn) NOT_REACHED
 #undef NOT_REACHED
+
+unsigned
+background_thread_pressure_level(void) {
+	return 0;
+}
 #else
 
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
 static bool background_thread_enabled_at_fork;
 
+#ifdef JEMALLOC_HAVE_SCHED_SETAFFINITY
+/* Parsed opt.background_thread_cpus; valid if background_thread_ncpus > 0. */
+static cpu_set_t background_thread_cpuset;
+static unsigned background_thread_ncpus;
+#endif
+
+static int
+bg_arena_deadline_comp(const arena_t *a, const arena_t *b) {
+	int ret = (a->bg_deadline > b->bg_deadline) - (a->bg_deadline <
+	    b->bg_deadline);
+	if (ret != 0) {
+		return ret;
+	}
+	return ((uintptr_t)a > (uintptr_t)b) - ((uintptr_t)a < (uintptr_t)b);
+}
+
+ph_gen(static UNUSED, bg_arena_heap_, bg_arena_heap_t, arena_t, bg_link,
+    bg_arena_deadline_comp)
+
+/*
+ * Memory pressure monitor state.  The monitor thread is started and stopped by
+ * background thread 0, so the fds and thread handle need no locking.
+ */
+static bool psi_monitor_started;
+static pthread_t psi_monitor_thread;
+static int psi_fd = -1;
+/* Written to by thread 0 to stop the monitor. */
+static int psi_stop_pipe[2] = {-1, -1};
+/* Current pressure level, in [0, PSI_LEVEL_MAX]. */
+static atomic_u_t psi_level;
+static atomic_zu_t psi_nevents;
+
+/* Schedule the arena to be processed at the given time.  */
+static void
+background_thread_arena_schedule(tsdn_t *tsdn, background_thread_info_t *info,
+    arena_t *arena, uint64_t deadline) {
+	malloc_mutex_assert_owner(tsdn, &info->mtx);
+	if (arena->bg_queued) {
+		if (arena->bg_deadline <= deadline) {
+			return;
+		}
+		bg_arena_heap_remove(&info->arenas, arena);
+	}
+	arena->bg_deadline = deadline;
+	arena->bg_queued = true;
+	bg_arena_heap_insert(&info->arenas, arena);
+}
+
+static void
+background_thread_arenas_drain(tsdn_t *tsdn, background_thread_info_t *info) {
+	malloc_mutex_assert_owner(tsdn, &info->mtx);
+	arena_t *arena;
+	while ((arena = bg_arena_heap_remove_first(&info->arenas)) != NULL) {
+		arena->bg_queued = false;
+	}
+}
+
 static void
 background_thread_info_init(tsdn_t *tsdn, background_thread_info_t *info) {
 	background_thread_wakeup_time_set(tsdn, info, 0);
 	info->npages_to_purge_new = 0;
+	background_thread_arenas_drain(tsdn, info);
 	if (config_stats) {
 		info->tot_n_runs = 0;
+		info->tot_n_arena_runs = 0;
 		nstime_init(&info->tot_sleep_time, 0);
 	}
 }
@@ -94,6 +183,84 @@ set_current_thread_affinity(UNUSED int cpu) {
 #endif
 }
 
+/*
+ * Parse a CPU list such as "0-3,8" into background_thread_cpuset.  Returns
+ * true on error.
+ */
+static bool
+background_thread_cpus_parse(const char *cpus) {
+#ifdef JEMALLOC_HAVE_SCHED_SETAFFINITY
+	CPU_ZERO(&background_thread_cpuset);
+	background_thread_ncpus = 0;
+	const char *p = cpus;
+	while (*p != '\0') {
+		char *end;
+		uintmax_t first = malloc_strtoumax(p, &end, 10);
+		if (end == p) {
+			return true;
+		}
+		uintmax_t last = first;
+		p = end;
+		if (*p == '-') {
+			p++;
+			last = malloc_strtoumax(p, &end, 10);
+			if (end == p || last < first) {
+				return true;
+			}
+			p = end;
+		}
+		if (last >= CPU_SETSIZE) {
+			return true;
+		}
+		for (uintmax_t cpu = first; cpu <= last; cpu++) {
+			if (!CPU_ISSET((int)cpu, &background_thread_cpuset)) {
+				CPU_SET((int)cpu, &background_thread_cpuset);
+				background_thread_ncpus++;
+			}
+		}
+		if (*p == ',') {
+			p++;
+		} else if (*p != '\0') {
+			return true;
+		}
+	}
+	return (background_thread_ncpus == 0);
+#else
+	return true;
+#endif
+}
+
+/*
+ * Apply the placement and priority options to the calling background thread.
+ * Failures are not fatal; the thread just runs with the inherited settings.
+ */
+static void
+background_thread_sched_setup(unsigned thread_ind) {
+#ifdef JEMALLOC_HAVE_SCHED_SETAFFINITY
+	if (background_thread_ncpus > 0) {
+		sched_setaffinity(0, sizeof(cpu_set_t),
+		    &background_thread_cpuset);
+	} else
+#endif
+	if (opt_percpu_arena != percpu_arena_disabled) {
+		set_current_thread_affinity((int)thread_ind);
+	}
+#ifdef SCHED_IDLE
+	if (opt_background_thread_sched_idle) {
+		struct sched_param param;
+		memset(&param, 0, sizeof(param));
+		pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+	}
+#endif
+#ifdef SYS_gettid
+	/* On Linux the nice value is per thread, despite what POSIX says. */
+	if (opt_background_thread_nice != 0) {
+		setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid),
+		    (int)opt_background_thread_nice);
+	}
+#endif
+}
+
 /* Threshold for determining when to wake up the background thread. */
 #define BACKGROUND_THREAD_NPAGES_THRESHOLD UINT64_C(1024)
 #define BILLION UINT64_C(1000000000)
@@ -115,8 +282,8 @@ decay_npurge_after_interval(arena_decay_t *decay, size_t interval) {
 }
 
 static uint64_t
-arena_decay_compute_purge_interval_impl(tsdn_t *tsdn, arena_decay_t *decay,
-    extents_t *extents) {
+arena_decay_compute_purge_interval_impl(tsdn_t *tsdn, arena_t *arena,
+    arena_decay_t *decay, extents_t *extents) {
 	if (malloc_mutex_trylock(tsdn, &decay->mtx)) {
 		/* Use minimal interval if decay is contended. */
 		return BACKGROUND_THREAD_MIN_INTERVAL_NS;
@@ -133,6 +300,27 @@ arena_decay_compute_purge_interval_impl(tsdn_t *tsdn, arena_decay_t *decay,
 	uint64_t decay_interval_ns = nstime_ns(&decay->interval);
 	assert(decay_interval_ns > 0);
 	size_t npages = extents_npages_get(extents);
+	purge_policy_t policy = (purge_policy_t)atomic_load_u(&decay->policy,
+	    ATOMIC_RELAXED);
+	if (npages > arena_decay_cap_npages_limit(arena, decay) ||
+	    decay->npages_debt > 0) {
+		/*
+		 * Over the policy or cgroup cap, or held back by the purge
+		 * budget; purge as soon as possible.
+		 */
+		interval = BACKGROUND_THREAD_MIN_INTERVAL_NS;
+		goto label_done;
+	}
+	if (policy != purge_policy_smoothstep && policy != purge_policy_hybrid) {
+		/*
+		 * Pure cap policies have no backlog to work through; pages
+		 * above the cap are purged by the thread that frees them, so
+		 * only recheck occasionally.
+		 */
+		interval = (npages == 0) ? BACKGROUND_THREAD_INDEFINITE_SLEEP :
+		    decay_interval_ns * SMOOTHSTEP_NSTEPS;
+		goto label_done;
+	}
 	if (npages == 0) {
 		unsigned i;
 		for (i = 0; i < SMOOTHSTEP_NSTEPS; i++) {
@@ -203,13 +391,17 @@ label_done:
 static uint64_t
 arena_decay_compute_purge_interval(tsdn_t *tsdn, arena_t *arena) {
 	uint64_t i1, i2;
-	i1 = arena_decay_compute_purge_interval_impl(tsdn, &arena->decay_dirty,
-	    &arena->extents_dirty);
+	if (arena_mlock_get(arena)) {
+		/* Locked arenas are only purged on request. */
+		return BACKGROUND_THREAD_INDEFINITE_SLEEP;
+	}
+	i1 = arena_decay_compute_purge_interval_impl(tsdn, arena,
+	    &arena->decay_dirty, &arena->extents_dirty);
 	if (i1 == BACKGROUND_THREAD_MIN_INTERVAL_NS) {
 		return i1;
 	}
-	i2 = arena_decay_compute_purge_interval_impl(tsdn, &arena->decay_muzzy,
-	    &arena->extents_muzzy);
+	i2 = arena_decay_compute_purge_interval_impl(tsdn, arena,
+	    &arena->decay_muzzy, &arena->extents_muzzy);
 
 	return i1 < i2 ? i1 : i2;
 }
@@ -284,29 +476,87 @@ background_thread_pause_check(tsdn_t *tsdn, background_thread_info_t *info) {
 	return false;
 }
 
-static inline void
-background_work_sleep_once(tsdn_t *tsdn, background_thread_info_t *info, unsigned ind) {
-	uint64_t min_interval = BACKGROUND_THREAD_INDEFINITE_SLEEP;
+/*
+ * Queue every arena the thread serves, to be processed right away.  Arenas
+ * created later are queued by background_thread_arena_new().
+ */
+static void
+background_thread_arenas_scan(tsdn_t *tsdn, background_thread_info_t *info,
+    unsigned ind) {
 	unsigned narenas = narenas_total_get();
+	for (unsigned i = ind; i < narenas; i += max_background_threads) {
+		arena_t *arena = arena_get(tsdn, i, false);
+		if (arena != NULL) {
+			background_thread_arena_schedule(tsdn, info, arena, 0);
+		}
+	}
+}
 
+/* Under memory pressure, every arena is visited on every wakeup. */
+static void
+background_work_pressure(tsdn_t *tsdn, background_thread_info_t *info,
+    unsigned ind, unsigned level) {
+	unsigned narenas = narenas_total_get();
 	for (unsigned i = ind; i < narenas; i += max_background_threads) {
 		arena_t *arena = arena_get(tsdn, i, false);
 		if (!arena) {
 			continue;
 		}
+		if (level < PSI_LEVEL_MAX) {
+			arena_decay_accelerate(tsdn, arena, level);
+		} else if (!arena_mlock_get(arena)) {
+			arena_decay(tsdn, arena, true, true);
+		}
+		arena_retained_trim(tsdn, arena, 0);
+		if (config_stats) {
+			info->tot_n_arena_runs++;
+		}
+	}
+}
+
+static inline void
+background_work_sleep_once(tsdn_t *tsdn, background_thread_info_t *info, unsigned ind) {
+	unsigned level = atomic_load_u(&psi_level, ATOMIC_RELAXED);
+	if (level > 0) {
+		/* Keep rechecking until the pressure clears. */
+		background_work_pressure(tsdn, info, ind, level);
+		background_thread_sleep(tsdn, info,
+		    BACKGROUND_THREAD_MIN_INTERVAL_NS);
+		return;
+	}
+
+	nstime_t now;
+	nstime_init(&now, 0);
+	nstime_update(&now);
+	uint64_t now_ns = nstime_ns(&now);
+	/* Only visit the arenas whose deadline has passed. */
+	arena_t *arena;
+	while ((arena = bg_arena_heap_first(&info->arenas)) != NULL &&
+	    arena->bg_deadline <= now_ns) {
+		bg_arena_heap_remove_first(&info->arenas);
+		arena->bg_queued = false;
 		arena_decay(tsdn, arena, true, false);
-		if (min_interval == BACKGROUND_THREAD_MIN_INTERVAL_NS) {
-			/* Min interval will be used. */
-			continue;
+		arena_retained_trim(tsdn, arena, 0);
+		if (config_stats) {
+			info->tot_n_arena_runs++;
 		}
 		uint64_t interval = arena_decay_compute_purge_interval(tsdn,
 		    arena);
 		assert(interval >= BACKGROUND_THREAD_MIN_INTERVAL_NS);
-		if (min_interval > interval) {
-			min_interval = interval;
+		if (interval != BACKGROUND_THREAD_INDEFINITE_SLEEP) {
+			background_thread_arena_schedule(tsdn, info, arena,
+			    now_ns + interval);
 		}
 	}
-	background_thread_sleep(tsdn, info, min_interval);
+
+	uint64_t interval = BACKGROUND_THREAD_INDEFINITE_SLEEP;
+	if (arena != NULL) {
+		interval = (arena->bg_deadline - now_ns <
+		    BACKGROUND_THREAD_MIN_INTERVAL_NS) ?
+		    BACKGROUND_THREAD_MIN_INTERVAL_NS : arena->bg_deadline -
+		    now_ns;
+	}
+	background_thread_sleep(tsdn, info, interval);
 }
 
 static bool
@@ -382,6 +632,155 @@ background_thread_create_signals_masked(pthread_t *thread,
 	return create_err;
 }
 
+/* Wake up all running background threads, e.g. when memory pressure rises. */
+static void
+background_threads_wakeup(tsdn_t *tsdn) {
+	for (unsigned i = 0; i < max_background_threads; i++) {
+		background_thread_info_t *info = &background_thread_info[i];
+		malloc_mutex_lock(tsdn, &info->mtx);
+		if (info->state == background_thread_started) {
+			pthread_cond_signal(&info->cond);
+		}
+		malloc_mutex_unlock(tsdn, &info->mtx);
+	}
+}
+
+static void
+psi_drain(int fd) {
+	char buf[64];
+	while (read(fd, buf, sizeof(buf)) > 0) {
+		/* Discard. */
+	}
+}
+
+/*
+ * Memory pressure monitor.  Each PSI event (or, for a FIFO standing in for the
+ * PSI file, each write to it) raises the pressure level by one, up to
+ * PSI_LEVEL_MAX, and wakes the background threads.  Every window that passes
+ * without an event lowers it by one, until decay is back to normal.
+ */
+static void *
+psi_monitor_entry(void *fifo_arg) {
+	bool fifo = (bool)(uintptr_t)fifo_arg;
+#ifdef JEMALLOC_HAVE_PTHREAD_SETNAME_NP
+	pthread_setname_np(pthread_self(), "jemalloc_psi");
+#endif
+	size_t window_ms = opt_psi_window_us / 1000;
+	int timeout = (window_ms == 0) ? 1 : (window_ms > INT_MAX) ? INT_MAX :
+	    (int)window_ms;
+
+	struct pollfd fds[2];
+	fds[0].fd = psi_fd;
+	fds[0].events = fifo ? POLLIN : POLLPRI;
+	fds[1].fd = psi_stop_pipe[0];
+	fds[1].events = POLLIN;
+	while (true) {
+		int n = poll(fds, 2, timeout);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+		if (fds[1].revents != 0) {
+			/* Stop requested. */
+			break;
+		}
+		unsigned level = atomic_load_u(&psi_level, ATOMIC_RELAXED);
+		if (n == 0) {
+			if (level > 0) {
+				atomic_store_u(&psi_level, level - 1,
+				    ATOMIC_RELAXED);
+			}
+			continue;
+		}
+		if (fds[0].revents & (POLLERR | POLLNVAL)) {
+			break;
+		}
+		if (fifo) {
+			psi_drain(psi_fd);
+		}
+		if (level < PSI_LEVEL_MAX) {
+			atomic_store_u(&psi_level, level + 1, ATOMIC_RELAXED);
+		}
+		atomic_fetch_add_zu(&psi_nevents, 1, ATOMIC_RELAXED);
+		background_threads_wakeup(TSDN_NULL);
+	}
+
+	return NULL;
+}
+
+static void
+psi_monitor_close(void) {
+	if (psi_fd != -1) {
+		close(psi_fd);
+		psi_fd = -1;
+	}
+	for (unsigned i = 0; i < 2; i++) {
+		if (psi_stop_pipe[i] != -1) {
+			close(psi_stop_pipe[i]);
+			psi_stop_pipe[i] = -1;
+		}
+	}
+	atomic_store_u(&psi_level, 0, ATOMIC_RELAXED);
+}
+
+static void
+psi_monitor_start(tsd_t *tsd) {
+	assert(!psi_monitor_started);
+
+	int flags = O_RDWR | O_NONBLOCK;
+#ifdef O_CLOEXEC
+	flags |= O_CLOEXEC;
+#endif
+	psi_fd = open(opt_psi_path, flags);
+	if (psi_fd == -1) {
+		goto label_error;
+	}
+	struct stat st;
+	if (fstat(psi_fd, &st) != 0) {
+		goto label_error;
+	}
+	bool fifo = S_ISFIFO(st.st_mode);
+	if (!fifo) {
+		char trigger[64];
+		malloc_snprintf(trigger, sizeof(trigger), "some %zu %zu",
+		    opt_psi_stall_us, opt_psi_window_us);
+		if (write(psi_fd, trigger, strlen(trigger) + 1) < 0) {
+			goto label_error;
+		}
+	}
+	if (pipe(psi_stop_pipe) != 0) {
+		goto label_error;
+	}
+
+	pre_reentrancy(tsd, NULL);
+	int err = background_thread_create_signals_masked(&psi_monitor_thread,
+	    NULL, psi_monitor_entry, (void *)(uintptr_t)fifo);
+	post_reentrancy(tsd);
+	if (err != 0) {
+		goto label_error;
+	}
+	psi_monitor_started = true;
+	return;
+label_error:
+	malloc_printf("<jemalloc>: Unable to monitor memory pressure via %s\n",
+	    opt_psi_path);
+	psi_monitor_close();
+}
+
+static void
+psi_monitor_stop(void) {
+	if (!psi_monitor_started) {
+		return;
+	}
+	char c = 0;
+	UNUSED ssize_t n = write(psi_stop_pipe[1], &c, 1);
+	pthread_join(psi_monitor_thread, NULL);
+	psi_monitor_started = false;
+	psi_monitor_close();
+}
+
 static bool
 check_background_thread_creation(tsd_t *tsd, unsigned *n_created,
     bool *created_threads) {
@@ -474,6 +873,7 @@ background_thread0_work(tsd_t *tsd) {
 				n_background_threads--;
 				info->state = background_thread_stopped;
 			}
+			background_thread_arenas_drain(tsd_tsdn(tsd), info);
 			malloc_mutex_unlock(tsd_tsdn(tsd), &info->mtx);
 		}
 	}
@@ -485,9 +885,13 @@ static void
 background_work(tsd_t *tsd, unsigned ind) {
 	background_thread_info_t *info = &background_thread_info[ind];
 
+	if (ind == 0 && opt_psi_purge) {
+		psi_monitor_start(tsd);
+	}
 	malloc_mutex_lock(tsd_tsdn(tsd), &info->mtx);
 	background_thread_wakeup_time_set(tsd_tsdn(tsd), info,
 	    BACKGROUND_THREAD_INDEFINITE_SLEEP);
+	background_thread_arenas_scan(tsd_tsdn(tsd), info, ind);
 	if (ind == 0) {
 		background_thread0_work(tsd);
 	} else {
@@ -501,7 +905,12 @@ background_work(tsd_t *tsd, unsigned ind) {
 	}
 	assert(info->state == background_thread_stopped);
 	background_thread_wakeup_time_set(tsd_tsdn(tsd), info, 0);
+	/* Arenas may be destroyed once no thread serves them. */
+	background_thread_arenas_drain(tsd_tsdn(tsd), info);
 	malloc_mutex_unlock(tsd_tsdn(tsd), &info->mtx);
+	if (ind == 0) {
+		psi_monitor_stop();
+	}
 }
 
 static void *
@@ -511,15 +920,16 @@ background_thread_entry(void *ind_arg) {
 #ifdef JEMALLOC_HAVE_PTHREAD_SETNAME_NP
 	pthread_setname_np(pthread_self(), "jemalloc_bg_thd");
 #endif
-	if (opt_percpu_arena != percpu_arena_disabled) {
-		set_current_thread_affinity((int)thread_ind);
-	}
+	background_thread_sched_setup(thread_ind);
 	/*
 	 * Start periodic background work.  We use internal tsd which avoids
 	 * side effects, for example triggering new arena creation (which in
 	 * turn triggers another background thread creation).
 	 */
-	background_work(tsd_internal_fetch(), thread_ind);
+	tsd_t *tsd = tsd_internal_fetch();
+	/* Lets the latency stats tell our work apart from the application's. */
+	*tsd_in_background_threadp_get(tsd) = true;
+	background_work(tsd, thread_ind);
 	assert(pthread_equal(pthread_self(),
 	    background_thread_info[thread_ind].thread));
 
@@ -659,6 +1069,15 @@ background_thread_interval_check(tsdn_t *tsdn, arena_t *arena,
 	if (info->state != background_thread_started) {
 		goto label_done;
 	}
+	if (!arena->bg_queued) {
+		/*
+		 * The arena had nothing to purge when last visited; have the
+		 * thread look at it again on its next wakeup.
+		 */
+		background_thread_arena_schedule(tsdn, info, arena,
+		    background_thread_indefinite_sleep(info) ? 0 :
+		    background_thread_wakeup_time_get(info));
+	}
 	if (malloc_mutex_trylock(tsdn, &decay->mtx)) {
 		goto label_done;
 	}
@@ -716,6 +1135,8 @@ background_thread_interval_check(tsdn_t *tsdn, arena_t *arena,
 
 	if (should_signal) {
 		info->npages_to_purge_new = 0;
+		/* Make sure the wakeup visits this arena. */
+		background_thread_arena_schedule(tsdn, info, arena, 0);
 		pthread_cond_signal(&info->cond);
 	}
 label_done_unlock2:
@@ -724,6 +1145,34 @@ label_done:
 	malloc_mutex_unlock(tsdn, &info->mtx);
 }
 
+/*
+ * Have the thread serving a newly created arena visit it on its next wakeup.
+ * Threads not running yet queue all their arenas once they start.
+ */
+void
+background_thread_arena_new(tsdn_t *tsdn, arena_t *arena) {
+	background_thread_info_t *info = arena_background_thread_info_get(
+	    arena);
+	malloc_mutex_lock(tsdn, &info->mtx);
+	if (info->state == background_thread_started) {
+		background_thread_arena_schedule(tsdn, info, arena, 0);
+	}
+	malloc_mutex_unlock(tsdn, &info->mtx);
+}
+
+/* Stop visiting an arena that is about to be destroyed. */
+void
+background_thread_arena_unschedule(tsdn_t *tsdn, arena_t *arena) {
+	background_thread_info_t *info = arena_background_thread_info_get(
+	    arena);
+	malloc_mutex_lock(tsdn, &info->mtx);
+	if (arena->bg_queued) {
+		bg_arena_heap_remove(&info->arenas, arena);
+		arena->bg_queued = false;
+	}
+	malloc_mutex_unlock(tsdn, &info->mtx);
+}
+
 void
 background_thread_prefork0(tsdn_t *tsdn) {
 	malloc_mutex_prefork(tsdn, &background_thread_lock);
@@ -759,6 +1208,9 @@ background_thread_postfork_child(tsdn_t *tsdn) {
 
 	/* Clear background_thread state (reset to disabled for child). */
 	malloc_mutex_lock(tsdn, &background_thread_lock);
+	/* The monitor thread does not survive fork; drop its fds. */
+	psi_monitor_started = false;
+	psi_monitor_close();
 	n_background_threads = 0;
 	background_thread_enabled_set(tsdn, false);
 	for (unsigned i = 0; i < max_background_threads; i++) {
@@ -784,17 +1236,21 @@ background_thread_stats_read(tsdn_t *tsdn, background_thread_stats_t *stats) {
 
 	stats->num_threads = n_background_threads;
 	uint64_t num_runs = 0;
+	uint64_t num_arena_runs = 0;
 	nstime_init(&stats->run_interval, 0);
 	for (unsigned i = 0; i < max_background_threads; i++) {
 		background_thread_info_t *info = &background_thread_info[i];
 		malloc_mutex_lock(tsdn, &info->mtx);
 		if (info->state != background_thread_stopped) {
 			num_runs += info->tot_n_runs;
+			num_arena_runs += info->tot_n_arena_runs;
 			nstime_add(&stats->run_interval, &info->tot_sleep_time);
 		}
 		malloc_mutex_unlock(tsdn, &info->mtx);
 	}
 	stats->num_runs = num_runs;
+	stats->num_arena_runs = num_arena_runs;
+	stats->pressure_events = atomic_load_zu(&psi_nevents, ATOMIC_RELAXED);
 	if (num_runs > 0) {
 		nstime_idivide(&stats->run_interval, num_runs);
 	}
@@ -803,6 +1259,12 @@ background_thread_stats_read(tsdn_t *tsdn, background_thread_stats_t *stats) {
 	return false;
 }
 
+/* Zero unless the memory pressure monitor has seen a recent stall. */
+unsigned
+background_thread_pressure_level(void) {
+	return atomic_load_u(&psi_level, ATOMIC_RELAXED);
+}
+
 #undef BACKGROUND_THREAD_NPAGES_THRESHOLD
 #undef BILLION
 #undef BACKGROUND_THREAD_MIN_INTERVAL_NS
@@ -871,6 +1333,14 @@ background_thread_boot1(tsdn_t *tsdn) {
 		opt_max_background_threads = ncpus;
 	}
 	max_background_threads = opt_max_background_threads;
+	if (opt_background_thread_cpus[0] != '\0' &&
+	    background_thread_cpus_parse(opt_background_thread_cpus)) {
+		malloc_printf("<jemalloc>: Invalid background_thread_cpus "
+		    "\"%s\"\n", opt_background_thread_cpus);
+		if (opt_abort_conf) {
+			abort();
+		}
+	}
 
 	background_thread_enabled_set(tsdn, opt_background_thread);
 	if (malloc_mutex_init(&background_thread_lock,
@@ -898,6 +1368,7 @@ background_thread_boot1(tsdn_t *tsdn) {
 		if (pthread_cond_init(&info->cond, NULL)) {
 			return true;
 		}
+		bg_arena_heap_new(&info->arenas);
 		malloc_mutex_lock(tsdn, &info->mtx);
 		info->state = background_thread_stopped;
 		background_thread_info_init(tsdn, info);
@@ -28,6 +28,9 @@ bin_init(bin_t *bin) {
 	bin->slabcur = NULL;
 	extent_heap_new(&bin->slabs_nonfull);
 	extent_list_init(&bin->slabs_full);
+	extent_list_init(&bin->slabs_empty);
+	bin->nslabs_empty = 0;
+	bin->nslabs_empty_idle = 0;
 	if (config_stats) {
 		memset(&bin->stats, 0, sizeof(bin_stats_t));
 	}
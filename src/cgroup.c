@@ -0,0 +1,285 @@
+#define JEMALLOC_CGROUP_C_
+#include "jemalloc/internal/jemalloc_preamble.h"
+#include "jemalloc/internal/jemalloc_internal_includes.h"
+
+#include "jemalloc/internal/assert.h"
+#include "jemalloc/internal/cgroup.h"
+#include "jemalloc/internal/malloc_io.h"
+
+/******************************************************************************/
+/* Data. */
+
+bool opt_cgroup_aware = false;
+char opt_cgroup_root[PATH_MAX + 1] = CGROUP_ROOT_DEFAULT;
+size_t opt_cgroup_unpurged_ratio = CGROUP_UNPURGED_RATIO_DEFAULT;
+
+atomic_zu_t cgroup_limit = ATOMIC_INIT(SIZE_T_MAX);
+atomic_zu_t cgroup_unpurged_ceiling = ATOMIC_INIT(SIZE_T_MAX);
+atomic_zu_t cgroup_arena_unpurged_npages = ATOMIC_INIT(SIZE_T_MAX);
+atomic_b_t cgroup_headroom_low = ATOMIC_INIT(false);
+
+/* Time of the last refresh, in seconds. */
+static atomic_zu_t cgroup_refresh_sec = ATOMIC_INIT(0);
+/* Serializes refreshes, which share the static buffers below. */
+static atomic_b_t cgroup_refreshing = ATOMIC_INIT(false);
+
+#define CGROUP_PROC_BUFSIZE	4096
+static char cgroup_proc_buf[CGROUP_PROC_BUFSIZE];
+static char cgroup_path[PATH_MAX + 1];
+
+/*
+ * cgroup v1 reports "no limit" as a very large page-aligned number rather than
+ * "max".
+ */
+#define CGROUP_V1_UNLIMITED	((uintmax_t)1 << 62)
+
+/******************************************************************************/
+
+/* Read a file into buf as a NUL-terminated string.  Returns true on error. */
+static bool
+cgroup_read_file(const char *path, char *buf, size_t size) {
+#ifdef _WIN32
+	return true;
+#else
+	int flags = O_RDONLY;
+#ifdef O_CLOEXEC
+	flags |= O_CLOEXEC;
+#endif
+	int fd = open(path, flags);
+	if (fd == -1) {
+		return true;
+	}
+	size_t nread = 0;
+	while (nread < size - 1) {
+		ssize_t n = malloc_read_fd(fd, &buf[nread], size - 1 - nread);
+		if (n <= 0) {
+			break;
+		}
+		nread += (size_t)n;
+	}
+	close(fd);
+	buf[nread] = '\0';
+	return (nread == 0);
+#endif
+}
+
+/*
+ * Read a byte count from the file name in the directory held by cgroup_path,
+ * whose length is dirlen.  "max" and the v1 equivalent read as SIZE_T_MAX.
+ */
+static bool
+cgroup_read_bytes(size_t dirlen, const char *name, size_t *r_bytes) {
+	if (malloc_snprintf(&cgroup_path[dirlen], sizeof(cgroup_path) - dirlen,
+	    "/%s", name) >= sizeof(cgroup_path) - dirlen) {
+		cgroup_path[dirlen] = '\0';
+		return true;
+	}
+	char buf[64];
+	bool err = cgroup_read_file(cgroup_path, buf, sizeof(buf));
+	cgroup_path[dirlen] = '\0';
+	if (err) {
+		return true;
+	}
+
+	if (strncmp(buf, "max", 3) == 0) {
+		*r_bytes = SIZE_T_MAX;
+		return false;
+	}
+	char *end;
+	uintmax_t bytes = malloc_strtoumax(buf, &end, 10);
+	if (end == buf) {
+		return true;
+	}
+	*r_bytes = (bytes >= CGROUP_V1_UNLIMITED || bytes >= SIZE_T_MAX) ?
+	    SIZE_T_MAX : (size_t)bytes;
+	return false;
+}
+
+/*
+ * Walk from opt_cgroup_root/subsys/path up to opt_cgroup_root/subsys, keeping
+ * the tightest limit and the least headroom (limit minus usage) seen on the
+ * way.  Levels without a limit file are skipped, which also lets a fake
+ * hierarchy provide limits only at its root.
+ */
+static void
+cgroup_walk(const char *subsys, const char *path, const char *limit_name,
+    const char *usage_name, size_t *r_limit, size_t *r_headroom) {
+	size_t rootlen = malloc_snprintf(cgroup_path, sizeof(cgroup_path),
+	    "%s%s", opt_cgroup_root, subsys);
+	size_t len = malloc_snprintf(cgroup_path, sizeof(cgroup_path),
+	    "%s%s%s", opt_cgroup_root, subsys, path);
+	if (len >= sizeof(cgroup_path)) {
+		return;
+	}
+	while (len > rootlen && cgroup_path[len - 1] == '/') {
+		len--;
+	}
+	cgroup_path[len] = '\0';
+
+	while (true) {
+		size_t limit;
+		if (!cgroup_read_bytes(len, limit_name, &limit) && limit !=
+		    SIZE_T_MAX) {
+			size_t usage;
+			if (cgroup_read_bytes(len, usage_name, &usage)) {
+				usage = 0;
+			}
+			size_t headroom = (limit > usage) ? limit - usage : 0;
+			if (limit < *r_limit) {
+				*r_limit = limit;
+			}
+			if (headroom < *r_headroom) {
+				*r_headroom = headroom;
+			}
+		}
+		if (len <= rootlen) {
+			break;
+		}
+		/* Strip the last path component and its separator. */
+		while (len > rootlen && cgroup_path[len - 1] != '/') {
+			len--;
+		}
+		while (len > rootlen && cgroup_path[len - 1] == '/') {
+			len--;
+		}
+		cgroup_path[len] = '\0';
+	}
+}
+
+static bool
+cgroup_ctls_have_memory(const char *ctls) {
+	while (*ctls != '\0') {
+		const char *end = strchr(ctls, ',');
+		size_t len = (end == NULL) ? strlen(ctls) : (size_t)(end - ctls);
+		if (len == strlen("memory") && strncmp(ctls, "memory", len) ==
+		    0) {
+			return true;
+		}
+		if (end == NULL) {
+			break;
+		}
+		ctls = end + 1;
+	}
+	return false;
+}
+
+/*
+ * Find the process's v2 and v1 memory cgroup paths in /proc/self/cgroup, whose
+ * lines look like "hierarchy-ID:controller-list:path".  The v2 hierarchy has ID
+ * 0 and an empty controller list.  Lines are NUL-terminated in place.
+ */
+static void
+cgroup_proc_paths(char *buf, const char **r_v2, const char **r_v1) {
+	char *line = buf;
+	while (*line != '\0') {
+		char *eol = strchr(line, '\n');
+		if (eol != NULL) {
+			*eol = '\0';
+		}
+		char *ctls = strchr(line, ':');
+		char *path = (ctls == NULL) ? NULL : strchr(ctls + 1, ':');
+		if (path != NULL) {
+			*ctls++ = '\0';
+			*path++ = '\0';
+			if (strcmp(line, "0") == 0 && *ctls == '\0') {
+				*r_v2 = path;
+			} else if (cgroup_ctls_have_memory(ctls)) {
+				*r_v1 = path;
+			}
+		}
+		if (eol == NULL) {
+			break;
+		}
+		line = eol + 1;
+	}
+}
+
+static unsigned
+cgroup_narenas_initialized(tsdn_t *tsdn) {
+	unsigned narenas = 0;
+	unsigned narenas_total = narenas_total_get();
+	for (unsigned i = 0; i < narenas_total; i++) {
+		if (arena_get(tsdn, i, false) != NULL) {
+			narenas++;
+		}
+	}
+	return (narenas == 0) ? 1 : narenas;
+}
+
+static void
+cgroup_refresh_impl(tsdn_t *tsdn) {
+	/* Without /proc, only look for limits at the root. */
+	const char *v2 = "/";
+	const char *v1 = "/";
+	if (!cgroup_read_file("/proc/self/cgroup", cgroup_proc_buf,
+	    sizeof(cgroup_proc_buf))) {
+		v2 = v1 = NULL;
+		cgroup_proc_paths(cgroup_proc_buf, &v2, &v1);
+	}
+
+	size_t limit = SIZE_T_MAX;
+	size_t headroom = SIZE_T_MAX;
+	if (v2 != NULL) {
+		cgroup_walk("", v2, "memory.max", "memory.current", &limit,
+		    &headroom);
+	}
+	if (limit == SIZE_T_MAX && v1 != NULL) {
+		cgroup_walk("/memory", v1, "memory.limit_in_bytes",
+		    "memory.usage_in_bytes", &limit, &headroom);
+	}
+
+	size_t ceiling = SIZE_T_MAX;
+	size_t npages = SIZE_T_MAX;
+	bool headroom_low = false;
+	if (limit != SIZE_T_MAX) {
+		ceiling = limit / 100 * opt_cgroup_unpurged_ratio + limit % 100
+		    * opt_cgroup_unpurged_ratio / 100;
+		if (headroom < ceiling) {
+			ceiling = headroom;
+			headroom_low = true;
+		}
+		npages = (ceiling >> LG_PAGE) / cgroup_narenas_initialized(tsdn);
+	}
+	atomic_store_zu(&cgroup_limit, limit, ATOMIC_RELAXED);
+	atomic_store_zu(&cgroup_unpurged_ceiling, ceiling, ATOMIC_RELAXED);
+	atomic_store_zu(&cgroup_arena_unpurged_npages, npages, ATOMIC_RELAXED);
+	atomic_store_b(&cgroup_headroom_low, headroom_low, ATOMIC_RELAXED);
+}
+
+void
+cgroup_refresh(tsdn_t *tsdn) {
+	if (!opt_cgroup_aware) {
+		return;
+	}
+	if (atomic_exchange_b(&cgroup_refreshing, true, ATOMIC_ACQUIRE)) {
+		/* Somebody else is already at it. */
+		return;
+	}
+	cgroup_refresh_impl(tsdn);
+	atomic_store_b(&cgroup_refreshing, false, ATOMIC_RELEASE);
+}
+
+void
+cgroup_maybe_refresh(tsdn_t *tsdn) {
+	if (!opt_cgroup_aware) {
+		return;
+	}
+	nstime_t now;
+	nstime_init(&now, 0);
+	nstime_update(&now);
+	size_t now_sec = (size_t)nstime_sec(&now);
+	size_t last_sec = atomic_load_zu(&cgroup_refresh_sec, ATOMIC_RELAXED);
+	if (now_sec - last_sec < CGROUP_REFRESH_INTERVAL_S) {
+		return;
+	}
+	if (!atomic_compare_exchange_strong_zu(&cgroup_refresh_sec, &last_sec,
+	    now_sec, ATOMIC_RELAXED, ATOMIC_RELAXED)) {
+		return;
+	}
+	cgroup_refresh(tsdn);
+}
+
+void
+cgroup_boot(void) {
+	cgroup_refresh(TSDN_NULL);
+}
@@ -3,11 +3,15 @@
 #include "jemalloc/internal/jemalloc_internal_includes.h"
 
 #include "jemalloc/internal/assert.h"
+#include "jemalloc/internal/cgroup.h"
 #include "jemalloc/internal/ctl.h"
 #include "jemalloc/internal/extent_dss.h"
+#include "jemalloc/internal/extent_fd.h"
 #include "jemalloc/internal/extent_mmap.h"
 #include "jemalloc/internal/mutex.h"
 #include "jemalloc/internal/nstime.h"
+#include "jemalloc/internal/percpu_cache.h"
+#include "jemalloc/internal/purge_budget.h"
 #include "jemalloc/internal/size_classes.h"
 #include "jemalloc/internal/util.h"
 
@@ -67,6 +71,9 @@ CTL_PROTO(thread_allocated)
 CTL_PROTO(thread_allocatedp)
 CTL_PROTO(thread_deallocated)
 CTL_PROTO(thread_deallocatedp)
+CTL_PROTO(thread_rtree_cache_hits)
+CTL_PROTO(thread_rtree_cache_misses)
+CTL_PROTO(thread_rtree_cache_hard_lookups)
 CTL_PROTO(config_cache_oblivious)
 CTL_PROTO(config_debug)
 CTL_PROTO(config_fill)
@@ -82,13 +89,32 @@ CTL_PROTO(opt_abort)
 CTL_PROTO(opt_abort_conf)
 CTL_PROTO(opt_metadata_thp)
 CTL_PROTO(opt_retain)
+CTL_PROTO(opt_reserve_va)
+CTL_PROTO(opt_retain_trim_threshold)
+CTL_PROTO(opt_retain_trim_ratio)
 CTL_PROTO(opt_dss)
+CTL_PROTO(opt_persistent_addr)
 CTL_PROTO(opt_narenas)
+CTL_PROTO(opt_freeze_narenas_max)
+CTL_PROTO(opt_fork_skip_quiescent)
 CTL_PROTO(opt_percpu_arena)
+CTL_PROTO(opt_percpu_cache)
 CTL_PROTO(opt_background_thread)
 CTL_PROTO(opt_max_background_threads)
+CTL_PROTO(opt_background_thread_cpus)
+CTL_PROTO(opt_background_thread_sched_idle)
+CTL_PROTO(opt_background_thread_nice)
+CTL_PROTO(opt_psi_purge)
+CTL_PROTO(opt_psi_path)
+CTL_PROTO(opt_psi_stall_us)
+CTL_PROTO(opt_psi_window_us)
 CTL_PROTO(opt_dirty_decay_ms)
 CTL_PROTO(opt_muzzy_decay_ms)
+CTL_PROTO(opt_dirty_decay_adaptive)
+CTL_PROTO(opt_dirty_decay_refault_target)
+CTL_PROTO(opt_empty_slab_cache_max)
+CTL_PROTO(opt_extent_steal)
+CTL_PROTO(opt_extent_steal_threshold)
 CTL_PROTO(opt_stats_print)
 CTL_PROTO(opt_stats_print_opts)
 CTL_PROTO(opt_junk)
@@ -98,6 +124,18 @@ CTL_PROTO(opt_xmalloc)
 CTL_PROTO(opt_tcache)
 CTL_PROTO(opt_thp)
 CTL_PROTO(opt_lg_extent_max_active_fit)
+CTL_PROTO(opt_extent_reuse)
+CTL_PROTO(opt_purge_policy)
+CTL_PROTO(opt_purge_max_dirty)
+CTL_PROTO(opt_purge_dirty_ratio)
+CTL_PROTO(opt_purge_floor)
+CTL_PROTO(opt_purge_rate)
+CTL_PROTO(opt_purge_call_max)
+CTL_PROTO(opt_purge_inline_share)
+CTL_PROTO(opt_purge_select)
+CTL_PROTO(opt_cgroup_aware)
+CTL_PROTO(opt_cgroup_root)
+CTL_PROTO(opt_cgroup_unpurged_ratio)
 CTL_PROTO(opt_lg_tcache_max)
 CTL_PROTO(opt_prof)
 CTL_PROTO(opt_prof_prefix)
@@ -117,11 +155,24 @@ CTL_PROTO(arena_i_decay)
 CTL_PROTO(arena_i_purge)
 CTL_PROTO(arena_i_reset)
 CTL_PROTO(arena_i_destroy)
+CTL_PROTO(arena_i_quiesce)
 CTL_PROTO(arena_i_dss)
 CTL_PROTO(arena_i_dirty_decay_ms)
 CTL_PROTO(arena_i_muzzy_decay_ms)
+CTL_PROTO(arena_i_dirty_decay_adaptive)
 CTL_PROTO(arena_i_extent_hooks)
 CTL_PROTO(arena_i_retain_grow_limit)
+CTL_PROTO(arena_i_extent_reuse)
+CTL_PROTO(arena_i_purge_policy)
+CTL_PROTO(arena_i_purge_max_dirty)
+CTL_PROTO(arena_i_purge_dirty_ratio)
+CTL_PROTO(arena_i_purge_floor)
+CTL_PROTO(arena_i_purge_select)
+CTL_PROTO(arena_i_prefault)
+CTL_PROTO(arena_i_mlock)
+CTL_PROTO(arena_i_fd)
+CTL_PROTO(arena_i_fd_base)
+CTL_PROTO(arena_i_persistent_root)
 INDEX_PROTO(arena_i)
 CTL_PROTO(arenas_bin_i_size)
 CTL_PROTO(arenas_bin_i_nregs)
@@ -139,7 +190,9 @@ CTL_PROTO(arenas_nbins)
 CTL_PROTO(arenas_nhbins)
 CTL_PROTO(arenas_nlextents)
 CTL_PROTO(arenas_create)
+CTL_PROTO(arenas_create_persistent)
 CTL_PROTO(arenas_lookup)
+CTL_PROTO(heap_freeze)
 CTL_PROTO(prof_thread_active_init)
 CTL_PROTO(prof_active)
 CTL_PROTO(prof_dump)
@@ -164,28 +217,52 @@ CTL_PROTO(stats_arenas_i_bins_j_nflushes)
 CTL_PROTO(stats_arenas_i_bins_j_nslabs)
 CTL_PROTO(stats_arenas_i_bins_j_nreslabs)
 CTL_PROTO(stats_arenas_i_bins_j_curslabs)
+CTL_PROTO(stats_arenas_i_bins_j_curslabs_empty)
 INDEX_PROTO(stats_arenas_i_bins_j)
 CTL_PROTO(stats_arenas_i_lextents_j_nmalloc)
 CTL_PROTO(stats_arenas_i_lextents_j_ndalloc)
 CTL_PROTO(stats_arenas_i_lextents_j_nrequests)
 CTL_PROTO(stats_arenas_i_lextents_j_curlextents)
 INDEX_PROTO(stats_arenas_i_lextents_j)
+CTL_PROTO(stats_arenas_i_reuse_ages_j_npages)
+INDEX_PROTO(stats_arenas_i_reuse_ages_j)
+#define OP(op)								\
+CTL_PROTO(stats_arenas_i_latency_##op##_j_background)			\
+CTL_PROTO(stats_arenas_i_latency_##op##_j_application)			\
+INDEX_PROTO(stats_arenas_i_latency_##op##_j)
+LATENCY_OPS
+#undef OP
 CTL_PROTO(stats_arenas_i_nthreads)
 CTL_PROTO(stats_arenas_i_uptime)
 CTL_PROTO(stats_arenas_i_dss)
 CTL_PROTO(stats_arenas_i_dirty_decay_ms)
 CTL_PROTO(stats_arenas_i_muzzy_decay_ms)
+CTL_PROTO(stats_arenas_i_dirty_decay_ms_effective)
 CTL_PROTO(stats_arenas_i_pactive)
 CTL_PROTO(stats_arenas_i_pdirty)
 CTL_PROTO(stats_arenas_i_pmuzzy)
 CTL_PROTO(stats_arenas_i_mapped)
 CTL_PROTO(stats_arenas_i_retained)
+CTL_PROTO(stats_arenas_i_retained_peak)
+CTL_PROTO(stats_arenas_i_retained_ntrims)
+CTL_PROTO(stats_arenas_i_retained_trimmed)
 CTL_PROTO(stats_arenas_i_dirty_npurge)
 CTL_PROTO(stats_arenas_i_dirty_nmadvise)
+CTL_PROTO(stats_arenas_i_dirty_nmadvise_saved)
 CTL_PROTO(stats_arenas_i_dirty_purged)
 CTL_PROTO(stats_arenas_i_muzzy_npurge)
 CTL_PROTO(stats_arenas_i_muzzy_nmadvise)
+CTL_PROTO(stats_arenas_i_muzzy_nmadvise_saved)
 CTL_PROTO(stats_arenas_i_muzzy_purged)
+CTL_PROTO(stats_arenas_i_extent_steals)
+CTL_PROTO(stats_arenas_i_extent_stolen)
+CTL_PROTO(stats_arenas_i_prefaulted)
+CTL_PROTO(stats_arenas_i_mlocked)
+CTL_PROTO(stats_arenas_i_lazy_nselected)
+CTL_PROTO(stats_arenas_i_forced_nselected)
+CTL_PROTO(stats_arenas_i_lazy_purged)
+CTL_PROTO(stats_arenas_i_lazy_reclaimed)
+CTL_PROTO(stats_arenas_i_forced_purged)
 CTL_PROTO(stats_arenas_i_base)
 CTL_PROTO(stats_arenas_i_internal)
 CTL_PROTO(stats_arenas_i_metadata_thp)
@@ -196,12 +273,28 @@ CTL_PROTO(stats_allocated)
 CTL_PROTO(stats_active)
 CTL_PROTO(stats_background_thread_num_threads)
 CTL_PROTO(stats_background_thread_num_runs)
+CTL_PROTO(stats_background_thread_num_arena_runs)
 CTL_PROTO(stats_background_thread_run_interval)
+CTL_PROTO(stats_background_thread_pressure_events)
 CTL_PROTO(stats_metadata)
 CTL_PROTO(stats_metadata_thp)
 CTL_PROTO(stats_resident)
 CTL_PROTO(stats_mapped)
 CTL_PROTO(stats_retained)
+CTL_PROTO(stats_cgroup_limit)
+CTL_PROTO(stats_unpurged_ceiling)
+CTL_PROTO(stats_purge_budget_debt)
+CTL_PROTO(stats_purge_budget_nthrottled)
+CTL_PROTO(stats_purge_budget_max_duration)
+CTL_PROTO(stats_percpu_cache_ncpus)
+CTL_PROTO(stats_percpu_cache_ncached)
+CTL_PROTO(stats_percpu_cache_bytes)
+CTL_PROTO(stats_percpu_cache_naborts)
+CTL_PROTO(stats_percpu_cache_nfills)
+CTL_PROTO(stats_percpu_cache_nflushes)
+CTL_PROTO(stats_percpu_cache_cpus_i_ncached)
+CTL_PROTO(stats_percpu_cache_cpus_i_bytes)
+INDEX_PROTO(stats_percpu_cache_cpus_i)
 
 #define MUTEX_STATS_CTL_PROTO_GEN(n)					\
 CTL_PROTO(stats_##n##_num_ops)						\
@@ -254,6 +347,12 @@ static const ctl_named_node_t	thread_prof_node[] = {
 	{NAME("active"),	CTL(thread_prof_active)}
 };
 
+static const ctl_named_node_t	thread_rtree_cache_node[] = {
+	{NAME("hits"),		CTL(thread_rtree_cache_hits)},
+	{NAME("misses"),	CTL(thread_rtree_cache_misses)},
+	{NAME("hard_lookups"),	CTL(thread_rtree_cache_hard_lookups)}
+};
+
 static const ctl_named_node_t	thread_node[] = {
 	{NAME("arena"),		CTL(thread_arena)},
 	{NAME("allocated"),	CTL(thread_allocated)},
@@ -261,7 +360,8 @@ static const ctl_named_node_t	thread_node[] = {
 	{NAME("deallocated"),	CTL(thread_deallocated)},
 	{NAME("deallocatedp"),	CTL(thread_deallocatedp)},
 	{NAME("tcache"),	CHILD(named, thread_tcache)},
-	{NAME("prof"),		CHILD(named, thread_prof)}
+	{NAME("prof"),		CHILD(named, thread_prof)},
+	{NAME("rtree_cache"),	CHILD(named, thread_rtree_cache)}
 };
 
 static const ctl_named_node_t	config_node[] = {
@@ -283,13 +383,45 @@ static const ctl_named_node_t opt_node[] = {
 	{NAME("abort_conf"),	CTL(opt_abort_conf)},
 	{NAME("metadata_thp"),	CTL(opt_metadata_thp)},
 	{NAME("retain"),	CTL(opt_retain)},
+	{NAME("reserve_va"),	CTL(opt_reserve_va)},
+	{NAME("retain_trim_threshold"), CTL(opt_retain_trim_threshold)},
+	{NAME("retain_trim_ratio"), CTL(opt_retain_trim_ratio)},
 	{NAME("dss"),		CTL(opt_dss)},
+	{NAME("persistent_addr"), CTL(opt_persistent_addr)},
 	{NAME("narenas"),	CTL(opt_narenas)},
+	{NAME("freeze_narenas_max"), CTL(opt_freeze_narenas_max)},
+	{NAME("fork_skip_quiescent"), CTL(opt_fork_skip_quiescent)},
 	{NAME("percpu_arena"),	CTL(opt_percpu_arena)},
+	{NAME("percpu_cache"),	CTL(opt_percpu_cache)},
 	{NAME("background_thread"),	CTL(opt_background_thread)},
 	{NAME("max_background_threads"),	CTL(opt_max_background_threads)},
+	{NAME("background_thread_cpus"),	CTL(opt_background_thread_cpus)},
+	{NAME("background_thread_sched_idle"),
+	    CTL(opt_background_thread_sched_idle)},
+	{NAME("background_thread_nice"),	CTL(opt_background_thread_nice)},
+	{NAME("psi_purge"),	CTL(opt_psi_purge)},
+	{NAME("psi_path"),	CTL(opt_psi_path)},
+	{NAME("psi_stall_us"),	CTL(opt_psi_stall_us)},
+	{NAME("psi_window_us"),	CTL(opt_psi_window_us)},
 	{NAME("dirty_decay_ms"), CTL(opt_dirty_decay_ms)},
 	{NAME("muzzy_decay_ms"), CTL(opt_muzzy_decay_ms)},
+	{NAME("dirty_decay_adaptive"), CTL(opt_dirty_decay_adaptive)},
+	{NAME("dirty_decay_refault_target"),
+	    CTL(opt_dirty_decay_refault_target)},
+	{NAME("empty_slab_cache_max"), CTL(opt_empty_slab_cache_max)},
+	{NAME("extent_steal"),	CTL(opt_extent_steal)},
+	{NAME("extent_steal_threshold"), CTL(opt_extent_steal_threshold)},
+	{NAME("purge_policy"),	CTL(opt_purge_policy)},
+	{NAME("purge_max_dirty"), CTL(opt_purge_max_dirty)},
+	{NAME("purge_dirty_ratio"), CTL(opt_purge_dirty_ratio)},
+	{NAME("purge_floor"),	CTL(opt_purge_floor)},
+	{NAME("purge_rate"),	CTL(opt_purge_rate)},
+	{NAME("purge_call_max"), CTL(opt_purge_call_max)},
+	{NAME("purge_inline_share"), CTL(opt_purge_inline_share)},
+	{NAME("purge_select"),	CTL(opt_purge_select)},
+	{NAME("cgroup_aware"),	CTL(opt_cgroup_aware)},
+	{NAME("cgroup_root"),	CTL(opt_cgroup_root)},
+	{NAME("cgroup_unpurged_ratio"), CTL(opt_cgroup_unpurged_ratio)},
 	{NAME("stats_print"),	CTL(opt_stats_print)},
 	{NAME("stats_print_opts"),	CTL(opt_stats_print_opts)},
 	{NAME("junk"),		CTL(opt_junk)},
@@ -299,6 +431,7 @@ static const ctl_named_node_t opt_node[] = {
 	{NAME("tcache"),	CTL(opt_tcache)},
 	{NAME("thp"),		CTL(opt_thp)},
 	{NAME("lg_extent_max_active_fit"), CTL(opt_lg_extent_max_active_fit)},
+	{NAME("extent_reuse"),	CTL(opt_extent_reuse)},
 	{NAME("lg_tcache_max"),	CTL(opt_lg_tcache_max)},
 	{NAME("prof"),		CTL(opt_prof)},
 	{NAME("prof_prefix"),	CTL(opt_prof_prefix)},
@@ -324,11 +457,24 @@ static const ctl_named_node_t arena_i_node[] = {
 	{NAME("purge"),		CTL(arena_i_purge)},
 	{NAME("reset"),		CTL(arena_i_reset)},
 	{NAME("destroy"),	CTL(arena_i_destroy)},
+	{NAME("quiesce"),	CTL(arena_i_quiesce)},
 	{NAME("dss"),		CTL(arena_i_dss)},
 	{NAME("dirty_decay_ms"), CTL(arena_i_dirty_decay_ms)},
 	{NAME("muzzy_decay_ms"), CTL(arena_i_muzzy_decay_ms)},
+	{NAME("dirty_decay_adaptive"), CTL(arena_i_dirty_decay_adaptive)},
 	{NAME("extent_hooks"),	CTL(arena_i_extent_hooks)},
-	{NAME("retain_grow_limit"),	CTL(arena_i_retain_grow_limit)}
+	{NAME("retain_grow_limit"),	CTL(arena_i_retain_grow_limit)},
+	{NAME("extent_reuse"),	CTL(arena_i_extent_reuse)},
+	{NAME("purge_policy"),	CTL(arena_i_purge_policy)},
+	{NAME("purge_max_dirty"), CTL(arena_i_purge_max_dirty)},
+	{NAME("purge_dirty_ratio"), CTL(arena_i_purge_dirty_ratio)},
+	{NAME("purge_floor"),	CTL(arena_i_purge_floor)},
+	{NAME("purge_select"),	CTL(arena_i_purge_select)},
+	{NAME("prefault"),	CTL(arena_i_prefault)},
+	{NAME("mlock"),		CTL(arena_i_mlock)},
+	{NAME("fd"),		CTL(arena_i_fd)},
+	{NAME("fd_base"),	CTL(arena_i_fd_base)},
+	{NAME("persistent_root"), CTL(arena_i_persistent_root)}
 };
 static const ctl_named_node_t super_arena_i_node[] = {
 	{NAME(""),		CHILD(named, arena_i)}
@@ -375,9 +521,14 @@ static const ctl_named_node_t arenas_node[] = {
 	{NAME("nlextents"),	CTL(arenas_nlextents)},
 	{NAME("lextent"),	CHILD(indexed, arenas_lextent)},
 	{NAME("create"),	CTL(arenas_create)},
+	{NAME("create_persistent"), CTL(arenas_create_persistent)},
 	{NAME("lookup"),	CTL(arenas_lookup)}
 };
 
+static const ctl_named_node_t heap_node[] = {
+	{NAME("freeze"),	CTL(heap_freeze)}
+};
+
 static const ctl_named_node_t	prof_node[] = {
 	{NAME("thread_active_init"), CTL(prof_thread_active_init)},
 	{NAME("active"),	CTL(prof_active)},
@@ -433,6 +584,7 @@ static const ctl_named_node_t stats_arenas_i_bins_j_node[] = {
 	{NAME("nslabs"),	CTL(stats_arenas_i_bins_j_nslabs)},
 	{NAME("nreslabs"),	CTL(stats_arenas_i_bins_j_nreslabs)},
 	{NAME("curslabs"),	CTL(stats_arenas_i_bins_j_curslabs)},
+	{NAME("curslabs_empty"), CTL(stats_arenas_i_bins_j_curslabs_empty)},
 	{NAME("mutex"),		CHILD(named, stats_arenas_i_bins_j_mutex)}
 };
 
@@ -458,6 +610,40 @@ static const ctl_indexed_node_t stats_arenas_i_lextents_node[] = {
 	{INDEX(stats_arenas_i_lextents_j)}
 };
 
+static const ctl_named_node_t stats_arenas_i_reuse_ages_j_node[] = {
+	{NAME("npages"),	CTL(stats_arenas_i_reuse_ages_j_npages)}
+};
+static const ctl_named_node_t super_stats_arenas_i_reuse_ages_j_node[] = {
+	{NAME(""),		CHILD(named, stats_arenas_i_reuse_ages_j)}
+};
+
+static const ctl_indexed_node_t stats_arenas_i_reuse_ages_node[] = {
+	{INDEX(stats_arenas_i_reuse_ages_j)}
+};
+
+#define OP(op)								\
+static const ctl_named_node_t stats_arenas_i_latency_##op##_j_node[] = {\
+	{NAME("background"),						\
+	 CTL(stats_arenas_i_latency_##op##_j_background)},		\
+	{NAME("application"),						\
+	 CTL(stats_arenas_i_latency_##op##_j_application)}		\
+};									\
+static const ctl_named_node_t						\
+    super_stats_arenas_i_latency_##op##_j_node[] = {			\
+	{NAME(""), CHILD(named, stats_arenas_i_latency_##op##_j)}	\
+};									\
+static const ctl_indexed_node_t stats_arenas_i_latency_##op##_node[] = {\
+	{INDEX(stats_arenas_i_latency_##op##_j)}			\
+};
+LATENCY_OPS
+#undef OP
+
+static const ctl_named_node_t stats_arenas_i_latency_node[] = {
+#define OP(op) {NAME(#op), CHILD(indexed, stats_arenas_i_latency_##op)},
+LATENCY_OPS
+#undef OP
+};
+
 #define OP(mtx)  MUTEX_PROF_DATA_NODE(arenas_i_mutexes_##mtx)
 MUTEX_PROF_ARENA_MUTEXES
 #undef OP
@@ -474,17 +660,35 @@ static const ctl_named_node_t stats_arenas_i_node[] = {
 	{NAME("dss"),		CTL(stats_arenas_i_dss)},
 	{NAME("dirty_decay_ms"), CTL(stats_arenas_i_dirty_decay_ms)},
 	{NAME("muzzy_decay_ms"), CTL(stats_arenas_i_muzzy_decay_ms)},
+	{NAME("dirty_decay_ms_effective"),
+	    CTL(stats_arenas_i_dirty_decay_ms_effective)},
 	{NAME("pactive"),	CTL(stats_arenas_i_pactive)},
 	{NAME("pdirty"),	CTL(stats_arenas_i_pdirty)},
 	{NAME("pmuzzy"),	CTL(stats_arenas_i_pmuzzy)},
 	{NAME("mapped"),	CTL(stats_arenas_i_mapped)},
 	{NAME("retained"),	CTL(stats_arenas_i_retained)},
+	{NAME("retained_peak"),	CTL(stats_arenas_i_retained_peak)},
+	{NAME("retained_ntrims"), CTL(stats_arenas_i_retained_ntrims)},
+	{NAME("retained_trimmed"), CTL(stats_arenas_i_retained_trimmed)},
 	{NAME("dirty_npurge"),	CTL(stats_arenas_i_dirty_npurge)},
 	{NAME("dirty_nmadvise"), CTL(stats_arenas_i_dirty_nmadvise)},
+	{NAME("dirty_nmadvise_saved"),
+	    CTL(stats_arenas_i_dirty_nmadvise_saved)},
 	{NAME("dirty_purged"),	CTL(stats_arenas_i_dirty_purged)},
 	{NAME("muzzy_npurge"),	CTL(stats_arenas_i_muzzy_npurge)},
 	{NAME("muzzy_nmadvise"), CTL(stats_arenas_i_muzzy_nmadvise)},
+	{NAME("muzzy_nmadvise_saved"),
+	    CTL(stats_arenas_i_muzzy_nmadvise_saved)},
 	{NAME("muzzy_purged"),	CTL(stats_arenas_i_muzzy_purged)},
+	{NAME("extent_steals"),	CTL(stats_arenas_i_extent_steals)},
+	{NAME("extent_stolen"),	CTL(stats_arenas_i_extent_stolen)},
+	{NAME("prefaulted"),	CTL(stats_arenas_i_prefaulted)},
+	{NAME("mlocked"),	CTL(stats_arenas_i_mlocked)},
+	{NAME("lazy_nselected"), CTL(stats_arenas_i_lazy_nselected)},
+	{NAME("forced_nselected"), CTL(stats_arenas_i_forced_nselected)},
+	{NAME("lazy_purged"),	CTL(stats_arenas_i_lazy_purged)},
+	{NAME("lazy_reclaimed"), CTL(stats_arenas_i_lazy_reclaimed)},
+	{NAME("forced_purged"),	CTL(stats_arenas_i_forced_purged)},
 	{NAME("base"),		CTL(stats_arenas_i_base)},
 	{NAME("internal"),	CTL(stats_arenas_i_internal)},
 	{NAME("metadata_thp"),	CTL(stats_arenas_i_metadata_thp)},
@@ -494,6 +698,8 @@ static const ctl_named_node_t stats_arenas_i_node[] = {
 	{NAME("large"),		CHILD(named, stats_arenas_i_large)},
 	{NAME("bins"),		CHILD(indexed, stats_arenas_i_bins)},
 	{NAME("lextents"),	CHILD(indexed, stats_arenas_i_lextents)},
+	{NAME("reuse_ages"),	CHILD(indexed, stats_arenas_i_reuse_ages)},
+	{NAME("latency"),	CHILD(named, stats_arenas_i_latency)},
 	{NAME("mutexes"),	CHILD(named, stats_arenas_i_mutexes)}
 };
 static const ctl_named_node_t super_stats_arenas_i_node[] = {
@@ -504,10 +710,42 @@ static const ctl_indexed_node_t stats_arenas_node[] = {
 	{INDEX(stats_arenas_i)}
 };
 
+static const ctl_named_node_t stats_purge_budget_node[] = {
+	{NAME("debt"),		CTL(stats_purge_budget_debt)},
+	{NAME("nthrottled"),	CTL(stats_purge_budget_nthrottled)},
+	{NAME("max_duration"),	CTL(stats_purge_budget_max_duration)}
+};
+
+static const ctl_named_node_t stats_percpu_cache_cpus_i_node[] = {
+	{NAME("ncached"),	CTL(stats_percpu_cache_cpus_i_ncached)},
+	{NAME("bytes"),		CTL(stats_percpu_cache_cpus_i_bytes)}
+};
+static const ctl_named_node_t super_stats_percpu_cache_cpus_i_node[] = {
+	{NAME(""),		CHILD(named, stats_percpu_cache_cpus_i)}
+};
+
+static const ctl_indexed_node_t stats_percpu_cache_cpus_node[] = {
+	{INDEX(stats_percpu_cache_cpus_i)}
+};
+
+static const ctl_named_node_t stats_percpu_cache_node[] = {
+	{NAME("ncpus"),		CTL(stats_percpu_cache_ncpus)},
+	{NAME("ncached"),	CTL(stats_percpu_cache_ncached)},
+	{NAME("bytes"),		CTL(stats_percpu_cache_bytes)},
+	{NAME("naborts"),	CTL(stats_percpu_cache_naborts)},
+	{NAME("nfills"),	CTL(stats_percpu_cache_nfills)},
+	{NAME("nflushes"),	CTL(stats_percpu_cache_nflushes)},
+	{NAME("cpus"),		CHILD(indexed, stats_percpu_cache_cpus)}
+};
+
 static const ctl_named_node_t stats_background_thread_node[] = {
 	{NAME("num_threads"),	CTL(stats_background_thread_num_threads)},
 	{NAME("num_runs"),	CTL(stats_background_thread_num_runs)},
-	{NAME("run_interval"),	CTL(stats_background_thread_run_interval)}
+	{NAME("num_arena_runs"),
+	    CTL(stats_background_thread_num_arena_runs)},
+	{NAME("run_interval"),	CTL(stats_background_thread_run_interval)},
+	{NAME("pressure_events"),
+	    CTL(stats_background_thread_pressure_events)}
 };
 
 #define OP(mtx) MUTEX_PROF_DATA_NODE(mutexes_##mtx)
@@ -530,6 +768,10 @@ static const ctl_named_node_t stats_node[] = {
 	{NAME("resident"),	CTL(stats_resident)},
 	{NAME("mapped"),	CTL(stats_mapped)},
 	{NAME("retained"),	CTL(stats_retained)},
+	{NAME("cgroup_limit"),	CTL(stats_cgroup_limit)},
+	{NAME("unpurged_ceiling"), CTL(stats_unpurged_ceiling)},
+	{NAME("purge_budget"),	CHILD(named, stats_purge_budget)},
+	{NAME("percpu_cache"),	CHILD(named, stats_percpu_cache)},
 	{NAME("background_thread"),
 	 CHILD(named, stats_background_thread)},
 	{NAME("mutexes"),	CHILD(named, stats_mutexes)},
@@ -547,6 +789,7 @@ static const ctl_named_node_t	root_node[] = {
 	{NAME("tcache"),	CHILD(named, tcache)},
 	{NAME("arena"),		CHILD(indexed, arena)},
 	{NAME("arenas"),	CHILD(named, arenas)},
+	{NAME("heap"),		CHILD(named, heap)},
 	{NAME("prof"),		CHILD(named, prof)},
 	{NAME("stats"),		CHILD(named, stats)}
 };
@@ -687,6 +930,7 @@ ctl_arena_clear(ctl_arena_t *ctl_arena) {
 	ctl_arena->dss = dss_prec_names[dss_prec_limit];
 	ctl_arena->dirty_decay_ms = -1;
 	ctl_arena->muzzy_decay_ms = -1;
+	ctl_arena->dirty_decay_ms_effective = -1;
 	ctl_arena->pactive = 0;
 	ctl_arena->pdirty = 0;
 	ctl_arena->pmuzzy = 0;
@@ -732,6 +976,8 @@ ctl_arena_stats_amerge(tsdn_t *tsdn, ctl_arena_t *ctl_arena, arena_t *arena) {
 		    &ctl_arena->muzzy_decay_ms, &ctl_arena->pactive,
 		    &ctl_arena->pdirty, &ctl_arena->pmuzzy);
 	}
+	ctl_arena->dirty_decay_ms_effective =
+	    arena_dirty_decay_ms_effective_get(arena);
 }
 
 static void
@@ -760,12 +1006,21 @@ ctl_arena_stats_sdmerge(ctl_arena_t *ctl_sdarena, ctl_arena_t *ctl_arena,
 			    &astats->astats.mapped);
 			accum_atomic_zu(&sdstats->astats.retained,
 			    &astats->astats.retained);
+			accum_atomic_zu(&sdstats->astats.retained_peak,
+			    &astats->astats.retained_peak);
 		}
+		ctl_accum_arena_stats_u64(&sdstats->astats.retained_ntrims,
+		    &astats->astats.retained_ntrims);
+		ctl_accum_arena_stats_u64(&sdstats->astats.retained_trimmed,
+		    &astats->astats.retained_trimmed);
 
 		ctl_accum_arena_stats_u64(&sdstats->astats.decay_dirty.npurge,
 		    &astats->astats.decay_dirty.npurge);
 		ctl_accum_arena_stats_u64(&sdstats->astats.decay_dirty.nmadvise,
 		    &astats->astats.decay_dirty.nmadvise);
+		ctl_accum_arena_stats_u64(
+		    &sdstats->astats.decay_dirty.nmadvise_saved,
+		    &astats->astats.decay_dirty.nmadvise_saved);
 		ctl_accum_arena_stats_u64(&sdstats->astats.decay_dirty.purged,
 		    &astats->astats.decay_dirty.purged);
 
@@ -773,9 +1028,46 @@ ctl_arena_stats_sdmerge(ctl_arena_t *ctl_sdarena, ctl_arena_t *ctl_arena,
 		    &astats->astats.decay_muzzy.npurge);
 		ctl_accum_arena_stats_u64(&sdstats->astats.decay_muzzy.nmadvise,
 		    &astats->astats.decay_muzzy.nmadvise);
+		ctl_accum_arena_stats_u64(
+		    &sdstats->astats.decay_muzzy.nmadvise_saved,
+		    &astats->astats.decay_muzzy.nmadvise_saved);
 		ctl_accum_arena_stats_u64(&sdstats->astats.decay_muzzy.purged,
 		    &astats->astats.decay_muzzy.purged);
 
+		ctl_accum_arena_stats_u64(&sdstats->astats.nsteals,
+		    &astats->astats.nsteals);
+		ctl_accum_arena_stats_u64(&sdstats->astats.stolen,
+		    &astats->astats.stolen);
+		ctl_accum_arena_stats_u64(&sdstats->astats.prefaulted,
+		    &astats->astats.prefaulted);
+		ctl_accum_arena_stats_u64(&sdstats->astats.mlocked,
+		    &astats->astats.mlocked);
+		for (i = 0; i < REUSE_AGE_NBUCKETS; i++) {
+			ctl_accum_arena_stats_u64(
+			    &sdstats->astats.reuse_ages[i],
+			    &astats->astats.reuse_ages[i]);
+		}
+		ctl_accum_arena_stats_u64(&sdstats->astats.lazy_nselected,
+		    &astats->astats.lazy_nselected);
+		ctl_accum_arena_stats_u64(&sdstats->astats.forced_nselected,
+		    &astats->astats.forced_nselected);
+		ctl_accum_arena_stats_u64(&sdstats->astats.lazy_purged,
+		    &astats->astats.lazy_purged);
+		ctl_accum_arena_stats_u64(&sdstats->astats.lazy_reclaimed,
+		    &astats->astats.lazy_reclaimed);
+		ctl_accum_arena_stats_u64(&sdstats->astats.forced_purged,
+		    &astats->astats.forced_purged);
+		for (i = 0; i < latency_op_limit; i++) {
+			for (unsigned bg = 0; bg < 2; bg++) {
+				for (unsigned j = 0; j < LATENCY_NBUCKETS;
+				    j++) {
+					ctl_accum_arena_stats_u64(
+					    &sdstats->astats.latency[i][bg][j],
+					    &astats->astats.latency[i][bg][j]);
+				}
+			}
+		}
+
 #define OP(mtx) malloc_mutex_prof_merge(				\
 		    &(sdstats->astats.mutex_prof_data[			\
 		        arena_prof_mutex_##mtx]),			\
@@ -846,8 +1138,11 @@ MUTEX_PROF_ARENA_MUTEXES
 			if (!destroyed) {
 				sdstats->bstats[i].curslabs +=
 				    astats->bstats[i].curslabs;
+				sdstats->bstats[i].curslabs_empty +=
+				    astats->bstats[i].curslabs_empty;
 			} else {
 				assert(astats->bstats[i].curslabs == 0);
+				assert(astats->bstats[i].curslabs_empty == 0);
 			}
 			malloc_mutex_prof_merge(&sdstats->bstats[i].mutex_data,
 			    &astats->bstats[i].mutex_data);
@@ -882,7 +1177,7 @@ ctl_arena_refresh(tsdn_t *tsdn, arena_t *arena, ctl_arena_t *ctl_sdarena,
 }
 
 static unsigned
-ctl_arena_init(tsd_t *tsd, extent_hooks_t *extent_hooks) {
+ctl_arena_init(tsd_t *tsd, extent_hooks_t *extent_hooks, arena_t *persisted) {
 	unsigned arena_ind;
 	ctl_arena_t *ctl_arena;
 
@@ -899,8 +1194,14 @@ ctl_arena_init(tsd_t *tsd, extent_hooks_t *extent_hooks) {
 		return UINT_MAX;
 	}
 
-	/* Initialize new arena. */
-	if (arena_init(tsd_tsdn(tsd), arena_ind, extent_hooks) == NULL) {
+	/* Initialize new arena, or attach one persisted in a file. */
+	if (persisted != NULL) {
+		if (arena_attach(tsd_tsdn(tsd), arena_ind, persisted,
+		    extent_hooks)) {
+			return UINT_MAX;
+		}
+	} else if (arena_init(tsd_tsdn(tsd), arena_ind, extent_hooks) ==
+	    NULL) {
 		return UINT_MAX;
 	}
 
@@ -965,6 +1266,13 @@ ctl_refresh(tsdn_t *tsdn) {
 		    &ctl_sarena->astats->astats.mapped, ATOMIC_RELAXED);
 		ctl_stats->retained = atomic_load_zu(
 		    &ctl_sarena->astats->astats.retained, ATOMIC_RELAXED);
+		cgroup_refresh(tsdn);
+		ctl_stats->cgroup_limit = cgroup_limit_get();
+		ctl_stats->unpurged_ceiling = cgroup_unpurged_ceiling_get();
+		purge_budget_stats_read(&ctl_stats->purge_budget);
+		if (percpu_cache_enabled) {
+			percpu_cache_stats_read(&ctl_stats->percpu_cache);
+		}
 
 		ctl_background_thread_stats_read(tsdn);
 
@@ -1025,6 +1333,16 @@ ctl_init(tsd_t *tsd) {
 				ret = true;
 				goto label_return;
 			}
+			if (percpu_cache_enabled) {
+				ctl_stats->percpu_cache.cpus =
+				    (percpu_cache_cpu_stats_t *)base_alloc(
+				    tsdn, b0get(), percpu_cache_ncpus *
+				    sizeof(percpu_cache_cpu_stats_t), QUANTUM);
+				if (ctl_stats->percpu_cache.cpus == NULL) {
+					ret = true;
+					goto label_return;
+				}
+			}
 		}
 
 		/*
@@ -1656,14 +1974,50 @@ CTL_RO_NL_GEN(opt_abort_conf, opt_abort_conf, bool)
 CTL_RO_NL_GEN(opt_metadata_thp, metadata_thp_mode_names[opt_metadata_thp],
     const char *)
 CTL_RO_NL_GEN(opt_retain, opt_retain, bool)
+CTL_RO_NL_GEN(opt_reserve_va, opt_reserve_va, size_t)
+CTL_RO_NL_GEN(opt_retain_trim_threshold, opt_retain_trim_threshold, size_t)
+CTL_RO_NL_GEN(opt_retain_trim_ratio, opt_retain_trim_ratio, size_t)
 CTL_RO_NL_GEN(opt_dss, opt_dss, const char *)
+CTL_RO_NL_GEN(opt_persistent_addr, opt_persistent_addr, size_t)
 CTL_RO_NL_GEN(opt_narenas, opt_narenas, unsigned)
+CTL_RO_NL_GEN(opt_freeze_narenas_max, opt_freeze_narenas_max, unsigned)
+CTL_RO_NL_GEN(opt_fork_skip_quiescent, opt_fork_skip_quiescent, bool)
+CTL_RO_NL_GEN(opt_percpu_cache, opt_percpu_cache, bool)
 CTL_RO_NL_GEN(opt_percpu_arena, percpu_arena_mode_names[opt_percpu_arena],
     const char *)
 CTL_RO_NL_GEN(opt_background_thread, opt_background_thread, bool)
 CTL_RO_NL_GEN(opt_max_background_threads, opt_max_background_threads, size_t)
+CTL_RO_NL_GEN(opt_background_thread_cpus, opt_background_thread_cpus,
+    const char *)
+CTL_RO_NL_GEN(opt_background_thread_sched_idle,
+    opt_background_thread_sched_idle, bool)
+CTL_RO_NL_GEN(opt_background_thread_nice, opt_background_thread_nice, ssize_t)
+CTL_RO_NL_GEN(opt_psi_purge, opt_psi_purge, bool)
+CTL_RO_NL_GEN(opt_psi_path, opt_psi_path, const char *)
+CTL_RO_NL_GEN(opt_psi_stall_us, opt_psi_stall_us, size_t)
+CTL_RO_NL_GEN(opt_psi_window_us, opt_psi_window_us, size_t)
 CTL_RO_NL_GEN(opt_dirty_decay_ms, opt_dirty_decay_ms, ssize_t)
 CTL_RO_NL_GEN(opt_muzzy_decay_ms, opt_muzzy_decay_ms, ssize_t)
+CTL_RO_NL_GEN(opt_dirty_decay_adaptive, opt_dirty_decay_adaptive, bool)
+CTL_RO_NL_GEN(opt_dirty_decay_refault_target, opt_dirty_decay_refault_target,
+    size_t)
+CTL_RO_NL_GEN(opt_empty_slab_cache_max, opt_empty_slab_cache_max, size_t)
+CTL_RO_NL_GEN(opt_extent_steal, opt_extent_steal, bool)
+CTL_RO_NL_GEN(opt_extent_steal_threshold, opt_extent_steal_threshold, size_t)
+CTL_RO_NL_GEN(opt_purge_policy, purge_policy_names[opt_purge_policy],
+    const char *)
+CTL_RO_NL_GEN(opt_purge_max_dirty, opt_purge_max_dirty, size_t)
+CTL_RO_NL_GEN(opt_purge_dirty_ratio, opt_purge_dirty_ratio, size_t)
+CTL_RO_NL_GEN(opt_purge_floor, opt_purge_floor, size_t)
+CTL_RO_NL_GEN(opt_purge_rate, opt_purge_rate, size_t)
+CTL_RO_NL_GEN(opt_purge_call_max, opt_purge_call_max, size_t)
+CTL_RO_NL_GEN(opt_purge_inline_share, opt_purge_inline_share, size_t)
+CTL_RO_NL_GEN(opt_purge_select, purge_select_names[opt_purge_select],
+    const char *)
+CTL_RO_NL_GEN(opt_cgroup_aware, opt_cgroup_aware, bool)
+CTL_RO_NL_GEN(opt_cgroup_root, opt_cgroup_root, const char *)
+CTL_RO_NL_GEN(opt_cgroup_unpurged_ratio, opt_cgroup_unpurged_ratio,
+    size_t)
 CTL_RO_NL_GEN(opt_stats_print, opt_stats_print, bool)
 CTL_RO_NL_GEN(opt_stats_print_opts, opt_stats_print_opts, const char *)
 CTL_RO_NL_CGEN(config_fill, opt_junk, opt_junk, const char *)
@@ -1674,6 +2028,8 @@ CTL_RO_NL_GEN(opt_tcache, opt_tcache, bool)
 CTL_RO_NL_GEN(opt_thp, thp_mode_names[opt_thp], const char *)
 CTL_RO_NL_GEN(opt_lg_extent_max_active_fit, opt_lg_extent_max_active_fit,
     size_t)
+CTL_RO_NL_GEN(opt_extent_reuse, extent_reuse_names[opt_extent_reuse],
+    const char *)
 CTL_RO_NL_GEN(opt_lg_tcache_max, opt_lg_tcache_max, ssize_t)
 CTL_RO_NL_CGEN(config_prof, opt_prof, opt_prof, bool)
 CTL_RO_NL_CGEN(config_prof, opt_prof_prefix, opt_prof_prefix, const char *)
@@ -1754,6 +2110,34 @@ CTL_TSD_RO_NL_CGEN(config_stats, thread_deallocated, tsd_thread_deallocated_get,
 CTL_TSD_RO_NL_CGEN(config_stats, thread_deallocatedp,
     tsd_thread_deallocatedp_get, uint64_t *)
 
+#ifdef ANDROID_RTREE_CTX_STATS
+#  define RTREE_CTX_STAT_GET(field)	(tsd_rtree_ctx(tsd)->field)
+#else
+#  define RTREE_CTX_STAT_GET(field)	0
+#endif
+
+static uint64_t
+rtree_ctx_nhits_get(tsd_t *tsd) {
+	return RTREE_CTX_STAT_GET(nhits);
+}
+
+static uint64_t
+rtree_ctx_nmisses_get(tsd_t *tsd) {
+	return RTREE_CTX_STAT_GET(nmisses);
+}
+
+static uint64_t
+rtree_ctx_nhard_get(tsd_t *tsd) {
+	return RTREE_CTX_STAT_GET(nhard);
+}
+
+CTL_TSD_RO_NL_CGEN(config_rtree_ctx_stats, thread_rtree_cache_hits,
+    rtree_ctx_nhits_get, uint64_t)
+CTL_TSD_RO_NL_CGEN(config_rtree_ctx_stats, thread_rtree_cache_misses,
+    rtree_ctx_nmisses_get, uint64_t)
+CTL_TSD_RO_NL_CGEN(config_rtree_ctx_stats, thread_rtree_cache_hard_lookups,
+    rtree_ctx_nhard_get, uint64_t)
+
 static int
 thread_tcache_enabled_ctl(tsd_t *tsd, const size_t *mib, size_t miblen,
     void *oldp, size_t *oldlenp, void *newp, size_t newlen) {
@@ -2044,7 +2428,7 @@ arena_reset_prepare_background_thread(tsd_t *tsd, unsigned arena_ind) {
 	if (have_background_thread) {
 		malloc_mutex_lock(tsd_tsdn(tsd), &background_thread_lock);
 		if (background_thread_enabled()) {
-			unsigned ind = arena_ind % ncpus;
+			unsigned ind = arena_ind % max_background_threads;
 			background_thread_info_t *info =
 			    &background_thread_info[ind];
 			assert(info->state == background_thread_started);
@@ -2059,7 +2443,7 @@ static void
 arena_reset_finish_background_thread(tsd_t *tsd, unsigned arena_ind) {
 	if (have_background_thread) {
 		if (background_thread_enabled()) {
-			unsigned ind = arena_ind % ncpus;
+			unsigned ind = arena_ind % max_background_threads;
 			background_thread_info_t *info =
 			    &background_thread_info[ind];
 			assert(info->state == background_thread_paused);
@@ -2111,6 +2495,7 @@ arena_i_destroy_ctl(tsd_t *tsd, const size_t *mib, size_t miblen, void *oldp,
 		goto label_return;
 	}
 
+	extent_hooks_t *extent_hooks = extent_hooks_get(arena);
 	arena_reset_prepare_background_thread(tsd, arena_ind);
 	/* Merge stats after resetting and purging arena. */
 	arena_reset(tsd, arena);
@@ -2118,6 +2503,9 @@ arena_i_destroy_ctl(tsd_t *tsd, const size_t *mib, size_t miblen, void *oldp,
 	ctl_darena = arenas_i(MALLCTL_ARENAS_DESTROYED);
 	ctl_darena->initialized = true;
 	ctl_arena_refresh(tsd_tsdn(tsd), arena, ctl_darena, arena_ind, true);
+	if (have_background_thread) {
+		background_thread_arena_unschedule(tsd_tsdn(tsd), arena);
+	}
 	/* Destroy arena. */
 	arena_destroy(tsd, arena);
 	ctl_arena = arenas_i(arena_ind);
@@ -2126,6 +2514,53 @@ arena_i_destroy_ctl(tsd_t *tsd, const size_t *mib, size_t miblen, void *oldp,
 	ql_elm_new(ctl_arena, destroyed_link);
 	ql_tail_insert(&ctl_arenas->destroyed, ctl_arena, destroyed_link);
 	arena_reset_finish_background_thread(tsd, arena_ind);
+	/* Unmap the file backing the arena, if any. */
+	extent_fd_delete(extent_hooks);
+
+	assert(ret == 0);
+label_return:
+	return ret;
+}
+
+static int
+arena_i_quiesce_ctl(tsd_t *tsd, const size_t *mib, size_t miblen, void *oldp,
+    size_t *oldlenp, void *newp, size_t newlen) {
+	int ret;
+	unsigned arena_ind;
+	arena_t *arena;
+	ctl_arena_t *ctl_arena;
+
+	ret = arena_i_reset_destroy_helper(tsd, mib, miblen, oldp, oldlenp,
+	    newp, newlen, &arena_ind, &arena);
+	if (ret != 0) {
+		goto label_return;
+	}
+
+	if (arena_nthreads_get(arena, false) != 0 || arena_nthreads_get(arena,
+	    true) != 0) {
+		ret = EFAULT;
+		goto label_return;
+	}
+	extent_hooks_t *extent_hooks = extent_hooks_get(arena);
+	if (extent_fd_persistent_root(extent_hooks) == NULL) {
+		/* Not a persistent arena. */
+		ret = ENOENT;
+		goto label_return;
+	}
+
+	arena_reset_prepare_background_thread(tsd, arena_ind);
+	if (have_background_thread) {
+		background_thread_arena_unschedule(tsd_tsdn(tsd), arena);
+	}
+	/* Unlike destroy, leave the arena's memory as it is. */
+	arena_quiesce(tsd, arena);
+	ctl_arena = arenas_i(arena_ind);
+	ctl_arena->initialized = false;
+	/* Record arena index for later recycling via arenas.create. */
+	ql_elm_new(ctl_arena, destroyed_link);
+	ql_tail_insert(&ctl_arenas->destroyed, ctl_arena, destroyed_link);
+	arena_reset_finish_background_thread(tsd, arena_ind);
+	extent_fd_persistent_quiesce(extent_hooks);
 
 	assert(ret == 0);
 label_return:
@@ -2244,6 +2679,38 @@ arena_i_muzzy_decay_ms_ctl(tsd_t *tsd, const size_t *mib, size_t miblen,
 	    newlen, false);
 }
 
+static int
+arena_i_dirty_decay_adaptive_ctl(tsd_t *tsd, const size_t *mib, size_t miblen,
+    void *oldp, size_t *oldlenp, void *newp, size_t newlen) {
+	int ret;
+	unsigned arena_ind;
+	arena_t *arena;
+
+	MIB_UNSIGNED(arena_ind, 1);
+	arena = arena_get(tsd_tsdn(tsd), arena_ind, false);
+	if (arena == NULL) {
+		ret = EFAULT;
+		goto label_return;
+	}
+
+	if (oldp != NULL && oldlenp != NULL) {
+		bool oldval = arena_dirty_decay_adaptive_get(arena);
+		READ(oldval, bool);
+	}
+	if (newp != NULL) {
+		if (newlen != sizeof(bool)) {
+			ret = EINVAL;
+			goto label_return;
+		}
+		arena_dirty_decay_adaptive_set(tsd_tsdn(tsd), arena,
+		    *(bool *)newp);
+	}
+
+	ret = 0;
+label_return:
+	return ret;
+}
+
 static int
 arena_i_extent_hooks_ctl(tsd_t *tsd, const size_t *mib, size_t miblen,
     void *oldp, size_t *oldlenp, void *newp, size_t newlen) {
@@ -2335,6 +2802,312 @@ label_return:
 	return ret;
 }
 
+static int
+arena_i_extent_reuse_ctl(tsd_t *tsd, const size_t *mib, size_t miblen,
+    void *oldp, size_t *oldlenp, void *newp, size_t newlen) {
+	int ret;
+	const char *extent_reuse = NULL;
+	extent_reuse_t extent_reuse_new = extent_reuse_limit;
+	unsigned arena_ind;
+	arena_t *arena;
+
+	malloc_mutex_lock(tsd_tsdn(tsd), &ctl_mtx);
+	WRITE(extent_reuse, const char *);
+	MIB_UNSIGNED(arena_ind, 1);
+	if (extent_reuse != NULL) {
+		for (unsigned i = 0; i < extent_reuse_limit; i++) {
+			if (strcmp(extent_reuse_names[i], extent_reuse) == 0) {
+				extent_reuse_new = i;
+				break;
+			}
+		}
+		if (extent_reuse_new == extent_reuse_limit) {
+			ret = EINVAL;
+			goto label_return;
+		}
+	}
+
+	if (arena_ind >= narenas_total_get() || (arena =
+	    arena_get(tsd_tsdn(tsd), arena_ind, false)) == NULL) {
+		ret = EFAULT;
+		goto label_return;
+	}
+	extent_reuse = extent_reuse_names[arena_extent_reuse_get(arena)];
+	if (extent_reuse_new != extent_reuse_limit) {
+		arena_extent_reuse_set(arena, extent_reuse_new);
+	}
+	READ(extent_reuse, const char *);
+
+	ret = 0;
+label_return:
+	malloc_mutex_unlock(tsd_tsdn(tsd), &ctl_mtx);
+	return ret;
+}
+
+static int
+arena_i_purge_policy_ctl(tsd_t *tsd, const size_t *mib, size_t miblen,
+    void *oldp, size_t *oldlenp, void *newp, size_t newlen) {
+	int ret;
+	const char *purge_policy = NULL;
+	purge_policy_t purge_policy_new = purge_policy_limit;
+	unsigned arena_ind;
+	arena_t *arena;
+
+	malloc_mutex_lock(tsd_tsdn(tsd), &ctl_mtx);
+	WRITE(purge_policy, const char *);
+	MIB_UNSIGNED(arena_ind, 1);
+	if (purge_policy != NULL) {
+		for (unsigned i = 0; i < purge_policy_limit; i++) {
+			if (strcmp(purge_policy_names[i], purge_policy) == 0) {
+				purge_policy_new = i;
+				break;
+			}
+		}
+		if (purge_policy_new == purge_policy_limit) {
+			ret = EINVAL;
+			goto label_return;
+		}
+	}
+
+	if (arena_ind >= narenas_total_get() || (arena =
+	    arena_get(tsd_tsdn(tsd), arena_ind, false)) == NULL) {
+		ret = EFAULT;
+		goto label_return;
+	}
+	purge_policy = purge_policy_names[arena_purge_policy_get(arena)];
+	if (purge_policy_new != purge_policy_limit) {
+		arena_purge_policy_set(tsd_tsdn(tsd), arena, purge_policy_new);
+	}
+	READ(purge_policy, const char *);
+
+	ret = 0;
+label_return:
+	malloc_mutex_unlock(tsd_tsdn(tsd), &ctl_mtx);
+	return ret;
+}
+
+static int
+arena_i_purge_param_ctl_impl(tsd_t *tsd, const size_t *mib, size_t miblen,
+    void *oldp, size_t *oldlenp, void *newp, size_t newlen,
+    size_t (*get)(arena_t *), void (*set)(tsdn_t *, arena_t *, size_t)) {
+	int ret;
+	unsigned arena_ind;
+	arena_t *arena;
+
+	malloc_mutex_lock(tsd_tsdn(tsd), &ctl_mtx);
+	MIB_UNSIGNED(arena_ind, 1);
+	if (arena_ind >= narenas_total_get() || (arena =
+	    arena_get(tsd_tsdn(tsd), arena_ind, false)) == NULL) {
+		ret = EFAULT;
+		goto label_return;
+	}
+
+	size_t oldval = get(arena);
+	READ(oldval, size_t);
+	if (newp != NULL) {
+		if (newlen != sizeof(size_t)) {
+			ret = EINVAL;
+			goto label_return;
+		}
+		set(tsd_tsdn(tsd), arena, *(size_t *)newp);
+	}
+
+	ret = 0;
+label_return:
+	malloc_mutex_unlock(tsd_tsdn(tsd), &ctl_mtx);
+	return ret;
+}
+
+static int
+arena_i_purge_max_dirty_ctl(tsd_t *tsd, const size_t *mib, size_t miblen,
+    void *oldp, size_t *oldlenp, void *newp, size_t newlen) {
+	return arena_i_purge_param_ctl_impl(tsd, mib, miblen, oldp, oldlenp,
+	    newp, newlen, arena_purge_max_dirty_get, arena_purge_max_dirty_set);
+}
+
+static int
+arena_i_purge_dirty_ratio_ctl(tsd_t *tsd, const size_t *mib, size_t miblen,
+    void *oldp, size_t *oldlenp, void *newp, size_t newlen) {
+	return arena_i_purge_param_ctl_impl(tsd, mib, miblen, oldp, oldlenp,
+	    newp, newlen, arena_purge_dirty_ratio_get,
+	    arena_purge_dirty_ratio_set);
+}
+
+static int
+arena_i_purge_floor_ctl(tsd_t *tsd, const size_t *mib, size_t miblen,
+    void *oldp, size_t *oldlenp, void *newp, size_t newlen) {
+	return arena_i_purge_param_ctl_impl(tsd, mib, miblen, oldp, oldlenp,
+	    newp, newlen, arena_purge_floor_get, arena_purge_floor_set);
+}
+
+static int
+arena_i_purge_select_ctl(tsd_t *tsd, const size_t *mib, size_t miblen,
+    void *oldp, size_t *oldlenp, void *newp, size_t newlen) {
+	int ret;
+	const char *purge_select = NULL;
+	purge_select_t purge_select_new = purge_select_limit;
+	unsigned arena_ind;
+	arena_t *arena;
+
+	malloc_mutex_lock(tsd_tsdn(tsd), &ctl_mtx);
+	WRITE(purge_select, const char *);
+	MIB_UNSIGNED(arena_ind, 1);
+	if (purge_select != NULL) {
+		for (unsigned i = 0; i < purge_select_limit; i++) {
+			if (strcmp(purge_select_names[i], purge_select) == 0) {
+				purge_select_new = i;
+				break;
+			}
+		}
+		if (purge_select_new == purge_select_limit) {
+			ret = EINVAL;
+			goto label_return;
+		}
+	}
+
+	if (arena_ind >= narenas_total_get() || (arena =
+	    arena_get(tsd_tsdn(tsd), arena_ind, false)) == NULL) {
+		ret = EFAULT;
+		goto label_return;
+	}
+	purge_select = purge_select_names[arena_purge_select_get(arena)];
+	if (purge_select_new != purge_select_limit) {
+		arena_purge_select_set(arena, purge_select_new);
+	}
+	READ(purge_select, const char *);
+
+	ret = 0;
+label_return:
+	malloc_mutex_unlock(tsd_tsdn(tsd), &ctl_mtx);
+	return ret;
+}
+
+#define CTL_ARENA_I_BOOL_GEN(n, get, set)				\
+static int								\
+n##_ctl(tsd_t *tsd, const size_t *mib, size_t miblen, void *oldp,	\
+    size_t *oldlenp, void *newp, size_t newlen) {			\
+	int ret;							\
+	unsigned arena_ind;						\
+	arena_t *arena;							\
+	bool oldval, newval;						\
+									\
+	malloc_mutex_lock(tsd_tsdn(tsd), &ctl_mtx);			\
+	MIB_UNSIGNED(arena_ind, 1);					\
+	if (arena_ind >= narenas_total_get() || (arena =		\
+	    arena_get(tsd_tsdn(tsd), arena_ind, false)) == NULL) {	\
+		ret = EFAULT;						\
+		goto label_return;					\
+	}								\
+	oldval = newval = get(arena);					\
+	WRITE(newval, bool);						\
+	READ(oldval, bool);						\
+	if (newp != NULL) {						\
+		set(arena, newval);					\
+	}								\
+									\
+	ret = 0;							\
+label_return:								\
+	malloc_mutex_unlock(tsd_tsdn(tsd), &ctl_mtx);			\
+	return ret;							\
+}
+
+CTL_ARENA_I_BOOL_GEN(arena_i_prefault, arena_prefault_get, arena_prefault_set)
+CTL_ARENA_I_BOOL_GEN(arena_i_mlock, arena_mlock_get, arena_mlock_set)
+
+static int
+arena_i_fd_get(tsd_t *tsd, unsigned arena_ind, int *r_fd, void **r_base) {
+	arena_t *arena;
+
+	malloc_mutex_assert_owner(tsd_tsdn(tsd), &ctl_mtx);
+	if (arena_ind >= narenas_total_get() || (arena =
+	    arena_get(tsd_tsdn(tsd), arena_ind, false)) == NULL) {
+		return EFAULT;
+	}
+	if (extent_fd_get(extent_hooks_get(arena), r_fd, r_base)) {
+		/* Not a file-backed arena. */
+		return ENOENT;
+	}
+	return 0;
+}
+
+static int
+arena_i_fd_ctl(tsd_t *tsd, const size_t *mib, size_t miblen, void *oldp,
+    size_t *oldlenp, void *newp, size_t newlen) {
+	int ret;
+	unsigned arena_ind;
+	int fd;
+	void *base;
+
+	malloc_mutex_lock(tsd_tsdn(tsd), &ctl_mtx);
+	READONLY();
+	MIB_UNSIGNED(arena_ind, 1);
+	ret = arena_i_fd_get(tsd, arena_ind, &fd, &base);
+	if (ret != 0) {
+		goto label_return;
+	}
+	READ(fd, int);
+
+	ret = 0;
+label_return:
+	malloc_mutex_unlock(tsd_tsdn(tsd), &ctl_mtx);
+	return ret;
+}
+
+static int
+arena_i_fd_base_ctl(tsd_t *tsd, const size_t *mib, size_t miblen, void *oldp,
+    size_t *oldlenp, void *newp, size_t newlen) {
+	int ret;
+	unsigned arena_ind;
+	int fd;
+	void *base;
+
+	malloc_mutex_lock(tsd_tsdn(tsd), &ctl_mtx);
+	READONLY();
+	MIB_UNSIGNED(arena_ind, 1);
+	ret = arena_i_fd_get(tsd, arena_ind, &fd, &base);
+	if (ret != 0) {
+		goto label_return;
+	}
+	READ(base, void *);
+
+	ret = 0;
+label_return:
+	malloc_mutex_unlock(tsd_tsdn(tsd), &ctl_mtx);
+	return ret;
+}
+
+static int
+arena_i_persistent_root_ctl(tsd_t *tsd, const size_t *mib, size_t miblen,
+    void *oldp, size_t *oldlenp, void *newp, size_t newlen) {
+	int ret;
+	unsigned arena_ind;
+	arena_t *arena;
+	void **root;
+
+	malloc_mutex_lock(tsd_tsdn(tsd), &ctl_mtx);
+	MIB_UNSIGNED(arena_ind, 1);
+	if (arena_ind >= narenas_total_get() || (arena =
+	    arena_get(tsd_tsdn(tsd), arena_ind, false)) == NULL) {
+		ret = EFAULT;
+		goto label_return;
+	}
+	if ((root = extent_fd_persistent_root(extent_hooks_get(arena))) ==
+	    NULL) {
+		ret = ENOENT;
+		goto label_return;
+	}
+	void *old_root = *root;
+	void *new_root = old_root;
+	WRITE(new_root, void *);
+	READ(old_root, void *);
+	*root = new_root;
+
+	ret = 0;
+label_return:
+	malloc_mutex_unlock(tsd_tsdn(tsd), &ctl_mtx);
+	return ret;
+}
+
 static const ctl_named_node_t *
 arena_i_index(tsdn_t *tsdn, const size_t *mib, size_t miblen, size_t i) {
 	const ctl_named_node_t *ret;
@@ -2455,21 +3228,100 @@ arenas_create_ctl(tsd_t *tsd, const size_t *mib, size_t miblen, void *oldp,
     size_t *oldlenp, void *newp, size_t newlen) {
 	int ret;
 	extent_hooks_t *extent_hooks;
+	arena_config_t config;
+	arena_t *arena;
 	unsigned arena_ind;
 
-	malloc_mutex_lock(tsd_tsdn(tsd), &ctl_mtx);
-
 	extent_hooks = (extent_hooks_t *)&extent_hooks_default;
-	WRITE(extent_hooks, extent_hooks_t *);
-	if ((arena_ind = ctl_arena_init(tsd, extent_hooks)) == UINT_MAX) {
+	config.prefault = config.mlock = config.fd_backed = false;
+	if (newp != NULL && newlen == sizeof(arena_config_t)) {
+		WRITE(config, arena_config_t);
+		if (config.fd_backed && (config.extent_hooks != NULL ||
+		    config.fd < -1)) {
+			ret = EINVAL;
+			goto label_return;
+		}
+		if (config.extent_hooks != NULL) {
+			extent_hooks = config.extent_hooks;
+		}
+	} else {
+		WRITE(extent_hooks, extent_hooks_t *);
+	}
+	/* Not under ctl_mtx, since close() may call back into malloc. */
+	if (config.fd_backed && (extent_hooks = extent_fd_new(config.fd)) ==
+	    NULL) {
+		ret = EAGAIN;
+		goto label_return;
+	}
+
+	malloc_mutex_lock(tsd_tsdn(tsd), &ctl_mtx);
+	if ((arena_ind = ctl_arena_init(tsd, extent_hooks, NULL)) ==
+	    UINT_MAX) {
+		malloc_mutex_unlock(tsd_tsdn(tsd), &ctl_mtx);
+		if (config.fd_backed) {
+			extent_fd_delete(extent_hooks);
+		}
 		ret = EAGAIN;
 		goto label_return;
 	}
+	/* Nothing can have allocated from the new arena yet. */
+	arena = arena_get(tsd_tsdn(tsd), arena_ind, false);
+	arena_prefault_set(arena, config.prefault);
+	arena_mlock_set(arena, config.mlock);
+	malloc_mutex_unlock(tsd_tsdn(tsd), &ctl_mtx);
 	READ(arena_ind, unsigned);
 
 	ret = 0;
 label_return:
+	return ret;
+}
+
+static int
+arenas_create_persistent_ctl(tsd_t *tsd, const size_t *mib, size_t miblen,
+    void *oldp, size_t *oldlenp, void *newp, size_t newlen) {
+	int ret;
+	extent_hooks_t *extent_hooks;
+	arena_t *arena;
+	unsigned arena_ind;
+	int fd;
+
+	if (config_prof && opt_prof) {
+		/* Profiling state cannot outlive the process. */
+		ret = ENOENT;
+		goto label_return;
+	}
+	fd = -1;
+	WRITE(fd, int);
+	if (fd < 0) {
+		ret = EINVAL;
+		goto label_return;
+	}
+	if ((extent_hooks = extent_fd_persistent_new(fd, &arena, &ret)) ==
+	    NULL) {
+		goto label_return;
+	}
+	malloc_mutex_lock(tsd_tsdn(tsd), &ctl_mtx);
+	arena_ind = ctl_arena_init(tsd, extent_hooks, arena);
+	if (arena_ind != UINT_MAX && arena == NULL) {
+		/* Record the new arena, so that it can be attached again. */
+		extent_fd_persistent_arena_set(extent_hooks,
+		    arena_get(tsd_tsdn(tsd), arena_ind, false));
+	}
 	malloc_mutex_unlock(tsd_tsdn(tsd), &ctl_mtx);
+	if (arena_ind == UINT_MAX) {
+		if (arena == NULL) {
+			extent_fd_delete(extent_hooks);
+		} else {
+			/* Leave the persisted arena for a later attempt. */
+			extent_fd_persistent_quiesce(extent_hooks);
+		}
+		ret = EAGAIN;
+		goto label_return;
+	}
+	READ(arena_ind, unsigned);
+
+	ret = 0;
+label_return:
 	return ret;
 }
 
@@ -2489,6 +3341,9 @@ arenas_lookup_ctl(tsd_t *tsd, const size_t *mib, size_t miblen, void *oldp,
 	extent = iealloc(tsd_tsdn(tsd), ptr);
 	if (extent == NULL)
 		goto label_return;
+	/* Freed extents stay registered while the arena caches them. */
+	if (extent_state_get(extent) != extent_state_active)
+		goto label_return;
 
 	arena = extent_arena_get(extent);
 	if (arena == NULL)
@@ -2505,6 +3360,60 @@ label_return:
 
 /******************************************************************************/
 
+static int
+heap_freeze_ctl(tsd_t *tsd, const size_t *mib, size_t miblen, void *oldp,
+    size_t *oldlenp, void *newp, size_t newlen) {
+	int ret;
+
+	malloc_mutex_lock(tsd_tsdn(tsd), &ctl_mtx);
+	READONLY();
+	WRITEONLY();
+
+	for (unsigned i = 0; i < narenas_auto; i++) {
+		arena_t *arena = arena_get(tsd_tsdn(tsd), i, false);
+		if (arena == NULL) {
+			continue;
+		}
+		/* Arenas that took over in an earlier freeze get frozen too. */
+		while (arena_is_frozen(arena)) {
+			arena = arena_successor_get(arena);
+		}
+		arena_t *successor = arena_freeze_reusable_get(tsd_tsdn(tsd),
+		    arena);
+		if (successor == NULL) {
+			unsigned successor_ind = ctl_arena_init(tsd,
+			    extent_hooks_get(arena), NULL);
+			if (successor_ind == UINT_MAX) {
+				ret = EAGAIN;
+				goto label_return;
+			}
+			successor = arena_get(tsd_tsdn(tsd), successor_ind,
+			    false);
+		}
+		arena_freeze(tsd_tsdn(tsd), arena, successor);
+	}
+
+	/*
+	 * Other threads' tcaches are flushed once they choose an arena again,
+	 * but the calling thread is typically the one about to fork.  The
+	 * per-CPU caches are shared by all threads, and have to be drained
+	 * now.
+	 */
+	if (tcache_available(tsd)) {
+		tcache_flush(tsd);
+	}
+	if (percpu_cache_enabled) {
+		percpu_cache_flush_all(tsd);
+	}
+
+	ret = 0;
+label_return:
+	malloc_mutex_unlock(tsd_tsdn(tsd), &ctl_mtx);
+	return ret;
+}
+
+/******************************************************************************/
+
 static int
 prof_thread_active_init_ctl(tsd_t *tsd, const size_t *mib, size_t miblen,
     void *oldp, size_t *oldlenp, void *newp, size_t newlen) {
@@ -2642,19 +3551,61 @@ CTL_RO_CGEN(config_stats, stats_metadata_thp, ctl_stats->metadata_thp, size_t)
 CTL_RO_CGEN(config_stats, stats_resident, ctl_stats->resident, size_t)
 CTL_RO_CGEN(config_stats, stats_mapped, ctl_stats->mapped, size_t)
 CTL_RO_CGEN(config_stats, stats_retained, ctl_stats->retained, size_t)
+CTL_RO_CGEN(config_stats, stats_cgroup_limit, ctl_stats->cgroup_limit,
+    size_t)
+CTL_RO_CGEN(config_stats, stats_unpurged_ceiling, ctl_stats->unpurged_ceiling,
+    size_t)
+CTL_RO_CGEN(config_stats, stats_purge_budget_debt,
+    ctl_stats->purge_budget.debt, size_t)
+CTL_RO_CGEN(config_stats, stats_purge_budget_nthrottled,
+    ctl_stats->purge_budget.nthrottled, uint64_t)
+CTL_RO_CGEN(config_stats, stats_purge_budget_max_duration,
+    ctl_stats->purge_budget.max_duration, uint64_t)
+
+CTL_RO_CGEN(config_stats, stats_percpu_cache_ncpus, percpu_cache_ncpus,
+    unsigned)
+CTL_RO_CGEN(config_stats, stats_percpu_cache_ncached,
+    ctl_stats->percpu_cache.ncached, size_t)
+CTL_RO_CGEN(config_stats, stats_percpu_cache_bytes,
+    ctl_stats->percpu_cache.bytes, size_t)
+CTL_RO_CGEN(config_stats, stats_percpu_cache_naborts,
+    ctl_stats->percpu_cache.naborts, uint64_t)
+CTL_RO_CGEN(config_stats, stats_percpu_cache_nfills,
+    ctl_stats->percpu_cache.nfills, uint64_t)
+CTL_RO_CGEN(config_stats, stats_percpu_cache_nflushes,
+    ctl_stats->percpu_cache.nflushes, uint64_t)
+CTL_RO_CGEN(config_stats, stats_percpu_cache_cpus_i_ncached,
+    ctl_stats->percpu_cache.cpus[mib[3]].ncached, size_t)
+CTL_RO_CGEN(config_stats, stats_percpu_cache_cpus_i_bytes,
+    ctl_stats->percpu_cache.cpus[mib[3]].bytes, size_t)
+
+static const ctl_named_node_t *
+stats_percpu_cache_cpus_i_index(tsdn_t *tsdn, const size_t *mib,
+    size_t miblen, size_t i) {
+	if (i >= percpu_cache_ncpus) {
+		return NULL;
+	}
+	return super_stats_percpu_cache_cpus_i_node;
+}
 
 CTL_RO_CGEN(config_stats, stats_background_thread_num_threads,
     ctl_stats->background_thread.num_threads, size_t)
 CTL_RO_CGEN(config_stats, stats_background_thread_num_runs,
     ctl_stats->background_thread.num_runs, uint64_t)
+CTL_RO_CGEN(config_stats, stats_background_thread_num_arena_runs,
+    ctl_stats->background_thread.num_arena_runs, uint64_t)
 CTL_RO_CGEN(config_stats, stats_background_thread_run_interval,
     nstime_ns(&ctl_stats->background_thread.run_interval), uint64_t)
+CTL_RO_CGEN(config_stats, stats_background_thread_pressure_events,
+    ctl_stats->background_thread.pressure_events, uint64_t)
 
 CTL_RO_GEN(stats_arenas_i_dss, arenas_i(mib[2])->dss, const char *)
 CTL_RO_GEN(stats_arenas_i_dirty_decay_ms, arenas_i(mib[2])->dirty_decay_ms,
     ssize_t)
 CTL_RO_GEN(stats_arenas_i_muzzy_decay_ms, arenas_i(mib[2])->muzzy_decay_ms,
     ssize_t)
+CTL_RO_GEN(stats_arenas_i_dirty_decay_ms_effective,
+    arenas_i(mib[2])->dirty_decay_ms_effective, ssize_t)
 CTL_RO_GEN(stats_arenas_i_nthreads, arenas_i(mib[2])->nthreads, unsigned)
 CTL_RO_GEN(stats_arenas_i_uptime,
     nstime_ns(&arenas_i(mib[2])->astats->astats.uptime), uint64_t)
@@ -2667,6 +3618,15 @@ CTL_RO_CGEN(config_stats, stats_arenas_i_mapped,
 CTL_RO_CGEN(config_stats, stats_arenas_i_retained,
     atomic_load_zu(&arenas_i(mib[2])->astats->astats.retained, ATOMIC_RELAXED),
     size_t)
+CTL_RO_CGEN(config_stats, stats_arenas_i_retained_peak,
+    atomic_load_zu(&arenas_i(mib[2])->astats->astats.retained_peak,
+    ATOMIC_RELAXED), size_t)
+CTL_RO_CGEN(config_stats, stats_arenas_i_retained_ntrims,
+    ctl_arena_stats_read_u64(
+    &arenas_i(mib[2])->astats->astats.retained_ntrims), uint64_t)
+CTL_RO_CGEN(config_stats, stats_arenas_i_retained_trimmed,
+    ctl_arena_stats_read_u64(
+    &arenas_i(mib[2])->astats->astats.retained_trimmed), uint64_t)
 
 CTL_RO_CGEN(config_stats, stats_arenas_i_dirty_npurge,
     ctl_arena_stats_read_u64(
@@ -2674,6 +3634,10 @@ CTL_RO_CGEN(config_stats, stats_arenas_i_dirty_npurge,
 CTL_RO_CGEN(config_stats, stats_arenas_i_dirty_nmadvise,
     ctl_arena_stats_read_u64(
     &arenas_i(mib[2])->astats->astats.decay_dirty.nmadvise), uint64_t)
+CTL_RO_CGEN(config_stats, stats_arenas_i_dirty_nmadvise_saved,
+    ctl_arena_stats_read_u64(
+    &arenas_i(mib[2])->astats->astats.decay_dirty.nmadvise_saved),
+    uint64_t)
 CTL_RO_CGEN(config_stats, stats_arenas_i_dirty_purged,
     ctl_arena_stats_read_u64(
     &arenas_i(mib[2])->astats->astats.decay_dirty.purged), uint64_t)
@@ -2684,10 +3648,42 @@ CTL_RO_CGEN(config_stats, stats_arenas_i_muzzy_npurge,
 CTL_RO_CGEN(config_stats, stats_arenas_i_muzzy_nmadvise,
     ctl_arena_stats_read_u64(
     &arenas_i(mib[2])->astats->astats.decay_muzzy.nmadvise), uint64_t)
+CTL_RO_CGEN(config_stats, stats_arenas_i_muzzy_nmadvise_saved,
+    ctl_arena_stats_read_u64(
+    &arenas_i(mib[2])->astats->astats.decay_muzzy.nmadvise_saved),
+    uint64_t)
 CTL_RO_CGEN(config_stats, stats_arenas_i_muzzy_purged,
     ctl_arena_stats_read_u64(
     &arenas_i(mib[2])->astats->astats.decay_muzzy.purged), uint64_t)
 
+CTL_RO_CGEN(config_stats, stats_arenas_i_extent_steals,
+    ctl_arena_stats_read_u64(&arenas_i(mib[2])->astats->astats.nsteals),
+    uint64_t)
+CTL_RO_CGEN(config_stats, stats_arenas_i_extent_stolen,
+    ctl_arena_stats_read_u64(&arenas_i(mib[2])->astats->astats.stolen),
+    uint64_t)
+CTL_RO_CGEN(config_stats, stats_arenas_i_prefaulted,
+    ctl_arena_stats_read_u64(&arenas_i(mib[2])->astats->astats.prefaulted),
+    uint64_t)
+CTL_RO_CGEN(config_stats, stats_arenas_i_mlocked,
+    ctl_arena_stats_read_u64(&arenas_i(mib[2])->astats->astats.mlocked),
+    uint64_t)
+CTL_RO_CGEN(config_stats, stats_arenas_i_lazy_nselected,
+    ctl_arena_stats_read_u64(
+    &arenas_i(mib[2])->astats->astats.lazy_nselected), uint64_t)
+CTL_RO_CGEN(config_stats, stats_arenas_i_forced_nselected,
+    ctl_arena_stats_read_u64(
+    &arenas_i(mib[2])->astats->astats.forced_nselected), uint64_t)
+CTL_RO_CGEN(config_stats, stats_arenas_i_lazy_purged,
+    ctl_arena_stats_read_u64(
+    &arenas_i(mib[2])->astats->astats.lazy_purged), uint64_t)
+CTL_RO_CGEN(config_stats, stats_arenas_i_lazy_reclaimed,
+    ctl_arena_stats_read_u64(
+    &arenas_i(mib[2])->astats->astats.lazy_reclaimed), uint64_t)
+CTL_RO_CGEN(config_stats, stats_arenas_i_forced_purged,
+    ctl_arena_stats_read_u64(
+    &arenas_i(mib[2])->astats->astats.forced_purged), uint64_t)
+
 CTL_RO_CGEN(config_stats, stats_arenas_i_base,
     atomic_load_zu(&arenas_i(mib[2])->astats->astats.base, ATOMIC_RELAXED),
     size_t)
@@ -2833,6 +3829,8 @@ CTL_RO_CGEN(config_stats, stats_arenas_i_bins_j_nreslabs,
     arenas_i(mib[2])->astats->bstats[mib[4]].reslabs, uint64_t)
 CTL_RO_CGEN(config_stats, stats_arenas_i_bins_j_curslabs,
     arenas_i(mib[2])->astats->bstats[mib[4]].curslabs, size_t)
+CTL_RO_CGEN(config_stats, stats_arenas_i_bins_j_curslabs_empty,
+    arenas_i(mib[2])->astats->bstats[mib[4]].curslabs_empty, size_t)
 
 static const ctl_named_node_t *
 stats_arenas_i_bins_j_index(tsdn_t *tsdn, const size_t *mib, size_t miblen,
@@ -2864,6 +3862,37 @@ stats_arenas_i_lextents_j_index(tsdn_t *tsdn, const size_t *mib, size_t miblen,
 	return super_stats_arenas_i_lextents_j_node;
 }
 
+CTL_RO_CGEN(config_stats, stats_arenas_i_reuse_ages_j_npages,
+    ctl_arena_stats_read_u64(
+    &arenas_i(mib[2])->astats->astats.reuse_ages[mib[4]]), uint64_t)
+
+static const ctl_named_node_t *
+stats_arenas_i_reuse_ages_j_index(tsdn_t *tsdn, const size_t *mib,
+    size_t miblen, size_t j) {
+	if (j >= REUSE_AGE_NBUCKETS) {
+		return NULL;
+	}
+	return super_stats_arenas_i_reuse_ages_j_node;
+}
+
+#define OP(op)								\
+CTL_RO_CGEN(config_stats, stats_arenas_i_latency_##op##_j_background,	\
+    ctl_arena_stats_read_u64(&arenas_i(mib[2])->astats->astats.latency[	\
+    latency_op_##op][1][mib[5]]), uint64_t)				\
+CTL_RO_CGEN(config_stats, stats_arenas_i_latency_##op##_j_application,	\
+    ctl_arena_stats_read_u64(&arenas_i(mib[2])->astats->astats.latency[	\
+    latency_op_##op][0][mib[5]]), uint64_t)				\
+static const ctl_named_node_t *						\
+stats_arenas_i_latency_##op##_j_index(tsdn_t *tsdn, const size_t *mib,	\
+    size_t miblen, size_t j) {						\
+	if (j >= LATENCY_NBUCKETS) {					\
+		return NULL;						\
+	}								\
+	return super_stats_arenas_i_latency_##op##_j_node;		\
+}
+LATENCY_OPS
+#undef OP
+
 static const ctl_named_node_t *
 stats_arenas_i_index(tsdn_t *tsdn, const size_t *mib, size_t miblen, size_t i) {
 	const ctl_named_node_t *ret;
@@ -4,6 +4,7 @@
 
 #include "jemalloc/internal/assert.h"
 #include "jemalloc/internal/extent_dss.h"
+#include "jemalloc/internal/extent_fd.h"
 #include "jemalloc/internal/extent_mmap.h"
 #include "jemalloc/internal/ph.h"
 #include "jemalloc/internal/rtree.h"
@@ -19,6 +20,12 @@ mutex_pool_t	extent_mutex_pool;
 
 size_t opt_lg_extent_max_active_fit = LG_EXTENT_MAX_ACTIVE_FIT_DEFAULT;
 
+extent_reuse_t opt_extent_reuse = EXTENT_REUSE_DEFAULT;
+const char *extent_reuse_names[] = {
+	"fit",
+	"lifo"
+};
+
 static const bitmap_info_t extents_bitmap_info =
     BITMAP_INFO_INITIALIZER(NPSIZES+1);
 
@@ -109,7 +116,7 @@ static void extent_deregister(tsdn_t *tsdn, extent_t *extent);
 static extent_t *extent_recycle(tsdn_t *tsdn, arena_t *arena,
     extent_hooks_t **r_extent_hooks, extents_t *extents, void *new_addr,
     size_t usize, size_t pad, size_t alignment, bool slab, szind_t szind,
-    bool *zero, bool *commit, bool growing_retained);
+    bool *zero, bool *commit, bool growing_retained, bool trylock);
 static extent_t *extent_try_coalesce(tsdn_t *tsdn, arena_t *arena,
     extent_hooks_t **r_extent_hooks, rtree_ctx_t *rtree_ctx, extents_t *extents,
     extent_t *extent, bool *coalesced, bool growing_retained);
@@ -173,8 +180,84 @@ extent_lock_from_addr(tsdn_t *tsdn, rtree_ctx_t *rtree_ctx, void *addr) {
 	return ret;
 }
 
+/*
+ * Return the calling thread's extent_t magazine if it may cache structures
+ * from arena, or NULL if the shared extent_avail heap must be used instead.
+ */
+static extent_cache_t *
+extent_cache_get(tsdn_t *tsdn, arena_t *arena) {
+	if (tsdn_null(tsdn)) {
+		return NULL;
+	}
+	tsd_t *tsd = tsdn_tsd(tsdn);
+	if (!tsd_nominal(tsd) || tsd_arena_get(tsd) != arena) {
+		return NULL;
+	}
+	extent_cache_t *cache = tsd_extent_cachep_get(tsd);
+	if (cache->arena != arena) {
+		assert(cache->ncached == 0);
+		cache->arena = arena;
+	}
+	return cache;
+}
+
+/* Move the nflush bottommost cached structures back to extent_avail. */
+static void
+extent_cache_flush_impl(tsdn_t *tsdn, extent_cache_t *cache,
+    unsigned nflush) {
+	assert(nflush <= cache->ncached);
+	if (nflush == 0) {
+		return;
+	}
+	arena_t *arena = cache->arena;
+	malloc_mutex_lock(tsdn, &arena->extent_avail_mtx);
+	for (unsigned i = 0; i < nflush; i++) {
+		extent_avail_insert(&arena->extent_avail, cache->cached[i]);
+	}
+	malloc_mutex_unlock(tsdn, &arena->extent_avail_mtx);
+	memmove(&cache->cached[0], &cache->cached[nflush],
+	    (cache->ncached - nflush) * sizeof(extent_t *));
+	cache->ncached -= nflush;
+}
+
+void
+extent_cache_flush(tsd_t *tsd) {
+	extent_cache_t *cache = tsd_extent_cachep_get(tsd);
+	if (cache->arena != NULL) {
+		extent_cache_flush_impl(tsd_tsdn(tsd), cache, cache->ncached);
+		cache->arena = NULL;
+	}
+	assert(cache->ncached == 0);
+}
+
+static void
+extent_cache_fill(tsdn_t *tsdn, arena_t *arena, extent_cache_t *cache) {
+	assert(cache->ncached == 0);
+	malloc_mutex_lock(tsdn, &arena->extent_avail_mtx);
+	while (cache->ncached < EXTENT_CACHE_NBATCH) {
+		extent_t *extent = extent_avail_first(&arena->extent_avail);
+		if (extent == NULL) {
+			break;
+		}
+		extent_avail_remove(&arena->extent_avail, extent);
+		cache->cached[cache->ncached++] = extent;
+	}
+	malloc_mutex_unlock(tsdn, &arena->extent_avail_mtx);
+}
+
 extent_t *
 extent_alloc(tsdn_t *tsdn, arena_t *arena) {
+	extent_cache_t *cache = extent_cache_get(tsdn, arena);
+	if (cache != NULL) {
+		if (cache->ncached == 0) {
+			extent_cache_fill(tsdn, arena, cache);
+		}
+		if (cache->ncached > 0) {
+			return cache->cached[--cache->ncached];
+		}
+		return base_alloc_extent(tsdn, arena->base);
+	}
+
 	malloc_mutex_lock(tsdn, &arena->extent_avail_mtx);
 	extent_t *extent = extent_avail_first(&arena->extent_avail);
 	if (extent == NULL) {
@@ -188,6 +271,16 @@ extent_alloc(tsdn_t *tsdn, arena_t *arena) {
 
 void
 extent_dalloc(tsdn_t *tsdn, arena_t *arena, extent_t *extent) {
+	extent_cache_t *cache = extent_cache_get(tsdn, arena);
+	if (cache != NULL) {
+		if (cache->ncached == EXTENT_CACHE_NCACHED) {
+			extent_cache_flush_impl(tsdn, cache,
+			    EXTENT_CACHE_NBATCH);
+		}
+		cache->cached[cache->ncached++] = extent;
+		return;
+	}
+
 	malloc_mutex_lock(tsdn, &arena->extent_avail_mtx);
 	extent_avail_insert(&arena->extent_avail, extent);
 	malloc_mutex_unlock(tsdn, &arena->extent_avail_mtx);
@@ -290,6 +383,7 @@ extents_init(tsdn_t *tsdn, extents_t *extents, extent_state_t state,
 	bitmap_init(extents->bitmap, &extents_bitmap_info, true);
 	extent_list_init(&extents->lru);
 	atomic_store_zu(&extents->npages, 0, ATOMIC_RELAXED);
+	atomic_store_zu(&extents->npages_peak, 0, ATOMIC_RELAXED);
 	extents->state = state;
 	extents->delay_coalesce = delay_coalesce;
 	return false;
@@ -305,6 +399,11 @@ extents_npages_get(extents_t *extents) {
 	return atomic_load_zu(&extents->npages, ATOMIC_RELAXED);
 }
 
+size_t
+extents_npages_peak_get(extents_t *extents) {
+	return atomic_load_zu(&extents->npages_peak, ATOMIC_RELAXED);
+}
+
 static void
 extents_insert_locked(tsdn_t *tsdn, extents_t *extents, extent_t *extent) {
 	malloc_mutex_assert_owner(tsdn, &extents->mtx);
@@ -329,6 +428,11 @@ extents_insert_locked(tsdn_t *tsdn, extents_t *extents, extent_t *extent) {
 	    atomic_load_zu(&extents->npages, ATOMIC_RELAXED);
 	atomic_store_zu(&extents->npages, cur_extents_npages + npages,
 	    ATOMIC_RELAXED);
+	if (cur_extents_npages + npages > atomic_load_zu(&extents->npages_peak,
+	    ATOMIC_RELAXED)) {
+		atomic_store_zu(&extents->npages_peak, cur_extents_npages +
+		    npages, ATOMIC_RELAXED);
+	}
 }
 
 static void
@@ -454,6 +558,31 @@ extents_first_fit_locked(tsdn_t *tsdn, arena_t *arena, extents_t *extents,
 	return ret;
 }
 
+/*
+ * Cache-warm selection: walk the LRU from its most recently inserted end and
+ * return the first extent that is large enough, so that alloc/free churn keeps
+ * reusing pages that are still resident.  Only near-exact fits are accepted,
+ * since splitting a recently freed large extent would scatter the warm pages
+ * and fragment the address space.  Only a bounded number of
+ * entries is examined; NULL means the caller should fall back to first-fit.
+ */
+static extent_t *
+extents_lifo_fit_locked(tsdn_t *tsdn, arena_t *arena, extents_t *extents,
+    size_t size) {
+	unsigned nscan = 0;
+	for (extent_t *extent = extent_list_last(&extents->lru); extent !=
+	    NULL && nscan < EXTENT_REUSE_LIFO_NSCAN; extent =
+	    ql_prev(&extents->lru, extent, ql_link), nscan++) {
+		size_t extent_size = extent_size_get(extent);
+		if (extent_size >= size && (extent_size >>
+		    LG_EXTENT_REUSE_LIFO_MAX_FIT) <= size) {
+			return extent;
+		}
+	}
+
+	return NULL;
+}
+
 /*
  * Do {best,first}-fit extent selection, where the selection policy choice is
  * based on extents->delay_coalesce.  Best-fit selection requires less
@@ -481,8 +610,16 @@ extents_fit_locked(tsdn_t *tsdn, arena_t *arena, extents_t *extents,
 	    extents_best_fit_locked(tsdn, arena, extents, max_size) :
 	    extents_first_fit_locked(tsdn, arena, extents, max_size);
 #endif
-	extent_t *extent =
-	    extents_first_fit_locked(tsdn, arena, extents, max_size);
+	extent_t *extent = NULL;
+	if (extents_state_get(extents) == extent_state_dirty &&
+	    arena_extent_reuse_get(arena) == extent_reuse_lifo) {
+		extent = extents_lifo_fit_locked(tsdn, arena, extents,
+		    max_size);
+	}
+	if (extent == NULL) {
+		extent = extents_first_fit_locked(tsdn, arena, extents,
+		    max_size);
+	}
 
 	if (alignment > PAGE && extent == NULL) {
 		/*
@@ -524,8 +661,46 @@ extents_alloc(tsdn_t *tsdn, arena_t *arena, extent_hooks_t **r_extent_hooks,
 	    WITNESS_RANK_CORE, 0);
 
 	extent_t *extent = extent_recycle(tsdn, arena, r_extent_hooks, extents,
-	    new_addr, size, pad, alignment, slab, szind, zero, commit, false);
+	    new_addr, size, pad, alignment, slab, szind, zero, commit, false,
+	    false);
 	assert(extent == NULL || extent_dumpable_get(extent));
+	if (extent != NULL && extents_state_get(extents) !=
+	    extent_state_dirty) {
+		arena_extent_populate(tsdn, arena, extent);
+	}
+	return extent;
+}
+
+/*
+ * Takes an extent out of victim's dirty extents and hands it over to arena.
+ * Gives up rather than waiting if victim's extents_dirty is contended.  Both
+ * arenas must use the default extent hooks, and victim must never be
+ * destroyed, since the extent_t itself stays allocated from victim's base.
+ */
+extent_t *
+extents_steal(tsdn_t *tsdn, arena_t *arena, arena_t *victim, size_t size,
+    size_t pad, size_t alignment, bool slab, szind_t szind, bool *zero,
+    bool *commit) {
+	assert(arena != victim);
+	assert(size + pad != 0);
+	assert(alignment != 0);
+	witness_assert_depth_to_rank(tsdn_witness_tsdp_get(tsdn),
+	    WITNESS_RANK_CORE, 0);
+
+	extent_hooks_t *extent_hooks = EXTENT_HOOKS_INITIALIZER;
+	extent_t *extent = extent_recycle(tsdn, victim, &extent_hooks,
+	    &victim->extents_dirty, NULL, size, pad, alignment, slab, szind,
+	    zero, commit, false, true);
+	if (extent == NULL) {
+		return NULL;
+	}
+	assert(extent_dumpable_get(extent));
+	assert(extent_state_get(extent) == extent_state_active);
+	/*
+	 * Active extents are never coalesced, so nothing else can observe the
+	 * owner changing here.
+	 */
+	extent_arena_set(extent, arena);
 	return extent;
 }
 
@@ -856,6 +1031,23 @@ extent_deregister_no_gdump_sub(tsdn_t *tsdn, extent_t *extent) {
 	extent_deregister_impl(tsdn, extent, false);
 }
 
+/*
+ * Registers an extent that already belongs to an arena, e.g. one that was
+ * mapped back in from a persistent file.
+ */
+bool
+extent_attach(tsdn_t *tsdn, extent_t *extent) {
+	return extent_register_no_gdump_add(tsdn, extent);
+}
+
+/* Undoes extent_attach(), leaving the extent itself unchanged. */
+void
+extent_detach(tsdn_t *tsdn, extent_t *extent) {
+	bool slab = extent_slab_get(extent);
+	extent_deregister_no_gdump_sub(tsdn, extent);
+	extent_slab_set(extent, slab);
+}
+
 /*
  * Tries to find and remove an extent from extents that can be used for the
  * given allocation request.
@@ -864,10 +1056,11 @@ static extent_t *
 extent_recycle_extract(tsdn_t *tsdn, arena_t *arena,
     extent_hooks_t **r_extent_hooks, rtree_ctx_t *rtree_ctx, extents_t *extents,
     void *new_addr, size_t size, size_t pad, size_t alignment, bool slab,
-    bool growing_retained) {
+    bool growing_retained, bool trylock) {
 	witness_assert_depth_to_rank(tsdn_witness_tsdp_get(tsdn),
 	    WITNESS_RANK_CORE, growing_retained ? 1 : 0);
 	assert(alignment > 0);
+	assert(!trylock || new_addr == NULL);
 	if (config_debug && new_addr != NULL) {
 		/*
 		 * Non-NULL new_addr has two use cases:
@@ -886,7 +1079,13 @@ extent_recycle_extract(tsdn_t *tsdn, arena_t *arena,
 	}
 
 	size_t esize = size + pad;
-	malloc_mutex_lock(tsdn, &extents->mtx);
+	if (trylock) {
+		if (malloc_mutex_trylock(tsdn, &extents->mtx)) {
+			return NULL;
+		}
+	} else {
+		malloc_mutex_lock(tsdn, &extents->mtx);
+	}
 	extent_hooks_assure_initialized(arena, r_extent_hooks);
 	extent_t *extent;
 	if (new_addr != NULL) {
@@ -1077,7 +1276,7 @@ static extent_t *
 extent_recycle(tsdn_t *tsdn, arena_t *arena, extent_hooks_t **r_extent_hooks,
     extents_t *extents, void *new_addr, size_t size, size_t pad,
     size_t alignment, bool slab, szind_t szind, bool *zero, bool *commit,
-    bool growing_retained) {
+    bool growing_retained, bool trylock) {
 	witness_assert_depth_to_rank(tsdn_witness_tsdp_get(tsdn),
 	    WITNESS_RANK_CORE, growing_retained ? 1 : 0);
 	assert(new_addr == NULL || !slab);
@@ -1089,10 +1288,11 @@ extent_recycle(tsdn_t *tsdn, arena_t *arena, extent_hooks_t **r_extent_hooks,
 
 	extent_t *extent = extent_recycle_extract(tsdn, arena, r_extent_hooks,
 	    rtree_ctx, extents, new_addr, size, pad, alignment, slab,
-	    growing_retained);
+	    growing_retained, trylock);
 	if (extent == NULL) {
 		return NULL;
 	}
+	uint64_t dirtied_ns = extent_dirtied_ns_get(extent);
 
 	extent = extent_recycle_split(tsdn, arena, r_extent_hooks, rtree_ctx,
 	    extents, new_addr, size, pad, alignment, slab, szind, extent,
@@ -1100,6 +1300,15 @@ extent_recycle(tsdn_t *tsdn, arena_t *arena, extent_hooks_t **r_extent_hooks,
 	if (extent == NULL) {
 		return NULL;
 	}
+	if (dirtied_ns != 0) {
+		/*
+		 * Reuse from extents_muzzy or extents_retained is a refault of
+		 * pages that were dirtied earlier.
+		 */
+		arena_decay_reuse_sample(tsdn, arena, dirtied_ns,
+		    (size + pad) >> LG_PAGE);
+		extent_dirtied_ns_set(extent, 0);
+	}
 
 	if (*commit && !extent_committed_get(extent)) {
 		if (extent_commit_impl(tsdn, arena, r_extent_hooks, extent,
@@ -1252,6 +1461,8 @@ extent_grow_retained(tsdn_t *tsdn, arena_t *arena,
 	if (alloc_size_min < esize) {
 		goto label_err;
 	}
+	bool trimmed = false;
+label_retry:;
 	/*
 	 * Find the next extent size in the series that would be large enough to
 	 * satisfy this request.
@@ -1275,6 +1486,11 @@ extent_grow_retained(tsdn_t *tsdn, arena_t *arena,
 	bool zeroed = false;
 	bool committed = false;
 
+	nstime_t start;
+	if (config_stats) {
+		nstime_init(&start, 0);
+		nstime_update_precise(&start);
+	}
 	void *ptr;
 	if (*r_extent_hooks == &extent_hooks_default) {
 		ptr = extent_alloc_default_impl(tsdn, arena, NULL,
@@ -1286,12 +1502,33 @@ extent_grow_retained(tsdn_t *tsdn, arena_t *arena,
 		    arena_ind_get(arena));
 		extent_hook_post_reentrancy(tsdn);
 	}
+	if (config_stats) {
+		arena_latency_record(tsdn, arena, latency_op_map, &start);
+	}
 
 	extent_init(extent, arena, ptr, alloc_size, false, NSIZES,
 	    arena_extent_sn_next(arena), extent_state_active, zeroed,
 	    committed, true);
 	if (ptr == NULL) {
 		extent_dalloc(tsdn, arena, extent);
+		if (trimmed) {
+			goto label_err;
+		}
+		/*
+		 * Address space may have run out.  The retry starts the series
+		 * over, so give back just enough retained memory for the
+		 * smallest mapping that fits the request, and retry if that
+		 * helped.
+		 */
+		trimmed = true;
+		size_t retry_size = sz_pind2sz(sz_psz2ind((alloc_size_min >
+		    HUGEPAGE) ? alloc_size_min : HUGEPAGE));
+		malloc_mutex_unlock(tsdn, &arena->extent_grow_mtx);
+		bool retry = arena_retained_trim(tsdn, arena, retry_size);
+		malloc_mutex_lock(tsdn, &arena->extent_grow_mtx);
+		if (retry) {
+			goto label_retry;
+		}
 		goto label_err;
 	}
 
@@ -1413,7 +1650,7 @@ extent_alloc_retained(tsdn_t *tsdn, arena_t *arena,
 
 	extent_t *extent = extent_recycle(tsdn, arena, r_extent_hooks,
 	    &arena->extents_retained, new_addr, size, pad, alignment, slab,
-	    szind, zero, commit, true);
+	    szind, zero, commit, true, false);
 	if (extent != NULL) {
 		malloc_mutex_unlock(tsdn, &arena->extent_grow_mtx);
 		if (config_prof) {
@@ -1440,6 +1677,11 @@ extent_alloc_wrapper_hard(tsdn_t *tsdn, arena_t *arena,
 	if (extent == NULL) {
 		return NULL;
 	}
+	nstime_t start;
+	if (config_stats) {
+		nstime_init(&start, 0);
+		nstime_update_precise(&start);
+	}
 	void *addr;
 	if (*r_extent_hooks == &extent_hooks_default) {
 		/* Call directly to propagate tsdn. */
@@ -1451,6 +1693,9 @@ extent_alloc_wrapper_hard(tsdn_t *tsdn, arena_t *arena,
 		    esize, alignment, zero, commit, arena_ind_get(arena));
 		extent_hook_post_reentrancy(tsdn);
 	}
+	if (config_stats) {
+		arena_latency_record(tsdn, arena, latency_op_map, &start);
+	}
 	if (addr == NULL) {
 		extent_dalloc(tsdn, arena, extent);
 		return NULL;
@@ -1496,6 +1741,9 @@ extent_alloc_wrapper(tsdn_t *tsdn, arena_t *arena,
 	}
 
 	assert(extent == NULL || extent_dumpable_get(extent));
+	if (extent != NULL) {
+		arena_extent_populate(tsdn, arena, extent);
+	}
 	return extent;
 }
 
@@ -1618,6 +1866,7 @@ extent_record(tsdn_t *tsdn, arena_t *arena, extent_hooks_t **r_extent_hooks,
 	assert((extents_state_get(extents) != extent_state_dirty &&
 	    extents_state_get(extents) != extent_state_muzzy) ||
 	    !extent_zeroed_get(extent));
+	size_t npages = extent_size_get(extent) >> LG_PAGE;
 
 	malloc_mutex_lock(tsdn, &extents->mtx);
 	extent_hooks_assure_initialized(arena, r_extent_hooks);
@@ -1647,6 +1896,10 @@ extent_record(tsdn_t *tsdn, arena_t *arena, extent_hooks_t **r_extent_hooks,
 		} while (coalesced &&
 		    extent_size_get(extent) >= prev_size + LARGE_MINCLASS);
 	}
+	if (extents_state_get(extents) == extent_state_dirty) {
+		extent_dirtied_ns_set(extent, arena_decay_reuse_stamp(arena,
+		    npages));
+	}
 	extent_deactivate_locked(tsdn, arena, extents, extent);
 
 	malloc_mutex_unlock(tsdn, &extents->mtx);
@@ -1769,6 +2022,36 @@ extent_dalloc_wrapper(tsdn_t *tsdn, arena_t *arena,
 	    extent, false);
 }
 
+/*
+ * Whether extent_dalloc_wrapper() would end up purging the extent with
+ * pages_purge_forced() and retaining it.  If so, the caller may purge it as
+ * part of a batch and pass it to extent_dalloc_purged_wrapper() instead.
+ */
+bool
+extent_dalloc_batchable(arena_t *arena, extent_hooks_t **r_extent_hooks,
+    extent_t *extent) {
+	extent_hooks_assure_initialized(arena, r_extent_hooks);
+	return (*r_extent_hooks == &extent_hooks_default && opt_retain &&
+	    extent_committed_get(extent) && !pages_decommit_enabled());
+}
+
+void
+extent_dalloc_purged_wrapper(tsdn_t *tsdn, arena_t *arena,
+    extent_hooks_t **r_extent_hooks, extent_t *extent) {
+	assert(extent_dumpable_get(extent));
+	assert(extent_dalloc_batchable(arena, r_extent_hooks, extent));
+	witness_assert_depth_to_rank(tsdn_witness_tsdp_get(tsdn),
+	    WITNESS_RANK_CORE, 0);
+
+	extent_zeroed_set(extent, true);
+	if (config_prof) {
+		extent_gdump_sub(tsdn, extent);
+	}
+
+	extent_record(tsdn, arena, r_extent_hooks, &arena->extents_retained,
+	    extent, false);
+}
+
 static void
 extent_destroy_default_impl(void *addr, size_t size) {
 	if (!have_dss || !extent_in_dss(addr)) {
@@ -1812,6 +2095,65 @@ extent_destroy_wrapper(tsdn_t *tsdn, arena_t *arena,
 	extent_dalloc(tsdn, arena, extent);
 }
 
+/*
+ * Unmaps the least recently used retained extents until at most npages_max
+ * pages remain retained.  Returns the number of bytes unmapped.
+ */
+size_t
+extent_retained_trim(tsdn_t *tsdn, arena_t *arena,
+    extent_hooks_t **r_extent_hooks, size_t npages_max) {
+	witness_assert_depth_to_rank(tsdn_witness_tsdp_get(tsdn),
+	    WITNESS_RANK_CORE, 0);
+
+	extent_hooks_assure_initialized(arena, r_extent_hooks);
+	if (*r_extent_hooks != &extent_hooks_default &&
+	    (*r_extent_hooks)->destroy == NULL) {
+		/* Nothing would be unmapped; keep the extents for reuse. */
+		return 0;
+	}
+	int fd;
+	void *base;
+	if (!extent_fd_get(*r_extent_hooks, &fd, &base)) {
+		/*
+		 * A file window hands each range out only once, and retained
+		 * extents there had their pages punched out when purged, so
+		 * destroying them would only shrink the window for good.
+		 */
+		return 0;
+	}
+
+	size_t trimmed = 0;
+	extent_list_t dss_extents;
+	extent_list_init(&dss_extents);
+	extent_t *extent;
+	while ((extent = extents_evict(tsdn, arena, r_extent_hooks,
+	    &arena->extents_retained, npages_max)) != NULL) {
+		if (*r_extent_hooks == &extent_hooks_default && have_dss &&
+		    extent_in_dss(extent_base_get(extent))) {
+			/*
+			 * The dss cannot be unmapped.  Set the extent aside,
+			 * still counting against the limit, and go on with the
+			 * less recently used extents behind it.
+			 */
+			size_t npages = extent_size_get(extent) >> LG_PAGE;
+			npages_max -= (npages < npages_max) ? npages :
+			    npages_max;
+			extent_list_append(&dss_extents, extent);
+			continue;
+		}
+		trimmed += extent_size_get(extent);
+		extent_destroy_wrapper(tsdn, arena, r_extent_hooks, extent);
+	}
+	while ((extent = extent_list_first(&dss_extents)) != NULL) {
+		extent_list_remove(&dss_extents, extent);
+		extent_state_set(extent, extent_state_active);
+		extent_reregister(tsdn, extent);
+		extent_record(tsdn, arena, r_extent_hooks,
+		    &arena->extents_retained, extent, false);
+	}
+	return trimmed;
+}
+
 static bool
 extent_commit_default(extent_hooks_t *extent_hooks, void *addr, size_t size,
     size_t offset, size_t length, unsigned arena_ind) {
@@ -1904,6 +2246,11 @@ extent_purge_lazy_impl(tsdn_t *tsdn, arena_t *arena,
 	if ((*r_extent_hooks)->purge_lazy == NULL) {
 		return true;
 	}
+	nstime_t start;
+	if (config_stats) {
+		nstime_init(&start, 0);
+		nstime_update_precise(&start);
+	}
 	if (*r_extent_hooks != &extent_hooks_default) {
 		extent_hook_pre_reentrancy(tsdn, arena);
 	}
@@ -1913,6 +2260,9 @@ extent_purge_lazy_impl(tsdn_t *tsdn, arena_t *arena,
 	if (*r_extent_hooks != &extent_hooks_default) {
 		extent_hook_post_reentrancy(tsdn);
 	}
+	if (config_stats) {
+		arena_latency_record(tsdn, arena, latency_op_purge, &start);
+	}
 
 	return err;
 }
@@ -1951,6 +2301,11 @@ extent_purge_forced_impl(tsdn_t *tsdn, arena_t *arena,
 	if ((*r_extent_hooks)->purge_forced == NULL) {
 		return true;
 	}
+	nstime_t start;
+	if (config_stats) {
+		nstime_init(&start, 0);
+		nstime_update_precise(&start);
+	}
 	if (*r_extent_hooks != &extent_hooks_default) {
 		extent_hook_pre_reentrancy(tsdn, arena);
 	}
@@ -1960,6 +2315,9 @@ extent_purge_forced_impl(tsdn_t *tsdn, arena_t *arena,
 	if (*r_extent_hooks != &extent_hooks_default) {
 		extent_hook_post_reentrancy(tsdn);
 	}
+	if (config_stats) {
+		arena_latency_record(tsdn, arena, latency_op_purge, &start);
+	}
 	return err;
 }
 
@@ -2010,6 +2368,8 @@ extent_split_impl(tsdn_t *tsdn, arena_t *arena,
 	    size_a), size_b, slab_b, szind_b, extent_sn_get(extent),
 	    extent_state_get(extent), extent_zeroed_get(extent),
 	    extent_committed_get(extent), extent_dumpable_get(extent));
+	/* The trail keeps the age of the pages it came from. */
+	extent_dirtied_ns_set(trail, extent_dirtied_ns_get(extent));
 
 	rtree_ctx_t rtree_ctx_fallback;
 	rtree_ctx_t *rtree_ctx = tsdn_rtree_ctx(tsdn, &rtree_ctx_fallback);
@@ -2180,6 +2540,20 @@ extent_boot(void) {
 		return true;
 	}
 
+	if (opt_reserve_va != 0) {
+		/* Without the region, extents are simply mapped one by one. */
+		void *base;
+		size_t size;
+		if (extent_mmap_reserve(&base, &size) ||
+		    rtree_flat_init(&extents_rtree, base, size)) {
+			malloc_write("<jemalloc>: Error reserving address space "
+			    "for opt.reserve_va\n");
+			if (opt_abort) {
+				abort();
+			}
+		}
+	}
+
 	if (mutex_pool_init(&extent_mutex_pool, "extent_mutex_pool",
 	    WITNESS_RANK_EXTENT_POOL)) {
 		return true;
@@ -0,0 +1,467 @@
+#define JEMALLOC_EXTENT_FD_C_
+#include "jemalloc/internal/jemalloc_preamble.h"
+#include "jemalloc/internal/jemalloc_internal_includes.h"
+
+#include "jemalloc/internal/assert.h"
+#include "jemalloc/internal/extent_fd.h"
+
+#include <sys/stat.h>
+
+#if defined(__linux__) && defined(SYS_memfd_create) &&			\
+    defined(FALLOC_FL_PUNCH_HOLE) && defined(FALLOC_FL_KEEP_SIZE)
+#  define EXTENT_FD_SUPPORTED
+#  ifndef MFD_CLOEXEC
+#    define MFD_CLOEXEC 1U
+#  endif
+#endif
+
+/******************************************************************************/
+/* Data. */
+
+size_t opt_persistent_addr = 0;
+
+#define EXTENT_FD_MAGIC		UINT64_C(0x636f6c6c616d656a) /* "jemalloc" */
+#define EXTENT_FD_VERSION	1
+
+/* The build's metadata layout, which a persisted arena relies on. */
+typedef struct extent_fd_layout_s extent_fd_layout_t;
+struct extent_fd_layout_s {
+	char		version[64];
+	uint32_t	lg_page;
+	uint32_t	nbins;
+	uint32_t	nsizes;
+	uint32_t	arena_size;
+	uint32_t	extent_size;
+	uint32_t	base_size;
+	uint32_t	config;
+};
+
+/* Stored at the start of the window of a persistent file. */
+typedef struct extent_fd_header_s extent_fd_header_t;
+struct extent_fd_header_s {
+	uint64_t		magic;
+	uint32_t		version;
+	extent_fd_layout_t	layout;
+	/* Address at which the window has to be mapped, and its size. */
+	void			*addr;
+	size_t			size;
+	bool			zeroed;
+	/* Whether a process has the arena attached, i.e. did not quiesce. */
+	bool			attached;
+	atomic_zu_t		used;
+	arena_t			*arena;
+	void			*root;
+};
+
+typedef struct extent_fd_s extent_fd_t;
+struct extent_fd_s {
+	/* Must come first, since the hooks are all the callbacks get. */
+	extent_hooks_t		hooks;
+	int			fd;
+	/* Whether fd is a memfd created by, and closed with, the provider. */
+	bool			fd_owned;
+	/* Whether the window read as zeros when it was first mapped. */
+	bool			zeroed;
+	void			*base;
+	size_t			size;
+	/*
+	 * Number of bytes at the start of the window that were handed out;
+	 * points into the header for persistent files.
+	 */
+	atomic_zu_t		*used;
+	atomic_zu_t		used_local;
+	/* Header of a persistent file, or NULL. */
+	extent_fd_header_t	*header;
+};
+
+#ifdef EXTENT_FD_SUPPORTED
+static void *extent_fd_alloc(extent_hooks_t *extent_hooks, void *new_addr,
+    size_t size, size_t alignment, bool *zero, bool *commit,
+    unsigned arena_ind);
+static bool extent_fd_dalloc(extent_hooks_t *extent_hooks, void *addr,
+    size_t size, bool committed, unsigned arena_ind);
+static void extent_fd_destroy(extent_hooks_t *extent_hooks, void *addr,
+    size_t size, bool committed, unsigned arena_ind);
+static bool extent_fd_purge_forced(extent_hooks_t *extent_hooks, void *addr,
+    size_t size, size_t offset, size_t length, unsigned arena_ind);
+static bool extent_fd_split(extent_hooks_t *extent_hooks, void *addr,
+    size_t size, size_t size_a, size_t size_b, bool committed,
+    unsigned arena_ind);
+static bool extent_fd_merge(extent_hooks_t *extent_hooks, void *addr_a,
+    size_t size_a, void *addr_b, size_t size_b, bool committed,
+    unsigned arena_ind);
+
+/*
+ * The window is mapped read/write for its whole lifetime, so extents are
+ * always committed, and there is nothing to decommit or to purge lazily.
+ */
+static const extent_hooks_t extent_fd_hooks = {
+	extent_fd_alloc,
+	extent_fd_dalloc,
+	extent_fd_destroy,
+	NULL,
+	NULL,
+	NULL,
+	extent_fd_purge_forced,
+	extent_fd_split,
+	extent_fd_merge
+};
+
+/******************************************************************************/
+
+static bool
+extent_fd_punch(extent_fd_t *provider, void *addr, size_t size) {
+	assert((uintptr_t)addr >= (uintptr_t)provider->base);
+	assert((uintptr_t)addr - (uintptr_t)provider->base + size <=
+	    provider->size);
+
+	return (fallocate(provider->fd, FALLOC_FL_PUNCH_HOLE |
+	    FALLOC_FL_KEEP_SIZE, (off_t)((uintptr_t)addr -
+	    (uintptr_t)provider->base), (off_t)size) != 0);
+}
+
+static void *
+extent_fd_alloc(extent_hooks_t *extent_hooks, void *new_addr, size_t size,
+    size_t alignment, bool *zero, bool *commit, unsigned arena_ind) {
+	extent_fd_t *provider = (extent_fd_t *)extent_hooks;
+	uintptr_t base = (uintptr_t)provider->base;
+	alignment = ALIGNMENT_CEILING(alignment, PAGE);
+
+	size_t used = atomic_load_zu(provider->used, ATOMIC_RELAXED);
+	uintptr_t addr;
+	do {
+		addr = ALIGNMENT_CEILING(base + used, alignment);
+		if (new_addr != NULL && addr != (uintptr_t)new_addr) {
+			return NULL;
+		}
+		if (addr - base > provider->size || size > provider->size -
+		    (addr - base)) {
+			return NULL;
+		}
+	} while (!atomic_compare_exchange_weak_zu(provider->used, &used,
+	    addr + size - base, ATOMIC_RELAXED, ATOMIC_RELAXED));
+
+	/*
+	 * Each part of the window is handed out only once, so it still reads
+	 * as zeros if the whole window did.  Otherwise punching a hole zeroes
+	 * the range without touching every page.
+	 */
+	if (*zero && !provider->zeroed) {
+		if (extent_fd_punch(provider, (void *)addr, size)) {
+			memset((void *)addr, 0, size);
+		}
+	} else {
+		*zero = provider->zeroed;
+	}
+	*commit = true;
+	return (void *)addr;
+}
+
+static bool
+extent_fd_dalloc(extent_hooks_t *extent_hooks, void *addr, size_t size,
+    bool committed, unsigned arena_ind) {
+	/* Opt out, so that the arena retains the extent for reuse. */
+	return true;
+}
+
+static void
+extent_fd_destroy(extent_hooks_t *extent_hooks, void *addr, size_t size,
+    bool committed, unsigned arena_ind) {
+	extent_fd_punch((extent_fd_t *)extent_hooks, addr, size);
+}
+
+static bool
+extent_fd_purge_forced(extent_hooks_t *extent_hooks, void *addr, size_t size,
+    size_t offset, size_t length, unsigned arena_ind) {
+	return extent_fd_punch((extent_fd_t *)extent_hooks,
+	    (void *)((uintptr_t)addr + (uintptr_t)offset), length);
+}
+
+static bool
+extent_fd_split(extent_hooks_t *extent_hooks, void *addr, size_t size,
+    size_t size_a, size_t size_b, bool committed, unsigned arena_ind) {
+	return false;
+}
+
+static bool
+extent_fd_merge(extent_hooks_t *extent_hooks, void *addr_a, size_t size_a,
+    void *addr_b, size_t size_b, bool committed, unsigned arena_ind) {
+	/* Adjacent in the window means adjacent in the file. */
+	return false;
+}
+
+static void
+extent_fd_layout_init(extent_fd_layout_t *layout) {
+	memset(layout, 0, sizeof(*layout));
+	strncpy(layout->version, JEMALLOC_VERSION, sizeof(layout->version) - 1);
+	layout->lg_page = LG_PAGE;
+	layout->nbins = NBINS;
+	layout->nsizes = NSIZES;
+	layout->arena_size = (uint32_t)sizeof(arena_t);
+	layout->extent_size = (uint32_t)sizeof(extent_t);
+	layout->base_size = (uint32_t)sizeof(base_t);
+	layout->config = (config_debug ? 0x1U : 0) | (config_stats ? 0x2U : 0) |
+	    (config_prof ? 0x4U : 0) | (config_cache_oblivious ? 0x8U : 0);
+}
+
+/*
+ * Returns the size of the window for fd, after extending an empty file, or 0
+ * on error.
+ */
+static size_t
+extent_fd_size(int fd, bool *r_extended) {
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (uintmax_t)st.st_size > SIZE_MAX) {
+		return 0;
+	}
+	*r_extended = (st.st_size == 0);
+	if (*r_extended) {
+		if (ftruncate(fd, (off_t)EXTENT_FD_SIZE_DEFAULT) != 0) {
+			return 0;
+		}
+		return EXTENT_FD_SIZE_DEFAULT;
+	}
+	return (size_t)st.st_size & ~PAGE_MASK;
+}
+
+/* Maps fd at addr, or wherever the kernel chooses if addr is NULL. */
+static void *
+extent_fd_map(int fd, void *addr, size_t size) {
+	int flags = MAP_SHARED | MAP_NORESERVE;
+#ifdef MAP_FIXED_NOREPLACE
+	if (addr != NULL) {
+		flags |= MAP_FIXED_NOREPLACE;
+	}
+#endif
+	void *ret = mmap(addr, size, PROT_READ | PROT_WRITE, flags, fd, 0);
+	if (ret == MAP_FAILED) {
+		return NULL;
+	}
+	if (addr != NULL && ret != addr) {
+		/* The address was only taken as a hint. */
+		munmap(ret, size);
+		return NULL;
+	}
+	return ret;
+}
+
+static extent_fd_t *
+extent_fd_provider_new(int fd, bool fd_owned, bool zeroed, void *base,
+    size_t size, extent_fd_header_t *header) {
+	extent_fd_t *provider = (extent_fd_t *)a0malloc(sizeof(extent_fd_t));
+	if (provider == NULL) {
+		return NULL;
+	}
+	provider->hooks = extent_fd_hooks;
+	provider->fd = fd;
+	provider->fd_owned = fd_owned;
+	provider->zeroed = zeroed;
+	provider->base = base;
+	provider->size = size;
+	atomic_store_zu(&provider->used_local, 0, ATOMIC_RELAXED);
+	provider->used = (header != NULL) ? &header->used :
+	    &provider->used_local;
+	provider->header = header;
+	return provider;
+}
+
+static void
+extent_fd_release(extent_fd_t *provider) {
+	munmap(provider->base, provider->size);
+	if (provider->fd_owned) {
+		close(provider->fd);
+	}
+	a0dalloc(provider);
+}
+#endif
+
+extent_hooks_t *
+extent_fd_new(int fd) {
+#ifdef EXTENT_FD_SUPPORTED
+	bool fd_owned = (fd == -1);
+	if (fd_owned) {
+		fd = (int)syscall(SYS_memfd_create, "jemalloc", MFD_CLOEXEC);
+		if (fd == -1) {
+			return NULL;
+		}
+	}
+
+	bool extended;
+	size_t size = extent_fd_size(fd, &extended);
+	if (size == 0) {
+		goto label_error;
+	}
+	void *base = extent_fd_map(fd, NULL, size);
+	if (base == NULL) {
+		goto label_truncate;
+	}
+	extent_fd_t *provider = extent_fd_provider_new(fd, fd_owned, extended,
+	    base, size, NULL);
+	if (provider == NULL) {
+		munmap(base, size);
+		goto label_truncate;
+	}
+
+	return &provider->hooks;
+label_truncate:
+	if (extended && !fd_owned) {
+		/* Leave the caller's file as it was. */
+		UNUSED int err = ftruncate(fd, 0);
+	}
+label_error:
+	if (fd_owned) {
+		close(fd);
+	}
+	return NULL;
+#else
+	return NULL;
+#endif
+}
+
+extent_hooks_t *
+extent_fd_persistent_new(int fd, arena_t **r_arena, int *r_err) {
+#ifdef EXTENT_FD_SUPPORTED
+	*r_err = EAGAIN;
+	bool extended;
+	size_t size = extent_fd_size(fd, &extended);
+	if (size == 0) {
+		return NULL;
+	}
+
+	extent_fd_layout_t layout;
+	extent_fd_layout_init(&layout);
+	extent_fd_header_t header;
+	if (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+		goto label_truncate;
+	}
+	bool fresh = (header.magic == 0);
+	void *addr;
+	if (fresh) {
+		addr = (void *)opt_persistent_addr;
+	} else {
+		if (header.magic != EXTENT_FD_MAGIC || header.version !=
+		    EXTENT_FD_VERSION || memcmp(&header.layout, &layout,
+		    sizeof(layout)) != 0 || header.size > size) {
+			*r_err = EINVAL;
+			return NULL;
+		}
+		if (header.attached) {
+			*r_err = EFAULT;
+			return NULL;
+		}
+		addr = header.addr;
+		size = header.size;
+	}
+
+	void *base = extent_fd_map(fd, addr, size);
+	if (base == NULL) {
+		goto label_truncate;
+	}
+	extent_fd_header_t *hdr = (extent_fd_header_t *)base;
+	if (fresh) {
+		hdr->version = EXTENT_FD_VERSION;
+		hdr->layout = layout;
+		hdr->addr = base;
+		hdr->size = size;
+		hdr->zeroed = extended;
+		atomic_store_zu(&hdr->used, PAGE_CEILING(sizeof(*hdr)),
+		    ATOMIC_RELAXED);
+		hdr->arena = NULL;
+		hdr->root = NULL;
+		hdr->magic = EXTENT_FD_MAGIC;
+	}
+	extent_fd_t *provider = extent_fd_provider_new(fd, false, hdr->zeroed,
+	    base, size, hdr);
+	if (provider == NULL) {
+		munmap(base, size);
+		goto label_truncate;
+	}
+	hdr->attached = true;
+
+	*r_arena = hdr->arena;
+	return &provider->hooks;
+label_truncate:
+	if (extended) {
+		UNUSED int err = ftruncate(fd, 0);
+	}
+	return NULL;
+#else
+	*r_err = EAGAIN;
+	return NULL;
+#endif
+}
+
+void
+extent_fd_persistent_arena_set(extent_hooks_t *extent_hooks, arena_t *arena) {
+	extent_fd_t *provider = (extent_fd_t *)extent_hooks;
+	assert(provider->header != NULL);
+	provider->header->arena = arena;
+}
+
+void **
+extent_fd_persistent_root(extent_hooks_t *extent_hooks) {
+	int fd;
+	void *base;
+	if (extent_fd_get(extent_hooks, &fd, &base)) {
+		return NULL;
+	}
+	extent_fd_t *provider = (extent_fd_t *)extent_hooks;
+	return (provider->header != NULL) ? &provider->header->root : NULL;
+}
+
+void
+extent_fd_persistent_quiesce(extent_hooks_t *extent_hooks) {
+#ifdef EXTENT_FD_SUPPORTED
+	extent_fd_t *provider = (extent_fd_t *)extent_hooks;
+	extent_fd_header_t *header = provider->header;
+	assert(header != NULL);
+	/* Write the arena back before marking it as quiesced. */
+	msync(provider->base, atomic_load_zu(provider->used, ATOMIC_RELAXED),
+	    MS_SYNC);
+	header->attached = false;
+	msync(provider->base, PAGE, MS_SYNC);
+	extent_fd_release(provider);
+#else
+	not_reached();
+#endif
+}
+
+void
+extent_fd_delete(extent_hooks_t *extent_hooks) {
+#ifdef EXTENT_FD_SUPPORTED
+	int fd;
+	void *base;
+	if (extent_fd_get(extent_hooks, &fd, &base)) {
+		return;
+	}
+	extent_fd_t *provider = (extent_fd_t *)extent_hooks;
+	extent_fd_header_t *header = provider->header;
+	if (header != NULL) {
+		/*
+		 * Destroying the arena purged all of its memory, so a later
+		 * attach can start over with a new arena.
+		 */
+		header->arena = NULL;
+		header->root = NULL;
+		atomic_store_zu(&header->used, PAGE_CEILING(sizeof(*header)),
+		    ATOMIC_RELAXED);
+		header->attached = false;
+	}
+	extent_fd_release(provider);
+#endif
+}
+
+bool
+extent_fd_get(extent_hooks_t *extent_hooks, int *r_fd, void **r_base) {
+#ifdef EXTENT_FD_SUPPORTED
+	if (extent_hooks->alloc != extent_fd_alloc) {
+		return true;
+	}
+	extent_fd_t *provider = (extent_fd_t *)extent_hooks;
+	*r_fd = provider->fd;
+	*r_base = provider->base;
+	return false;
+#else
+	return true;
+#endif
+}
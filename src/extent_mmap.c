@@ -15,14 +15,85 @@ bool	opt_retain =
     false
 #endif
     ;
+size_t	opt_reserve_va = 0;
+
+/*
+ * Region reserved at boot (see opt.reserve_va), which extents are carved out of
+ * bottom up until it is exhausted.
+ */
+static uintptr_t	reserve_base;
+static size_t		reserve_size;
+/* Whether the reservation is committed already, i.e. the OS overcommits. */
+static bool		reserve_committed;
+static atomic_zu_t	reserve_used;
 
 /******************************************************************************/
 
+bool
+extent_mmap_reserve(void **r_base, size_t *r_size) {
+	assert(opt_reserve_va != 0);
+	size_t size = HUGEPAGE_CEILING(opt_reserve_va);
+	if (size < opt_reserve_va) {
+		return true;
+	}
+	bool commit = false;
+	void *base = pages_map(NULL, size, HUGEPAGE, &commit);
+	if (base == NULL) {
+		return true;
+	}
+	reserve_base = (uintptr_t)base;
+	reserve_size = size;
+	reserve_committed = commit;
+	atomic_store_zu(&reserve_used, 0, ATOMIC_RELAXED);
+
+	*r_base = base;
+	*r_size = size;
+	return false;
+}
+
+bool
+extent_mmap_reserved(const void *addr) {
+	return ((uintptr_t)addr - reserve_base < reserve_size);
+}
+
+static void *
+extent_alloc_reserved(void *new_addr, size_t size, size_t alignment,
+    bool *commit) {
+	if (reserve_size == 0) {
+		return NULL;
+	}
+
+	size_t used = atomic_load_zu(&reserve_used, ATOMIC_RELAXED);
+	uintptr_t addr;
+	do {
+		addr = ALIGNMENT_CEILING(reserve_base + used, alignment);
+		if (new_addr != NULL && addr != (uintptr_t)new_addr) {
+			return NULL;
+		}
+		if (addr - reserve_base > reserve_size || size > reserve_size
+		    - (addr - reserve_base)) {
+			return NULL;
+		}
+	} while (!atomic_compare_exchange_weak_zu(&reserve_used, &used,
+	    addr + size - reserve_base, ATOMIC_RELAXED, ATOMIC_RELAXED));
+
+	if (reserve_committed) {
+		*commit = true;
+	} else if (*commit) {
+		*commit = !pages_commit((void *)addr, size);
+	}
+	return (void *)addr;
+}
+
 void *
 extent_alloc_mmap(void *new_addr, size_t size, size_t alignment, bool *zero,
     bool *commit) {
-	void *ret = pages_map(new_addr, size, ALIGNMENT_CEILING(alignment,
-	    PAGE), commit);
+	alignment = ALIGNMENT_CEILING(alignment, PAGE);
+	/* Only fall back to a separate mapping once the region is full. */
+	void *ret = extent_alloc_reserved(new_addr, size, alignment, commit);
+	if (ret == NULL) {
+		ret = pages_map(new_addr, size, alignment, commit);
+	}
 	if (ret == NULL) {
 		return NULL;
 	}
@@ -4,13 +4,18 @@
 
 #include "jemalloc/internal/assert.h"
 #include "jemalloc/internal/atomic.h"
+#include "jemalloc/internal/cgroup.h"
 #include "jemalloc/internal/ctl.h"
 #include "jemalloc/internal/extent_dss.h"
+#include "jemalloc/internal/extent_fd.h"
 #include "jemalloc/internal/extent_mmap.h"
 #include "jemalloc/internal/jemalloc_internal_types.h"
 #include "jemalloc/internal/log.h"
 #include "jemalloc/internal/malloc_io.h"
 #include "jemalloc/internal/mutex.h"
+#include "jemalloc/internal/percpu_cache.h"
+#include "jemalloc/internal/purge_budget.h"
+#include "jemalloc/internal/rseq.h"
 #include "jemalloc/internal/rtree.h"
 #include "jemalloc/internal/size_classes.h"
 #include "jemalloc/internal/spin.h"
@@ -67,6 +72,7 @@ bool	opt_utrace = false;
 bool	opt_xmalloc = false;
 bool	opt_zero = false;
 unsigned	opt_narenas = 0;
+bool	opt_fork_skip_quiescent = false;
 
 unsigned	ncpus;
 
@@ -351,6 +357,7 @@ arena_new_create_background_thread(tsdn_t *tsdn, unsigned ind) {
 				      "creation for arena %u. Abort.\n", ind);
 			abort();
 		}
+		background_thread_arena_new(tsdn, arena_get(tsdn, ind, false));
 	}
 }
 
@@ -367,6 +374,31 @@ arena_init(tsdn_t *tsdn, unsigned ind, extent_hooks_t *extent_hooks) {
 	return arena;
 }
 
+/*
+ * Insert an arena that was quiesced into a persistent file into the arenas
+ * array at index ind.
+ */
+bool
+arena_attach(tsdn_t *tsdn, unsigned ind, arena_t *arena,
+    extent_hooks_t *extent_hooks) {
+	malloc_mutex_lock(tsdn, &arenas_lock);
+	assert(ind <= narenas_total_get());
+	if (ind >= MALLOCX_ARENA_LIMIT) {
+		malloc_mutex_unlock(tsdn, &arenas_lock);
+		return true;
+	}
+	if (ind == narenas_total_get()) {
+		narenas_total_inc();
+	}
+	bool err = arena_reattach(tsdn, ind, arena, extent_hooks);
+	malloc_mutex_unlock(tsdn, &arenas_lock);
+
+	if (!err) {
+		arena_new_create_background_thread(tsdn, ind);
+	}
+	return err;
+}
+
 static void
 arena_bind(tsd_t *tsd, unsigned ind, bool internal) {
 	arena_t *arena = arena_get(tsd_tsdn(tsd), ind, false);
@@ -385,6 +417,7 @@ arena_migrate(tsd_t *tsd, unsigned oldind, unsigned newind) {
 
 	oldarena = arena_get(tsd_tsdn(tsd), oldind, false);
 	newarena = arena_get(tsd_tsdn(tsd), newind, false);
+	extent_cache_flush(tsd);
 	arena_nthreads_dec(oldarena, false);
 	arena_nthreads_inc(newarena, false);
 	tsd_arena_set(tsd, newarena);
@@ -400,6 +433,7 @@ arena_unbind(tsd_t *tsd, unsigned ind, bool internal) {
 	if (internal) {
 		tsd_iarena_set(tsd, NULL);
 	} else {
+		extent_cache_flush(tsd);
 		tsd_arena_set(tsd, NULL);
 	}
 }
@@ -481,12 +515,25 @@ label_return:
 }
 
 /* Slow path, called only by arena_choose(). */
+/*
+ * The number of threads assigned to an automatic arena, or to the arena that
+ * took over from it if it is frozen.
+ */
+static unsigned
+arena_auto_nthreads_get(tsdn_t *tsdn, unsigned ind, bool internal) {
+	arena_t *arena = arena_get(tsdn, ind, false);
+	while (arena_is_frozen(arena)) {
+		arena = arena_successor_get(arena);
+	}
+	return arena_nthreads_get(arena, internal);
+}
+
 arena_t *
 arena_choose_hard(tsd_t *tsd, bool internal) {
 	arena_t *ret JEMALLOC_CC_SILENCE_INIT(NULL);
 
 	if (have_percpu_arena && PERCPU_ARENA_ENABLED(opt_percpu_arena)) {
-		unsigned choose = percpu_arena_choose();
+		unsigned choose = percpu_arena_choose(tsd);
 		ret = arena_get(tsd_tsdn(tsd), choose, true);
 		assert(ret != NULL);
 		arena_bind(tsd, arena_ind_get(ret), false);
@@ -522,11 +569,10 @@ arena_choose_hard(tsd_t *tsd, bool internal) {
 				 * number of threads assigned to it.
 				 */
 				for (j = 0; j < 2; j++) {
-					if (arena_nthreads_get(arena_get(
-					    tsd_tsdn(tsd), i, false), !!j) <
-					    arena_nthreads_get(arena_get(
-					    tsd_tsdn(tsd), choose[j], false),
-					    !!j)) {
+					if (arena_auto_nthreads_get(
+					    tsd_tsdn(tsd), i, !!j) <
+					    arena_auto_nthreads_get(
+					    tsd_tsdn(tsd), choose[j], !!j)) {
 						choose[j] = i;
 					}
 				}
@@ -545,9 +591,8 @@ arena_choose_hard(tsd_t *tsd, bool internal) {
 		}
 
 		for (j = 0; j < 2; j++) {
-			if (arena_nthreads_get(arena_get(tsd_tsdn(tsd),
-			    choose[j], false), !!j) == 0 || first_null ==
-			    narenas_auto) {
+			if (arena_auto_nthreads_get(tsd_tsdn(tsd), choose[j],
+			    !!j) == 0 || first_null == narenas_auto) {
 				/*
 				 * Use an unloaded arena, or the least loaded
 				 * arena if all arenas are already initialized.
@@ -595,6 +640,45 @@ arena_choose_hard(tsd_t *tsd, bool internal) {
 	return ret;
 }
 
+/*
+ * Moves the calling thread off a frozen arena, onto the arena that took over
+ * from it.  The tcache is flushed as well, so that it stops handing out the
+ * frozen arena's regions.
+ */
+arena_t *
+arena_choose_frozen(tsd_t *tsd, arena_t *arena, bool internal) {
+	arena_t *ret = arena;
+	do {
+		ret = arena_successor_get(ret);
+	} while (arena_is_frozen(ret));
+
+	/* Percpu arenas are rebound as threads migrate; leave that alone. */
+	if (have_percpu_arena && PERCPU_ARENA_ENABLED(opt_percpu_arena) &&
+	    !internal) {
+		return ret;
+	}
+
+	if (internal) {
+		arena_unbind(tsd, arena_ind_get(arena), true);
+		arena_bind(tsd, arena_ind_get(ret), true);
+	} else {
+		arena_migrate(tsd, arena_ind_get(arena), arena_ind_get(ret));
+		if (tcache_available(tsd)) {
+			tcache_t *tcache = tcache_get(tsd);
+			if (tcache->arena != NULL) {
+				tcache_flush(tsd);
+				tcache_arena_reassociate(tsd_tsdn(tsd), tcache,
+				    ret);
+			} else {
+				tcache_arena_associate(tsd_tsdn(tsd), tcache,
+				    ret);
+			}
+		}
+	}
+
+	return ret;
+}
+
 void
 iarena_cleanup(tsd_t *tsd) {
 	arena_t *iarena;
@@ -1075,6 +1159,13 @@ malloc_conf_init(void) {
 				continue;
 			}
 			CONF_HANDLE_BOOL(opt_retain, "retain")
+			CONF_HANDLE_SIZE_T(opt_reserve_va, "reserve_va", 0,
+			    SIZE_T_MAX, no, no, false)
+			CONF_HANDLE_SIZE_T(opt_retain_trim_threshold,
+			    "retain_trim_threshold", 0, SIZE_T_MAX, no, no,
+			    false)
+			CONF_HANDLE_SIZE_T(opt_retain_trim_ratio,
+			    "retain_trim_ratio", 0, 100, no, yes, true)
 			if (strncmp("dss", k, klen) == 0) {
 				int i;
 				bool match = false;
@@ -1099,8 +1190,14 @@ malloc_conf_init(void) {
 				}
 				continue;
 			}
+			CONF_HANDLE_SIZE_T(opt_persistent_addr,
+			    "persistent_addr", 0, SIZE_T_MAX, no, no, false)
 			CONF_HANDLE_UNSIGNED(opt_narenas, "narenas", 1,
 			    UINT_MAX, yes, no, false)
+			CONF_HANDLE_UNSIGNED(opt_freeze_narenas_max,
+			    "freeze_narenas_max", 0, UINT_MAX, no, no, false)
+			CONF_HANDLE_BOOL(opt_fork_skip_quiescent,
+			    "fork_skip_quiescent")
 			CONF_HANDLE_SSIZE_T(opt_dirty_decay_ms,
 			    "dirty_decay_ms", -1, NSTIME_SEC_MAX * KQU(1000) <
 			    QU(SSIZE_MAX) ? NSTIME_SEC_MAX * KQU(1000) :
@@ -1109,6 +1206,66 @@ malloc_conf_init(void) {
 			    "muzzy_decay_ms", -1, NSTIME_SEC_MAX * KQU(1000) <
 			    QU(SSIZE_MAX) ? NSTIME_SEC_MAX * KQU(1000) :
 			    SSIZE_MAX);
+			CONF_HANDLE_BOOL(opt_dirty_decay_adaptive,
+			    "dirty_decay_adaptive")
+			CONF_HANDLE_SIZE_T(opt_dirty_decay_refault_target,
+			    "dirty_decay_refault_target", 0, 100, no, yes, true)
+			CONF_HANDLE_SIZE_T(opt_empty_slab_cache_max,
+			    "empty_slab_cache_max", 0, SIZE_T_MAX, no, no,
+			    false)
+			CONF_HANDLE_BOOL(opt_extent_steal, "extent_steal")
+			CONF_HANDLE_SIZE_T(opt_extent_steal_threshold,
+			    "extent_steal_threshold", 0, SIZE_T_MAX, no, no,
+			    false)
+			if (CONF_MATCH("purge_policy")) {
+				bool match = false;
+				for (int i = 0; i < purge_policy_limit; i++) {
+					if (strncmp(purge_policy_names[i], v,
+					    vlen) == 0) {
+						opt_purge_policy = i;
+						match = true;
+						break;
+					}
+				}
+				if (!match) {
+					malloc_conf_error("Invalid conf value",
+					    k, klen, v, vlen);
+				}
+				continue;
+			}
+			CONF_HANDLE_SIZE_T(opt_purge_max_dirty,
+			    "purge_max_dirty", 0, SIZE_T_MAX, no, no, false)
+			CONF_HANDLE_SIZE_T(opt_purge_dirty_ratio,
+			    "purge_dirty_ratio", 0, SIZE_T_MAX, no, no, false)
+			CONF_HANDLE_SIZE_T(opt_purge_floor, "purge_floor", 0,
+			    SIZE_T_MAX, no, no, false)
+			CONF_HANDLE_SIZE_T(opt_purge_rate, "purge_rate", 0,
+			    SIZE_T_MAX, no, no, false)
+			CONF_HANDLE_SIZE_T(opt_purge_call_max, "purge_call_max",
+			    0, SIZE_T_MAX, no, no, false)
+			CONF_HANDLE_SIZE_T(opt_purge_inline_share,
+			    "purge_inline_share", 0, 100, no, yes, true)
+			if (CONF_MATCH("purge_select")) {
+				bool match = false;
+				for (int i = 0; i < purge_select_limit; i++) {
+					if (strncmp(purge_select_names[i], v,
+					    vlen) == 0) {
+						opt_purge_select = i;
+						match = true;
+						break;
+					}
+				}
+				if (!match) {
+					malloc_conf_error("Invalid conf value",
+					    k, klen, v, vlen);
+				}
+				continue;
+			}
+			CONF_HANDLE_BOOL(opt_cgroup_aware, "cgroup_aware")
+			CONF_HANDLE_CHAR_P(opt_cgroup_root, "cgroup_root",
+			    CGROUP_ROOT_DEFAULT)
+			CONF_HANDLE_SIZE_T(opt_cgroup_unpurged_ratio,
+			    "cgroup_unpurged_ratio", 0, 100, no, yes, true)
 			CONF_HANDLE_BOOL(opt_stats_print, "stats_print")
 			if (CONF_MATCH("stats_print_opts")) {
 				init_opt_stats_print_opts(v, vlen);
@@ -1151,6 +1308,22 @@ malloc_conf_init(void) {
 			CONF_HANDLE_SIZE_T(opt_lg_extent_max_active_fit,
 			    "lg_extent_max_active_fit", 0,
 			    (sizeof(size_t) << 3), yes, yes, false)
+			if (CONF_MATCH("extent_reuse")) {
+				bool match = false;
+				for (int i = 0; i < extent_reuse_limit; i++) {
+					if (strncmp(extent_reuse_names[i], v,
+					    vlen) == 0) {
+						opt_extent_reuse = i;
+						match = true;
+						break;
+					}
+				}
+				if (!match) {
+					malloc_conf_error("Invalid conf value",
+					    k, klen, v, vlen);
+				}
+				continue;
+			}
 			CONF_HANDLE_SSIZE_T(opt_lg_tcache_max, "lg_tcache_max",
 			    -1, (sizeof(size_t) << 3) - 1)
 			if (strncmp("percpu_arena", k, klen) == 0) {
@@ -1175,12 +1348,26 @@ malloc_conf_init(void) {
 				}
 				continue;
 			}
+			CONF_HANDLE_BOOL(opt_percpu_cache, "percpu_cache")
 			CONF_HANDLE_BOOL(opt_background_thread,
 			    "background_thread");
 			CONF_HANDLE_SIZE_T(opt_max_background_threads,
 					   "max_background_threads", 1,
 					   opt_max_background_threads, yes, yes,
 					   true);
+			CONF_HANDLE_CHAR_P(opt_background_thread_cpus,
+			    "background_thread_cpus", "")
+			CONF_HANDLE_BOOL(opt_background_thread_sched_idle,
+			    "background_thread_sched_idle")
+			CONF_HANDLE_SSIZE_T(opt_background_thread_nice,
+			    "background_thread_nice", -20, 19)
+			CONF_HANDLE_BOOL(opt_psi_purge, "psi_purge")
+			CONF_HANDLE_CHAR_P(opt_psi_path, "psi_path",
+			    PSI_PATH_DEFAULT)
+			CONF_HANDLE_SIZE_T(opt_psi_stall_us, "psi_stall_us", 1,
+			    SIZE_T_MAX, yes, no, false)
+			CONF_HANDLE_SIZE_T(opt_psi_window_us, "psi_window_us", 1,
+			    SIZE_T_MAX, yes, no, false)
 			if (config_prof) {
 				CONF_HANDLE_BOOL(opt_prof, "prof")
 				CONF_HANDLE_CHAR_P(opt_prof_prefix,
@@ -1333,6 +1520,9 @@ malloc_init_hard_a0_locked() {
 		return true;
 	}
 	a0 = arena_get(TSDN_NULL, 0, false);
+	cgroup_boot();
+	purge_budget_boot();
+	rseq_boot();
 	malloc_init_state = malloc_init_a0_initialized;
 
 	return false;
@@ -1483,9 +1673,10 @@ malloc_init_narenas(void) {
 	return false;
 }
 
-static void
-malloc_init_percpu(void) {
+static bool
+malloc_init_percpu(tsd_t *tsd) {
 	opt_percpu_arena = percpu_arena_as_initialized(opt_percpu_arena);
+	return percpu_cache_boot(tsd);
 }
 
 static bool
@@ -1555,9 +1746,7 @@ malloc_init_hard(void) {
 		UNLOCK_RETURN(tsd_tsdn(tsd), true, true)
 	}
 
-	malloc_init_percpu();
-
-	if (malloc_init_hard_finish()) {
+	if (malloc_init_percpu(tsd) || malloc_init_hard_finish()) {
 		UNLOCK_RETURN(tsd_tsdn(tsd), true, true)
 	}
 	post_reentrancy(tsd);
@@ -1690,6 +1879,16 @@ imalloc_no_sample(static_opts_t *sopts, dynamic_opts_t *dopts, tsd_t *tsd,
 	tcache_t *tcache;
 	arena_t *arena;
 
+	if (unlikely(percpu_cache_enabled) && dopts->tcache_ind ==
+	    TCACHE_IND_AUTOMATIC && dopts->arena_ind == ARENA_IND_AUTOMATIC &&
+	    dopts->alignment == 0 && ind < NBINS) {
+		void *ret = percpu_cache_alloc(tsd, ind, dopts->zero,
+		    sopts->slow);
+		if (likely(ret != NULL)) {
+			return ret;
+		}
+	}
+
 	/* Fill in the tcache. */
 	if (dopts->tcache_ind == TCACHE_IND_AUTOMATIC) {
 		if (likely(!sopts->slow)) {
@@ -2218,9 +2417,15 @@ ifree(tsd_t *tsd, void *ptr, tcache_t *tcache, bool slow_path) {
 	assert(malloc_initialized() || IS_INITIALIZER);
 
 	alloc_ctx_t alloc_ctx;
-	rtree_ctx_t *rtree_ctx = tsd_rtree_ctx(tsd);
-	rtree_szind_slab_read(tsd_tsdn(tsd), &extents_rtree, rtree_ctx,
-	    (uintptr_t)ptr, true, &alloc_ctx.szind, &alloc_ctx.slab);
+	bool frozen = false;
+	if (unlikely(atomic_load_b(&arena_heap_frozen, ATOMIC_RELAXED))) {
+		frozen = arena_dalloc_ctx_frozen(tsd_tsdn(tsd), ptr,
+		    &alloc_ctx);
+	} else {
+		rtree_ctx_t *rtree_ctx = tsd_rtree_ctx(tsd);
+		rtree_szind_slab_read(tsd_tsdn(tsd), &extents_rtree, rtree_ctx,
+		    (uintptr_t)ptr, true, &alloc_ctx.szind, &alloc_ctx.slab);
+	}
 	assert(alloc_ctx.szind != NSIZES);
 
 	size_t usize;
@@ -2234,6 +2439,15 @@ ifree(tsd_t *tsd, void *ptr, tcache_t *tcache, bool slow_path) {
 		*tsd_thread_deallocatedp_get(tsd) += usize;
 	}
 
+	if (unlikely(frozen)) {
+		/* Neither cache may hand out a frozen arena's regions again. */
+		tcache = NULL;
+	} else if (unlikely(percpu_cache_enabled) && alloc_ctx.slab &&
+	    percpu_cache_tcache_is_auto(tsd, tcache) &&
+	    percpu_cache_dalloc(tsd, ptr, alloc_ctx.szind, slow_path)) {
+		return;
+	}
+
 	if (likely(!slow_path)) {
 		idalloctm(tsd_tsdn(tsd), ptr, tcache, &alloc_ctx, false,
 		    false);
@@ -2257,7 +2471,13 @@ isfree(tsd_t *tsd, void *ptr, size_t usize, tcache_t *tcache, bool slow_path) {
 	assert(malloc_initialized() || IS_INITIALIZER);
 
 	alloc_ctx_t alloc_ctx, *ctx;
-	if (!config_cache_oblivious && ((uintptr_t)ptr & PAGE_MASK) != 0) {
+	bool frozen = false;
+	if (unlikely(atomic_load_b(&arena_heap_frozen, ATOMIC_RELAXED))) {
+		frozen = arena_dalloc_ctx_frozen(tsd_tsdn(tsd), ptr,
+		    &alloc_ctx);
+		ctx = &alloc_ctx;
+	} else if (!config_cache_oblivious &&
+	    ((uintptr_t)ptr & PAGE_MASK) != 0) {
 		/*
 		 * When cache_oblivious is disabled and ptr is not page aligned,
 		 * the allocation was not sampled -- usize can be used to
@@ -2292,6 +2512,16 @@ isfree(tsd_t *tsd, void *ptr, size_t usize, tcache_t *tcache, bool slow_path) {
 		*tsd_thread_deallocatedp_get(tsd) += usize;
 	}
 
+	if (unlikely(frozen)) {
+		/* Neither cache may hand out a frozen arena's regions again. */
+		tcache = NULL;
+	} else if (unlikely(percpu_cache_enabled) &&
+	    usize <= SMALL_MAXCLASS &&
+	    percpu_cache_tcache_is_auto(tsd, tcache) &&
+	    percpu_cache_dalloc(tsd, ptr, sz_size2index(usize), slow_path)) {
+		return;
+	}
+
 	if (likely(!slow_path)) {
 		isdalloct(tsd_tsdn(tsd), ptr, usize, tcache, ctx, false);
 	} else {
@@ -3201,6 +3431,61 @@ jemalloc_constructor(void) {
 }
 #endif
 
+/* Acquires the mutexes of the arenas marked by jemalloc_prefork(). */
+static void
+prefork_arenas(tsdn_t *tsdn, unsigned narenas) {
+	unsigned i, j;
+	arena_t *arena;
+
+	/* Break arena prefork into stages to preserve lock order. */
+	for (i = 0; i < 8; i++) {
+		for (j = 0; j < narenas; j++) {
+			if ((arena = arena_get(tsdn, j, false)) != NULL &&
+			    arena->fork_locked) {
+				switch (i) {
+				case 0:
+					arena_prefork0(tsdn, arena);
+					break;
+				case 1:
+					arena_prefork1(tsdn, arena);
+					break;
+				case 2:
+					arena_prefork2(tsdn, arena);
+					break;
+				case 3:
+					arena_prefork3(tsdn, arena);
+					break;
+				case 4:
+					arena_prefork4(tsdn, arena);
+					break;
+				case 5:
+					arena_prefork5(tsdn, arena);
+					break;
+				case 6:
+					arena_prefork6(tsdn, arena);
+					break;
+				case 7:
+					arena_prefork7(tsdn, arena);
+					break;
+				default: not_reached();
+				}
+			}
+		}
+	}
+}
+
+static void
+postfork_parent_arenas(tsdn_t *tsdn, unsigned narenas) {
+	for (unsigned i = 0; i < narenas; i++) {
+		arena_t *arena;
+
+		if ((arena = arena_get(tsdn, i, false)) != NULL &&
+		    arena->fork_locked) {
+			arena_postfork_parent(tsdn, arena);
+		}
+	}
+}
+
 #ifndef JEMALLOC_MUTEX_INIT_CB
 void
 jemalloc_prefork(void)
@@ -3210,7 +3495,7 @@ _malloc_prefork(void)
 #endif
 {
 	tsd_t *tsd;
-	unsigned i, j, narenas;
+	unsigned j, narenas;
 	arena_t *arena;
 
 #ifdef JEMALLOC_MUTEX_INIT_CB
@@ -3236,40 +3521,39 @@ _malloc_prefork(void)
 	if (have_background_thread) {
 		background_thread_prefork1(tsd_tsdn(tsd));
 	}
-	/* Break arena prefork into stages to preserve lock order. */
-	for (i = 0; i < 8; i++) {
-		for (j = 0; j < narenas; j++) {
-			if ((arena = arena_get(tsd_tsdn(tsd), j, false)) !=
-			    NULL) {
-				switch (i) {
-				case 0:
-					arena_prefork0(tsd_tsdn(tsd), arena);
-					break;
-				case 1:
-					arena_prefork1(tsd_tsdn(tsd), arena);
-					break;
-				case 2:
-					arena_prefork2(tsd_tsdn(tsd), arena);
-					break;
-				case 3:
-					arena_prefork3(tsd_tsdn(tsd), arena);
-					break;
-				case 4:
-					arena_prefork4(tsd_tsdn(tsd), arena);
-					break;
-				case 5:
-					arena_prefork5(tsd_tsdn(tsd), arena);
-					break;
-				case 6:
-					arena_prefork6(tsd_tsdn(tsd), arena);
-					break;
-				case 7:
-					arena_prefork7(tsd_tsdn(tsd), arena);
-					break;
-				default: not_reached();
+	/*
+	 * With opt_fork_skip_quiescent, only lock the arenas used since the
+	 * previous fork; see malloc_mutex_fork_begin() for why that is safe.
+	 */
+	if (opt_fork_skip_quiescent) {
+		size_t epoch = malloc_mutex_fork_begin();
+		while (true) {
+			for (j = 0; j < narenas; j++) {
+				arena = arena_get(tsd_tsdn(tsd), j, false);
+				if (arena != NULL) {
+					arena->fork_locked =
+					    arena_fork_used(arena, epoch);
 				}
 			}
+			prefork_arenas(tsd_tsdn(tsd), narenas);
+			/*
+			 * Start over if any skipped arena was used while the
+			 * others were being locked.
+			 */
+			bool used = false;
+			for (j = 0; j < narenas && !used; j++) {
+				arena = arena_get(tsd_tsdn(tsd), j, false);
+				if (arena != NULL && !arena->fork_locked) {
+					used = arena_fork_used(arena, epoch);
+				}
+			}
+			if (!used) {
+				break;
+			}
+			postfork_parent_arenas(tsd_tsdn(tsd), narenas);
 		}
+	} else {
+		prefork_arenas(tsd_tsdn(tsd), narenas);
 	}
 	prof_prefork1(tsd_tsdn(tsd));
 }
@@ -3283,7 +3567,6 @@ _malloc_postfork(void)
 #endif
 {
 	tsd_t *tsd;
-	unsigned i, narenas;
 
 #ifdef JEMALLOC_MUTEX_INIT_CB
 	if (!malloc_initialized()) {
@@ -3295,14 +3578,11 @@ _malloc_postfork(void)
 	tsd = tsd_fetch();
 
 	witness_postfork_parent(tsd_witness_tsdp_get(tsd));
-	/* Release all mutexes, now that fork() has completed. */
-	for (i = 0, narenas = narenas_total_get(); i < narenas; i++) {
-		arena_t *arena;
-
-		if ((arena = arena_get(tsd_tsdn(tsd), i, false)) != NULL) {
-			arena_postfork_parent(tsd_tsdn(tsd), arena);
-		}
+	if (opt_fork_skip_quiescent) {
+		malloc_mutex_fork_end();
 	}
+	/* Release all mutexes, now that fork() has completed. */
+	postfork_parent_arenas(tsd_tsdn(tsd), narenas_total_get());
 	prof_postfork_parent(tsd_tsdn(tsd));
 	if (have_background_thread) {
 		background_thread_postfork_parent(tsd_tsdn(tsd));
@@ -3322,6 +3602,9 @@ jemalloc_postfork_child(void) {
 	tsd = tsd_fetch();
 
 	witness_postfork_child(tsd_witness_tsdp_get(tsd));
+	if (opt_fork_skip_quiescent) {
+		malloc_mutex_fork_end();
+	}
 	/* Release all mutexes, now that fork() has completed. */
 	for (i = 0, narenas = narenas_total_get(); i < narenas; i++) {
 		arena_t *arena;
@@ -3337,6 +3620,7 @@ jemalloc_postfork_child(void) {
 	malloc_mutex_postfork_child(tsd_tsdn(tsd), &arenas_lock);
 	tcache_postfork_child(tsd_tsdn(tsd));
 	ctl_postfork_child(tsd_tsdn(tsd));
+	pages_postfork_child();
 }
 
 /******************************************************************************/
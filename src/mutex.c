@@ -21,6 +21,8 @@ static bool		postpone_init = true;
 static malloc_mutex_t	*postponed_mutexes = NULL;
 #endif
 
+atomic_zu_t malloc_mutex_fork_epoch = ATOMIC_INIT(0);
+
 /******************************************************************************/
 /*
  * We intercept pthread_create() calls in order to toggle isthreaded if the
@@ -134,6 +136,7 @@ bool
 malloc_mutex_init(malloc_mutex_t *mutex, const char *name,
     witness_rank_t rank, malloc_mutex_lock_order_t lock_order) {
 	mutex_prof_data_init(&mutex->prof_data);
+	mutex->fork_epoch = NULL;
 #ifdef _WIN32
 #  if _WIN32_WINNT >= 0x0600
 	InitializeSRWLock(&mutex->lock);
@@ -184,19 +187,20 @@ malloc_mutex_init(malloc_mutex_t *mutex, const char *name,
 
 void
 malloc_mutex_prefork(tsdn_t *tsdn, malloc_mutex_t *mutex) {
-	malloc_mutex_lock(tsdn, mutex);
+	malloc_mutex_lock_impl(tsdn, mutex, false);
 }
 
 void
 malloc_mutex_postfork_parent(tsdn_t *tsdn, malloc_mutex_t *mutex) {
-	malloc_mutex_unlock(tsdn, mutex);
+	malloc_mutex_unlock_impl(tsdn, mutex, false);
 }
 
 void
 malloc_mutex_postfork_child(tsdn_t *tsdn, malloc_mutex_t *mutex) {
 #ifdef JEMALLOC_MUTEX_INIT_CB
-	malloc_mutex_unlock(tsdn, mutex);
+	malloc_mutex_unlock_impl(tsdn, mutex, false);
 #else
+	atomic_zu_t *fork_epoch = mutex->fork_epoch;
 	if (malloc_mutex_init(mutex, mutex->witness.name,
 	    mutex->witness.rank, mutex->lock_order)) {
 		malloc_printf("<jemalloc>: Error re-initializing mutex in "
@@ -205,9 +209,87 @@ malloc_mutex_postfork_child(tsdn_t *tsdn, malloc_mutex_t *mutex) {
 			abort();
 		}
 	}
+	mutex->fork_epoch = fork_epoch;
 #endif
 }
 
+/*
+ * Fork epoch tracking lets jemalloc_prefork() skip arenas that have not been
+ * used since the previous fork.  Each tracked mutex points at its arena's
+ * epoch, which whoever acquires the mutex brings up to date (the even value of
+ * malloc_mutex_fork_epoch).  The forking thread first acquires all the global
+ * mutexes, makes malloc_mutex_fork_epoch odd, and then locks only the arenas
+ * whose epoch is current.  Once they are locked, it checks all the other
+ * arenas again, and starts over if any of them has been used in the meantime.
+ *
+ * A thread that has to update the arena's epoch while the fork epoch is odd
+ * waits for the fork to complete, after releasing the mutex, unless it already
+ * holds other tracked mutexes.  In that case waiting could deadlock the
+ * forking thread, so it proceeds instead.  That is safe because every chain of
+ * tracked mutexes a thread holds at once starts with one acquired before the
+ * fork began, whose arena the forking thread locks; the update is visible to
+ * the recheck once the forking thread has acquired that mutex.
+ *
+ * All loads and stores of the epochs are sequentially consistent.  A thread
+ * that finds its arena's epoch current (reading it before the fork epoch) or
+ * updates it before reading an even fork epoch is thus ordered before the fork
+ * epoch becomes odd, and the forking thread sees the arena as used.
+ */
+void
+malloc_mutex_fork_track(malloc_mutex_t *mutex, atomic_zu_t *fork_epoch) {
+	mutex->fork_epoch = fork_epoch;
+}
+
+/* Returns the epoch that arenas used since the previous fork are in. */
+size_t
+malloc_mutex_fork_begin(void) {
+	size_t epoch = atomic_load_zu(&malloc_mutex_fork_epoch,
+	    ATOMIC_RELAXED);
+	assert((epoch & 1) == 0);
+	atomic_store_zu(&malloc_mutex_fork_epoch, epoch + 1, ATOMIC_SEQ_CST);
+	return epoch;
+}
+
+/*
+ * Must be called before any skipped-over arena mutexes are released, so that
+ * threads acquiring them afterwards observe the new epoch.
+ */
+void
+malloc_mutex_fork_end(void) {
+	size_t epoch = atomic_load_zu(&malloc_mutex_fork_epoch,
+	    ATOMIC_RELAXED);
+	assert((epoch & 1) == 1);
+	atomic_store_zu(&malloc_mutex_fork_epoch, epoch + 1, ATOMIC_SEQ_CST);
+}
+
+bool
+malloc_mutex_fork_enter_slow(tsdn_t *tsdn, malloc_mutex_t *mutex) {
+	size_t epoch = atomic_load_zu(&malloc_mutex_fork_epoch,
+	    ATOMIC_SEQ_CST);
+	while (true) {
+		atomic_store_zu(mutex->fork_epoch, epoch & ~ZU(1),
+		    ATOMIC_SEQ_CST);
+		size_t cur = atomic_load_zu(&malloc_mutex_fork_epoch,
+		    ATOMIC_SEQ_CST);
+		if ((cur & ~ZU(1)) != (epoch & ~ZU(1))) {
+			/* A fork began or ended in between; update again. */
+			epoch = cur;
+			continue;
+		}
+		if ((cur & 1) == 0 ||
+		    *tsd_fork_nheldp_get_unsafe(tsdn_tsd(tsdn)) > 0) {
+			return false;
+		}
+		MALLOC_MUTEX_UNLOCK(mutex);
+		spin_t spinner = SPIN_INITIALIZER;
+		while (atomic_load_zu(&malloc_mutex_fork_epoch,
+		    ATOMIC_ACQUIRE) == cur) {
+			spin_adaptive(&spinner);
+		}
+		return true;
+	}
+}
+
 bool
 malloc_mutex_boot(void) {
 #ifdef JEMALLOC_MUTEX_INIT_CB
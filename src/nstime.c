@@ -168,3 +168,35 @@ nstime_update_impl(nstime_t *time) {
 	return false;
 }
 nstime_update_t *JET_MUTABLE nstime_update = nstime_update_impl;
+
+/*
+ * nstime_get() may read a coarse clock that only ticks every few ms, which is
+ * fine for decay but useless for timing a single madvise().
+ */
+#if !defined(_WIN32) && defined(JEMALLOC_HAVE_CLOCK_MONOTONIC)
+static void
+nstime_get_precise(nstime_t *time) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	nstime_init2(time, ts.tv_sec, ts.tv_nsec);
+}
+#else
+#  define nstime_get_precise nstime_get
+#endif
+
+bool
+nstime_update_precise(nstime_t *time) {
+	nstime_t old_time;
+
+	nstime_copy(&old_time, time);
+	nstime_get_precise(time);
+
+	/* Handle non-monotonic clocks. */
+	if (unlikely(nstime_compare(&old_time, time) > 0)) {
+		nstime_copy(time, &old_time);
+		return true;
+	}
+
+	return false;
+}
@@ -7,6 +7,7 @@
 
 #include "jemalloc/internal/assert.h"
 #include "jemalloc/internal/malloc_io.h"
+#include "jemalloc/internal/spin.h"
 
 #ifdef JEMALLOC_SYSCTL_VM_OVERCOMMIT
 #include <sys/sysctl.h>
@@ -33,6 +34,13 @@ static size_t	os_page;
 #  define PAGES_PROT_DECOMMIT (PROT_NONE)
 static int	mmap_flags;
 #endif
+#if defined(__linux__) && defined(SYS_mlock2)
+#  ifdef MLOCK_ONFAULT
+#    define PAGES_MLOCK_ONFAULT MLOCK_ONFAULT
+#  else
+#    define PAGES_MLOCK_ONFAULT 1U
+#  endif
+#endif
 static bool	os_overcommits;
 
 const char *thp_mode_names[] = {
@@ -47,6 +55,31 @@ thp_mode_t init_system_thp_mode;
 /* Runtime support for lazy purge. Irrelevant when !pages_can_purge_lazy. */
 static bool pages_can_purge_lazy_runtime = true;
 
+/*
+ * The runtime purge support above is probed on first use rather than at boot,
+ * since short-lived processes often exit before they ever purge.
+ */
+#define PAGES_PURGE_PROBE_NONE		0U
+#define PAGES_PURGE_PROBE_BUSY		1U
+#define PAGES_PURGE_PROBE_DONE		2U
+static atomic_u_t pages_purge_probe_state =
+    ATOMIC_INIT(PAGES_PURGE_PROBE_NONE);
+
+/*
+ * process_madvise(2) purges several ranges with a single syscall.  Whether the
+ * kernel accepts the advice we need for our own pid is probed at boot.
+ */
+#if defined(SYS_process_madvise) && defined(SYS_pidfd_open)
+#  define PAGES_CAN_PURGE_BATCH
+#endif
+
+#ifdef PAGES_CAN_PURGE_BATCH
+/* pidfd referring to this process; -1 if batch purging is unavailable. */
+static int pages_pidfd = -1;
+static bool pages_can_purge_batch_lazy_runtime = false;
+static bool pages_can_purge_batch_forced_runtime = false;
+#endif
+
 /******************************************************************************/
 /*
  * Function prototypes for static functions that are referenced prior to
@@ -54,6 +87,12 @@ static bool pages_can_purge_lazy_runtime = true;
  */
 
 static void os_pages_unmap(void *addr, size_t size);
+static bool pages_purge_lazy_impl(void *addr, size_t size);
+#ifdef PAGES_CAN_PURGE_BATCH
+static bool pages_purge_batch_impl(const pages_range_t *ranges,
+    size_t nranges, bool lazy);
+#endif
+static void pages_purge_probe(void);
 
 /******************************************************************************/
 
@@ -281,6 +320,7 @@ pages_purge_lazy(void *addr, size_t size) {
 	if (!pages_can_purge_lazy) {
 		return true;
 	}
+	pages_purge_probe();
 	if (!pages_can_purge_lazy_runtime) {
 		/*
 		 * Built with lazy purge enabled, but detected it was not
@@ -288,7 +328,11 @@ pages_purge_lazy(void *addr, size_t size) {
 		 */
 		return true;
 	}
+	return pages_purge_lazy_impl(addr, size);
+}
 
+static bool
+pages_purge_lazy_impl(void *addr, size_t size) {
 #ifdef _WIN32
 	VirtualAlloc(addr, size, MEM_RESET, PAGE_READWRITE);
 	return false;
@@ -328,6 +372,127 @@ pages_purge_forced(void *addr, size_t size) {
 #endif
 }
 
+#ifdef PAGES_CAN_PURGE_BATCH
+/* Advice matching pages_purge_lazy()/pages_purge_forced(), or -1 if none. */
+static int
+pages_purge_batch_advice(bool lazy) {
+	if (lazy) {
+#if defined(JEMALLOC_PURGE_MADVISE_FREE)
+#  ifdef MADV_FREE
+		return MADV_FREE;
+#  else
+		return JEMALLOC_MADV_FREE;
+#  endif
+#elif defined(JEMALLOC_PURGE_MADVISE_DONTNEED) && \
+    !defined(JEMALLOC_PURGE_MADVISE_DONTNEED_ZEROS)
+		return MADV_DONTNEED;
+#else
+		return -1;
+#endif
+	}
+#if defined(JEMALLOC_PURGE_MADVISE_DONTNEED) && \
+    defined(JEMALLOC_PURGE_MADVISE_DONTNEED_ZEROS)
+	return MADV_DONTNEED;
+#else
+	return -1;
+#endif
+}
+#endif
+
+bool
+pages_purge_batch_enabled(bool lazy) {
+#ifdef PAGES_CAN_PURGE_BATCH
+	pages_purge_probe();
+	return lazy ? pages_can_purge_batch_lazy_runtime :
+	    pages_can_purge_batch_forced_runtime;
+#else
+	return false;
+#endif
+}
+
+/*
+ * Purge all of ranges with a single syscall, with the semantics of
+ * pages_purge_lazy() or pages_purge_forced().  Returns true if any part of the
+ * batch may not have been purged, in which case the caller should purge the
+ * ranges one at a time.
+ */
+bool
+pages_purge_batch(const pages_range_t *ranges, size_t nranges, bool lazy) {
+	assert(nranges > 0 && nranges <= PAGES_PURGE_BATCH_MAX);
+
+	if (!pages_purge_batch_enabled(lazy)) {
+		return true;
+	}
+#ifdef PAGES_CAN_PURGE_BATCH
+	return pages_purge_batch_impl(ranges, nranges, lazy);
+#else
+	not_reached();
+	return true;
+#endif
+}
+
+#ifdef PAGES_CAN_PURGE_BATCH
+static bool
+pages_purge_batch_impl(const pages_range_t *ranges, size_t nranges,
+    bool lazy) {
+	struct iovec iov[PAGES_PURGE_BATCH_MAX];
+	size_t size = 0;
+	for (size_t i = 0; i < nranges; i++) {
+		assert(PAGE_ADDR2BASE(ranges[i].addr) == ranges[i].addr);
+		assert(PAGE_CEILING(ranges[i].size) == ranges[i].size);
+		iov[i].iov_base = ranges[i].addr;
+		iov[i].iov_len = ranges[i].size;
+		size += ranges[i].size;
+	}
+	/* The kernel stops at the first range it fails to advise. */
+	long advised = syscall(SYS_process_madvise, pages_pidfd, iov,
+	    nranges, pages_purge_batch_advice(lazy), 0);
+	return (advised < 0 || (size_t)advised != size);
+}
+#endif
+
+/*
+ * Count the pages of [addr, addr+size) that are backed by physical memory.
+ * Lazily purged pages stay resident until the kernel reclaims them, so this
+ * tells how much of a lazy purge has actually been given back.  Returns true
+ * if residency cannot be queried.
+ */
+bool
+pages_nresident(void *addr, size_t size, size_t *r_nresident) {
+	assert(PAGE_ADDR2BASE(addr) == addr);
+	assert(PAGE_CEILING(size) == size);
+
+#if defined(JEMALLOC_PURGE_MADVISE_FREE) && defined(__linux__)
+	unsigned char vec[64];
+	size_t nresident = 0;
+	for (size_t offset = 0; offset < size; offset += sizeof(vec) << LG_PAGE) {
+		size_t len = size - offset;
+		if (len > sizeof(vec) << LG_PAGE) {
+			len = sizeof(vec) << LG_PAGE;
+		}
+		if (mincore((void *)((uintptr_t)addr + offset), len, vec) != 0) {
+			return true;
+		}
+		for (size_t i = 0; i < len >> LG_PAGE; i++) {
+			nresident += (vec[i] & 1);
+		}
+	}
+	*r_nresident = nresident;
+	return false;
+#else
+	return true;
+#endif
+}
+
+/*
+ * Whether pages_decommit() can succeed.  When it cannot, deallocating a
+ * retained extent with the default hooks falls back to pages_purge_forced().
+ */
+bool
+pages_decommit_enabled(void) {
+	return !os_overcommits;
+}
+
 static bool
 pages_huge_impl(void *addr, size_t size, bool aligned) {
 	if (aligned) {
@@ -397,6 +562,67 @@ pages_dodump(void *addr, size_t size) {
 #endif
 }
 
+/*
+ * Fault in [addr, addr+size) for writing, so that the first touches of the
+ * pages do not take page faults.  Page contents are preserved.
+ */
+void
+pages_prefault(void *addr, size_t size) {
+	assert(PAGE_ADDR2BASE(addr) == addr);
+	assert(PAGE_CEILING(size) == size);
+#if defined(__linux__) && defined(MADV_POPULATE_WRITE)
+	int err = get_errno();
+	bool populated = (madvise(addr, size, MADV_POPULATE_WRITE) == 0);
+	set_errno(err);
+	if (populated) {
+		return;
+	}
+	/* Kernels older than 5.14 reject the advice; touch the pages. */
+#endif
+	for (uintptr_t page = (uintptr_t)addr; page < (uintptr_t)addr + size;
+	    page += os_page) {
+		volatile char *p = (volatile char *)page;
+		*p = *p;
+	}
+}
+
+/*
+ * Lock [addr, addr+size) in memory as its pages get faulted in, without
+ * faulting them in now.  Returns true on error, e.g. if RLIMIT_MEMLOCK would
+ * be exceeded.
+ */
+bool
+pages_mlock(void *addr, size_t size) {
+	assert(PAGE_ADDR2BASE(addr) == addr);
+	assert(PAGE_CEILING(size) == size);
+#if defined(__linux__) && defined(SYS_mlock2)
+	int err = get_errno();
+	bool failed = (syscall(SYS_mlock2, addr, size, PAGES_MLOCK_ONFAULT)
+	    != 0);
+	if (failed && get_errno() == ENOSYS) {
+		/* Pre-4.4 kernels; lock (and fault in) the range right away. */
+		failed = (mlock(addr, size) != 0);
+	}
+	set_errno(err);
+	return failed;
+#elif !defined(_WIN32)
+	return mlock(addr, size) != 0;
+#else
+	return true;
+#endif
+}
+
+bool
+pages_munlock(void *addr, size_t size) {
+	assert(PAGE_ADDR2BASE(addr) == addr);
+	assert(PAGE_CEILING(size) == size);
+#ifndef _WIN32
+	return munlock(addr, size) != 0;
+#else
+	return true;
+#endif
+}
+
 
 static size_t
 os_page_detect(void) {
@@ -572,6 +798,85 @@ label_error:
 	opt_thp = init_system_thp_mode = thp_mode_not_supported;
 }
 
+#ifdef PAGES_CAN_PURGE_BATCH
+static void
+pages_purge_batch_init(void) {
+	pages_pidfd = (int)syscall(SYS_pidfd_open, getpid(), 0);
+	if (pages_pidfd == -1) {
+		return;
+	}
+
+	bool committed = false;
+	void *page = os_pages_map(NULL, PAGE, PAGE, &committed);
+	if (page != NULL) {
+		pages_range_t range = {page, PAGE};
+		pages_can_purge_batch_lazy_runtime = pages_can_purge_lazy &&
+		    pages_can_purge_lazy_runtime &&
+		    pages_purge_batch_advice(true) != -1;
+		if (pages_can_purge_batch_lazy_runtime &&
+		    pages_purge_batch_impl(&range, 1, true)) {
+			pages_can_purge_batch_lazy_runtime = false;
+		}
+		pages_can_purge_batch_forced_runtime = pages_can_purge_forced &&
+		    pages_purge_batch_advice(false) != -1;
+		if (pages_can_purge_batch_forced_runtime &&
+		    pages_purge_batch_impl(&range, 1, false)) {
+			pages_can_purge_batch_forced_runtime = false;
+		}
+		os_pages_unmap(page, PAGE);
+	}
+
+	if (!pages_can_purge_batch_lazy_runtime &&
+	    !pages_can_purge_batch_forced_runtime) {
+		close(pages_pidfd);
+		pages_pidfd = -1;
+	}
+}
+#endif
+
+static void
+pages_purge_probe_impl(void) {
+	/* Detect lazy purge runtime support. */
+	if (pages_can_purge_lazy) {
+		bool committed = false;
+		void *madv_free_page = os_pages_map(NULL, PAGE, PAGE, &committed);
+		if (madv_free_page == NULL ||
+		    pages_purge_lazy_impl(madv_free_page, PAGE)) {
+			pages_can_purge_lazy_runtime = false;
+		}
+		if (madv_free_page != NULL) {
+			os_pages_unmap(madv_free_page, PAGE);
+		}
+	}
+
+#ifdef PAGES_CAN_PURGE_BATCH
+	pages_purge_batch_init();
+#endif
+}
+
+static void
+pages_purge_probe(void) {
+	if (likely(atomic_load_u(&pages_purge_probe_state, ATOMIC_ACQUIRE) ==
+	    PAGES_PURGE_PROBE_DONE)) {
+		return;
+	}
+	unsigned expected = PAGES_PURGE_PROBE_NONE;
+	if (atomic_compare_exchange_strong_u(&pages_purge_probe_state,
+	    &expected, PAGES_PURGE_PROBE_BUSY, ATOMIC_ACQUIRE,
+	    ATOMIC_RELAXED)) {
+		pages_purge_probe_impl();
+		atomic_store_u(&pages_purge_probe_state, PAGES_PURGE_PROBE_DONE,
+		    ATOMIC_RELEASE);
+		return;
+	}
+	/* Another thread is probing; wait for its results. */
+	spin_t spinner = SPIN_INITIALIZER;
+	while (atomic_load_u(&pages_purge_probe_state, ATOMIC_ACQUIRE) !=
+	    PAGES_PURGE_PROBE_DONE) {
+		spin_adaptive(&spinner);
+	}
+}
+
 bool
 pages_boot(void) {
 	os_page = os_page_detect();
@@ -609,19 +914,36 @@ pages_boot(void) {
 
 	init_thp_state();
 
-	/* Detect lazy purge runtime support. */
-	if (pages_can_purge_lazy) {
-		bool committed = false;
-		void *madv_free_page = os_pages_map(NULL, PAGE, PAGE, &committed);
-		if (madv_free_page == NULL) {
-			return true;
+	return false;
+}
+
+void
+pages_postfork_child(void) {
+	if (atomic_load_u(&pages_purge_probe_state, ATOMIC_RELAXED) !=
+	    PAGES_PURGE_PROBE_DONE) {
+		/* A probe interrupted by fork() is redone from scratch. */
+		atomic_store_u(&pages_purge_probe_state, PAGES_PURGE_PROBE_NONE,
+		    ATOMIC_RELAXED);
+#ifdef PAGES_CAN_PURGE_BATCH
+		if (pages_pidfd != -1) {
+			close(pages_pidfd);
+			pages_pidfd = -1;
 		}
-		assert(pages_can_purge_lazy_runtime);
-		if (pages_purge_lazy(madv_free_page, PAGE)) {
-			pages_can_purge_lazy_runtime = false;
+		pages_can_purge_batch_lazy_runtime = false;
+		pages_can_purge_batch_forced_runtime = false;
+#endif
+		pages_can_purge_lazy_runtime = true;
+		return;
+	}
+#ifdef PAGES_CAN_PURGE_BATCH
+	/* The inherited pidfd still refers to the parent. */
+	if (pages_pidfd != -1) {
+		close(pages_pidfd);
+		pages_pidfd = (int)syscall(SYS_pidfd_open, getpid(), 0);
+		if (pages_pidfd == -1) {
+			pages_can_purge_batch_lazy_runtime = false;
+			pages_can_purge_batch_forced_runtime = false;
 		}
-		os_pages_unmap(madv_free_page, PAGE);
 	}
-
-	return false;
+#endif
 }
@@ -0,0 +1,284 @@
+#define JEMALLOC_PERCPU_CACHE_C_
+#include "jemalloc/internal/jemalloc_preamble.h"
+#include "jemalloc/internal/jemalloc_internal_includes.h"
+
+#include "jemalloc/internal/assert.h"
+#include "jemalloc/internal/percpu_cache.h"
+
+/******************************************************************************/
+/* Data. */
+
+bool opt_percpu_cache = false;
+
+bool percpu_cache_enabled = false;
+unsigned percpu_cache_ncpus = 0;
+uintptr_t percpu_cache_base;
+size_t percpu_cache_stride;
+atomic_u64_t percpu_cache_naborts = ATOMIC_INIT(0);
+
+static atomic_u64_t percpu_cache_nfills = ATOMIC_INIT(0);
+static atomic_u64_t percpu_cache_nflushes = ATOMIC_INIT(0);
+
+/******************************************************************************/
+
+bool
+percpu_cache_boot(tsd_t *tsd) {
+	if (!opt_percpu_cache) {
+		return false;
+	}
+	if (config_prof && opt_prof) {
+		/* Cached objects would escape prof_accumbytes. */
+		opt_percpu_cache = false;
+		malloc_printf("<jemalloc>: perCPU cache not supported with "
+		    "profiling\n");
+		if (opt_abort) {
+			abort();
+		}
+		return false;
+	}
+	if (!have_rseq || rseq_cpu_id_get(rseq_area_get(tsd)) < 0) {
+		opt_percpu_cache = false;
+		malloc_printf("<jemalloc>: perCPU cache rseq not available\n");
+		if (opt_abort) {
+			abort();
+		}
+		return false;
+	}
+
+	size_t stack_nelms = 0;
+	for (unsigned i = 0; i < NBINS; i++) {
+		stack_nelms += tcache_bin_info[i].ncached_max;
+	}
+	/*
+	 * All caches are allocated up front.  Base memory is demand-zeroed, so
+	 * the stacks of idle CPUs' caches never become resident.
+	 */
+	percpu_cache_stride = CACHELINE_CEILING(sizeof(percpu_cache_t) +
+	    stack_nelms * sizeof(void *));
+	void *base = base_alloc(tsd_tsdn(tsd), b0get(), ncpus *
+	    percpu_cache_stride, CACHELINE);
+	if (base == NULL) {
+		return true;
+	}
+	percpu_cache_base = (uintptr_t)base;
+	percpu_cache_ncpus = ncpus;
+	for (unsigned cpu = 0; cpu < ncpus; cpu++) {
+		percpu_cache_t *cache = percpu_cache_get(cpu);
+		uintptr_t stack = (uintptr_t)cache + sizeof(percpu_cache_t);
+		for (unsigned i = 0; i < NBINS; i++) {
+			cache_bin_t *bin = &cache->bins[i];
+			bin->low_water = 0;
+			bin->ncached = 0;
+			stack += tcache_bin_info[i].ncached_max *
+			    sizeof(void *);
+			bin->avail = (void **)stack;
+		}
+	}
+	percpu_cache_enabled = true;
+
+	return false;
+}
+
+/*
+ * Pushes the objects of tbin onto the current CPU's bin, and flushes those
+ * that do not fit.
+ */
+static void
+percpu_cache_bin_fill(tsd_t *tsd, rseq_area_t *area, arena_t *arena,
+    cache_bin_t *tbin, szind_t binind) {
+	cache_bin_sz_t ncached_max = tcache_bin_info[binind].ncached_max;
+	cache_bin_sz_t i = 0;
+	/* The lowest regions are pushed last, so that they are used first. */
+	while (i < tbin->ncached) {
+		int32_t cpu = rseq_cpu_id_get(area);
+		percpu_cache_t *cache = percpu_cache_get(cpu);
+		if (cache == NULL) {
+			break;
+		}
+		percpu_cache_op_t op = percpu_cache_bin_push(area, cpu,
+		    &cache->bins[binind], ncached_max, *(tbin->avail - 1 - i));
+		if (op == percpu_cache_op_done) {
+			i++;
+		} else if (op == percpu_cache_op_bin_limit) {
+			break;
+		} else {
+			percpu_cache_abort_record();
+		}
+	}
+	if (i < tbin->ncached) {
+		tbin->avail -= i;
+		tbin->ncached -= i;
+		tcache_bin_flush_small_arena(tsd, arena, tbin, binind, 0, NULL);
+	}
+}
+
+void *
+percpu_cache_alloc_hard(tsd_t *tsd, rseq_area_t *area, szind_t binind) {
+	arena_t *arena = arena_choose(tsd, NULL);
+	if (unlikely(arena == NULL)) {
+		return NULL;
+	}
+
+	cache_bin_sz_t ncached_max = tcache_bin_info[binind].ncached_max;
+	VARIABLE_ARRAY(void *, stack, ncached_max);
+	cache_bin_t tbin;
+	tbin.low_water = 0;
+	tbin.ncached = 0;
+	tbin.avail = stack + ncached_max;
+#if defined(ANDROID_ENABLE_TCACHE_STATS)
+	tbin.tstats.nrequests = 0;
+#endif
+	arena_cache_bin_fill_small(tsd_tsdn(tsd), arena, &tbin, binind,
+	    ncached_max >> 1, 0);
+	if (config_stats) {
+		atomic_fetch_add_u64(&percpu_cache_nfills, 1, ATOMIC_RELAXED);
+	}
+
+	bool success;
+	void *ret = cache_bin_alloc_easy(&tbin, &success);
+	if (unlikely(!success)) {
+		return NULL;
+	}
+	percpu_cache_bin_fill(tsd, area, arena, &tbin, binind);
+	return ret;
+}
+
+bool
+percpu_cache_dalloc_hard(tsd_t *tsd, rseq_area_t *area, void *ptr,
+    szind_t binind) {
+	arena_t *arena = arena_choose(tsd, NULL);
+	if (unlikely(arena == NULL)) {
+		return false;
+	}
+
+	/* Flush ptr along with the older half of the bin. */
+	cache_bin_sz_t nflush = tcache_bin_info[binind].ncached_max >> 1;
+	VARIABLE_ARRAY(void *, stack, nflush + 1);
+	cache_bin_t tbin;
+	tbin.low_water = 0;
+	tbin.ncached = 1;
+	tbin.avail = stack + nflush + 1;
+#if defined(ANDROID_ENABLE_TCACHE_STATS)
+	tbin.tstats.nrequests = 0;
+#endif
+	*(tbin.avail - 1) = ptr;
+	while (tbin.ncached <= nflush) {
+		int32_t cpu = rseq_cpu_id_get(area);
+		percpu_cache_t *cache = percpu_cache_get(cpu);
+		if (cache == NULL) {
+			break;
+		}
+		percpu_cache_op_t op = percpu_cache_bin_pop(area, cpu,
+		    &cache->bins[binind], tbin.avail - tbin.ncached - 1);
+		if (op == percpu_cache_op_done) {
+			tbin.ncached++;
+		} else if (op == percpu_cache_op_bin_limit) {
+			break;
+		} else {
+			percpu_cache_abort_record();
+		}
+	}
+	tcache_bin_flush_small_arena(tsd, arena, &tbin, binind, 0, NULL);
+	if (config_stats) {
+		atomic_fetch_add_u64(&percpu_cache_nflushes, 1, ATOMIC_RELAXED);
+	}
+
+	return true;
+}
+
+/* Flushes what the current CPU's bin holds, up to a bin's capacity. */
+static void
+percpu_cache_bin_drain(tsd_t *tsd, rseq_area_t *area, arena_t *arena,
+    szind_t binind) {
+	cache_bin_sz_t ncached_max = tcache_bin_info[binind].ncached_max;
+	VARIABLE_ARRAY(void *, stack, ncached_max);
+	cache_bin_t tbin;
+	tbin.low_water = 0;
+	tbin.ncached = 0;
+	tbin.avail = stack + ncached_max;
+#if defined(ANDROID_ENABLE_TCACHE_STATS)
+	tbin.tstats.nrequests = 0;
+#endif
+	while (tbin.ncached < ncached_max) {
+		int32_t cpu = rseq_cpu_id_get(area);
+		percpu_cache_t *cache = percpu_cache_get(cpu);
+		if (cache == NULL) {
+			break;
+		}
+		percpu_cache_op_t op = percpu_cache_bin_pop(area, cpu,
+		    &cache->bins[binind], tbin.avail - tbin.ncached - 1);
+		if (op == percpu_cache_op_done) {
+			tbin.ncached++;
+		} else if (op == percpu_cache_op_bin_limit) {
+			break;
+		} else {
+			percpu_cache_abort_record();
+		}
+	}
+	if (tbin.ncached == 0) {
+		return;
+	}
+	tcache_bin_flush_small_arena(tsd, arena, &tbin, binind, 0, NULL);
+	if (config_stats) {
+		atomic_fetch_add_u64(&percpu_cache_nflushes, 1, ATOMIC_RELAXED);
+	}
+}
+
+/*
+ * Flushes the objects cached by all CPUs.  Only a thread running on a CPU may
+ * take objects out of its bins, so the calling thread migrates to each CPU in
+ * turn, and gets its affinity back afterwards.  CPUs that no thread of the
+ * process may run on are skipped.
+ */
+void
+percpu_cache_flush_all(tsd_t *tsd) {
+#ifdef JEMALLOC_HAVE_SCHED_SETAFFINITY
+	arena_t *arena = arena_choose(tsd, NULL);
+	if (unlikely(arena == NULL)) {
+		return;
+	}
+	cpu_set_t affinity;
+	if (sched_getaffinity(0, sizeof(affinity), &affinity) != 0) {
+		return;
+	}
+	rseq_area_t *area = rseq_area_get(tsd);
+	for (unsigned cpu = 0; cpu < percpu_cache_ncpus; cpu++) {
+		cpu_set_t cpuset;
+		CPU_ZERO(&cpuset);
+		CPU_SET(cpu, &cpuset);
+		if (sched_setaffinity(0, sizeof(cpuset), &cpuset) != 0) {
+			continue;
+		}
+		for (unsigned i = 0; i < NBINS; i++) {
+			percpu_cache_bin_drain(tsd, area, arena, i);
+		}
+	}
+	sched_setaffinity(0, sizeof(affinity), &affinity);
+#endif
+}
+
+void
+percpu_cache_stats_read(percpu_cache_stats_t *stats) {
+	stats->ncached = 0;
+	stats->bytes = 0;
+	for (unsigned cpu = 0; cpu < percpu_cache_ncpus; cpu++) {
+		percpu_cache_t *cache = percpu_cache_get(cpu);
+		percpu_cache_cpu_stats_t *cpu_stats = &stats->cpus[cpu];
+		cpu_stats->ncached = 0;
+		cpu_stats->bytes = 0;
+		for (unsigned i = 0; i < NBINS; i++) {
+			/* Racy, since the bins belong to other CPUs. */
+			cache_bin_sz_t ncached = *(volatile cache_bin_sz_t *)
+			    &cache->bins[i].ncached;
+			cpu_stats->ncached += ncached;
+			cpu_stats->bytes += ncached * sz_index2size(i);
+		}
+		stats->ncached += cpu_stats->ncached;
+		stats->bytes += cpu_stats->bytes;
+	}
+	stats->naborts = atomic_load_u64(&percpu_cache_naborts,
+	    ATOMIC_RELAXED);
+	stats->nfills = atomic_load_u64(&percpu_cache_nfills, ATOMIC_RELAXED);
+	stats->nflushes = atomic_load_u64(&percpu_cache_nflushes,
+	    ATOMIC_RELAXED);
+}
@@ -0,0 +1,162 @@
+#define JEMALLOC_PURGE_BUDGET_C_
+#include "jemalloc/internal/jemalloc_preamble.h"
+#include "jemalloc/internal/jemalloc_internal_includes.h"
+
+#include "jemalloc/internal/assert.h"
+#include "jemalloc/internal/nstime.h"
+#include "jemalloc/internal/purge_budget.h"
+
+/******************************************************************************/
+/* Data. */
+
+size_t opt_purge_rate = 0;
+size_t opt_purge_call_max = 0;
+size_t opt_purge_inline_share = PURGE_INLINE_SHARE_DEFAULT;
+
+/* Bytes currently available; negative after an oversized purge. */
+static atomic_zd_t purge_budget_tokens = ATOMIC_INIT(0);
+/* Time of the last refill, in nanoseconds. */
+static atomic_u64_t purge_budget_refill_ns = ATOMIC_INIT(0);
+
+static atomic_zu_t purge_budget_debt = ATOMIC_INIT(0);
+static atomic_u64_t purge_budget_nthrottled = ATOMIC_INIT(0);
+static atomic_u64_t purge_budget_max_duration = ATOMIC_INIT(0);
+
+#define MILLION	UINT64_C(1000000)
+
+/******************************************************************************/
+
+static uint64_t
+purge_budget_now_ns(void) {
+	nstime_t now;
+	nstime_init(&now, 0);
+	nstime_update(&now);
+	return nstime_ns(&now);
+}
+
+/* The bucket holds at most one second's worth of budget. */
+static ssize_t
+purge_budget_capacity(void) {
+	return (opt_purge_rate > (size_t)SSIZE_MAX) ? SSIZE_MAX :
+	    (ssize_t)opt_purge_rate;
+}
+
+static void
+purge_budget_refill(void) {
+	uint64_t now_ns = purge_budget_now_ns();
+	uint64_t last_ns = atomic_load_u64(&purge_budget_refill_ns,
+	    ATOMIC_RELAXED);
+	if (now_ns <= last_ns) {
+		return;
+	}
+	if (!atomic_compare_exchange_strong_u64(&purge_budget_refill_ns,
+	    &last_ns, now_ns, ATOMIC_RELAXED, ATOMIC_RELAXED)) {
+		/* Another thread is refilling for this interval. */
+		return;
+	}
+	uint64_t elapsed_us = (now_ns - last_ns) / 1000;
+	if (elapsed_us > MILLION) {
+		elapsed_us = MILLION;
+	}
+	ssize_t capacity = purge_budget_capacity();
+	ssize_t refill = ((uint64_t)capacity < UINT64_MAX / MILLION) ?
+	    (ssize_t)((uint64_t)capacity * elapsed_us / MILLION) :
+	    (ssize_t)((uint64_t)capacity / MILLION * elapsed_us);
+	ssize_t tokens = atomic_load_zd(&purge_budget_tokens, ATOMIC_RELAXED);
+	ssize_t tokens_new;
+	do {
+		tokens_new = (tokens > capacity - refill) ? capacity : tokens +
+		    refill;
+	} while (!atomic_compare_exchange_weak_zd(&purge_budget_tokens, &tokens,
+	    tokens_new, ATOMIC_RELAXED, ATOMIC_RELAXED));
+}
+
+static size_t
+purge_budget_inline_share(size_t avail) {
+	return (avail < SIZE_T_MAX / 100) ? avail * opt_purge_inline_share /
+	    100 : avail / 100 * opt_purge_inline_share;
+}
+
+static size_t
+purge_budget_take_tokens(size_t wanted, bool is_background_thread) {
+	purge_budget_refill();
+	ssize_t tokens = atomic_load_zd(&purge_budget_tokens, ATOMIC_RELAXED);
+	size_t granted;
+	do {
+		size_t avail = (tokens > 0) ? (size_t)tokens : 0;
+		if (!is_background_thread && background_thread_enabled()) {
+			avail = purge_budget_inline_share(avail);
+		}
+		granted = ((wanted < avail) ? wanted : avail) & ~PAGE_MASK;
+		if (granted == 0) {
+			break;
+		}
+	} while (!atomic_compare_exchange_weak_zd(&purge_budget_tokens, &tokens,
+	    tokens - (ssize_t)granted, ATOMIC_RELAXED, ATOMIC_RELAXED));
+	return granted;
+}
+
+size_t
+purge_budget_take(size_t wanted, bool is_background_thread) {
+	size_t granted = wanted;
+	if (opt_purge_call_max != 0 && granted > opt_purge_call_max) {
+		granted = opt_purge_call_max & ~PAGE_MASK;
+	}
+	if (opt_purge_rate != 0) {
+		granted = purge_budget_take_tokens(granted,
+		    is_background_thread);
+	}
+	if (config_stats && granted < wanted) {
+		atomic_fetch_add_u64(&purge_budget_nthrottled, 1,
+		    ATOMIC_RELAXED);
+	}
+	return granted;
+}
+
+void
+purge_budget_settle(size_t granted, size_t purged) {
+	if (opt_purge_rate == 0 || purged == granted) {
+		return;
+	}
+	atomic_fetch_add_zd(&purge_budget_tokens, (ssize_t)granted -
+	    (ssize_t)purged, ATOMIC_RELAXED);
+}
+
+void
+purge_budget_debt_update(size_t debt_old, size_t debt_new) {
+	if (debt_new > debt_old) {
+		atomic_fetch_add_zu(&purge_budget_debt, debt_new - debt_old,
+		    ATOMIC_RELAXED);
+	} else if (debt_new < debt_old) {
+		atomic_fetch_sub_zu(&purge_budget_debt, debt_old - debt_new,
+		    ATOMIC_RELAXED);
+	}
+}
+
+void
+purge_budget_duration_record(uint64_t duration) {
+	uint64_t max = atomic_load_u64(&purge_budget_max_duration,
+	    ATOMIC_RELAXED);
+	while (duration > max && !atomic_compare_exchange_weak_u64(
+	    &purge_budget_max_duration, &max, duration, ATOMIC_RELAXED,
+	    ATOMIC_RELAXED)) {
+		/* max now holds the latest value; retry. */
+	}
+}
+
+void
+purge_budget_stats_read(purge_budget_stats_t *stats) {
+	stats->debt = atomic_load_zu(&purge_budget_debt, ATOMIC_RELAXED);
+	stats->nthrottled = atomic_load_u64(&purge_budget_nthrottled,
+	    ATOMIC_RELAXED);
+	stats->max_duration = atomic_load_u64(&purge_budget_max_duration,
+	    ATOMIC_RELAXED);
+}
+
+void
+purge_budget_boot(void) {
+	atomic_store_zd(&purge_budget_tokens, purge_budget_capacity(),
+	    ATOMIC_RELAXED);
+	atomic_store_u64(&purge_budget_refill_ns, purge_budget_now_ns(),
+	    ATOMIC_RELAXED);
+}
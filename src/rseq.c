@@ -0,0 +1,68 @@
+#define JEMALLOC_RSEQ_C_
+#include "jemalloc/internal/jemalloc_preamble.h"
+#include "jemalloc/internal/jemalloc_internal_includes.h"
+
+#include "jemalloc/internal/assert.h"
+#include "jemalloc/internal/rseq.h"
+
+/******************************************************************************/
+/* Data. */
+
+/* Handed out to threads that cannot use rseq. */
+static rseq_area_t rseq_area_unregistered = {0,
+    RSEQ_CPU_ID_REGISTRATION_FAILED, 0, 0};
+
+#ifdef JEMALLOC_HAVE_RSEQ
+/*
+ * Exported by glibc 2.35 and later.  __rseq_size is 0 if glibc does not
+ * register areas, e.g. because of the glibc.pthread.rseq tunable.
+ */
+extern const ptrdiff_t __rseq_offset JEMALLOC_ATTR(weak);
+extern const unsigned int __rseq_size JEMALLOC_ATTR(weak);
+
+/* Whether glibc registers an area, at rseq_glibc_offset from the TCB. */
+static bool rseq_glibc = false;
+static ptrdiff_t rseq_glibc_offset;
+
+/* Registered by ourselves in the absence of glibc's. */
+static __thread rseq_area_t JEMALLOC_TLS_MODEL rseq_area_tls = {0,
+    RSEQ_CPU_ID_UNINITIALIZED, 0, 0};
+#endif
+
+/******************************************************************************/
+
+void
+rseq_boot(void) {
+#ifdef JEMALLOC_HAVE_RSEQ
+	if (&__rseq_size != NULL && __rseq_size != 0) {
+		rseq_glibc = true;
+		rseq_glibc_offset = __rseq_offset;
+	}
+#endif
+}
+
+rseq_area_t *
+rseq_area_register(tsd_t *tsd) {
+	rseq_area_t *area = &rseq_area_unregistered;
+#ifdef JEMALLOC_HAVE_RSEQ
+	if (rseq_glibc) {
+		uintptr_t tp;
+		__asm__ ("movq %%fs:0, %0" : "=r" (tp));
+		area = (rseq_area_t *)(tp + rseq_glibc_offset);
+	} else {
+		int err = get_errno();
+		/*
+		 * EBUSY means that the thread is registered already, which is
+		 * fine if it was us (the tsd may have been reinitialized).
+		 */
+		if (syscall(SYS_rseq, &rseq_area_tls, sizeof(rseq_area_t), 0,
+		    RSEQ_SIG) == 0 || (get_errno() == EBUSY &&
+		    rseq_cpu_id_get(&rseq_area_tls) >= 0)) {
+			area = &rseq_area_tls;
+		}
+		set_errno(err);
+	}
+#endif
+	tsd_rseq_area_set(tsd, area);
+	return area;
+}
@@ -27,6 +27,29 @@ rtree_new(rtree_t *rtree, bool zeroed) {
 	return false;
 }
 
+/*
+ * Sets up the flat leaf for [base, base + size).  Its pages are only touched,
+ * and hence only become resident, as the corresponding keys are written.  Must
+ * be called before any key in the range is written.
+ */
+bool
+rtree_flat_init(rtree_t *rtree, void *base, size_t size) {
+	assert(PAGE_ADDR2BASE(base) == base);
+	assert(rtree->flat_size == 0);
+
+	bool commit = true;
+	rtree_leaf_elm_t *flat = (rtree_leaf_elm_t *)pages_map(NULL,
+	    PAGE_CEILING((size >> LG_PAGE) * sizeof(rtree_leaf_elm_t)), PAGE,
+	    &commit);
+	if (flat == NULL) {
+		return true;
+	}
+	rtree->flat = flat;
+	rtree->flat_base = (uintptr_t)base;
+	rtree->flat_size = size;
+	return false;
+}
+
 static rtree_node_elm_t *
 rtree_node_alloc_impl(tsdn_t *tsdn, rtree_t *rtree, size_t nelms) {
 	return (rtree_node_elm_t *)base_alloc(tsdn, b0get(), nelms *
@@ -95,6 +118,10 @@ rtree_delete(tsdn_t *tsdn, rtree_t *rtree) {
 #  if RTREE_HEIGHT > 1
 	rtree_delete_subtree(tsdn, rtree, rtree->root, 0);
 #  endif
+	if (rtree->flat_size != 0) {
+		pages_unmap(rtree->flat, PAGE_CEILING((rtree->flat_size >>
+		    LG_PAGE) * sizeof(rtree_leaf_elm_t)));
+	}
 }
 #endif
 
@@ -232,7 +259,8 @@ rtree_leaf_elm_lookup_hard(tsdn_t *tsdn, rtree_t *rtree, rtree_ctx_t *rtree_ctx,
 
 	if (config_debug) {
 		uintptr_t leafkey = rtree_leafkey(key);
-		for (unsigned i = 0; i < RTREE_CTX_NCACHE; i++) {
+		for (unsigned i = 0; i < RTREE_CTX_NCACHE * RTREE_CTX_NWAYS;
+		    i++) {
 			assert(rtree_ctx->cache[i].leafkey != leafkey);
 		}
 		for (unsigned i = 0; i < RTREE_CTX_NCACHE_L2; i++) {
@@ -264,10 +292,14 @@ rtree_leaf_elm_lookup_hard(tsdn_t *tsdn, rtree_t *rtree, rtree_ctx_t *rtree_ctx,
 			    dependent);					\
 		}							\
 	}
+#ifdef ANDROID_RTREE_CTX_STATS
+	rtree_ctx->nhard++;
+#endif
+
 	/*
 	 * Cache replacement upon hard lookup (i.e. L1 & L2 rtree cache miss):
-	 * (1) evict last entry in L2 cache; (2) move the collision slot from L1
-	 * cache down to L2; and 3) fill L1.
+	 * (1) evict last entry in L2 cache; (2) move the last way of the L1 set
+	 * down to L2; and 3) fill the front of the L1 set.
 	 */
 #define RTREE_GET_LEAF(level) {						\
 		assert(level == RTREE_HEIGHT-1);			\
@@ -284,13 +316,20 @@ rtree_leaf_elm_lookup_hard(tsdn_t *tsdn, rtree_t *rtree, rtree_ctx_t *rtree_ctx,
 			    (RTREE_CTX_NCACHE_L2 - 1));			\
 		}							\
 		size_t slot = rtree_cache_direct_map(key);		\
+		rtree_ctx_cache_elm_t *set =				\
+		    &rtree_ctx->cache[slot * RTREE_CTX_NWAYS];		\
 		rtree_ctx->l2_cache[0].leafkey =			\
-		    rtree_ctx->cache[slot].leafkey;			\
+		    set[RTREE_CTX_NWAYS - 1].leafkey;			\
 		rtree_ctx->l2_cache[0].leaf =				\
-		    rtree_ctx->cache[slot].leaf;			\
+		    set[RTREE_CTX_NWAYS - 1].leaf;			\
+		if (RTREE_CTX_NWAYS > 1) {				\
+			memmove(&set[1], &set[0],			\
+			    sizeof(rtree_ctx_cache_elm_t) *		\
+			    (RTREE_CTX_NWAYS - 1));			\
+		}							\
 		uintptr_t leafkey = rtree_leafkey(key);			\
-		rtree_ctx->cache[slot].leafkey = leafkey;		\
-		rtree_ctx->cache[slot].leaf = leaf;			\
+		set[0].leafkey = leafkey;				\
+		set[0].leaf = leaf;					\
 		uintptr_t subkey = rtree_subkey(key, level);		\
 		return &leaf[subkey];					\
 	}
@@ -313,7 +352,7 @@ rtree_leaf_elm_lookup_hard(tsdn_t *tsdn, rtree_t *rtree, rtree_ctx_t *rtree_ctx,
 
 void
 rtree_ctx_data_init(rtree_ctx_t *ctx) {
-	for (unsigned i = 0; i < RTREE_CTX_NCACHE; i++) {
+	for (unsigned i = 0; i < RTREE_CTX_NCACHE * RTREE_CTX_NWAYS; i++) {
 		rtree_ctx_cache_elm_t *cache = &ctx->cache[i];
 		cache->leafkey = RTREE_LEAFKEY_INVALID;
 		cache->leaf = NULL;
@@ -323,4 +362,9 @@ rtree_ctx_data_init(rtree_ctx_t *ctx) {
 		cache->leafkey = RTREE_LEAFKEY_INVALID;
 		cache->leaf = NULL;
 	}
+#ifdef ANDROID_RTREE_CTX_STATS
+	ctx->nhits = 0;
+	ctx->nmisses = 0;
+	ctx->nhard = 0;
+#endif
 }
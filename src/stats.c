@@ -292,7 +292,7 @@ stats_arena_bins_print(emitter_t *emitter, bool mutex, unsigned i) {
 	for (j = 0, in_gap = false; j < nbins; j++) {
 		uint64_t nslabs;
 		size_t reg_size, slab_size, curregs;
-		size_t curslabs;
+		size_t curslabs, curslabs_empty;
 		uint32_t nregs;
 		uint64_t nmalloc, ndalloc, nrequests, nfills, nflushes;
 		uint64_t nreslabs;
@@ -327,6 +327,8 @@ stats_arena_bins_print(emitter_t *emitter, bool mutex, unsigned i) {
 		    uint64_t);
 		CTL_M2_M4_GET("stats.arenas.0.bins.0.curslabs", i, j, &curslabs,
 		    size_t);
+		CTL_M2_M4_GET("stats.arenas.0.bins.0.curslabs_empty", i, j,
+		    &curslabs_empty, size_t);
 
 		if (mutex) {
 			mutex_stats_read_arena_bin(i, j, col_mutex64,
@@ -350,6 +352,8 @@ stats_arena_bins_print(emitter_t *emitter, bool mutex, unsigned i) {
 		    &nreslabs);
 		emitter_json_kv(emitter, "curslabs", emitter_type_size,
 		    &curslabs);
+		emitter_json_kv(emitter, "curslabs_empty", emitter_type_size,
+		    &curslabs_empty);
 		if (mutex) {
 			emitter_json_dict_begin(emitter, "mutex");
 			mutex_stats_emit(emitter, NULL, col_mutex64,
@@ -519,16 +523,188 @@ stats_arena_mutexes_print(emitter_t *emitter, unsigned arena_ind) {
 	emitter_json_dict_end(emitter); /* End "mutexes". */
 }
 
+/* Only buckets with any reused pages make it to the table. */
+static void
+stats_arena_reuse_ages_print(emitter_t *emitter, unsigned i) {
+	size_t mib[CTL_MAX_DEPTH];
+	size_t miblen = sizeof(mib) / sizeof(size_t);
+	xmallctlnametomib("stats.arenas.0.reuse_ages.0.npages", mib, &miblen);
+	mib[2] = i;
+
+	bool in_table = false;
+	emitter_json_arr_begin(emitter, "reuse_ages");
+	for (unsigned j = 0; j < REUSE_AGE_NBUCKETS; j++) {
+		uint64_t npages;
+		size_t sz = sizeof(npages);
+		mib[4] = j;
+		xmallctlbymib(mib, miblen, (void *)&npages, &sz, NULL, 0);
+
+		emitter_json_arr_obj_begin(emitter);
+		emitter_json_kv(emitter, "npages", emitter_type_uint64,
+		    &npages);
+		emitter_json_arr_obj_end(emitter);
+
+		if (npages == 0) {
+			continue;
+		}
+		if (!in_table) {
+			emitter_table_printf(emitter,
+			    "pages reused, by age since dirtied:\n");
+			in_table = true;
+		}
+		if (j == 0) {
+			emitter_table_printf(emitter, "  %12s: %"FMTu64"\n",
+			    "< 1 ms", npages);
+		} else if (j == REUSE_AGE_NBUCKETS - 1) {
+			emitter_table_printf(emitter, "  >= %7"FMTu64" ms: %"
+			    FMTu64"\n", UINT64_C(1) << (j - 1), npages);
+		} else {
+			emitter_table_printf(emitter, "  <  %7"FMTu64" ms: %"
+			    FMTu64"\n", UINT64_C(1) << j, npages);
+		}
+	}
+	emitter_json_arr_end(emitter);
+}
+
+/* Only CPUs with any cached objects make it to the table. */
+static void
+stats_percpu_cache_print(emitter_t *emitter) {
+	unsigned ncpus;
+	size_t ncached, bytes;
+	uint64_t naborts, nfills, nflushes;
+
+	CTL_GET("stats.percpu_cache.ncpus", &ncpus, unsigned);
+	CTL_GET("stats.percpu_cache.ncached", &ncached, size_t);
+	CTL_GET("stats.percpu_cache.bytes", &bytes, size_t);
+	CTL_GET("stats.percpu_cache.naborts", &naborts, uint64_t);
+	CTL_GET("stats.percpu_cache.nfills", &nfills, uint64_t);
+	CTL_GET("stats.percpu_cache.nflushes", &nflushes, uint64_t);
+
+	emitter_json_dict_begin(emitter, "percpu_cache");
+	emitter_json_kv(emitter, "ncpus", emitter_type_unsigned, &ncpus);
+	emitter_json_kv(emitter, "ncached", emitter_type_size, &ncached);
+	emitter_json_kv(emitter, "bytes", emitter_type_size, &bytes);
+	emitter_json_kv(emitter, "naborts", emitter_type_uint64, &naborts);
+	emitter_json_kv(emitter, "nfills", emitter_type_uint64, &nfills);
+	emitter_json_kv(emitter, "nflushes", emitter_type_uint64, &nflushes);
+
+	emitter_table_printf(emitter, "Per-CPU caches: %zu objects (%zu "
+	    "bytes) on %u CPUs, fills: %"FMTu64", flushes: %"FMTu64", rseq "
+	    "aborts: %"FMTu64"\n", ncached, bytes, ncpus, nfills, nflushes,
+	    naborts);
+
+	size_t ncached_mib[CTL_MAX_DEPTH], bytes_mib[CTL_MAX_DEPTH];
+	size_t miblen = sizeof(ncached_mib) / sizeof(size_t);
+	xmallctlnametomib("stats.percpu_cache.cpus.0.ncached", ncached_mib,
+	    &miblen);
+	miblen = sizeof(bytes_mib) / sizeof(size_t);
+	xmallctlnametomib("stats.percpu_cache.cpus.0.bytes", bytes_mib,
+	    &miblen);
+	emitter_json_arr_begin(emitter, "cpus");
+	for (unsigned i = 0; i < ncpus; i++) {
+		size_t sz = sizeof(size_t);
+		ncached_mib[3] = i;
+		xmallctlbymib(ncached_mib, miblen, (void *)&ncached, &sz, NULL,
+		    0);
+		bytes_mib[3] = i;
+		xmallctlbymib(bytes_mib, miblen, (void *)&bytes, &sz, NULL, 0);
+
+		emitter_json_arr_obj_begin(emitter);
+		emitter_json_kv(emitter, "ncached", emitter_type_size,
+		    &ncached);
+		emitter_json_kv(emitter, "bytes", emitter_type_size, &bytes);
+		emitter_json_arr_obj_end(emitter);
+
+		if (ncached != 0) {
+			emitter_table_printf(emitter, "  cpu %4u: %zu objects "
+			    "(%zu bytes)\n", i, ncached, bytes);
+		}
+	}
+	emitter_json_arr_end(emitter); /* Close "cpus". */
+	emitter_json_dict_end(emitter); /* Close "percpu_cache". */
+}
+
+static void
+stats_arena_latency_print(emitter_t *emitter, unsigned i) {
+	static const char *const op_names[] = {
+#define OP(op) #op,
+		LATENCY_OPS
+#undef OP
+	};
+
+	emitter_json_dict_begin(emitter, "latency");
+	for (unsigned op = 0; op < latency_op_limit; op++) {
+		char name[128];
+		malloc_snprintf(name, sizeof(name),
+		    "stats.arenas.0.latency.%s.0.background", op_names[op]);
+		size_t mib[CTL_MAX_DEPTH];
+		size_t miblen = sizeof(mib) / sizeof(size_t);
+		xmallctlnametomib(name, mib, &miblen);
+		mib[2] = i;
+
+		bool in_table = false;
+		emitter_json_arr_begin(emitter, op_names[op]);
+		for (unsigned j = 0; j < LATENCY_NBUCKETS; j++) {
+			uint64_t background, application;
+			size_t sz = sizeof(uint64_t);
+			mib[5] = j;
+			mib[6] = 0;
+			xmallctlbymib(mib, miblen, (void *)&background, &sz,
+			    NULL, 0);
+			mib[6] = 1;
+			xmallctlbymib(mib, miblen, (void *)&application, &sz,
+			    NULL, 0);
+
+			emitter_json_arr_obj_begin(emitter);
+			emitter_json_kv(emitter, "background",
+			    emitter_type_uint64, &background);
+			emitter_json_kv(emitter, "application",
+			    emitter_type_uint64, &application);
+			emitter_json_arr_obj_end(emitter);
+
+			if (background == 0 && application == 0) {
+				continue;
+			}
+			if (!in_table) {
+				malloc_snprintf(name, sizeof(name),
+				    "%s latency:", op_names[op]);
+				emitter_table_printf(emitter, "%-16s%12s%13s\n",
+				    name, "background", "application");
+				in_table = true;
+			}
+			if (j == 0) {
+				malloc_snprintf(name, sizeof(name), "< 1 us");
+			} else if (j == LATENCY_NBUCKETS - 1) {
+				malloc_snprintf(name, sizeof(name), ">= %"FMTu64
+				    " us", UINT64_C(1) << (j - 1));
+			} else {
+				malloc_snprintf(name, sizeof(name), "< %"FMTu64
+				    " us", UINT64_C(1) << j);
+			}
+			emitter_table_printf(emitter, "  %-14s%12"FMTu64"%13"
+			    FMTu64"\n", name, background, application);
+		}
+		emitter_json_arr_end(emitter);
+	}
+	emitter_json_dict_end(emitter);
+}
+
 static void
 stats_arena_print(emitter_t *emitter, unsigned i, bool bins, bool large,
     bool mutex) {
 	unsigned nthreads;
 	const char *dss;
-	ssize_t dirty_decay_ms, muzzy_decay_ms;
-	size_t page, pactive, pdirty, pmuzzy, mapped, retained;
+	ssize_t dirty_decay_ms, muzzy_decay_ms, dirty_decay_ms_effective;
+	size_t page, pactive, pdirty, pmuzzy, mapped, retained, retained_peak;
 	size_t base, internal, resident, metadata_thp;
 	uint64_t dirty_npurge, dirty_nmadvise, dirty_purged;
 	uint64_t muzzy_npurge, muzzy_nmadvise, muzzy_purged;
+	uint64_t dirty_nmadvise_saved, muzzy_nmadvise_saved;
+	uint64_t extent_steals, extent_stolen;
+	uint64_t prefaulted, mlocked;
+	uint64_t retained_ntrims, retained_trimmed;
+	uint64_t lazy_nselected, forced_nselected;
+	uint64_t lazy_purged, lazy_reclaimed, forced_purged;
 	size_t small_allocated;
 	uint64_t small_nmalloc, small_ndalloc, small_nrequests;
 	size_t large_allocated;
@@ -554,16 +730,22 @@ stats_arena_print(emitter_t *emitter, unsigned i, bool bins, bool large,
 	    ssize_t);
 	CTL_M2_GET("stats.arenas.0.muzzy_decay_ms", i, &muzzy_decay_ms,
 	    ssize_t);
+	CTL_M2_GET("stats.arenas.0.dirty_decay_ms_effective", i,
+	    &dirty_decay_ms_effective, ssize_t);
 	CTL_M2_GET("stats.arenas.0.pactive", i, &pactive, size_t);
 	CTL_M2_GET("stats.arenas.0.pdirty", i, &pdirty, size_t);
 	CTL_M2_GET("stats.arenas.0.pmuzzy", i, &pmuzzy, size_t);
 	CTL_M2_GET("stats.arenas.0.dirty_npurge", i, &dirty_npurge, uint64_t);
 	CTL_M2_GET("stats.arenas.0.dirty_nmadvise", i, &dirty_nmadvise,
 	    uint64_t);
+	CTL_M2_GET("stats.arenas.0.dirty_nmadvise_saved", i,
+	    &dirty_nmadvise_saved, uint64_t);
 	CTL_M2_GET("stats.arenas.0.dirty_purged", i, &dirty_purged, uint64_t);
 	CTL_M2_GET("stats.arenas.0.muzzy_npurge", i, &muzzy_npurge, uint64_t);
 	CTL_M2_GET("stats.arenas.0.muzzy_nmadvise", i, &muzzy_nmadvise,
 	    uint64_t);
+	CTL_M2_GET("stats.arenas.0.muzzy_nmadvise_saved", i,
+	    &muzzy_nmadvise_saved, uint64_t);
 	CTL_M2_GET("stats.arenas.0.muzzy_purged", i, &muzzy_purged, uint64_t);
 
 	emitter_row_t decay_row;
@@ -574,6 +756,8 @@ stats_arena_print(emitter_t *emitter, unsigned i, bool bins, bool large,
 	    &dirty_decay_ms);
 	emitter_json_kv(emitter, "muzzy_decay_ms", emitter_type_ssize,
 	    &muzzy_decay_ms);
+	emitter_json_kv(emitter, "dirty_decay_ms_effective", emitter_type_ssize,
+	    &dirty_decay_ms_effective);
 
 	emitter_json_kv(emitter, "pactive", emitter_type_size, &pactive);
 	emitter_json_kv(emitter, "pdirty", emitter_type_size, &pdirty);
@@ -583,6 +767,8 @@ stats_arena_print(emitter_t *emitter, unsigned i, bool bins, bool large,
 	    &dirty_npurge);
 	emitter_json_kv(emitter, "dirty_nmadvise", emitter_type_uint64,
 	    &dirty_nmadvise);
+	emitter_json_kv(emitter, "dirty_nmadvise_saved", emitter_type_uint64,
+	    &dirty_nmadvise_saved);
 	emitter_json_kv(emitter, "dirty_purged", emitter_type_uint64,
 	    &dirty_purged);
 
@@ -590,6 +776,8 @@ stats_arena_print(emitter_t *emitter, unsigned i, bool bins, bool large,
 	    &muzzy_npurge);
 	emitter_json_kv(emitter, "muzzy_nmadvise", emitter_type_uint64,
 	    &muzzy_nmadvise);
+	emitter_json_kv(emitter, "muzzy_nmadvise_saved", emitter_type_uint64,
+	    &muzzy_nmadvise_saved);
 	emitter_json_kv(emitter, "muzzy_purged", emitter_type_uint64,
 	    &muzzy_purged);
 
@@ -689,6 +877,58 @@ stats_arena_print(emitter_t *emitter, unsigned i, bool bins, bool large,
 
 	emitter_table_row(emitter, &decay_row);
 
+	if (dirty_decay_ms_effective != dirty_decay_ms) {
+		emitter_table_kv(emitter, "adaptive dirty decay time",
+		    emitter_type_ssize, &dirty_decay_ms_effective);
+	}
+
+	CTL_M2_GET("stats.arenas.0.extent_steals", i, &extent_steals, uint64_t);
+	emitter_kv(emitter, "extent_steals", "extents stolen from other arenas",
+	    emitter_type_uint64, &extent_steals);
+	CTL_M2_GET("stats.arenas.0.extent_stolen", i, &extent_stolen, uint64_t);
+	emitter_kv(emitter, "extent_stolen", "bytes stolen from other arenas",
+	    emitter_type_uint64, &extent_stolen);
+
+	CTL_M2_GET("stats.arenas.0.prefaulted", i, &prefaulted, uint64_t);
+	emitter_kv(emitter, "prefaulted", "bytes prefaulted",
+	    emitter_type_uint64, &prefaulted);
+	CTL_M2_GET("stats.arenas.0.mlocked", i, &mlocked, uint64_t);
+	emitter_kv(emitter, "mlocked", "bytes mlock()ed",
+	    emitter_type_uint64, &mlocked);
+
+	CTL_M2_GET("stats.arenas.0.retained_ntrims", i, &retained_ntrims,
+	    uint64_t);
+	emitter_kv(emitter, "retained_ntrims", "retained memory trims",
+	    emitter_type_uint64, &retained_ntrims);
+	CTL_M2_GET("stats.arenas.0.retained_trimmed", i, &retained_trimmed,
+	    uint64_t);
+	emitter_kv(emitter, "retained_trimmed", "retained bytes unmapped",
+	    emitter_type_uint64, &retained_trimmed);
+
+	CTL_M2_GET("stats.arenas.0.lazy_nselected", i, &lazy_nselected,
+	    uint64_t);
+	emitter_kv(emitter, "lazy_nselected", "lazy purges selected",
+	    emitter_type_uint64, &lazy_nselected);
+	CTL_M2_GET("stats.arenas.0.forced_nselected", i, &forced_nselected,
+	    uint64_t);
+	emitter_kv(emitter, "forced_nselected", "forced purges selected",
+	    emitter_type_uint64, &forced_nselected);
+	CTL_M2_GET("stats.arenas.0.lazy_purged", i, &lazy_purged, uint64_t);
+	emitter_kv(emitter, "lazy_purged", "bytes purged lazily",
+	    emitter_type_uint64, &lazy_purged);
+	CTL_M2_GET("stats.arenas.0.lazy_reclaimed", i, &lazy_reclaimed,
+	    uint64_t);
+	emitter_kv(emitter, "lazy_reclaimed",
+	    "lazily purged bytes seen reclaimed", emitter_type_uint64,
+	    &lazy_reclaimed);
+	CTL_M2_GET("stats.arenas.0.forced_purged", i, &forced_purged,
+	    uint64_t);
+	emitter_kv(emitter, "forced_purged", "bytes purged forcibly",
+	    emitter_type_uint64, &forced_purged);
+
+	stats_arena_reuse_ages_print(emitter, i);
+	stats_arena_latency_print(emitter, i);
+
 	/* Small / large / total allocation counts. */
 	emitter_row_t alloc_count_row;
 	emitter_row_init(&alloc_count_row);
@@ -804,6 +1044,7 @@ stats_arena_print(emitter_t *emitter, unsigned i, bool bins, bool large,
 
 	GET_AND_EMIT_MEM_STAT(mapped)
 	GET_AND_EMIT_MEM_STAT(retained)
+	GET_AND_EMIT_MEM_STAT(retained_peak)
 	GET_AND_EMIT_MEM_STAT(base)
 	GET_AND_EMIT_MEM_STAT(internal)
 	GET_AND_EMIT_MEM_STAT(metadata_thp)
@@ -891,6 +1132,9 @@ stats_general_print(emitter_t *emitter) {
 #define OPT_WRITE_UNSIGNED(name)					\
 	OPT_WRITE(name, uv, usz, emitter_type_unsigned)
 
+#define OPT_WRITE_SIZE_T(name)						\
+	OPT_WRITE(name, sv, ssz, emitter_type_size)
+
 #define OPT_WRITE_SSIZE_T(name)						\
 	OPT_WRITE(name, ssv, sssz, emitter_type_ssize)
 #define OPT_WRITE_SSIZE_T_MUTABLE(name, altname)			\
@@ -905,14 +1149,45 @@ stats_general_print(emitter_t *emitter) {
 	OPT_WRITE_BOOL("abort")
 	OPT_WRITE_BOOL("abort_conf")
 	OPT_WRITE_BOOL("retain")
+	OPT_WRITE_SIZE_T("reserve_va")
+	OPT_WRITE_SIZE_T("retain_trim_threshold")
+	OPT_WRITE_SIZE_T("retain_trim_ratio")
 	OPT_WRITE_CHAR_P("dss")
+	OPT_WRITE_SIZE_T("persistent_addr")
 	OPT_WRITE_UNSIGNED("narenas")
+	OPT_WRITE_UNSIGNED("freeze_narenas_max")
+	OPT_WRITE_BOOL("fork_skip_quiescent")
 	OPT_WRITE_CHAR_P("percpu_arena")
+	OPT_WRITE_BOOL("percpu_cache")
 	OPT_WRITE_CHAR_P("metadata_thp")
 	OPT_WRITE_BOOL_MUTABLE("background_thread", "background_thread")
+	OPT_WRITE_CHAR_P("background_thread_cpus")
+	OPT_WRITE_BOOL("background_thread_sched_idle")
+	OPT_WRITE_SSIZE_T("background_thread_nice")
+	OPT_WRITE_BOOL("psi_purge")
+	OPT_WRITE_CHAR_P("psi_path")
+	OPT_WRITE_SIZE_T("psi_stall_us")
+	OPT_WRITE_SIZE_T("psi_window_us")
 	OPT_WRITE_SSIZE_T_MUTABLE("dirty_decay_ms", "arenas.dirty_decay_ms")
 	OPT_WRITE_SSIZE_T_MUTABLE("muzzy_decay_ms", "arenas.muzzy_decay_ms")
+	OPT_WRITE_BOOL("dirty_decay_adaptive")
+	OPT_WRITE_SIZE_T("dirty_decay_refault_target")
+	OPT_WRITE_SIZE_T("empty_slab_cache_max")
+	OPT_WRITE_BOOL("extent_steal")
+	OPT_WRITE_SIZE_T("extent_steal_threshold")
+	OPT_WRITE_CHAR_P("purge_policy")
+	OPT_WRITE_SIZE_T("purge_max_dirty")
+	OPT_WRITE_SIZE_T("purge_dirty_ratio")
+	OPT_WRITE_SIZE_T("purge_floor")
+	OPT_WRITE_SIZE_T("purge_rate")
+	OPT_WRITE_SIZE_T("purge_call_max")
+	OPT_WRITE_SIZE_T("purge_inline_share")
+	OPT_WRITE_CHAR_P("purge_select")
+	OPT_WRITE_BOOL("cgroup_aware")
+	OPT_WRITE_CHAR_P("cgroup_root")
+	OPT_WRITE_SIZE_T("cgroup_unpurged_ratio")
 	OPT_WRITE_UNSIGNED("lg_extent_max_active_fit")
+	OPT_WRITE_CHAR_P("extent_reuse")
 	OPT_WRITE_CHAR_P("junk")
 	OPT_WRITE_BOOL("zero")
 	OPT_WRITE_BOOL("utrace")
@@ -941,6 +1216,7 @@ stats_general_print(emitter_t *emitter) {
 #undef OPT_WRITE_BOOL
 #undef OPT_WRITE_BOOL_MUTABLE
 #undef OPT_WRITE_UNSIGNED
+#undef OPT_WRITE_SIZE_T
 #undef OPT_WRITE_SSIZE_T
 #undef OPT_WRITE_SSIZE_T_MUTABLE
 #undef OPT_WRITE_CHAR_P
@@ -1069,9 +1345,14 @@ stats_print_helper(emitter_t *emitter, bool merged, bool destroyed,
 	 * the transition to the emitter code.
 	 */
 	size_t allocated, active, metadata, metadata_thp, resident, mapped,
-	    retained;
+	    retained, cgroup_limit, unpurged_ceiling;
+	size_t purge_budget_debt;
+	uint64_t purge_budget_nthrottled, purge_budget_max_duration;
+	bool percpu_cache;
 	size_t num_background_threads;
 	uint64_t background_thread_num_runs, background_thread_run_interval;
+	uint64_t background_thread_num_arena_runs;
+	uint64_t background_thread_pressure_events;
 
 	CTL_GET("stats.allocated", &allocated, size_t);
 	CTL_GET("stats.active", &active, size_t);
@@ -1080,18 +1361,32 @@ stats_print_helper(emitter_t *emitter, bool merged, bool destroyed,
 	CTL_GET("stats.resident", &resident, size_t);
 	CTL_GET("stats.mapped", &mapped, size_t);
 	CTL_GET("stats.retained", &retained, size_t);
+	CTL_GET("stats.cgroup_limit", &cgroup_limit, size_t);
+	CTL_GET("stats.unpurged_ceiling", &unpurged_ceiling, size_t);
+	CTL_GET("stats.purge_budget.debt", &purge_budget_debt, size_t);
+	CTL_GET("stats.purge_budget.nthrottled", &purge_budget_nthrottled,
+	    uint64_t);
+	CTL_GET("stats.purge_budget.max_duration", &purge_budget_max_duration,
+	    uint64_t);
+	CTL_GET("opt.percpu_cache", &percpu_cache, bool);
 
 	if (have_background_thread) {
 		CTL_GET("stats.background_thread.num_threads",
 		    &num_background_threads, size_t);
 		CTL_GET("stats.background_thread.num_runs",
 		    &background_thread_num_runs, uint64_t);
+		CTL_GET("stats.background_thread.num_arena_runs",
+		    &background_thread_num_arena_runs, uint64_t);
 		CTL_GET("stats.background_thread.run_interval",
 		    &background_thread_run_interval, uint64_t);
+		CTL_GET("stats.background_thread.pressure_events",
+		    &background_thread_pressure_events, uint64_t);
 	} else {
 		num_background_threads = 0;
 		background_thread_num_runs = 0;
+		background_thread_num_arena_runs = 0;
 		background_thread_run_interval = 0;
+		background_thread_pressure_events = 0;
 	}
 
 	/* Generic global stats. */
@@ -1104,11 +1399,38 @@ stats_print_helper(emitter_t *emitter, bool merged, bool destroyed,
 	emitter_json_kv(emitter, "resident", emitter_type_size, &resident);
 	emitter_json_kv(emitter, "mapped", emitter_type_size, &mapped);
 	emitter_json_kv(emitter, "retained", emitter_type_size, &retained);
+	emitter_json_kv(emitter, "cgroup_limit", emitter_type_size,
+	    &cgroup_limit);
+	emitter_json_kv(emitter, "unpurged_ceiling", emitter_type_size,
+	    &unpurged_ceiling);
 
 	emitter_table_printf(emitter, "Allocated: %zu, active: %zu, "
 	    "metadata: %zu (n_thp %zu), resident: %zu, mapped: %zu, "
 	    "retained: %zu\n", allocated, active, metadata, metadata_thp,
 	    resident, mapped, retained);
+	if (cgroup_limit != SIZE_T_MAX) {
+		emitter_table_printf(emitter, "Cgroup limit: %zu, "
+		    "unpurged ceiling: %zu\n", cgroup_limit, unpurged_ceiling);
+	}
+
+	/* Purge budget stats. */
+	emitter_json_dict_begin(emitter, "purge_budget");
+	emitter_json_kv(emitter, "debt", emitter_type_size,
+	    &purge_budget_debt);
+	emitter_json_kv(emitter, "nthrottled", emitter_type_uint64,
+	    &purge_budget_nthrottled);
+	emitter_json_kv(emitter, "max_duration", emitter_type_uint64,
+	    &purge_budget_max_duration);
+	emitter_json_dict_end(emitter); /* Close "purge_budget". */
+
+	emitter_table_printf(emitter, "Purge budget debt: %zu, throttled "
+	    "purges: %"FMTu64", longest purge: %"FMTu64" ns\n",
+	    purge_budget_debt, purge_budget_nthrottled,
+	    purge_budget_max_duration);
+
+	if (percpu_cache) {
+		stats_percpu_cache_print(emitter);
+	}
 
 	/* Background thread stats. */
 	emitter_json_dict_begin(emitter, "background_thread");
@@ -1116,14 +1438,20 @@ stats_print_helper(emitter_t *emitter, bool merged, bool destroyed,
 	    &num_background_threads);
 	emitter_json_kv(emitter, "num_runs", emitter_type_uint64,
 	    &background_thread_num_runs);
+	emitter_json_kv(emitter, "num_arena_runs", emitter_type_uint64,
+	    &background_thread_num_arena_runs);
 	emitter_json_kv(emitter, "run_interval", emitter_type_uint64,
 	    &background_thread_run_interval);
+	emitter_json_kv(emitter, "pressure_events", emitter_type_uint64,
+	    &background_thread_pressure_events);
 	emitter_json_dict_end(emitter); /* Close "background_thread". */
 
 	emitter_table_printf(emitter, "Background threads: %zu, "
-	    "num_runs: %"FMTu64", run_interval: %"FMTu64" ns\n",
+	    "num_runs: %"FMTu64", num_arena_runs: %"FMTu64", run_interval: "
+	    "%"FMTu64" ns, pressure_events: %"FMTu64"\n",
 	    num_background_threads, background_thread_num_runs,
-	    background_thread_run_interval);
+	    background_thread_num_arena_runs, background_thread_run_interval,
+	    background_thread_pressure_events);
 
 	if (mutex) {
 		emitter_row_t row;
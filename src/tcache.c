@@ -107,12 +107,21 @@ tcache_alloc_small_hard(tsdn_t *tsdn, arena_t *arena, tcache_t *tcache,
 void
 tcache_bin_flush_small(tsd_t *tsd, tcache_t *tcache, cache_bin_t *tbin,
     szind_t binind, unsigned rem) {
+	tcache_bin_flush_small_arena(tsd, tcache->arena, tbin, binind, rem,
+	    &tcache->prof_accumbytes);
+}
+
+/*
+ * Flushes all but rem objects of tbin; its stats and prof_accumbytes (if
+ * non-NULL) are merged into arena.
+ */
+void
+tcache_bin_flush_small_arena(tsd_t *tsd, arena_t *arena, cache_bin_t *tbin,
+    szind_t binind, unsigned rem, uint64_t *prof_accumbytes) {
 	bool merged_stats = false;
 
 	assert(binind < NBINS);
 	assert((cache_bin_sz_t)rem <= tbin->ncached);
-
-	arena_t *arena = tcache->arena;
 	assert(arena != NULL);
 	unsigned nflush = tbin->ncached - rem;
 	VARIABLE_ARRAY(extent_t *, item_extent, nflush);
@@ -127,12 +136,13 @@ tcache_bin_flush_small(tsd_t *tsd, tcache_t *tcache, cache_bin_t *tbin,
 		arena_t *bin_arena = extent_arena_get(extent);
 		bin_t *bin = &bin_arena->bins[binind];
 
-		if (config_prof && bin_arena == arena) {
+		if (config_prof && prof_accumbytes != NULL &&
+		    bin_arena == arena) {
 			if (arena_prof_accum(tsd_tsdn(tsd), arena,
-			    tcache->prof_accumbytes)) {
+			    *prof_accumbytes)) {
 				prof_idump(tsd_tsdn(tsd));
 			}
-			tcache->prof_accumbytes = 0;
+			*prof_accumbytes = 0;
 		}
 
 		malloc_mutex_lock(tsd_tsdn(tsd), &bin->lock);
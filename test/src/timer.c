@@ -3,13 +3,13 @@
 void
 timer_start(timedelta_t *timer) {
 	nstime_init(&timer->t0, 0);
-	nstime_update(&timer->t0);
+	nstime_update_precise(&timer->t0);
 }
 
 void
 timer_stop(timedelta_t *timer) {
 	nstime_copy(&timer->t1, &timer->t0);
-	nstime_update(&timer->t1);
+	nstime_update_precise(&timer->t1);
 }
 
 uint64_t
@@ -0,0 +1,127 @@
+#include "test/jemalloc_test.h"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#define NSLOTS		256
+#define NITER		(200 * 1000)
+#define MAX_NPAGES	64
+
+static uint64_t
+minflt_get(void) {
+#ifndef _WIN32
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0;
+	}
+	return (uint64_t)usage.ru_minflt;
+#else
+	return 0;
+#endif
+}
+
+static unsigned
+arena_create(const char *reuse) {
+	unsigned arena_ind;
+	size_t sz = sizeof(arena_ind);
+	assert_d_eq(mallctl("arenas.create", (void *)&arena_ind, &sz, NULL, 0),
+	    0, "Unexpected mallctl() failure");
+
+	size_t mib[3];
+	size_t miblen = sizeof(mib)/sizeof(size_t);
+	assert_d_eq(mallctlnametomib("arena.0.extent_reuse", mib, &miblen), 0,
+	    "Unexpected mallctlnametomib() failure");
+	mib[1] = (size_t)arena_ind;
+	assert_d_eq(mallctlbymib(mib, miblen, NULL, NULL, (void *)&reuse,
+	    sizeof(reuse)), 0, "Unexpected mallctlbymib() failure");
+
+	return arena_ind;
+}
+
+static size_t
+stats_arena_resident_get(unsigned arena_ind) {
+	uint64_t epoch = 1;
+	assert_d_eq(mallctl("epoch", NULL, NULL, (void *)&epoch,
+	    sizeof(epoch)), 0, "Unexpected mallctl() failure");
+
+	size_t resident;
+	size_t sz = sizeof(resident);
+	size_t mib[4];
+	size_t miblen = sizeof(mib)/sizeof(size_t);
+	if (mallctlnametomib("stats.arenas.0.resident", mib, &miblen) != 0) {
+		return 0;
+	}
+	mib[2] = (size_t)arena_ind;
+	if (mallctlbymib(mib, miblen, (void *)&resident, &sz, NULL, 0) != 0) {
+		return 0;
+	}
+	return resident;
+}
+
+/*
+ * Large allocation churn: repeatedly replace a random slot with an allocation
+ * of a random page count and touch every page of it.  Reusing recently freed
+ * (still resident) extents shows up as fewer minor page faults.
+ */
+static void
+churn(const char *reuse) {
+	unsigned arena_ind = arena_create(reuse);
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	void *slots[NSLOTS];
+	size_t sizes[NSLOTS];
+	sfmt_t *sfmt = init_gen_rand(0x27);
+	timedelta_t timer;
+
+	for (unsigned i = 0; i < NSLOTS; i++) {
+		slots[i] = NULL;
+	}
+
+	uint64_t minflt_start = minflt_get();
+	timer_start(&timer);
+	for (unsigned i = 0; i < NITER; i++) {
+		unsigned slot = (unsigned)gen_rand64_range(sfmt, NSLOTS);
+		if (slots[slot] != NULL) {
+			dallocx(slots[slot], flags);
+		}
+		sizes[slot] = (size_t)(gen_rand64_range(sfmt, MAX_NPAGES) + 4)
+		    * PAGE;
+		slots[slot] = mallocx(sizes[slot], flags);
+		assert_ptr_not_null(slots[slot],
+		    "Unexpected mallocx() failure");
+		for (size_t off = 0; off < sizes[slot]; off += PAGE) {
+			((char *)slots[slot])[off] = (char)i;
+		}
+	}
+	timer_stop(&timer);
+	uint64_t minflt = minflt_get() - minflt_start;
+	size_t resident = stats_arena_resident_get(arena_ind);
+
+	malloc_printf("extent_reuse:%s %u iterations, %"FMTu64"us, "
+	    "%"FMTu64" minor faults, %zu resident bytes\n", reuse, NITER,
+	    timer_usec(&timer), minflt, resident);
+
+	for (unsigned i = 0; i < NSLOTS; i++) {
+		if (slots[i] != NULL) {
+			dallocx(slots[i], flags);
+		}
+	}
+	fini_gen_rand(sfmt);
+}
+
+TEST_BEGIN(test_extent_reuse_fit) {
+	churn("fit");
+}
+TEST_END
+
+TEST_BEGIN(test_extent_reuse_lifo) {
+	churn("lifo");
+}
+TEST_END
+
+int
+main(void) {
+	return test_no_reentrancy(
+	    test_extent_reuse_fit,
+	    test_extent_reuse_lifo);
+}
@@ -0,0 +1,101 @@
+#include "test/jemalloc_test.h"
+
+#include <sys/wait.h>
+
+#define NFORKS		101
+#define LARGE_SZ	(ZU(64) << 10)
+
+static const int flags_base = MALLOCX_TCACHE_NONE;
+
+static unsigned fork_arenas[256];
+static unsigned nfork_arenas = 0;
+
+static void
+arena_use(unsigned arena_ind) {
+	int flags = flags_base | MALLOCX_ARENA(arena_ind);
+	void *p = mallocx(LARGE_SZ, flags);
+	assert_ptr_not_null(p, "Unexpected mallocx() failure");
+	dallocx(p, flags);
+}
+
+/* Returns the time fork() took to return in the parent, in nanoseconds. */
+static uint64_t
+fork_time(void) {
+	nstime_t start, end;
+	nstime_init(&start, 0);
+	nstime_update_precise(&start);
+	pid_t pid = fork();
+	nstime_copy(&end, &start);
+	nstime_update_precise(&end);
+	assert_d_ne(pid, -1, "Unexpected fork() failure");
+	if (pid == 0) {
+		_exit(0);
+	}
+	int status;
+	assert_d_eq(waitpid(pid, &status, 0), pid,
+	    "Unexpected waitpid() failure");
+	assert_true(WIFEXITED(status) && WEXITSTATUS(status) == 0,
+	    "Unexpected child failure");
+	nstime_subtract(&end, &start);
+	return nstime_ns(&end);
+}
+
+static int
+nsec_cmp(const void *a, const void *b) {
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+	return (x > y) - (x < y);
+}
+
+/*
+ * Forks repeatedly with the current set of arenas, either leaving them idle in
+ * between or using every one of them before each fork, and reports the median,
+ * which unlike the mean is not skewed by the occasional descheduled fork.
+ */
+static void
+fork_run(bool use) {
+	uint64_t nsecs[NFORKS];
+	/* Leaves the arenas unused since the last fork, when idle. */
+	fork_time();
+	for (unsigned i = 0; i < NFORKS; i++) {
+		if (use) {
+			for (unsigned j = 0; j < nfork_arenas; j++) {
+				arena_use(fork_arenas[j]);
+			}
+		}
+		nsecs[i] = fork_time();
+	}
+	qsort(nsecs, NFORKS, sizeof(nsecs[0]), nsec_cmp);
+	malloc_printf("%u arenas, %s: %"FMTu64"us median fork (%"FMTu64
+	    "-%"FMTu64"us)\n", nfork_arenas, use ? "used" : "idle",
+	    nsecs[NFORKS / 2] / 1000, nsecs[0] / 1000,
+	    nsecs[NFORKS - 1] / 1000);
+}
+
+TEST_BEGIN(test_fork_latency) {
+	bool skip;
+	size_t sz = sizeof(skip);
+	assert_d_eq(mallctl("opt.fork_skip_quiescent", (void *)&skip, &sz,
+	    NULL, 0), 0, "Unexpected mallctl() failure");
+	malloc_printf("fork_skip_quiescent: %s\n", skip ? "true" : "false");
+
+	unsigned counts[] = {0, 16, 64, 256};
+	for (unsigned i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+		while (nfork_arenas < counts[i]) {
+			unsigned *arena_ind = &fork_arenas[nfork_arenas++];
+			sz = sizeof(*arena_ind);
+			assert_d_eq(mallctl("arenas.create", (void *)arena_ind,
+			    &sz, NULL, 0), 0, "Unexpected mallctl() failure");
+			arena_use(*arena_ind);
+		}
+		fork_run(false);
+		fork_run(true);
+	}
+}
+TEST_END
+
+int
+main(void) {
+	return test_no_reentrancy(
+	    test_fork_latency);
+}
@@ -154,6 +154,60 @@ TEST_BEGIN(test_sallocx_vs_nallocx) {
 }
 TEST_END
 
+static volatile unsigned arena_ind_sink;
+static volatile arena_t *arena_sink;
+/* Makes the current thread take the sched_getcpu() path. */
+static rseq_area_t rseq_area_failed = {0, RSEQ_CPU_ID_REGISTRATION_FAILED};
+
+static void
+choose_percpu_arena(void) {
+	arena_ind_sink = percpu_arena_choose(tsd_fetch());
+}
+
+static void
+choose_arena(void) {
+	arena_sink = arena_choose(tsd_fetch(), NULL);
+}
+
+static void
+compare_rseq(uint64_t nwarmup, uint64_t niter, const char *name_sched,
+    const char *name_rseq, void (*func)(void)) {
+	tsd_t *tsd = tsd_fetch();
+	rseq_area_t *area = rseq_area_get(tsd);
+	timedelta_t timer_sched, timer_rseq;
+	char ratio_buf[6];
+
+	tsd_rseq_area_set(tsd, &rseq_area_failed);
+	time_func(&timer_sched, nwarmup, niter, func);
+	tsd_rseq_area_set(tsd, area);
+	time_func(&timer_rseq, nwarmup, niter, func);
+
+	timer_ratio(&timer_sched, &timer_rseq, ratio_buf, sizeof(ratio_buf));
+	malloc_printf("%"FMTu64" iterations, %s=%"FMTu64"us, "
+	    "%s=%"FMTu64"us, ratio=1:%s\n",
+	    niter, name_sched, timer_usec(&timer_sched), name_rseq,
+	    timer_usec(&timer_rseq), ratio_buf);
+}
+
+TEST_BEGIN(test_percpu_arena_sched_vs_rseq) {
+	test_skip_if(!have_percpu_arena ||
+	    !PERCPU_ARENA_ENABLED(opt_percpu_arena));
+	/* Boot the internal allocator, whose tsd and arenas are used. */
+	jet_free(jet_malloc(1));
+	test_skip_if(!malloc_getcpu_cheap(tsd_fetch()));
+
+	compare_rseq(10*1000*1000, 100*1000*1000,
+	    "percpu_arena_choose_sched", "percpu_arena_choose_rseq",
+	    choose_percpu_arena);
+	/*
+	 * Without rseq, arena_choose() only reads the cpu once another thread
+	 * used the arena, so this is the cost of checking on every call.
+	 */
+	compare_rseq(10*1000*1000, 100*1000*1000, "arena_choose_sched",
+	    "arena_choose_rseq", choose_arena);
+}
+TEST_END
+
 int
 main(void) {
 	return test_no_reentrancy(
@@ -161,5 +215,6 @@ main(void) {
 	    test_free_vs_dallocx,
 	    test_dallocx_vs_sdallocx,
 	    test_mus_vs_sallocx,
-	    test_sallocx_vs_nallocx);
+	    test_sallocx_vs_nallocx,
+	    test_percpu_arena_sched_vs_rseq);
 }
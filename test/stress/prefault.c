@@ -0,0 +1,78 @@
+#include "test/jemalloc_test.h"
+
+#include <sys/resource.h>
+
+#define NALLOCS	256
+#define SZ	(ZU(256) << 10)
+
+static void
+faults_get(uint64_t *minflt, uint64_t *majflt) {
+	struct rusage usage;
+	assert_d_eq(getrusage(RUSAGE_SELF, &usage), 0,
+	    "Unexpected getrusage() failure");
+	*minflt = (uint64_t)usage.ru_minflt;
+	*majflt = (uint64_t)usage.ru_majflt;
+}
+
+/*
+ * Allocate NALLOCS fresh extents from a new arena in the given mode, and count
+ * the page faults taken when the memory is first written to, which is where a
+ * latency-critical caller would feel them.
+ */
+static void
+prefault_run(const char *mode, bool prefault, bool mlock) {
+	unsigned arena_ind;
+	size_t sz = sizeof(arena_ind);
+	arena_config_t config = {NULL, prefault, mlock, false, -1};
+	assert_d_eq(mallctl("arenas.create", (void *)&arena_ind, &sz,
+	    (void *)&config, sizeof(config)), 0,
+	    "Unexpected mallctl() failure");
+
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	void *ptrs[NALLOCS];
+	timedelta_t alloc_timer, touch_timer;
+	uint64_t minflt0, majflt0, minflt1, majflt1, minflt2, majflt2;
+
+	faults_get(&minflt0, &majflt0);
+	timer_start(&alloc_timer);
+	for (unsigned i = 0; i < NALLOCS; i++) {
+		ptrs[i] = mallocx(SZ, flags);
+		assert_ptr_not_null(ptrs[i], "Unexpected mallocx() failure");
+	}
+	timer_stop(&alloc_timer);
+	faults_get(&minflt1, &majflt1);
+	timer_start(&touch_timer);
+	for (unsigned i = 0; i < NALLOCS; i++) {
+		memset(ptrs[i], (int)i, SZ);
+	}
+	timer_stop(&touch_timer);
+	faults_get(&minflt2, &majflt2);
+
+	malloc_printf("%s: alloc %"FMTu64"us (%"FMTu64" minor, %"FMTu64
+	    " major faults), first touch %"FMTu64"us (%"FMTu64" minor, %"FMTu64
+	    " major faults)\n", mode, timer_usec(&alloc_timer),
+	    minflt1 - minflt0, majflt1 - majflt0, timer_usec(&touch_timer),
+	    minflt2 - minflt1, majflt2 - majflt1);
+
+	for (unsigned i = 0; i < NALLOCS; i++) {
+		dallocx(ptrs[i], flags);
+	}
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.destroy", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+}
+
+TEST_BEGIN(test_prefault) {
+	prefault_run("default", false, false);
+	prefault_run("prefault", true, false);
+	prefault_run("mlock", false, true);
+	prefault_run("prefault+mlock", true, true);
+}
+TEST_END
+
+int
+main(void) {
+	return test_no_reentrancy(
+	    test_prefault);
+}
@@ -0,0 +1,139 @@
+#include "test/jemalloc_test.h"
+
+/*
+ * Compares pointer lookups in the region reserved via opt.reserve_va, which go
+ * through the flat leaf, with lookups of pointers in an extent_fd arena, which
+ * lies outside the region and goes through the rtree.  The large allocations
+ * are never touched, and are spread over more rtree leaves than the rtree_ctx
+ * cache holds.
+ */
+#define NPTRS	64
+#define SPREAD	(ZU(1) << (LG_SIZEOF_PTR == 3 ? 29 : 20))
+
+static unsigned region_arena, fd_arena;
+static void *region_ptrs[NPTRS], *fd_ptrs[NPTRS];
+static volatile size_t sink;
+
+static void
+ptrs_alloc(unsigned arena_ind, void **ptrs) {
+	/* Fresh memory is known to be zeroed, so it is left untouched. */
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE |
+	    MALLOCX_ZERO;
+	for (unsigned i = 0; i < NPTRS; i++) {
+		ptrs[i] = mallocx(SPREAD, flags);
+		assert_ptr_not_null(ptrs[i], "Unexpected mallocx() failure");
+	}
+}
+
+static void
+ptrs_dalloc(unsigned arena_ind, void **ptrs) {
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	for (unsigned i = 0; i < NPTRS; i++) {
+		dallocx(ptrs[i], flags);
+	}
+}
+
+static void
+lookup(void **ptrs) {
+	size_t usize = 0;
+	for (unsigned i = 0; i < NPTRS; i++) {
+		usize += sallocx(ptrs[i], 0);
+	}
+	sink = usize;
+}
+
+static void
+lookup_region(void) {
+	lookup(region_ptrs);
+}
+
+static void
+lookup_fd(void) {
+	lookup(fd_ptrs);
+}
+
+static void
+malloc_free(unsigned arena_ind) {
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	void *p = mallocx(1, flags);
+	if (p == NULL) {
+		test_fail("Unexpected mallocx() failure");
+		return;
+	}
+	dallocx(p, flags);
+}
+
+static void
+malloc_free_region(void) {
+	malloc_free(region_arena);
+}
+
+static void
+malloc_free_fd(void) {
+	malloc_free(fd_arena);
+}
+
+static void
+time_func(timedelta_t *timer, uint64_t nwarmup, uint64_t niter,
+    void (*func)(void)) {
+	for (uint64_t i = 0; i < nwarmup; i++) {
+		func();
+	}
+	timer_start(timer);
+	for (uint64_t i = 0; i < niter; i++) {
+		func();
+	}
+	timer_stop(timer);
+}
+
+static void
+compare_funcs(uint64_t nwarmup, uint64_t niter, const char *name_a,
+    void (*func_a)(void), const char *name_b, void (*func_b)(void)) {
+	timedelta_t timer_a, timer_b;
+	char ratio_buf[6];
+
+	time_func(&timer_a, nwarmup, niter, func_a);
+	time_func(&timer_b, nwarmup, niter, func_b);
+
+	timer_ratio(&timer_a, &timer_b, ratio_buf, sizeof(ratio_buf));
+	malloc_printf("%"FMTu64" iterations, %s=%"FMTu64"us, "
+	    "%s=%"FMTu64"us, ratio=1:%s\n",
+	    niter, name_a, timer_usec(&timer_a), name_b, timer_usec(&timer_b),
+	    ratio_buf);
+}
+
+TEST_BEGIN(test_reserve_va_lookup) {
+	size_t reserve_va;
+	size_t sz = sizeof(reserve_va);
+	assert_d_eq(mallctl("opt.reserve_va", (void *)&reserve_va, &sz, NULL,
+	    0), 0, "Unexpected mallctl() failure");
+	test_skip_if(reserve_va < NPTRS * (SPREAD + LARGE_MINCLASS));
+
+	sz = sizeof(unsigned);
+	assert_d_eq(mallctl("arenas.create", (void *)&region_arena, &sz, NULL,
+	    0), 0, "Unexpected mallctl() failure");
+	arena_config_t config = {NULL, false, false, true, -1};
+	int err = mallctl("arenas.create", (void *)&fd_arena, &sz,
+	    (void *)&config, sizeof(config));
+	/* extent_fd is not supported on this system. */
+	test_skip_if(err == EAGAIN);
+	assert_d_eq(err, 0, "Unexpected mallctl() failure");
+
+	ptrs_alloc(region_arena, region_ptrs);
+	ptrs_alloc(fd_arena, fd_ptrs);
+
+	compare_funcs(10 * 1000, 100 * 1000, "sallocx_region", lookup_region,
+	    "sallocx_fd", lookup_fd);
+	compare_funcs(10 * 1000, 10 * 1000 * 1000, "malloc_free_region",
+	    malloc_free_region, "malloc_free_fd", malloc_free_fd);
+
+	ptrs_dalloc(region_arena, region_ptrs);
+	ptrs_dalloc(fd_arena, fd_ptrs);
+}
+TEST_END
+
+int
+main(void) {
+	return test_no_reentrancy(
+	    test_reserve_va_lookup);
+}
@@ -0,0 +1,3 @@
+#!/bin/sh
+
+export MALLOC_CONF="reserve_va:68719476736,retain:false"
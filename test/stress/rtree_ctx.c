@@ -0,0 +1,173 @@
+#include "test/jemalloc_test.h"
+
+#include "jemalloc/internal/rtree_tsd.h"
+
+/*
+ * Frees objects from arenas that each live in their own rtree leaf, with more
+ * arenas than the rtree_ctx cache has leaves, in an order that alternates
+ * between the arenas and in one that frees each arena's objects together.
+ * Build with different ANDROID_RTREE_CTX_* settings to compare cache layouts,
+ * and with ANDROID_RTREE_CTX_STATS to also report the cache's hit rate.
+ */
+#define NARENAS	32
+#define NOBJS	4096
+#define NROUNDS	16
+#define SZ	64
+/*
+ * Each arena's extents come from a window covered by one rtree leaf, sized as
+ * in rtree.h.
+ */
+#define NSB	(LG_VADDR - LG_PAGE)
+#if NSB <= 36
+#  define LG_WINDOW	(LG_PAGE + NSB/2 + NSB%2)
+#else
+#  define LG_WINDOW	(LG_PAGE + NSB/3 + NSB%3 - NSB%3/2)
+#endif
+
+typedef struct window_s window_t;
+struct window_s {
+	extent_hooks_t	hooks;
+	uintptr_t	base;
+	uintptr_t	used;
+};
+
+static window_t windows[NARENAS];
+static unsigned arena_inds[NARENAS];
+static void *ptrs[NARENAS * NOBJS];
+
+static void *
+window_alloc(extent_hooks_t *extent_hooks, void *new_addr, size_t size,
+    size_t alignment, bool *zero, bool *commit, unsigned arena_ind) {
+	window_t *window = (window_t *)extent_hooks;
+	if (new_addr != NULL) {
+		return NULL;
+	}
+	uintptr_t addr = ALIGNMENT_CEILING(window->base + window->used,
+	    alignment);
+	if (addr + size > window->base + (ZU(1) << LG_WINDOW)) {
+		return NULL;
+	}
+	window->used = addr + size - window->base;
+	/* Extents are never returned, so fresh memory is always zeroed. */
+	*zero = true;
+	*commit = true;
+	return (void *)addr;
+}
+
+static bool
+window_dalloc(extent_hooks_t *extent_hooks, void *addr, size_t size,
+    bool committed, unsigned arena_ind) {
+	return true;
+}
+
+static bool
+window_split(extent_hooks_t *extent_hooks, void *addr, size_t size,
+    size_t size_a, size_t size_b, bool committed, unsigned arena_ind) {
+	return false;
+}
+
+static bool
+window_merge(extent_hooks_t *extent_hooks, void *addr_a, size_t size_a,
+    void *addr_b, size_t size_b, bool committed, unsigned arena_ind) {
+	return false;
+}
+
+static void
+windows_init(void) {
+	/* Reserve an extra window, to align them to the window size. */
+	size_t size = ZU(1) << LG_WINDOW;
+	void *map = mmap(NULL, (NARENAS + 1) * size, PROT_READ | PROT_WRITE,
+	    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	assert_ptr_ne(map, MAP_FAILED, "Unexpected mmap() failure");
+	uintptr_t base = ALIGNMENT_CEILING((uintptr_t)map, size);
+	for (unsigned i = 0; i < NARENAS; i++) {
+		window_t *window = &windows[i];
+		memset(&window->hooks, 0, sizeof(window->hooks));
+		window->hooks.alloc = window_alloc;
+		window->hooks.dalloc = window_dalloc;
+		window->hooks.split = window_split;
+		window->hooks.merge = window_merge;
+		window->base = base + i * size;
+		window->used = 0;
+
+		extent_hooks_t *hooks = &window->hooks;
+		size_t sz = sizeof(arena_inds[i]);
+		assert_d_eq(mallctl("arenas.create", (void *)&arena_inds[i],
+		    &sz, (void *)&hooks, sizeof(hooks)), 0,
+		    "Unexpected mallctl() failure");
+	}
+}
+
+static void
+rtree_cache_stats(uint64_t *hits, uint64_t *misses, uint64_t *hard) {
+	size_t sz = sizeof(uint64_t);
+	if (mallctl("thread.rtree_cache.hits", (void *)hits, &sz, NULL, 0) !=
+	    0) {
+		*hits = *misses = *hard = 0;
+		return;
+	}
+	assert_d_eq(mallctl("thread.rtree_cache.misses", (void *)misses, &sz,
+	    NULL, 0), 0, "Unexpected mallctl() failure");
+	assert_d_eq(mallctl("thread.rtree_cache.hard_lookups", (void *)hard,
+	    &sz, NULL, 0), 0, "Unexpected mallctl() failure");
+}
+
+/*
+ * Allocates NOBJS objects from each arena into ptrs, which is ordered by arena
+ * if grouped, and round robin across arenas otherwise.
+ */
+static void
+objs_alloc(bool grouped) {
+	for (unsigned i = 0; i < NARENAS; i++) {
+		int flags = MALLOCX_ARENA(arena_inds[i]) | MALLOCX_TCACHE_NONE;
+		for (unsigned j = 0; j < NOBJS; j++) {
+			void *p = mallocx(SZ, flags);
+			assert_ptr_not_null(p, "Unexpected mallocx() failure");
+			ptrs[grouped ? i * NOBJS + j : j * NARENAS + i] = p;
+		}
+	}
+}
+
+static void
+free_run(const char *name, bool grouped) {
+	timedelta_t timer;
+	uint64_t usec = 0;
+	uint64_t hits0, misses0, hard0, hits1, misses1, hard1;
+
+	rtree_cache_stats(&hits0, &misses0, &hard0);
+	for (unsigned i = 0; i < NROUNDS; i++) {
+		objs_alloc(grouped);
+		timer_start(&timer);
+		for (unsigned j = 0; j < NARENAS * NOBJS; j++) {
+			free(ptrs[j]);
+		}
+		timer_stop(&timer);
+		usec += timer_usec(&timer);
+	}
+	rtree_cache_stats(&hits1, &misses1, &hard1);
+
+	malloc_printf("%s: %u frees, %"FMTu64"us", name,
+	    NROUNDS * NARENAS * NOBJS, usec);
+	if (hits1 + misses1 != hits0 + misses0) {
+		/* Includes the lookups done by allocation. */
+		malloc_printf(", rtree_cache hits=%"FMTu64" misses=%"FMTu64
+		    " hard_lookups=%"FMTu64, hits1 - hits0, misses1 - misses0,
+		    hard1 - hard0);
+	}
+	malloc_printf("\n");
+}
+
+TEST_BEGIN(test_rtree_ctx_free) {
+	windows_init();
+	malloc_printf("rtree_ctx: %u sets x %u ways, %u L2 entries\n",
+	    RTREE_CTX_NCACHE, RTREE_CTX_NWAYS, RTREE_CTX_NCACHE_L2);
+	free_run("grouped", true);
+	free_run("mixed", false);
+}
+TEST_END
+
+int
+main(void) {
+	return test_no_reentrancy(
+	    test_rtree_ctx_free);
+}
@@ -0,0 +1,77 @@
+#include "test/jemalloc_test.h"
+
+#include <sys/wait.h>
+
+#define NSAMPLES	64
+#define NALLOCS		10000
+
+/*
+ * Unlike the public allocator, the internal one (jet_*) is not initialized by
+ * a library constructor, and nothing in this test touches it.  Each sample
+ * runs in a freshly forked child, which therefore bootstraps it from scratch,
+ * as a new process would on its first malloc().
+ */
+static uint64_t
+nsec_since(const nstime_t *start) {
+	nstime_t now;
+	nstime_copy(&now, start);
+	nstime_update_precise(&now);
+	nstime_subtract(&now, start);
+	return nstime_ns(&now);
+}
+
+static void
+startup_child(int fd) {
+	uint64_t nsecs[2];
+	nstime_t start;
+	nstime_init(&start, 0);
+	nstime_update_precise(&start);
+
+	/* Mixed small sizes, as startup code tends to allocate. */
+	for (unsigned i = 0; i < NALLOCS; i++) {
+		if (jet_malloc(8 + (i % 32) * 8) == NULL) {
+			_exit(1);
+		}
+		if (i == 0) {
+			nsecs[0] = nsec_since(&start);
+		}
+	}
+	nsecs[1] = nsec_since(&start);
+	_exit(write(fd, nsecs, sizeof(nsecs)) == sizeof(nsecs) ? 0 : 1);
+}
+
+TEST_BEGIN(test_startup_latency) {
+	uint64_t first = 0, last = 0;
+	for (unsigned i = 0; i < NSAMPLES; i++) {
+		int fds[2];
+		assert_d_eq(pipe(fds), 0, "Unexpected pipe() failure");
+		pid_t pid = fork();
+		assert_d_ne(pid, -1, "Unexpected fork() failure");
+		if (pid == 0) {
+			close(fds[0]);
+			startup_child(fds[1]);
+		}
+		close(fds[1]);
+		uint64_t nsecs[2];
+		assert_zd_eq(read(fds[0], nsecs, sizeof(nsecs)),
+		    (ssize_t)sizeof(nsecs), "Unexpected read() failure");
+		close(fds[0]);
+		int status;
+		assert_d_eq(waitpid(pid, &status, 0), pid,
+		    "Unexpected waitpid() failure");
+		assert_true(WIFEXITED(status) && WEXITSTATUS(status) == 0,
+		    "Unexpected child failure");
+		first += nsecs[0];
+		last += nsecs[1];
+	}
+	malloc_printf("time to 1st malloc: %"FMTu64"us, to %uth malloc: "
+	    "%"FMTu64"us\n", first / NSAMPLES / 1000, NALLOCS,
+	    last / NSAMPLES / 1000);
+}
+TEST_END
+
+int
+main(void) {
+	return test_no_malloc_init(
+	    test_startup_latency);
+}
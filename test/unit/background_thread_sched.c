@@ -0,0 +1,245 @@
+#include "test/jemalloc_test.h"
+
+#ifdef __linux__
+#include <dirent.h>
+#endif
+
+const char *malloc_conf = "max_background_threads:1,"
+    "background_thread_sched_idle:true";
+
+#define NIDLE		64
+#define ALLOC_SIZE	(ZU(64) << 10)
+#define NTICKS		2048
+
+static uint64_t
+stat_get_u64(const char *name) {
+	uint64_t epoch = 1;
+	assert_d_eq(mallctl("epoch", NULL, NULL, (void *)&epoch,
+	    sizeof(epoch)), 0, "Unexpected mallctl() failure");
+
+	uint64_t val;
+	size_t sz = sizeof(val);
+	assert_d_eq(mallctl(name, (void *)&val, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return val;
+}
+
+static void
+background_thread_set(bool enable) {
+	assert_d_eq(mallctl("background_thread", NULL, NULL, (void *)&enable,
+	    sizeof(enable)), 0, "Unexpected mallctl() failure");
+}
+
+static unsigned
+arena_create(ssize_t decay_ms) {
+	unsigned arena_ind;
+	size_t sz = sizeof(arena_ind);
+	assert_d_eq(mallctl("arenas.create", (void *)&arena_ind, &sz, NULL, 0),
+	    0, "Unexpected mallctl() failure");
+	char cmd[64];
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.dirty_decay_ms", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&decay_ms,
+	    sizeof(decay_ms)), 0, "Unexpected mallctl() failure");
+	return arena_ind;
+}
+
+/*
+ * Free large allocations, so that the arena always has pages to decay.  Enough
+ * of them to tick decay a few times between two (slow) stats refreshes.
+ */
+static void
+dirty_pages_add(unsigned arena_ind) {
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	for (unsigned i = 0; i < NTICKS; i++) {
+		void *p = mallocx(ALLOC_SIZE, flags);
+		assert_ptr_not_null(p, "Unexpected mallocx() failure");
+		dallocx(p, flags);
+	}
+}
+
+TEST_BEGIN(test_background_thread_deadlines) {
+	test_skip_if(!have_background_thread);
+	test_skip_if(!config_stats);
+
+	for (unsigned i = 0; i < NIDLE; i++) {
+		arena_create(1000);
+	}
+	unsigned arena_ind = arena_create(1000);
+	dirty_pages_add(arena_ind);
+
+	background_thread_set(true);
+	/* Let the first run visit every arena once. */
+	nstime_t deadline, now;
+	nstime_init(&deadline, 0);
+	nstime_update(&deadline);
+	nstime_iadd(&deadline, 10 * UINT64_C(1000000000));
+	do {
+		dirty_pages_add(arena_ind);
+		nstime_init(&now, 0);
+		nstime_update(&now);
+	} while (stat_get_u64("stats.background_thread.num_runs") < 2 &&
+	    nstime_compare(&now, &deadline) < 0);
+
+	uint64_t nruns0 = stat_get_u64("stats.background_thread.num_runs");
+	uint64_t narena_runs0 = stat_get_u64(
+	    "stats.background_thread.num_arena_runs");
+	uint64_t nruns, narena_runs;
+	nstime_init(&deadline, 0);
+	nstime_update(&deadline);
+	nstime_iadd(&deadline, 10 * UINT64_C(1000000000));
+	do {
+		dirty_pages_add(arena_ind);
+		nstime_init(&now, 0);
+		nstime_update(&now);
+		nruns = stat_get_u64("stats.background_thread.num_runs");
+	} while (nruns < nruns0 + 4 && nstime_compare(&now, &deadline) < 0);
+	narena_runs = stat_get_u64("stats.background_thread.num_arena_runs");
+	background_thread_set(false);
+
+	assert_u64_ge(nruns, nruns0 + 4,
+	    "The background thread should keep running while pages decay");
+	/*
+	 * Besides the decaying arena, only arenas with some leftover unused
+	 * pages (e.g. arena 0) may be visited; the idle ones must not be.
+	 */
+	assert_u64_lt(narena_runs - narena_runs0, (nruns - nruns0) * 8,
+	    "Idle arenas should not be visited on every wakeup");
+}
+TEST_END
+
+static size_t
+arena_pdirty_get(unsigned arena_ind) {
+	uint64_t epoch = 1;
+	assert_d_eq(mallctl("epoch", NULL, NULL, (void *)&epoch,
+	    sizeof(epoch)), 0, "Unexpected mallctl() failure");
+
+	char cmd[64];
+	malloc_snprintf(cmd, sizeof(cmd), "stats.arenas.%u.pdirty", arena_ind);
+	size_t pdirty;
+	size_t sz = sizeof(pdirty);
+	assert_d_eq(mallctl(cmd, (void *)&pdirty, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return pdirty;
+}
+
+TEST_BEGIN(test_background_thread_arena_reuse) {
+	test_skip_if(!have_background_thread);
+	test_skip_if(!config_stats);
+
+	background_thread_set(true);
+	unsigned arena_ind = arena_create(100);
+	char cmd[64];
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.destroy", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	/* The destroyed index is handed out again. */
+	assert_u_eq(arena_create(100), arena_ind,
+	    "Expected the destroyed arena index to be reused");
+
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	void *p = mallocx(ALLOC_SIZE, flags);
+	assert_ptr_not_null(p, "Unexpected mallocx() failure");
+	dallocx(p, flags);
+	assert_zu_gt(arena_pdirty_get(arena_ind), 0,
+	    "Expected dirty pages in the arena");
+
+	size_t pdirty;
+	nstime_t deadline, now;
+	nstime_init(&deadline, 0);
+	nstime_update(&deadline);
+	nstime_iadd(&deadline, 10 * UINT64_C(1000000000));
+	do {
+		usleep(10000);
+		pdirty = arena_pdirty_get(arena_ind);
+		nstime_init(&now, 0);
+		nstime_update(&now);
+	} while (pdirty != 0 && nstime_compare(&now, &deadline) < 0);
+	background_thread_set(false);
+
+	assert_zu_eq(pdirty, 0,
+	    "The background thread should purge an arena at a reused index");
+}
+TEST_END
+
+#ifdef __linux__
+/* Return the scheduling policy of the first background thread found. */
+static int
+background_thread_policy(void) {
+	DIR *dir = opendir("/proc/self/task");
+	if (dir == NULL) {
+		return -1;
+	}
+	int policy = -1;
+	struct dirent *ent;
+	while (policy == -1 && (ent = readdir(dir)) != NULL) {
+		if (ent->d_name[0] == '.') {
+			continue;
+		}
+		char path[128], buf[1024];
+		malloc_snprintf(path, sizeof(path), "/proc/self/task/%s/comm",
+		    ent->d_name);
+		int fd = open(path, O_RDONLY);
+		if (fd == -1) {
+			continue;
+		}
+		ssize_t n = read(fd, buf, sizeof(buf) - 1);
+		close(fd);
+		if (n <= 0 || strncmp(buf, "jemalloc_bg_thd",
+		    strlen("jemalloc_bg_thd")) != 0) {
+			continue;
+		}
+		malloc_snprintf(path, sizeof(path), "/proc/self/task/%s/stat",
+		    ent->d_name);
+		fd = open(path, O_RDONLY);
+		if (fd == -1) {
+			continue;
+		}
+		n = read(fd, buf, sizeof(buf) - 1);
+		close(fd);
+		if (n <= 0) {
+			continue;
+		}
+		buf[n] = '\0';
+		/* The policy is the 41st field; fields after comm start at 3. */
+		char *p = strrchr(buf, ')');
+		for (unsigned field = 2; p != NULL && field < 41; field++) {
+			p = strchr(p + 1, ' ');
+		}
+		if (p != NULL) {
+			policy = atoi(p + 1);
+		}
+	}
+	closedir(dir);
+	return policy;
+}
+#endif
+
+TEST_BEGIN(test_background_thread_sched_idle) {
+	test_skip_if(!have_background_thread);
+#if !defined(__linux__) || !defined(SCHED_IDLE) || \
+    !defined(JEMALLOC_HAVE_PTHREAD_SETNAME_NP)
+	test_skip("SCHED_IDLE or /proc unavailable");
+#else
+	background_thread_set(true);
+	int policy = -1;
+	/* The thread names and schedules itself once it is running. */
+	for (unsigned i = 0; i < 1000 && policy != SCHED_IDLE; i++) {
+		policy = background_thread_policy();
+		if (policy != SCHED_IDLE) {
+			usleep(1000);
+		}
+	}
+	background_thread_set(false);
+	assert_d_eq(policy, SCHED_IDLE,
+	    "Background thread should run under SCHED_IDLE");
+#endif
+}
+TEST_END
+
+int
+main(void) {
+	return test_no_reentrancy(
+	    test_background_thread_deadlines,
+	    test_background_thread_arena_reuse,
+	    test_background_thread_sched_idle);
+}
@@ -0,0 +1,192 @@
+#include "test/jemalloc_test.h"
+
+#include "jemalloc/internal/cgroup.h"
+
+#include <sys/stat.h>
+
+#define NALLOCS		64
+#define ALLOC_NPAGES	16
+#define LIMIT		(ZU(64) << 20)
+
+static char root[PATH_MAX + 1];
+
+static void
+file_write(const char *dir, const char *name, const char *val) {
+	char path[PATH_MAX + 1];
+	malloc_snprintf(path, sizeof(path), "%s/%s", dir, name);
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	assert_d_ne(fd, -1, "Unexpected open() failure");
+	assert_zd_eq(write(fd, val, strlen(val)), (ssize_t)strlen(val),
+	    "Unexpected write() failure");
+	close(fd);
+}
+
+static void
+file_remove(const char *dir, const char *name) {
+	char path[PATH_MAX + 1];
+	malloc_snprintf(path, sizeof(path), "%s/%s", dir, name);
+	unlink(path);
+}
+
+/*
+ * Write the same limit and usage for cgroup v2 at the root of the fake
+ * hierarchy and for v1 in its memory subdirectory, so that the test does not
+ * depend on which version /proc/self/cgroup reports.
+ */
+static void
+cgroup_set(const char *limit, size_t usage) {
+	char v1[PATH_MAX + 1];
+	malloc_snprintf(v1, sizeof(v1), "%s/memory", root);
+	char usage_str[32];
+	malloc_snprintf(usage_str, sizeof(usage_str), "%zu\n", usage);
+
+	file_write(root, "memory.max", limit);
+	file_write(root, "memory.current", usage_str);
+	file_write(v1, "memory.limit_in_bytes", strcmp(limit, "max\n") == 0 ?
+	    "9223372036854771712\n" : limit);
+	file_write(v1, "memory.usage_in_bytes", usage_str);
+}
+
+static size_t
+stat_get(const char *name) {
+	uint64_t epoch = 1;
+	assert_d_eq(mallctl("epoch", NULL, NULL, (void *)&epoch,
+	    sizeof(epoch)), 0, "Unexpected mallctl() failure");
+
+	size_t val;
+	size_t sz = sizeof(val);
+	assert_d_eq(mallctl(name, (void *)&val, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return val;
+}
+
+static size_t
+arena_stat_get(unsigned arena_ind, const char *name) {
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "stats.arenas.%u.%s", arena_ind,
+	    name);
+	return stat_get(cmd);
+}
+
+static void
+fake_hierarchy_create(void) {
+	malloc_snprintf(root, sizeof(root), "/tmp/jemalloc_cgroup.%d",
+	    (int)getpid());
+	char v1[PATH_MAX + 1];
+	malloc_snprintf(v1, sizeof(v1), "%s/memory", root);
+	assert_d_eq(mkdir(root, 0700), 0, "Unexpected mkdir() failure");
+	assert_d_eq(mkdir(v1, 0700), 0, "Unexpected mkdir() failure");
+	malloc_snprintf(opt_cgroup_root, sizeof(opt_cgroup_root), "%s", root);
+	opt_cgroup_aware = true;
+}
+
+static void
+fake_hierarchy_destroy(void) {
+	/* Leave the ceiling lifted for the rest of the process. */
+	cgroup_set("max\n", 0);
+	stat_get("stats.cgroup_limit");
+	opt_cgroup_aware = false;
+
+	char v1[PATH_MAX + 1];
+	malloc_snprintf(v1, sizeof(v1), "%s/memory", root);
+	file_remove(v1, "memory.limit_in_bytes");
+	file_remove(v1, "memory.usage_in_bytes");
+	file_remove(root, "memory.max");
+	file_remove(root, "memory.current");
+	rmdir(v1);
+	rmdir(root);
+}
+
+TEST_BEGIN(test_cgroup_ceiling) {
+	test_skip_if(!config_stats);
+
+	fake_hierarchy_create();
+
+	cgroup_set("max\n", 0);
+	assert_zu_eq(stat_get("stats.cgroup_limit"), SIZE_T_MAX,
+	    "Unlimited cgroup should not report a limit");
+	assert_zu_eq(stat_get("stats.unpurged_ceiling"), SIZE_T_MAX,
+	    "Unlimited cgroup should not impose a ceiling");
+
+	char limit[32];
+	malloc_snprintf(limit, sizeof(limit), "%zu\n", LIMIT);
+	cgroup_set(limit, LIMIT / 4);
+	assert_zu_eq(stat_get("stats.cgroup_limit"), LIMIT,
+	    "Unexpected cgroup limit");
+	assert_zu_eq(stat_get("stats.unpurged_ceiling"),
+	    (size_t)((uint64_t)LIMIT * opt_cgroup_unpurged_ratio / 100),
+	    "Ceiling should be derived from opt.cgroup_unpurged_ratio");
+
+	/* Nearly full; the ceiling is bounded by the remaining headroom. */
+	cgroup_set(limit, LIMIT - PAGE);
+	assert_zu_eq(stat_get("stats.unpurged_ceiling"), PAGE,
+	    "Ceiling should not exceed the cgroup headroom");
+
+	cgroup_set(limit, 2 * LIMIT);
+	assert_zu_eq(stat_get("stats.unpurged_ceiling"), 0,
+	    "Ceiling should be zero once usage exceeds the limit");
+
+	fake_hierarchy_destroy();
+}
+TEST_END
+
+TEST_BEGIN(test_cgroup_enforced) {
+	test_skip_if(!config_stats);
+	test_skip_if(NALLOCS * ALLOC_NPAGES * PAGE <= 2 * (ZU(1) << 20));
+
+	unsigned arena_ind;
+	size_t sz = sizeof(arena_ind);
+	assert_d_eq(mallctl("arenas.create", (void *)&arena_ind, &sz, NULL, 0),
+	    0, "Unexpected mallctl() failure");
+	char cmd[128];
+	ssize_t decay_ms = 3600 * 1000;
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.dirty_decay_ms", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&decay_ms,
+	    sizeof(decay_ms)), 0, "Unexpected mallctl() failure");
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.muzzy_decay_ms", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&decay_ms,
+	    sizeof(decay_ms)), 0, "Unexpected mallctl() failure");
+
+	fake_hierarchy_create();
+	char limit[32];
+	malloc_snprintf(limit, sizeof(limit), "%zu\n", LIMIT);
+	/* Leave 1 MiB of headroom. */
+	cgroup_set(limit, LIMIT - (ZU(1) << 20));
+	size_t ceiling = stat_get("stats.unpurged_ceiling");
+	assert_zu_eq(ceiling, ZU(1) << 20, "Unexpected ceiling");
+
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	void *ptrs[NALLOCS];
+	for (unsigned i = 0; i < NALLOCS; i++) {
+		ptrs[i] = mallocx(ALLOC_NPAGES * PAGE, flags);
+		assert_ptr_not_null(ptrs[i], "Unexpected mallocx() failure");
+	}
+	for (unsigned i = 0; i < NALLOCS; i++) {
+		dallocx(ptrs[i], flags);
+	}
+	size_t unpurged = arena_stat_get(arena_ind, "pdirty") +
+	    arena_stat_get(arena_ind, "pmuzzy");
+	assert_zu_le(unpurged, ceiling >> LG_PAGE,
+	    "Unpurged pages should be kept under the cgroup ceiling");
+
+	fake_hierarchy_destroy();
+
+	/* Without the ceiling, freed pages are kept until they decay. */
+	for (unsigned i = 0; i < NALLOCS; i++) {
+		ptrs[i] = mallocx(ALLOC_NPAGES * PAGE, flags);
+		assert_ptr_not_null(ptrs[i], "Unexpected mallocx() failure");
+	}
+	for (unsigned i = 0; i < NALLOCS; i++) {
+		dallocx(ptrs[i], flags);
+	}
+	assert_zu_gt(arena_stat_get(arena_ind, "pdirty"), ceiling >> LG_PAGE,
+	    "Dirty pages should accumulate without a ceiling");
+}
+TEST_END
+
+int
+main(void) {
+	return test(
+	    test_cgroup_ceiling,
+	    test_cgroup_enforced);
+}
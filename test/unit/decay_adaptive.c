@@ -0,0 +1,180 @@
+#include "test/jemalloc_test.h"
+
+#define DECAY_MS	10000
+#define ALLOC_SIZE	(ZU(64) << 10)
+#define NALLOCS		16
+
+static nstime_monotonic_t *nstime_monotonic_orig;
+static nstime_update_t *nstime_update_orig;
+
+static nstime_t time_mock;
+
+static bool
+nstime_monotonic_mock(void) {
+	return true;
+}
+
+static bool
+nstime_update_mock(nstime_t *time) {
+	nstime_copy(time, &time_mock);
+	return false;
+}
+
+static unsigned
+arena_create(void) {
+	unsigned arena_ind;
+	size_t sz = sizeof(arena_ind);
+	assert_d_eq(mallctl("arenas.create", (void *)&arena_ind, &sz, NULL, 0),
+	    0, "Unexpected mallctl() failure");
+
+	char cmd[64];
+	ssize_t decay_ms = DECAY_MS;
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.dirty_decay_ms", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&decay_ms,
+	    sizeof(decay_ms)), 0, "Unexpected mallctl() failure");
+	return arena_ind;
+}
+
+static void
+adaptive_set(unsigned arena_ind, bool adaptive) {
+	char cmd[64];
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.dirty_decay_adaptive",
+	    arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&adaptive,
+	    sizeof(adaptive)), 0, "Unexpected mallctl() failure");
+}
+
+/* Advances the arena's decay epoch if it is due, which may adapt it. */
+static void
+do_arena_decay(unsigned arena_ind) {
+	char cmd[64];
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.decay", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+}
+
+static ssize_t
+decay_ms_effective_get(unsigned arena_ind) {
+	uint64_t epoch = 1;
+	assert_d_eq(mallctl("epoch", NULL, NULL, (void *)&epoch,
+	    sizeof(epoch)), 0, "Unexpected mallctl() failure");
+
+	char cmd[64];
+	ssize_t decay_ms;
+	size_t sz = sizeof(decay_ms);
+	malloc_snprintf(cmd, sizeof(cmd),
+	    "stats.arenas.%u.dirty_decay_ms_effective", arena_ind);
+	assert_d_eq(mallctl(cmd, (void *)&decay_ms, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return decay_ms;
+}
+
+/* Pages reused at ages in buckets [ind_min, REUSE_AGE_NBUCKETS). */
+static uint64_t
+reuse_npages_get(unsigned arena_ind, unsigned ind_min) {
+	uint64_t sum = 0;
+	for (unsigned j = ind_min; j < REUSE_AGE_NBUCKETS; j++) {
+		char cmd[128];
+		uint64_t npages;
+		size_t sz = sizeof(npages);
+		malloc_snprintf(cmd, sizeof(cmd),
+		    "stats.arenas.%u.reuse_ages.%u.npages", arena_ind, j);
+		assert_d_eq(mallctl(cmd, (void *)&npages, &sz, NULL, 0), 0,
+		    "Unexpected mallctl() failure");
+		sum += npages;
+	}
+	return sum;
+}
+
+/* Frees and reuses NALLOCS extents, aging the freed ones by age_ms. */
+static void
+reuse_cycle(unsigned arena_ind, unsigned age_ms) {
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	void *ptrs[NALLOCS];
+	for (unsigned i = 0; i < NALLOCS; i++) {
+		ptrs[i] = mallocx(ALLOC_SIZE, flags);
+		assert_ptr_not_null(ptrs[i], "Unexpected mallocx() failure");
+	}
+	for (unsigned i = 0; i < NALLOCS; i++) {
+		dallocx(ptrs[i], flags);
+	}
+	nstime_t delta;
+	nstime_init(&delta, age_ms * KQU(1000000));
+	nstime_add(&time_mock, &delta);
+}
+
+static void
+time_mock_install(void) {
+	nstime_init(&time_mock, 0);
+	nstime_update(&time_mock);
+	nstime_monotonic_orig = nstime_monotonic;
+	nstime_update_orig = nstime_update;
+	nstime_monotonic = nstime_monotonic_mock;
+	nstime_update = nstime_update_mock;
+}
+
+static void
+time_mock_uninstall(void) {
+	nstime_monotonic = nstime_monotonic_orig;
+	nstime_update = nstime_update_orig;
+}
+
+TEST_BEGIN(test_decay_adaptive_immediate_reuse) {
+	time_mock_install();
+	unsigned arena_ind = arena_create();
+	assert_zd_eq(decay_ms_effective_get(arena_ind), DECAY_MS,
+	    "Decay time should not adapt unless enabled");
+	adaptive_set(arena_ind, true);
+
+	for (unsigned i = 0; i < 64; i++) {
+		reuse_cycle(arena_ind, 0);
+	}
+	/* Let an adaptation period pass before the next reuse. */
+	reuse_cycle(arena_ind, DECAY_ADAPT_PERIOD_MS);
+	do_arena_decay(arena_ind);
+	assert_zd_eq(decay_ms_effective_get(arena_ind), DECAY_ADAPT_MS_MIN,
+	    "Pages reused right away should not be kept for long");
+	if (config_stats) {
+		assert_u64_gt(reuse_npages_get(arena_ind, 0), 0,
+		    "Reuse should have been sampled");
+	}
+
+	adaptive_set(arena_ind, false);
+	assert_zd_eq(decay_ms_effective_get(arena_ind), DECAY_MS,
+	    "Disabling adaptive decay should restore the decay time");
+	time_mock_uninstall();
+}
+TEST_END
+
+TEST_BEGIN(test_decay_adaptive_delayed_reuse) {
+	time_mock_install();
+	unsigned arena_ind = arena_create();
+	adaptive_set(arena_ind, true);
+
+	/* Enough 300 ms cycles to span an adaptation period. */
+	for (unsigned i = 0; i < DECAY_ADAPT_PERIOD_MS / 300 + 2; i++) {
+		reuse_cycle(arena_ind, 300);
+		do_arena_decay(arena_ind);
+	}
+	ssize_t decay_ms = decay_ms_effective_get(arena_ind);
+	/*
+	 * Reuse after 300 ms must not be lost to purging, while a decay time
+	 * that long still leaves room to adapt.
+	 */
+	assert_zd_gt(decay_ms, 400, "Decay time too short for the reuse ages");
+	assert_zd_lt(decay_ms, DECAY_MS, "Decay time should have adapted");
+	if (config_stats) {
+		/* Bucket 9 holds [256, 512) ms. */
+		assert_u64_gt(reuse_npages_get(arena_ind, 9), 0,
+		    "Delayed reuse should have been sampled");
+	}
+	time_mock_uninstall();
+}
+TEST_END
+
+int
+main(void) {
+	return test(
+	    test_decay_adaptive_immediate_reuse,
+	    test_decay_adaptive_delayed_reuse);
+}
@@ -0,0 +1,216 @@
+#include "test/jemalloc_test.h"
+
+static nstime_t time_mock;
+
+static bool
+nstime_monotonic_mock(void) {
+	return true;
+}
+
+static bool
+nstime_update_mock(nstime_t *time) {
+	nstime_copy(time, &time_mock);
+	return false;
+}
+
+static unsigned
+do_arena_create(ssize_t dirty_decay_ms) {
+	unsigned arena_ind;
+	size_t sz = sizeof(unsigned);
+	assert_d_eq(mallctl("arenas.create", (void *)&arena_ind, &sz, NULL, 0),
+	    0, "Unexpected mallctl() failure");
+
+	size_t mib[3];
+	size_t miblen = sizeof(mib)/sizeof(size_t);
+	assert_d_eq(mallctlnametomib("arena.0.dirty_decay_ms", mib, &miblen),
+	    0, "Unexpected mallctlnametomib() failure");
+	mib[1] = (size_t)arena_ind;
+	assert_d_eq(mallctlbymib(mib, miblen, NULL, NULL,
+	    (void *)&dirty_decay_ms, sizeof(dirty_decay_ms)), 0,
+	    "Unexpected mallctlbymib() failure");
+
+	return arena_ind;
+}
+
+static void
+do_arena_destroy(unsigned arena_ind) {
+	size_t mib[3];
+	size_t miblen = sizeof(mib)/sizeof(size_t);
+	assert_d_eq(mallctlnametomib("arena.0.destroy", mib, &miblen), 0,
+	    "Unexpected mallctlnametomib() failure");
+	mib[1] = (size_t)arena_ind;
+	assert_d_eq(mallctlbymib(mib, miblen, NULL, NULL, NULL, 0), 0,
+	    "Unexpected mallctlbymib() failure");
+}
+
+static void
+do_purge(unsigned arena_ind) {
+	size_t mib[3];
+	size_t miblen = sizeof(mib)/sizeof(size_t);
+	assert_d_eq(mallctlnametomib("arena.0.purge", mib, &miblen), 0,
+	    "Unexpected mallctlnametomib() failure");
+	mib[1] = (size_t)arena_ind;
+	assert_d_eq(mallctlbymib(mib, miblen, NULL, NULL, NULL, 0), 0,
+	    "Unexpected mallctlbymib() failure");
+}
+
+static void
+do_decay(unsigned arena_ind) {
+	size_t mib[3];
+	size_t miblen = sizeof(mib)/sizeof(size_t);
+	assert_d_eq(mallctlnametomib("arena.0.decay", mib, &miblen), 0,
+	    "Unexpected mallctlnametomib() failure");
+	mib[1] = (size_t)arena_ind;
+	assert_d_eq(mallctlbymib(mib, miblen, NULL, NULL, NULL, 0), 0,
+	    "Unexpected mallctlbymib() failure");
+}
+
+static size_t
+get_bin_stat(unsigned arena_ind, szind_t binind, const char *name) {
+	uint64_t epoch = 1;
+	assert_d_eq(mallctl("epoch", NULL, NULL, (void *)&epoch,
+	    sizeof(epoch)), 0, "Unexpected mallctl() failure");
+
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "stats.arenas.%u.bins.%u.%s",
+	    arena_ind, (unsigned)binind, name);
+	size_t val;
+	size_t sz = sizeof(val);
+	assert_d_eq(mallctl(cmd, (void *)&val, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return val;
+}
+
+static uint64_t
+get_bin_nslabs(unsigned arena_ind, szind_t binind) {
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "stats.arenas.%u.bins.%u.nslabs",
+	    arena_ind, (unsigned)binind);
+	uint64_t val;
+	size_t sz = sizeof(val);
+	assert_d_eq(mallctl(cmd, (void *)&val, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return val;
+}
+
+TEST_BEGIN(test_empty_slab_reuse) {
+	test_skip_if(!config_stats);
+	test_skip_if(opt_empty_slab_cache_max < bin_infos[0].slab_size);
+
+	unsigned arena_ind = do_arena_create(10 * 1000);
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	const bin_info_t *bin_info = &bin_infos[0];
+	size_t nregs = bin_info->nregs;
+	void **ptrs = (void **)mallocx(nregs * sizeof(void *), 0);
+	assert_ptr_not_null(ptrs, "Unexpected mallocx() failure");
+
+	for (size_t i = 0; i < nregs; i++) {
+		ptrs[i] = mallocx(bin_info->reg_size, flags);
+		assert_ptr_not_null(ptrs[i], "Unexpected mallocx() failure");
+	}
+	assert_zu_eq(get_bin_stat(arena_ind, 0, "curslabs"), 1,
+	    "Expected a single slab");
+	uint64_t nslabs = get_bin_nslabs(arena_ind, 0);
+
+	for (size_t i = 0; i < nregs; i++) {
+		dallocx(ptrs[i], flags);
+	}
+	assert_zu_eq(get_bin_stat(arena_ind, 0, "curslabs_empty"), 1,
+	    "Emptied slab should be retained");
+	assert_zu_eq(get_bin_stat(arena_ind, 0, "curslabs"), 1,
+	    "Retained slab should still be counted");
+
+	/* Reuse must not create a new slab. */
+	void *p = mallocx(bin_info->reg_size, flags);
+	assert_ptr_not_null(p, "Unexpected mallocx() failure");
+	assert_zu_eq(get_bin_stat(arena_ind, 0, "curslabs_empty"), 0,
+	    "Retained slab should have been reused");
+	assert_u64_eq(get_bin_nslabs(arena_ind, 0), nslabs,
+	    "Reuse should not allocate a new slab");
+	assert_ptr_eq(iealloc(tsdn_fetch(), p),
+	    iealloc(tsdn_fetch(), ptrs[0]),
+	    "Reused slab should be the retained one");
+	dallocx(p, flags);
+
+	/* Purging releases retained slabs. */
+	do_purge(arena_ind);
+	assert_zu_eq(get_bin_stat(arena_ind, 0, "curslabs_empty"), 0,
+	    "Purge should release retained slabs");
+	assert_zu_eq(get_bin_stat(arena_ind, 0, "curslabs"), 0,
+	    "Purge should release retained slabs");
+
+	dallocx(ptrs, 0);
+	do_arena_destroy(arena_ind);
+}
+TEST_END
+
+TEST_BEGIN(test_empty_slab_no_retain_without_decay) {
+	test_skip_if(!config_stats);
+
+	unsigned arena_ind = do_arena_create(0);
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+
+	void *p = mallocx(bin_infos[0].reg_size, flags);
+	assert_ptr_not_null(p, "Unexpected mallocx() failure");
+	dallocx(p, flags);
+	assert_zu_eq(get_bin_stat(arena_ind, 0, "curslabs_empty"), 0,
+	    "Slabs should not be retained when purging immediately");
+	assert_zu_eq(get_bin_stat(arena_ind, 0, "curslabs"), 0,
+	    "Slab should have been deallocated");
+
+	do_arena_destroy(arena_ind);
+}
+TEST_END
+
+TEST_BEGIN(test_empty_slab_release_idle) {
+	test_skip_if(!config_stats);
+	test_skip_if(opt_empty_slab_cache_max < bin_infos[0].slab_size);
+	test_skip_if(background_thread_enabled());
+
+	nstime_monotonic_t *saved_monotonic = nstime_monotonic;
+	nstime_update_t *saved_update = nstime_update;
+	nstime_init(&time_mock, 0);
+	nstime_update(&time_mock);
+	nstime_monotonic = nstime_monotonic_mock;
+	nstime_update = nstime_update_mock;
+
+	unsigned arena_ind = do_arena_create(1000);
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	void *p = mallocx(bin_infos[0].reg_size, flags);
+	assert_ptr_not_null(p, "Unexpected mallocx() failure");
+	dallocx(p, flags);
+	assert_zu_eq(get_bin_stat(arena_ind, 0, "curslabs_empty"), 1,
+	    "Emptied slab should be retained");
+
+	/*
+	 * Nothing is dirty, so no epoch purges; the slab must still be
+	 * released once it has been idle for the decay time.
+	 */
+	nstime_iadd(&time_mock, 100 * KQU(1000000));
+	do_decay(arena_ind);
+	assert_zu_eq(get_bin_stat(arena_ind, 0, "curslabs_empty"), 1,
+	    "Slab should not be released before the decay time");
+	nstime_iadd(&time_mock, 600 * KQU(1000000));
+	do_decay(arena_ind);
+	assert_zu_eq(get_bin_stat(arena_ind, 0, "curslabs_empty"), 1,
+	    "Slab should not be released before the decay time");
+	nstime_iadd(&time_mock, 600 * KQU(1000000));
+	do_decay(arena_ind);
+	assert_zu_eq(get_bin_stat(arena_ind, 0, "curslabs_empty"), 0,
+	    "Idle slab should be released after the decay time");
+	assert_zu_eq(get_bin_stat(arena_ind, 0, "curslabs"), 0,
+	    "Idle slab should be released after the decay time");
+
+	nstime_monotonic = saved_monotonic;
+	nstime_update = saved_update;
+	do_arena_destroy(arena_ind);
+}
+TEST_END
+
+int
+main(void) {
+	return test_no_reentrancy(
+	    test_empty_slab_reuse,
+	    test_empty_slab_no_retain_without_decay,
+	    test_empty_slab_release_idle);
+}
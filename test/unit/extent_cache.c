@@ -0,0 +1,161 @@
+#include "test/jemalloc_test.h"
+
+#define NEXTENTS	(EXTENT_CACHE_NCACHED + 1)
+
+static unsigned
+do_arena_create(void) {
+	unsigned arena_ind;
+	size_t sz = sizeof(unsigned);
+	assert_d_eq(mallctl("arenas.create", (void *)&arena_ind, &sz, NULL, 0),
+	    0, "Unexpected mallctl() failure");
+	return arena_ind;
+}
+
+static arena_t *
+thread_arena_bind(tsd_t *tsd, unsigned arena_ind) {
+	assert_d_eq(mallctl("thread.arena", NULL, NULL, (void *)&arena_ind,
+	    sizeof(arena_ind)), 0, "Unexpected mallctl() failure");
+	arena_t *arena = arena_get(tsd_tsdn(tsd), arena_ind, false);
+	assert_ptr_eq(tsd_arena_get(tsd), arena, "Unexpected thread arena");
+	return arena;
+}
+
+#define NAVAIL_MAX	1024
+static extent_t *avail[NAVAIL_MAX];
+
+/* Copies arena->extent_avail into avail, and returns its size. */
+static size_t
+extent_avail_snapshot(tsdn_t *tsdn, arena_t *arena) {
+	size_t navail = 0;
+	malloc_mutex_lock(tsdn, &arena->extent_avail_mtx);
+	extent_t *extent;
+	while ((extent = extent_avail_first(&arena->extent_avail)) != NULL) {
+		assert_zu_lt(navail, NAVAIL_MAX, "Too many available extents");
+		extent_avail_remove(&arena->extent_avail, extent);
+		avail[navail++] = extent;
+	}
+	for (size_t i = 0; i < navail; i++) {
+		extent_avail_insert(&arena->extent_avail, avail[i]);
+	}
+	malloc_mutex_unlock(tsdn, &arena->extent_avail_mtx);
+	return navail;
+}
+
+static bool
+extent_avail_contains(tsdn_t *tsdn, arena_t *arena, extent_t *extent) {
+	size_t navail = extent_avail_snapshot(tsdn, arena);
+	for (size_t i = 0; i < navail; i++) {
+		if (avail[i] == extent) {
+			return true;
+		}
+	}
+	return false;
+}
+
+TEST_BEGIN(test_extent_cache_fill_flush) {
+	tsd_t *tsd = tsd_fetch();
+	tsdn_t *tsdn = tsd_tsdn(tsd);
+	arena_t *arena = thread_arena_bind(tsd, do_arena_create());
+	extent_cache_t *cache = tsd_extent_cachep_get(tsd);
+
+	extent_t *extents[NEXTENTS];
+	for (unsigned i = 0; i < NEXTENTS; i++) {
+		extents[i] = extent_alloc(tsdn, arena);
+		assert_ptr_not_null(extents[i], "Unexpected extent_alloc() "
+		    "failure");
+	}
+	extent_cache_flush(tsd);
+	assert_u_eq(cache->ncached, 0, "Flush should empty the magazine");
+	size_t navail = extent_avail_snapshot(tsdn, arena);
+
+	/* Frees are absorbed until the magazine is full. */
+	for (unsigned i = 0; i < EXTENT_CACHE_NCACHED; i++) {
+		extent_dalloc(tsdn, arena, extents[i]);
+	}
+	assert_u_eq(cache->ncached, EXTENT_CACHE_NCACHED,
+	    "Magazine should hold every freed extent");
+	assert_zu_eq(extent_avail_snapshot(tsdn, arena), navail,
+	    "Frees should not reach extent_avail");
+
+	/* One more flushes the bottom batch. */
+	extent_dalloc(tsdn, arena, extents[EXTENT_CACHE_NCACHED]);
+	assert_u_eq(cache->ncached, EXTENT_CACHE_NCACHED -
+	    EXTENT_CACHE_NBATCH + 1, "Unexpected number of cached extents");
+	assert_zu_eq(extent_avail_snapshot(tsdn, arena), navail +
+	    EXTENT_CACHE_NBATCH, "A full batch should be flushed");
+	for (unsigned i = 0; i < EXTENT_CACHE_NBATCH; i++) {
+		assert_true(extent_avail_contains(tsdn, arena, extents[i]),
+		    "The oldest extents should be flushed");
+	}
+
+	/* Allocation pops the most recently freed extents. */
+	for (unsigned i = NEXTENTS; i > EXTENT_CACHE_NBATCH; i--) {
+		assert_ptr_eq(extent_alloc(tsdn, arena), extents[i - 1],
+		    "Magazine should be LIFO");
+	}
+	assert_u_eq(cache->ncached, 0, "Magazine should be drained");
+
+	/* An empty magazine refills a batch at a time. */
+	extent_t *extent = extent_alloc(tsdn, arena);
+	assert_ptr_not_null(extent, "Unexpected extent_alloc() failure");
+	assert_u_eq(cache->ncached, EXTENT_CACHE_NBATCH - 1,
+	    "Unexpected number of cached extents after refill");
+	assert_zu_eq(extent_avail_snapshot(tsdn, arena), navail,
+	    "Refill should take a full batch from extent_avail");
+
+	extent_dalloc(tsdn, arena, extent);
+	extent_cache_flush(tsd);
+	assert_zu_eq(extent_avail_snapshot(tsdn, arena), navail +
+	    EXTENT_CACHE_NBATCH, "Flush should return every cached extent");
+}
+TEST_END
+
+static unsigned thd_arena_ind;
+static unsigned thd_ncached;
+static extent_t *thd_cached[EXTENT_CACHE_NCACHED];
+
+static void *
+thd_start(void *arg) {
+	tsd_t *tsd = tsd_fetch();
+	tsdn_t *tsdn = tsd_tsdn(tsd);
+	arena_t *arena = thread_arena_bind(tsd, thd_arena_ind);
+
+	extent_t *extents[EXTENT_CACHE_NBATCH];
+	for (unsigned i = 0; i < EXTENT_CACHE_NBATCH; i++) {
+		extents[i] = extent_alloc(tsdn, arena);
+		assert_ptr_not_null(extents[i], "Unexpected extent_alloc() "
+		    "failure");
+	}
+	for (unsigned i = 0; i < EXTENT_CACHE_NBATCH; i++) {
+		extent_dalloc(tsdn, arena, extents[i]);
+	}
+
+	extent_cache_t *cache = tsd_extent_cachep_get(tsd);
+	thd_ncached = cache->ncached;
+	memcpy(thd_cached, cache->cached, thd_ncached * sizeof(extent_t *));
+	return NULL;
+}
+
+TEST_BEGIN(test_extent_cache_thread_exit) {
+	thd_arena_ind = do_arena_create();
+	thd_t thd;
+	thd_create(&thd, thd_start, NULL);
+	thd_join(thd, NULL);
+
+	assert_u_ge(thd_ncached, EXTENT_CACHE_NBATCH,
+	    "Freed extents should have been cached");
+	tsdn_t *tsdn = tsd_tsdn(tsd_fetch());
+	arena_t *arena = arena_get(tsdn, thd_arena_ind, false);
+	for (unsigned i = 0; i < thd_ncached; i++) {
+		assert_true(extent_avail_contains(tsdn, arena, thd_cached[i]),
+		    "Thread exit should return cached extents to extent_avail");
+	}
+}
+TEST_END
+
+int
+main(void) {
+	return test_no_reentrancy(
+	    test_extent_cache_fill_flush,
+	    test_extent_cache_thread_exit);
+}
@@ -0,0 +1,239 @@
+#include "test/jemalloc_test.h"
+
+#include <sys/stat.h>
+
+#define SZ	(ZU(1) << 20)
+
+static bool
+arena_create_fd(int *fd, unsigned *arena_ind) {
+	arena_config_t config = {NULL, false, false, true, -1};
+	size_t sz = sizeof(*arena_ind);
+	if (fd != NULL) {
+		config.fd = *fd;
+	}
+	int err = mallctl("arenas.create", (void *)arena_ind, &sz,
+	    (void *)&config, sizeof(config));
+	if (err == EAGAIN) {
+		/* Not supported on this system. */
+		return true;
+	}
+	assert_d_eq(err, 0, "Unexpected mallctl() failure");
+	return false;
+}
+
+static int
+arena_fd_get(unsigned arena_ind, void **base) {
+	char cmd[128];
+	int fd;
+	size_t sz = sizeof(fd);
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.fd", arena_ind);
+	assert_d_eq(mallctl(cmd, (void *)&fd, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	sz = sizeof(*base);
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.fd_base", arena_ind);
+	assert_d_eq(mallctl(cmd, (void *)base, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return fd;
+}
+
+static void
+do_arena_cmd(unsigned arena_ind, const char *name) {
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.%s", arena_ind, name);
+	assert_d_eq(mallctl(cmd, NULL, NULL, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+}
+
+TEST_BEGIN(test_extent_fd_memfd) {
+	unsigned arena_ind;
+	test_skip_if(arena_create_fd(NULL, &arena_ind));
+	void *base;
+	int fd = arena_fd_get(arena_ind, &base);
+	assert_d_ge(fd, 0, "Unexpected fd");
+
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	/* Memory fresh from the file is known to be zeroed. */
+	unsigned char *p = (unsigned char *)mallocx(SZ, flags | MALLOCX_ZERO);
+	assert_ptr_not_null(p, "Unexpected mallocx() failure");
+	assert_true((uintptr_t)p >= (uintptr_t)base,
+	    "Allocation should come from the file");
+	for (size_t i = 0; i < SZ; i++) {
+		assert_u_eq(p[i], 0, "Memory should be zeroed");
+	}
+	memset(p, 0xa5, SZ);
+
+	/* A separate mapping of the file sees the same bytes. */
+	size_t offset = (size_t)((uintptr_t)p - (uintptr_t)base);
+	size_t map_offset = offset & ~PAGE_MASK;
+	void *map = mmap(NULL, SZ + PAGE, PROT_READ | PROT_WRITE, MAP_SHARED,
+	    fd, (off_t)map_offset);
+	assert_ptr_ne(map, MAP_FAILED, "Unexpected mmap() failure");
+	unsigned char *q = (unsigned char *)map + (offset - map_offset);
+	assert_d_eq(memcmp(p, q, SZ), 0, "Mappings should share memory");
+	q[SZ - 1] = 0x5a;
+	assert_u_eq(p[SZ - 1], 0x5a, "Mappings should share memory");
+
+	/* Purging punches holes into the file. */
+	dallocx(p, flags);
+	do_arena_cmd(arena_ind, "purge");
+	for (size_t i = 0; i < SZ; i += PAGE) {
+		assert_u_eq(q[i], 0, "Purged memory should read as zeros");
+	}
+	assert_d_eq(munmap(map, SZ + PAGE), 0, "Unexpected munmap() failure");
+
+	/* Small allocations work too. */
+	void *r = mallocx(1, flags);
+	assert_ptr_not_null(r, "Unexpected mallocx() failure");
+	dallocx(r, flags);
+
+	do_arena_cmd(arena_ind, "destroy");
+	assert_d_ne(fcntl(fd, F_GETFD), 0,
+	    "The provider's memfd should be closed with the arena");
+}
+TEST_END
+
+TEST_BEGIN(test_extent_fd_user) {
+	unsigned arena_ind;
+	test_skip_if(arena_create_fd(NULL, &arena_ind));
+	do_arena_cmd(arena_ind, "destroy");
+
+	char path[] = "/tmp/jemalloc.extent_fd.XXXXXX";
+	int fd = mkstemp(path);
+	test_skip_if(fd == -1);
+	unlink(path);
+	/* The size of a non-empty file bounds the arena. */
+	assert_d_eq(ftruncate(fd, (off_t)(8 * SZ)), 0,
+	    "Unexpected ftruncate() failure");
+	static unsigned char buf[SZ];
+	memset(buf, 0xa5, SZ);
+	for (size_t i = 0; i < 8; i++) {
+		assert_zd_eq(pwrite(fd, buf, SZ, (off_t)(i * SZ)), SZ,
+		    "Unexpected pwrite() failure");
+	}
+	test_skip_if(arena_create_fd(&fd, &arena_ind));
+	void *base;
+	assert_d_eq(arena_fd_get(arena_ind, &base), fd,
+	    "arena.<i>.fd should return the file descriptor");
+
+	/* The caller's file is not assumed to be zeroed. */
+	extent_hooks_t *hooks;
+	size_t sz = sizeof(hooks);
+	char cmd[64];
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.extent_hooks", arena_ind);
+	assert_d_eq(mallctl(cmd, (void *)&hooks, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	bool zero = false;
+	bool commit = false;
+	unsigned char *z = (unsigned char *)hooks->alloc(hooks, NULL, SZ, PAGE,
+	    &zero, &commit, arena_ind);
+	assert_ptr_not_null(z, "Unexpected extent hook failure");
+	assert_false(zero, "A non-empty file should not be reported zeroed");
+	assert_u_eq(z[0], 0xa5, "Unexpected file contents");
+	zero = true;
+	z = (unsigned char *)hooks->alloc(hooks, NULL, SZ, PAGE, &zero, &commit,
+	    arena_ind);
+	assert_ptr_not_null(z, "Unexpected extent hook failure");
+	assert_true(zero, "Requested zeroing should be reported");
+	for (size_t i = 0; i < SZ; i++) {
+		assert_u_eq(z[i], 0, "Memory should be zeroed on request");
+	}
+
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	void *p = mallocx(SZ, flags);
+	assert_ptr_not_null(p, "Unexpected mallocx() failure");
+	memset(p, 0xa5, SZ);
+	unsigned char c;
+	assert_zd_eq(pread(fd, &c, 1, (off_t)((uintptr_t)p -
+	    (uintptr_t)base)), 1, "Unexpected pread() failure");
+	assert_u_eq(c, 0xa5, "Allocation should be backed by the file");
+	assert_ptr_null(mallocx(8 * SZ, flags),
+	    "Allocations should not exceed the file");
+	dallocx(p, flags);
+
+	do_arena_cmd(arena_ind, "destroy");
+	struct stat st;
+	assert_d_eq(fstat(fd, &st), 0,
+	    "The caller's file should stay open");
+	assert_d_eq(st.st_size, 8 * SZ, "The file size should be unchanged");
+	close(fd);
+}
+TEST_END
+
+/* Allocates SZ at a time until the window is full, and frees it all. */
+static unsigned
+window_fill(unsigned arena_ind) {
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	void *ptrs[8];
+	unsigned n;
+	for (n = 0; n < sizeof(ptrs) / sizeof(ptrs[0]); n++) {
+		if ((ptrs[n] = mallocx(SZ, flags)) == NULL) {
+			break;
+		}
+	}
+	for (unsigned i = 0; i < n; i++) {
+		dallocx(ptrs[i], flags);
+	}
+	do_arena_cmd(arena_ind, "purge");
+	return n;
+}
+
+TEST_BEGIN(test_extent_fd_retained_trim) {
+	char path[] = "/tmp/jemalloc.extent_fd.XXXXXX";
+	int fd = mkstemp(path);
+	test_skip_if(fd == -1);
+	unlink(path);
+	assert_d_eq(ftruncate(fd, (off_t)(8 * SZ)), 0,
+	    "Unexpected ftruncate() failure");
+	unsigned arena_ind;
+	test_skip_if(arena_create_fd(&fd, &arena_ind));
+
+	unsigned n = window_fill(arena_ind);
+	assert_u_gt(n, 0, "Unexpected mallocx() failure");
+	assert_u_lt(n, 8, "Allocations should not exceed the file");
+	/* Trimming retained memory must not give the window away. */
+	tsdn_t *tsdn = tsd_tsdn(tsd_fetch());
+	arena_retained_trim(tsdn, arena_get(tsdn, arena_ind, false), SZ);
+	assert_u_ge(window_fill(arena_ind), n,
+	    "The window should be reusable after a trim");
+
+	do_arena_cmd(arena_ind, "destroy");
+	close(fd);
+}
+TEST_END
+
+TEST_BEGIN(test_extent_fd_errors) {
+	int fd;
+	void *base;
+	size_t sz = sizeof(fd);
+	assert_d_eq(mallctl("arena.0.fd", (void *)&fd, &sz, NULL, 0), ENOENT,
+	    "Arenas without a file should have no fd");
+	sz = sizeof(base);
+	assert_d_eq(mallctl("arena.0.fd_base", (void *)&base, &sz, NULL, 0),
+	    ENOENT, "Arenas without a file should have no fd_base");
+
+	unsigned arena_ind;
+	arena_config_t config = {NULL, false, false, true, -2};
+	sz = sizeof(arena_ind);
+	assert_d_eq(mallctl("arenas.create", (void *)&arena_ind, &sz,
+	    (void *)&config, sizeof(config)), EINVAL,
+	    "Invalid fd should be rejected");
+	config.fd = -1;
+	sz = sizeof(config.extent_hooks);
+	assert_d_eq(mallctl("arena.0.extent_hooks",
+	    (void *)&config.extent_hooks, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	sz = sizeof(arena_ind);
+	assert_d_eq(mallctl("arenas.create", (void *)&arena_ind, &sz,
+	    (void *)&config, sizeof(config)), EINVAL,
+	    "Extent hooks should be rejected along with a file");
+}
+TEST_END
+
+int
+main(void) {
+	return test(
+	    test_extent_fd_memfd,
+	    test_extent_fd_user,
+	    test_extent_fd_retained_trim,
+	    test_extent_fd_errors);
+}
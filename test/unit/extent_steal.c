@@ -0,0 +1,109 @@
+#include "test/jemalloc_test.h"
+
+#define SZ	(ZU(1) << 20)
+
+static uint64_t
+get_arena_u64_stat(unsigned arena_ind, const char *name) {
+	uint64_t epoch = 1;
+	assert_d_eq(mallctl("epoch", NULL, NULL, (void *)&epoch,
+	    sizeof(epoch)), 0, "Unexpected mallctl() failure");
+
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "stats.arenas.%u.%s", arena_ind,
+	    name);
+	uint64_t val;
+	size_t sz = sizeof(val);
+	assert_d_eq(mallctl(cmd, (void *)&val, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return val;
+}
+
+static size_t
+get_arena_pdirty(unsigned arena_ind) {
+	uint64_t epoch = 1;
+	assert_d_eq(mallctl("epoch", NULL, NULL, (void *)&epoch,
+	    sizeof(epoch)), 0, "Unexpected mallctl() failure");
+
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "stats.arenas.%u.pdirty", arena_ind);
+	size_t val;
+	size_t sz = sizeof(val);
+	assert_d_eq(mallctl(cmd, (void *)&val, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return val;
+}
+
+static unsigned
+lookup_arena(void *ptr) {
+	unsigned arena_ind;
+	size_t sz = sizeof(arena_ind);
+	assert_d_eq(mallctl("arenas.lookup", &arena_ind, &sz, &ptr,
+	    sizeof(ptr)), 0, "Unexpected mallctl() failure");
+	return arena_ind;
+}
+
+TEST_BEGIN(test_extent_steal_slab) {
+	test_skip_if(!config_stats);
+	test_skip_if(!opt_extent_steal || narenas_auto < 2);
+
+	int flags0 = MALLOCX_ARENA(0) | MALLOCX_TCACHE_NONE;
+	int flags1 = MALLOCX_ARENA(1) | MALLOCX_TCACHE_NONE;
+
+	/* Leave a dirty extent behind in arena 0. */
+	void *p = mallocx(SZ, flags0);
+	assert_ptr_not_null(p, "Unexpected mallocx() failure");
+	dallocx(p, flags0);
+
+	/*
+	 * Arena 1 is initialized by this allocation, so it has no dirty memory
+	 * of its own and its first slab must be stolen.
+	 */
+	size_t sz = bin_infos[0].reg_size;
+	void *s = mallocx(sz, flags1);
+	assert_ptr_not_null(s, "Unexpected mallocx() failure");
+	assert_u64_eq(get_arena_u64_stat(1, "extent_steals"), 1,
+	    "Arena 1 should have stolen a slab from arena 0");
+	assert_u_eq(lookup_arena(s), 1, "Slab should belong to arena 1");
+	memset(s, 0xa5, sz);
+	dallocx(s, flags1);
+}
+TEST_END
+
+TEST_BEGIN(test_extent_steal_large) {
+	test_skip_if(!config_stats);
+	test_skip_if(!opt_extent_steal || narenas_auto < 2);
+
+	int flags0 = MALLOCX_ARENA(0) | MALLOCX_TCACHE_NONE;
+	int flags1 = MALLOCX_ARENA(1) | MALLOCX_TCACHE_NONE;
+
+	void *p = mallocx(SZ << 1, flags0);
+	assert_ptr_not_null(p, "Unexpected mallocx() failure");
+	dallocx(p, flags0);
+	size_t pdirty0 = get_arena_pdirty(0);
+
+	uint64_t nsteals = get_arena_u64_stat(1, "extent_steals");
+	uint64_t stolen = get_arena_u64_stat(1, "extent_stolen");
+	void *q = mallocx(SZ, flags1);
+	assert_ptr_not_null(q, "Unexpected mallocx() failure");
+	assert_u64_eq(get_arena_u64_stat(1, "extent_steals"), nsteals + 1,
+	    "Arena 1 should have stolen from arena 0");
+	assert_u64_ge(get_arena_u64_stat(1, "extent_stolen") - stolen, SZ,
+	    "Stolen bytes should cover the request");
+	assert_zu_lt(get_arena_pdirty(0), pdirty0,
+	    "Arena 0 dirty pages should have been consumed");
+	assert_u_eq(lookup_arena(q), 1, "Stolen extent should belong to arena 1");
+
+	/* Freed memory goes back to the thief. */
+	size_t pdirty1 = get_arena_pdirty(1);
+	dallocx(q, flags1);
+	assert_zu_gt(get_arena_pdirty(1), pdirty1,
+	    "Stolen extent should be returned to arena 1");
+}
+TEST_END
+
+int
+main(void) {
+	return test_no_reentrancy(
+	    test_extent_steal_slab,
+	    test_extent_steal_large);
+}
@@ -0,0 +1,3 @@
+#!/bin/sh
+
+export MALLOC_CONF="extent_steal:true,extent_steal_threshold:0,narenas:2,dirty_decay_ms:-1,muzzy_decay_ms:-1"
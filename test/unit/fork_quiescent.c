@@ -0,0 +1,193 @@
+#include "test/jemalloc_test.h"
+
+#include <sys/wait.h>
+
+#define NARENAS		8
+#define NTHREADS	4
+#define NFORKS		64
+#define LARGE_SZ	(ZU(64) << 10)
+
+static const int flags_base = MALLOCX_TCACHE_NONE;
+
+static unsigned
+arena_create(void) {
+	unsigned arena_ind;
+	size_t sz = sizeof(arena_ind);
+	assert_d_eq(mallctl("arenas.create", (void *)&arena_ind, &sz, NULL, 0),
+	    0, "Unexpected mallctl() failure");
+	return arena_ind;
+}
+
+/* Returns false if the arena cannot allocate, so that children can use it. */
+static bool
+arena_use(unsigned arena_ind) {
+	int flags = flags_base | MALLOCX_ARENA(arena_ind);
+	void *small = mallocx(1, flags);
+	void *large = mallocx(LARGE_SZ, flags);
+	if (small == NULL || large == NULL) {
+		return false;
+	}
+	dallocx(small, flags);
+	dallocx(large, flags);
+	return true;
+}
+
+static void
+child_wait(pid_t pid) {
+	int status;
+	assert_d_eq(waitpid(pid, &status, 0), pid,
+	    "Unexpected waitpid() failure");
+	assert_false(WIFSIGNALED(status),
+	    "Unexpected child termination due to signal %d", WTERMSIG(status));
+	assert_true(WIFEXITED(status) && WEXITSTATUS(status) == 0,
+	    "The child failed to allocate");
+}
+
+/* Forks a child that just exits. */
+static void
+fork_exit(void) {
+	pid_t pid = fork();
+	assert_d_ne(pid, -1, "Unexpected fork() failure");
+	if (pid == 0) {
+		_exit(0);
+	}
+	child_wait(pid);
+}
+
+static uint64_t
+large_mtx_nops(unsigned arena_ind) {
+	uint64_t epoch = 1;
+	assert_d_eq(mallctl("epoch", NULL, NULL, (void *)&epoch,
+	    sizeof(epoch)), 0, "Unexpected mallctl() failure");
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd),
+	    "stats.arenas.%u.mutexes.large.num_ops", arena_ind);
+	uint64_t nops;
+	size_t sz = sizeof(nops);
+	assert_d_eq(mallctl(cmd, (void *)&nops, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return nops;
+}
+
+TEST_BEGIN(test_fork_quiescent_skip) {
+	test_skip_if(!config_stats);
+
+	/*
+	 * Forks lock the arena's large_mtx once, unless it is skipped.  Reading
+	 * the stats also locks it, which makes it used again.
+	 */
+	unsigned arena_ind = arena_create();
+	assert_true(arena_use(arena_ind), "Unexpected mallocx() failure");
+	uint64_t nops0 = large_mtx_nops(arena_ind);
+	uint64_t nops1 = large_mtx_nops(arena_ind);
+	uint64_t nread = nops1 - nops0;
+
+	fork_exit();
+	uint64_t nops2 = large_mtx_nops(arena_ind);
+	assert_u64_eq(nops2 - nops1, nread + 1,
+	    "A used arena should be locked for fork");
+
+	fork_exit();
+	fork_exit();
+	uint64_t nops3 = large_mtx_nops(arena_ind);
+	assert_u64_eq(nops3 - nops2, nread + (opt_fork_skip_quiescent ? 1 : 2),
+	    "Only the first fork after the arena was used should lock it");
+}
+TEST_END
+
+static unsigned child_arenas[2];
+
+static void *
+child_thd(void *arg) {
+	bool *ok = (bool *)arg;
+	*ok = arena_use(child_arenas[0]) && arena_use(child_arenas[1]);
+	return NULL;
+}
+
+TEST_BEGIN(test_fork_quiescent_child) {
+	/* The first arena is used right before the fork, the second isn't. */
+	child_arenas[0] = arena_create();
+	child_arenas[1] = arena_create();
+	assert_true(arena_use(child_arenas[1]), "Unexpected mallocx() failure");
+	fork_exit();
+	assert_true(arena_use(child_arenas[0]), "Unexpected mallocx() failure");
+
+	pid_t pid = fork();
+	assert_d_ne(pid, -1, "Unexpected fork() failure");
+	if (pid == 0) {
+		bool ok = arena_use(child_arenas[0]) &&
+		    arena_use(child_arenas[1]);
+		if (ok) {
+			/* Both arenas can be used by new threads, too. */
+			thd_t thd;
+			thd_create(&thd, child_thd, (void *)&ok);
+			thd_join(thd, NULL);
+		}
+		_exit(ok ? 0 : 1);
+	}
+	child_wait(pid);
+
+	assert_true(arena_use(child_arenas[0]) && arena_use(child_arenas[1]),
+	    "Unexpected mallocx() failure");
+}
+TEST_END
+
+static unsigned thd_arenas[NARENAS];
+static atomic_b_t thd_stop;
+
+/* Mostly uses its own arena, and occasionally one that is otherwise idle. */
+static void *
+use_thd(void *arg) {
+	unsigned ind = (unsigned)(uintptr_t)arg;
+	for (unsigned i = 0; !atomic_load_b(&thd_stop, ATOMIC_ACQUIRE); i++) {
+		unsigned arena_ind = (i % 64 == 0) ?
+		    thd_arenas[NTHREADS + ind % (NARENAS - NTHREADS)] :
+		    thd_arenas[ind];
+		assert_true(arena_use(arena_ind),
+		    "Unexpected mallocx() failure");
+	}
+	return NULL;
+}
+
+TEST_BEGIN(test_fork_quiescent_threads) {
+	for (unsigned i = 0; i < NARENAS; i++) {
+		thd_arenas[i] = arena_create();
+	}
+	atomic_store_b(&thd_stop, false, ATOMIC_RELAXED);
+	thd_t thds[NTHREADS];
+	for (unsigned i = 0; i < NTHREADS; i++) {
+		thd_create(&thds[i], use_thd, (void *)(uintptr_t)i);
+	}
+
+	/*
+	 * Whichever arenas get skipped, the child must be able to use all of
+	 * them; a deadlocked child is killed by the alarm.
+	 */
+	for (unsigned i = 0; i < NFORKS; i++) {
+		pid_t pid = fork();
+		assert_d_ne(pid, -1, "Unexpected fork() failure");
+		if (pid == 0) {
+			alarm(10);
+			bool ok = true;
+			for (unsigned j = 0; j < NARENAS && ok; j++) {
+				ok = arena_use(thd_arenas[j]);
+			}
+			_exit(ok ? 0 : 1);
+		}
+		child_wait(pid);
+	}
+
+	atomic_store_b(&thd_stop, true, ATOMIC_RELEASE);
+	for (unsigned i = 0; i < NTHREADS; i++) {
+		thd_join(thds[i], NULL);
+	}
+}
+TEST_END
+
+int
+main(void) {
+	return test_no_reentrancy(
+	    test_fork_quiescent_skip,
+	    test_fork_quiescent_child,
+	    test_fork_quiescent_threads);
+}
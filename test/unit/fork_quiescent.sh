@@ -0,0 +1,3 @@
+#!/bin/sh
+
+export MALLOC_CONF="fork_skip_quiescent:true"
@@ -0,0 +1,263 @@
+#include "test/jemalloc_test.h"
+
+#include <fcntl.h>
+#include <sys/wait.h>
+
+#define OBJ_SZ		64
+#define NOBJS		(ZU(64) << 10)
+/* One hole per slab, assuming OBJ_SZ slabs are a page each. */
+#define HOLE_STRIDE	64
+
+static void *objs[NOBJS];
+
+static unsigned
+thread_arena_get(void) {
+	unsigned arena_ind;
+	size_t sz = sizeof(arena_ind);
+	assert_d_eq(mallctl("thread.arena", (void *)&arena_ind, &sz, NULL, 0),
+	    0, "Unexpected mallctl() failure");
+	return arena_ind;
+}
+
+static unsigned
+ptr_arena_get(void *ptr) {
+	unsigned arena_ind;
+	size_t sz = sizeof(arena_ind);
+	assert_d_eq(mallctl("arenas.lookup", (void *)&arena_ind, &sz,
+	    (void *)&ptr, sizeof(ptr)), 0, "Unexpected mallctl() failure");
+	return arena_ind;
+}
+
+static void
+heap_freeze(void) {
+	assert_d_eq(mallctl("heap.freeze", NULL, NULL, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+}
+
+/* Returns the process's private dirty memory in kB, or 0 if unknown. */
+static size_t
+private_dirty_kb(void) {
+	int fd = open("/proc/self/smaps_rollup", O_RDONLY);
+	if (fd == -1) {
+		return 0;
+	}
+	char buf[4096];
+	ssize_t n = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (n <= 0) {
+		return 0;
+	}
+	buf[n] = '\0';
+	const char *field = strstr(buf, "Private_Dirty:");
+	if (field == NULL) {
+		return 0;
+	}
+	return (size_t)strtoul(field + strlen("Private_Dirty:"), NULL, 10);
+}
+
+/* Leaves a free region in each of the slabs that objs were allocated from. */
+static void
+holes_make(void) {
+	for (size_t i = 0; i < NOBJS; i++) {
+		objs[i] = mallocx(OBJ_SZ, 0);
+		assert_ptr_not_null(objs[i], "Unexpected mallocx() failure");
+	}
+	for (size_t i = 0; i < NOBJS; i += HOLE_STRIDE) {
+		dallocx(objs[i], MALLOCX_TCACHE_NONE);
+		objs[i] = NULL;
+	}
+}
+
+static void
+holes_free(void) {
+	for (size_t i = 0; i < NOBJS; i++) {
+		if (objs[i] != NULL) {
+			dallocx(objs[i], 0);
+		}
+	}
+}
+
+/*
+ * Forks a child that makes as many allocations as there are holes, and returns
+ * how much private dirty memory that cost it, in kB.
+ */
+static size_t
+child_dirty_kb(void) {
+	int fds[2];
+	assert_d_eq(pipe(fds), 0, "Unexpected pipe() failure");
+	pid_t pid = fork();
+	assert_d_ne(pid, -1, "Unexpected fork() failure");
+	if (pid == 0) {
+		close(fds[0]);
+		size_t before = private_dirty_kb();
+		for (size_t i = 0; i < NOBJS / HOLE_STRIDE; i++) {
+			void *p = mallocx(OBJ_SZ, 0);
+			if (p == NULL) {
+				_exit(1);
+			}
+			memset(p, 0, OBJ_SZ);
+		}
+		size_t after = private_dirty_kb();
+		size_t kb = (before == 0 || after < before) ? 0 : after -
+		    before;
+		_exit(write(fds[1], &kb, sizeof(kb)) == sizeof(kb) ? 0 : 1);
+	}
+	close(fds[1]);
+	size_t kb;
+	assert_zd_eq(read(fds[0], &kb, sizeof(kb)), (ssize_t)sizeof(kb),
+	    "Unexpected read() failure");
+	close(fds[0]);
+	int status;
+	assert_d_eq(waitpid(pid, &status, 0), pid,
+	    "Unexpected waitpid() failure");
+	assert_true(WIFEXITED(status) && WEXITSTATUS(status) == 0,
+	    "Unexpected child failure");
+	return kb;
+}
+
+TEST_BEGIN(test_heap_freeze_cow) {
+	/* Must run first, before the heap is frozen. */
+	holes_make();
+	size_t unfrozen_kb = child_dirty_kb();
+	holes_free();
+
+	holes_make();
+	heap_freeze();
+	size_t frozen_kb = child_dirty_kb();
+	holes_free();
+
+	if (unfrozen_kb == 0) {
+		malloc_printf("Private_Dirty unavailable; not compared\n");
+	} else {
+		assert_zu_lt(frozen_kb * 2, unfrozen_kb,
+		    "Children of a frozen heap should not dirty shared pages "
+		    "(frozen: %zu kB, unfrozen: %zu kB)", frozen_kb,
+		    unfrozen_kb);
+	}
+}
+TEST_END
+
+TEST_BEGIN(test_heap_freeze_arena) {
+	unsigned frozen_ind = thread_arena_get();
+	for (size_t i = 0; i < NOBJS; i++) {
+		objs[i] = mallocx(OBJ_SZ, 0);
+		assert_ptr_not_null(objs[i], "Unexpected mallocx() failure");
+	}
+	heap_freeze();
+
+	unsigned successor_ind = thread_arena_get();
+	assert_u_ne(successor_ind, frozen_ind,
+	    "The thread should move off the frozen arena");
+	for (unsigned i = 0; i < 2; i++) {
+		size_t miblen = 3;
+		size_t mib[3];
+		assert_d_eq(mallctlnametomib(i == 0 ? "arena.0.reset" :
+		    "arena.0.destroy", mib, &miblen), 0,
+		    "Unexpected mallctlnametomib() failure");
+		mib[1] = successor_ind;
+		assert_d_eq(mallctlbymib(mib, miblen, NULL, NULL, NULL, 0),
+		    EFAULT, "The successor arena should not be removable");
+	}
+
+	/* Freed regions of the frozen arena are not handed out again. */
+	for (size_t i = 0; i < NOBJS; i++) {
+		assert_u_eq(ptr_arena_get(objs[i]), frozen_ind,
+		    "Unexpected arena");
+		dallocx(objs[i], 0);
+	}
+	for (size_t i = 0; i < NOBJS; i++) {
+		objs[i] = mallocx(OBJ_SZ, 0);
+		assert_ptr_not_null(objs[i], "Unexpected mallocx() failure");
+		assert_u_eq(ptr_arena_get(objs[i]), successor_ind,
+		    "Allocations should come from the successor arena");
+	}
+
+	/* Freezing again moves on from the successor. */
+	heap_freeze();
+	assert_u_ne(thread_arena_get(), successor_ind,
+	    "Unexpected thread arena");
+	holes_free();
+}
+TEST_END
+
+static unsigned
+narenas_get(void) {
+	unsigned n;
+	size_t sz = sizeof(n);
+	assert_d_eq(mallctl("arenas.narenas", (void *)&n, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return n;
+}
+
+TEST_BEGIN(test_heap_freeze_reuse) {
+	unsigned narenas_before = narenas_get();
+	unsigned nauto;
+	size_t sz = sizeof(nauto);
+	assert_d_eq(mallctl("opt.narenas", (void *)&nauto, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+
+	/* Arenas emptied since they were frozen take over again. */
+	unsigned ind = thread_arena_get();
+	for (unsigned i = 0; i < 8; i++) {
+		heap_freeze();
+		unsigned successor_ind = thread_arena_get();
+		assert_u_ne(successor_ind, ind, "Unexpected thread arena");
+		ind = successor_ind;
+	}
+	/* Arenas that still hold memory are only reused with a limit. */
+	unsigned narenas_max;
+	sz = sizeof(narenas_max);
+	assert_d_eq(mallctl("opt.freeze_narenas_max", (void *)&narenas_max,
+	    &sz, NULL, 0), 0, "Unexpected mallctl() failure");
+	void *ptrs[16];
+	bool reused = false;
+	for (unsigned i = 0; i < sizeof(ptrs) / sizeof(ptrs[0]); i++) {
+		ptrs[i] = mallocx(OBJ_SZ, 0);
+		assert_ptr_not_null(ptrs[i], "Unexpected mallocx() failure");
+		heap_freeze();
+		unsigned successor_ind = thread_arena_get();
+		for (unsigned j = 0; j <= i; j++) {
+			if (ptr_arena_get(ptrs[j]) == successor_ind) {
+				reused = true;
+			}
+		}
+	}
+	if (narenas_max == 0) {
+		assert_false(reused,
+		    "Frozen arenas holding memory should not take over");
+	} else {
+		assert_true(reused,
+		    "Frozen arenas holding memory should take over eventually");
+		assert_u_le(narenas_get() - narenas_before, nauto *
+		    (narenas_max - 1),
+		    "Freezing should not keep creating arenas");
+	}
+	for (unsigned i = 0; i < sizeof(ptrs) / sizeof(ptrs[0]); i++) {
+		dallocx(ptrs[i], 0);
+	}
+}
+TEST_END
+
+TEST_BEGIN(test_heap_freeze_internal) {
+	heap_freeze();
+	/* Arenas that took over serve internal allocations, as auto ones. */
+	tsd_t *tsd = tsd_fetch();
+	arena_t *arena = arena_ichoose(tsd, NULL);
+	assert_false(arena_is_frozen(arena), "Unexpected frozen arena");
+	assert_true(arena_is_auto(arena),
+	    "Arenas taking over should be automatic");
+	void *p = iallocztm(tsd_tsdn(tsd), OBJ_SZ, sz_size2index(OBJ_SZ),
+	    false, NULL, true, arena, true);
+	assert_ptr_not_null(p, "Unexpected iallocztm() failure");
+	idalloctm(tsd_tsdn(tsd), p, NULL, NULL, true, true);
+}
+TEST_END
+
+int
+main(void) {
+	return test_no_reentrancy(
+	    test_heap_freeze_cow,
+	    test_heap_freeze_arena,
+	    test_heap_freeze_reuse,
+	    test_heap_freeze_internal);
+}
@@ -0,0 +1 @@
+#include "heap_freeze.c"
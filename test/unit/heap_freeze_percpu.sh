@@ -0,0 +1,3 @@
+#!/bin/sh
+
+export MALLOC_CONF="abort:false,percpu_cache:true,freeze_narenas_max:4"
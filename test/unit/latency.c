@@ -0,0 +1,109 @@
+#include "test/jemalloc_test.h"
+
+#define NALLOCS		16
+#define ALLOC_SIZE	(ZU(64) << 10)
+
+static uint64_t
+latency_count_get(unsigned arena_ind, const char *op, const char *thread) {
+	uint64_t epoch = 1;
+	assert_d_eq(mallctl("epoch", NULL, NULL, (void *)&epoch,
+	    sizeof(epoch)), 0, "Unexpected mallctl() failure");
+
+	uint64_t sum = 0;
+	for (unsigned j = 0; j < LATENCY_NBUCKETS; j++) {
+		char cmd[128];
+		uint64_t count;
+		size_t sz = sizeof(count);
+		malloc_snprintf(cmd, sizeof(cmd),
+		    "stats.arenas.%u.latency.%s.%u.%s", arena_ind, op, j,
+		    thread);
+		assert_d_eq(mallctl(cmd, (void *)&count, &sz, NULL, 0), 0,
+		    "Unexpected mallctl() failure");
+		sum += count;
+	}
+	return sum;
+}
+
+/* Dirty pages are purged as soon as they are freed; see purge_select.c. */
+static unsigned
+arena_create(void) {
+	unsigned arena_ind;
+	size_t sz = sizeof(arena_ind);
+	assert_d_eq(mallctl("arenas.create", (void *)&arena_ind, &sz, NULL, 0),
+	    0, "Unexpected mallctl() failure");
+
+	char cmd[64];
+	ssize_t decay_ms = 3600 * 1000;
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.dirty_decay_ms", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&decay_ms,
+	    sizeof(decay_ms)), 0, "Unexpected mallctl() failure");
+	const char *purge_policy = "max_dirty";
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.purge_policy", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&purge_policy,
+	    sizeof(purge_policy)), 0, "Unexpected mallctl() failure");
+	size_t max_dirty = 0;
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.purge_max_dirty",
+	    arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&max_dirty,
+	    sizeof(max_dirty)), 0, "Unexpected mallctl() failure");
+	return arena_ind;
+}
+
+TEST_BEGIN(test_latency_ctl) {
+	uint64_t count;
+	size_t sz = sizeof(count);
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "stats.arenas.0.latency.decay.%u."
+	    "background", LATENCY_NBUCKETS - 1);
+	assert_d_eq(mallctl(cmd, (void *)&count, &sz, NULL, 0),
+	    config_stats ? 0 : ENOENT, "Unexpected mallctl() result");
+	malloc_snprintf(cmd, sizeof(cmd), "stats.arenas.0.latency.decay.%u."
+	    "background", LATENCY_NBUCKETS);
+	assert_d_eq(mallctl(cmd, (void *)&count, &sz, NULL, 0), ENOENT,
+	    "Out-of-range bucket should not exist");
+}
+TEST_END
+
+TEST_BEGIN(test_latency_application) {
+	test_skip_if(!config_stats);
+
+	unsigned arena_ind = arena_create();
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	void *ptrs[NALLOCS];
+	for (unsigned i = 0; i < NALLOCS; i++) {
+		ptrs[i] = mallocx(ALLOC_SIZE, flags);
+		assert_ptr_not_null(ptrs[i], "Unexpected mallocx() failure");
+	}
+	for (unsigned i = 0; i < NALLOCS; i++) {
+		dallocx(ptrs[i], flags);
+	}
+
+	assert_u64_gt(latency_count_get(arena_ind, "map", "application"), 0,
+	    "Mapping memory for a new arena should be timed");
+	assert_u64_gt(latency_count_get(arena_ind, "decay", "application"),
+	    0, "Decay runs should be timed");
+	assert_u64_gt(latency_count_get(arena_ind, "purge", "application"),
+	    0, "Purges should be timed");
+
+	bool background_thread;
+	size_t sz = sizeof(background_thread);
+	if (have_background_thread) {
+		assert_d_eq(mallctl("background_thread",
+		    (void *)&background_thread, &sz, NULL, 0), 0,
+		    "Unexpected mallctl() failure");
+	} else {
+		background_thread = false;
+	}
+	if (!background_thread) {
+		assert_u64_eq(latency_count_get(arena_ind, "decay",
+		    "background"), 0, "No background thread has run");
+	}
+}
+TEST_END
+
+int
+main(void) {
+	return test(
+	    test_latency_ctl,
+	    test_latency_application);
+}
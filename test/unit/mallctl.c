@@ -160,12 +160,42 @@ TEST_BEGIN(test_mallctl_opt) {
 	TEST_MALLCTL_OPT(bool, abort_conf, always);
 	TEST_MALLCTL_OPT(const char *, metadata_thp, always);
 	TEST_MALLCTL_OPT(bool, retain, always);
+	TEST_MALLCTL_OPT(size_t, reserve_va, always);
+	TEST_MALLCTL_OPT(size_t, retain_trim_threshold, always);
+	TEST_MALLCTL_OPT(size_t, retain_trim_ratio, always);
 	TEST_MALLCTL_OPT(const char *, dss, always);
+	TEST_MALLCTL_OPT(size_t, persistent_addr, always);
 	TEST_MALLCTL_OPT(unsigned, narenas, always);
+	TEST_MALLCTL_OPT(unsigned, freeze_narenas_max, always);
+	TEST_MALLCTL_OPT(bool, fork_skip_quiescent, always);
 	TEST_MALLCTL_OPT(const char *, percpu_arena, always);
+	TEST_MALLCTL_OPT(bool, percpu_cache, always);
 	TEST_MALLCTL_OPT(bool, background_thread, always);
+	TEST_MALLCTL_OPT(const char *, background_thread_cpus, always);
+	TEST_MALLCTL_OPT(bool, background_thread_sched_idle, always);
+	TEST_MALLCTL_OPT(ssize_t, background_thread_nice, always);
 	TEST_MALLCTL_OPT(ssize_t, dirty_decay_ms, always);
 	TEST_MALLCTL_OPT(ssize_t, muzzy_decay_ms, always);
+	TEST_MALLCTL_OPT(bool, dirty_decay_adaptive, always);
+	TEST_MALLCTL_OPT(size_t, dirty_decay_refault_target, always);
+	TEST_MALLCTL_OPT(size_t, empty_slab_cache_max, always);
+	TEST_MALLCTL_OPT(bool, extent_steal, always);
+	TEST_MALLCTL_OPT(size_t, extent_steal_threshold, always);
+	TEST_MALLCTL_OPT(const char *, purge_policy, always);
+	TEST_MALLCTL_OPT(size_t, purge_max_dirty, always);
+	TEST_MALLCTL_OPT(size_t, purge_dirty_ratio, always);
+	TEST_MALLCTL_OPT(size_t, purge_floor, always);
+	TEST_MALLCTL_OPT(size_t, purge_rate, always);
+	TEST_MALLCTL_OPT(size_t, purge_call_max, always);
+	TEST_MALLCTL_OPT(size_t, purge_inline_share, always);
+	TEST_MALLCTL_OPT(const char *, purge_select, always);
+	TEST_MALLCTL_OPT(bool, cgroup_aware, always);
+	TEST_MALLCTL_OPT(const char *, cgroup_root, always);
+	TEST_MALLCTL_OPT(size_t, cgroup_unpurged_ratio, always);
+	TEST_MALLCTL_OPT(bool, psi_purge, always);
+	TEST_MALLCTL_OPT(const char *, psi_path, always);
+	TEST_MALLCTL_OPT(size_t, psi_stall_us, always);
+	TEST_MALLCTL_OPT(size_t, psi_window_us, always);
 	TEST_MALLCTL_OPT(bool, stats_print, always);
 	TEST_MALLCTL_OPT(const char *, junk, fill);
 	TEST_MALLCTL_OPT(bool, zero, fill);
@@ -173,6 +203,7 @@ TEST_BEGIN(test_mallctl_opt) {
 	TEST_MALLCTL_OPT(bool, xmalloc, xmalloc);
 	TEST_MALLCTL_OPT(bool, tcache, always);
 	TEST_MALLCTL_OPT(size_t, lg_extent_max_active_fit, always);
+	TEST_MALLCTL_OPT(const char *, extent_reuse, always);
 	TEST_MALLCTL_OPT(size_t, lg_tcache_max, always);
 	TEST_MALLCTL_OPT(const char *, thp, always);
 	TEST_MALLCTL_OPT(bool, prof, prof);
@@ -365,6 +396,45 @@ TEST_BEGIN(test_thread_arena) {
 }
 TEST_END
 
+static uint64_t
+thread_rtree_cache_get(const char *name) {
+	uint64_t val;
+	size_t sz = sizeof(val);
+	assert_d_eq(mallctl(name, (void *)&val, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return val;
+}
+
+static void
+thread_rtree_cache_check(void) {
+	uint64_t hits = thread_rtree_cache_get("thread.rtree_cache.hits");
+	uint64_t misses = thread_rtree_cache_get("thread.rtree_cache.misses");
+	assert_u64_le(thread_rtree_cache_get("thread.rtree_cache.hard_lookups"),
+	    misses, "Hard lookups should be misses");
+
+	/* Deallocation looks the pointer up in the calling thread's cache. */
+	void *p = mallocx(1, 0);
+	assert_ptr_not_null(p, "Unexpected mallocx() failure");
+	dallocx(p, 0);
+
+	assert_u64_gt(thread_rtree_cache_get("thread.rtree_cache.hits") +
+	    thread_rtree_cache_get("thread.rtree_cache.misses"), hits + misses,
+	    "Lookups should be counted");
+}
+
+TEST_BEGIN(test_thread_rtree_cache) {
+	if (config_rtree_ctx_stats) {
+		thread_rtree_cache_check();
+	} else {
+		uint64_t hits;
+		size_t sz = sizeof(hits);
+		assert_d_eq(mallctl("thread.rtree_cache.hits", (void *)&hits,
+		    &sz, NULL, 0), ENOENT,
+		    "thread.rtree_cache.* should require ANDROID_RTREE_CTX_STATS");
+	}
+}
+TEST_END
+
 TEST_BEGIN(test_arena_i_initialized) {
 	unsigned narenas, i;
 	size_t sz;
@@ -606,6 +676,41 @@ TEST_BEGIN(test_arena_i_retain_grow_limit) {
 }
 TEST_END
 
+TEST_BEGIN(test_arena_i_extent_reuse) {
+	const char *reuse_old, *reuse_new;
+	size_t sz = sizeof(reuse_old);
+	size_t mib[3];
+	size_t miblen;
+
+	miblen = sizeof(mib)/sizeof(size_t);
+	assert_d_eq(mallctlnametomib("arena.0.extent_reuse", mib, &miblen), 0,
+	    "Unexpected mallctlnametomib() error");
+
+	reuse_new = "lifo";
+	assert_d_eq(mallctlbymib(mib, miblen, (void *)&reuse_old, &sz,
+	    (void *)&reuse_new, sizeof(reuse_new)), 0,
+	    "Unexpected mallctl() failure");
+	assert_str_eq(reuse_old, "fit", "Unexpected default for extent_reuse");
+
+	assert_d_eq(mallctlbymib(mib, miblen, (void *)&reuse_new, &sz,
+	    (void *)&reuse_old, sizeof(reuse_old)), 0,
+	    "Unexpected mallctl() failure");
+	assert_str_eq(reuse_new, "lifo", "Unexpected value for extent_reuse");
+
+	reuse_new = "invalid";
+	assert_d_eq(mallctlbymib(mib, miblen, NULL, NULL, (void *)&reuse_new,
+	    sizeof(reuse_new)), EINVAL, "Unexpected mallctl() success");
+
+	assert_d_eq(mallctlbymib(mib, miblen, (void *)&reuse_old, &sz, NULL,
+	    0), 0, "Unexpected mallctl() failure");
+	assert_str_eq(reuse_old, "fit", "Unexpected value for extent_reuse");
+
+	mib[1] = narenas_total_get();
+	assert_d_eq(mallctlbymib(mib, miblen, (void *)&reuse_old, &sz, NULL,
+	    0), EFAULT, "Unexpected mallctl() success");
+}
+TEST_END
+
 TEST_BEGIN(test_arenas_dirty_decay_ms) {
 	ssize_t dirty_decay_ms, orig_dirty_decay_ms, prev_dirty_decay_ms;
 	size_t sz = sizeof(ssize_t);
@@ -735,6 +840,23 @@ TEST_BEGIN(test_arenas_create) {
 	assert_u_eq(narenas_before+1, narenas_after,
 	    "Unexpected number of arenas before versus after extension");
 	assert_u_eq(arena, narenas_after-1, "Unexpected arena index");
+
+	/* An arena_config_t may be written instead of the extent hooks. */
+	arena_config_t config = {NULL, false, true, false, -1};
+	assert_d_eq(mallctl("arenas.create", (void *)&arena, &sz,
+	    (void *)&config, sizeof(config)), 0,
+	    "Unexpected mallctl() failure");
+	assert_u_eq(arena, narenas_after, "Unexpected arena index");
+	char cmd[64];
+	bool mlock;
+	size_t mlock_sz = sizeof(mlock);
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.mlock", arena);
+	assert_d_eq(mallctl(cmd, (void *)&mlock, &mlock_sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	assert_true(mlock, "arena_config_t options should be applied");
+	assert_d_eq(mallctl("arenas.create", (void *)&arena, &sz,
+	    (void *)&config, sizeof(config) + 1), EINVAL,
+	    "Wrong size should be rejected");
 }
 TEST_END
 
@@ -751,6 +873,14 @@ TEST_BEGIN(test_arenas_lookup) {
 	    0, "Unexpected mallctl() failure");
 	assert_u_eq(arena, arena1, "Unexpected arena index");
 	dallocx(ptr, 0);
+
+	/* Freed memory no longer belongs to an arena. */
+	ptr = mallocx(LARGE_MINCLASS, MALLOCX_ARENA(arena) |
+	    MALLOCX_TCACHE_NONE);
+	assert_ptr_not_null(ptr, "Unexpected mallocx() failure");
+	dallocx(ptr, MALLOCX_TCACHE_NONE);
+	assert_d_eq(mallctl("arenas.lookup", &arena1, &sz, &ptr, sizeof(ptr)),
+	    EINVAL, "Freed extents should not be looked up");
 }
 TEST_END
 
@@ -766,6 +896,7 @@ TEST_BEGIN(test_stats_arenas) {
 	TEST_STATS_ARENAS(const char *, dss);
 	TEST_STATS_ARENAS(ssize_t, dirty_decay_ms);
 	TEST_STATS_ARENAS(ssize_t, muzzy_decay_ms);
+	TEST_STATS_ARENAS(ssize_t, dirty_decay_ms_effective);
 	TEST_STATS_ARENAS(size_t, pactive);
 	TEST_STATS_ARENAS(size_t, pdirty);
 
@@ -787,6 +918,7 @@ main(void) {
 	    test_tcache_none,
 	    test_tcache,
 	    test_thread_arena,
+	    test_thread_rtree_cache,
 	    test_arena_i_initialized,
 	    test_arena_i_dirty_decay_ms,
 	    test_arena_i_muzzy_decay_ms,
@@ -794,6 +926,7 @@ main(void) {
 	    test_arena_i_decay,
 	    test_arena_i_dss,
 	    test_arena_i_retain_grow_limit,
+	    test_arena_i_extent_reuse,
 	    test_arenas_dirty_decay_ms,
 	    test_arenas_muzzy_decay_ms,
 	    test_arenas_constants,
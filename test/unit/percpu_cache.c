@@ -0,0 +1,228 @@
+#include "test/jemalloc_test.h"
+
+#include "jemalloc/internal/percpu_cache.h"
+
+const char *malloc_conf = "percpu_cache:true";
+
+#define SZ	64
+#define NTHREADS	4
+#define NITER	10000
+
+static void
+epoch_refresh(void) {
+	uint64_t epoch = 1;
+	assert_d_eq(mallctl("epoch", NULL, NULL, (void *)&epoch,
+	    sizeof(epoch)), 0, "Unexpected mallctl() failure");
+}
+
+static size_t
+percpu_ncached_get(void) {
+	epoch_refresh();
+	size_t ncached;
+	size_t sz = sizeof(ncached);
+	assert_d_eq(mallctl("stats.percpu_cache.ncached", (void *)&ncached,
+	    &sz, NULL, 0), 0, "Unexpected mallctl() failure");
+	return ncached;
+}
+
+static uint64_t
+percpu_stat_get(const char *name) {
+	epoch_refresh();
+	char cmd[128];
+	uint64_t val;
+	size_t sz = sizeof(val);
+	malloc_snprintf(cmd, sizeof(cmd), "stats.percpu_cache.%s", name);
+	assert_d_eq(mallctl(cmd, (void *)&val, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return val;
+}
+
+TEST_BEGIN(test_percpu_cache_ctl) {
+	bool enabled;
+	size_t sz = sizeof(enabled);
+	assert_d_eq(mallctl("opt.percpu_cache", (void *)&enabled, &sz, NULL,
+	    0), 0, "Unexpected mallctl() failure");
+	assert_b_eq(enabled, percpu_cache_enabled,
+	    "opt.percpu_cache should reflect whether the caches are in use");
+	test_skip_if(!config_stats);
+
+	unsigned ncpus;
+	sz = sizeof(ncpus);
+	assert_d_eq(mallctl("stats.percpu_cache.ncpus", (void *)&ncpus, &sz,
+	    NULL, 0), 0, "Unexpected mallctl() failure");
+	assert_u_eq(ncpus, percpu_cache_ncpus, "Unexpected number of CPUs");
+
+	epoch_refresh();
+	size_t sum = 0;
+	for (unsigned i = 0; i < ncpus; i++) {
+		char cmd[128];
+		size_t ncached;
+		sz = sizeof(ncached);
+		malloc_snprintf(cmd, sizeof(cmd),
+		    "stats.percpu_cache.cpus.%u.ncached", i);
+		assert_d_eq(mallctl(cmd, (void *)&ncached, &sz, NULL, 0), 0,
+		    "Unexpected mallctl() failure");
+		sum += ncached;
+	}
+	assert_zu_eq(sum, percpu_ncached_get(),
+	    "Total should be the sum of the per-CPU occupancies");
+
+	char cmd[128];
+	size_t ncached;
+	sz = sizeof(ncached);
+	malloc_snprintf(cmd, sizeof(cmd), "stats.percpu_cache.cpus.%u.ncached",
+	    ncpus);
+	assert_d_eq(mallctl(cmd, (void *)&ncached, &sz, NULL, 0), ENOENT,
+	    "Out of range CPU should be rejected");
+}
+TEST_END
+
+TEST_BEGIN(test_percpu_cache_alloc_free) {
+	test_skip_if(!percpu_cache_enabled);
+	test_skip_if(!config_stats);
+
+	cache_bin_sz_t ncached_max =
+	    tcache_bin_info[sz_size2index(SZ)].ncached_max;
+	/* More than all CPUs can cache, so that some bin overflows. */
+	unsigned nptrs = percpu_cache_ncpus * ncached_max + 1;
+	void **ptrs = (void **)mallocx(nptrs * sizeof(void *),
+	    MALLOCX_TCACHE_NONE);
+	assert_ptr_not_null(ptrs, "Unexpected mallocx() failure");
+
+	for (unsigned i = 0; i < nptrs; i++) {
+		ptrs[i] = malloc(SZ);
+		assert_ptr_not_null(ptrs[i], "Unexpected malloc() failure");
+		memset(ptrs[i], (int)i, SZ);
+	}
+	assert_u64_gt(percpu_stat_get("nfills"), 0,
+	    "Caches should have been filled");
+	for (unsigned i = 0; i < nptrs; i++) {
+		free(ptrs[i]);
+	}
+	assert_u64_gt(percpu_stat_get("nflushes"), 0,
+	    "Caches should have been flushed");
+	assert_zu_gt(percpu_ncached_get(), 0, "Objects should be cached");
+	size_t bytes;
+	size_t sz = sizeof(bytes);
+	assert_d_eq(mallctl("stats.percpu_cache.bytes", (void *)&bytes, &sz,
+	    NULL, 0), 0, "Unexpected mallctl() failure");
+	assert_zu_ge(bytes, percpu_ncached_get() * 8,
+	    "Unexpected cached bytes");
+
+	dallocx(ptrs, MALLOCX_TCACHE_NONE);
+}
+TEST_END
+
+TEST_BEGIN(test_percpu_cache_zero) {
+	test_skip_if(!percpu_cache_enabled);
+
+	for (unsigned i = 0; i < 16; i++) {
+		void *p = malloc(SZ);
+		assert_ptr_not_null(p, "Unexpected malloc() failure");
+		memset(p, 0xa5, SZ);
+		free(p);
+		unsigned char *q = (unsigned char *)calloc(1, SZ);
+		assert_ptr_not_null(q, "Unexpected calloc() failure");
+		for (unsigned j = 0; j < SZ; j++) {
+			assert_u_eq(q[j], 0, "Memory should be zeroed");
+		}
+		free(q);
+	}
+}
+TEST_END
+
+TEST_BEGIN(test_percpu_cache_bypass) {
+	test_skip_if(!percpu_cache_enabled);
+	test_skip_if(!config_stats);
+
+	unsigned arena_ind;
+	size_t sz = sizeof(arena_ind);
+	assert_d_eq(mallctl("arenas.create", (void *)&arena_ind, &sz, NULL, 0),
+	    0, "Unexpected mallctl() failure");
+
+	size_t ncached = percpu_ncached_get();
+	/* Explicit arenas and tcaches bypass the per-CPU caches. */
+	void *p = mallocx(SZ, MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE);
+	assert_ptr_not_null(p, "Unexpected mallocx() failure");
+	void *q = mallocx(SZ, MALLOCX_TCACHE_NONE);
+	assert_ptr_not_null(q, "Unexpected mallocx() failure");
+	dallocx(q, MALLOCX_TCACHE_NONE);
+	assert_zu_eq(percpu_ncached_get(), ncached,
+	    "Explicitly uncached objects should not be cached");
+	/* Objects of manual arenas are never cached. */
+	free(p);
+	assert_zu_eq(percpu_ncached_get(), ncached,
+	    "Objects of manual arenas should not be cached");
+}
+TEST_END
+
+TEST_BEGIN(test_percpu_cache_tcache_disabled) {
+	test_skip_if(!percpu_cache_enabled);
+	test_skip_if(!config_stats);
+
+	bool e0 = false, e1;
+	size_t sz = sizeof(e1);
+	assert_d_eq(mallctl("thread.tcache.enabled", (void *)&e1, &sz,
+	    (void *)&e0, sizeof(e0)), 0, "Unexpected mallctl() failure");
+
+	void *p = malloc(SZ);
+	assert_ptr_not_null(p, "Unexpected malloc() failure");
+	size_t ncached = percpu_ncached_get();
+	free(p);
+	assert_zu_eq(percpu_ncached_get(), ncached + 1,
+	    "Caches should stand in for a disabled tcache");
+
+	assert_d_eq(mallctl("thread.tcache.enabled", NULL, NULL, (void *)&e1,
+	    sizeof(e1)), 0, "Unexpected mallctl() failure");
+}
+TEST_END
+
+static void *
+thd_start(void *arg) {
+	uintptr_t tag = (uintptr_t)arg;
+	void *ptrs[64];
+	for (unsigned i = 0; i < NITER; i++) {
+		unsigned n = i % 64 + 1;
+		for (unsigned j = 0; j < n; j++) {
+			ptrs[j] = malloc(SZ);
+			assert_ptr_not_null(ptrs[j], "Unexpected malloc() failure");
+			*(uintptr_t *)ptrs[j] = tag + j;
+		}
+		sched_yield();
+		for (unsigned j = 0; j < n; j++) {
+			/* Objects handed out twice would be overwritten. */
+			assert_zu_eq(*(uintptr_t *)ptrs[j], tag + j,
+			    "Object should not be shared");
+			free(ptrs[j]);
+		}
+	}
+	return NULL;
+}
+
+TEST_BEGIN(test_percpu_cache_threads) {
+	test_skip_if(!percpu_cache_enabled);
+
+	thd_t thds[NTHREADS];
+	for (unsigned i = 0; i < NTHREADS; i++) {
+		thd_create(&thds[i], thd_start, (void *)((uintptr_t)i << 16));
+	}
+	for (unsigned i = 0; i < NTHREADS; i++) {
+		thd_join(thds[i], NULL);
+	}
+	if (config_stats) {
+		/* Aborts are up to the scheduler; only check the stat. */
+		percpu_stat_get("naborts");
+	}
+}
+TEST_END
+
+int
+main(void) {
+	return test(
+	    test_percpu_cache_ctl,
+	    test_percpu_cache_alloc_free,
+	    test_percpu_cache_zero,
+	    test_percpu_cache_bypass,
+	    test_percpu_cache_tcache_disabled,
+	    test_percpu_cache_threads);
+}
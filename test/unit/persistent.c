@@ -0,0 +1,348 @@
+#include "test/jemalloc_test.h"
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define FILE_SZ		(ZU(64) << 20)
+#define NNODES		64
+#define LARGE_SZ	(ZU(1) << 20)
+
+typedef struct node_s node_t;
+struct node_s {
+	node_t		*next;
+	unsigned	val;
+	unsigned char	*large;
+};
+
+static const int flags_base = MALLOCX_TCACHE_NONE;
+
+static int
+persistent_file(void) {
+	char path[] = "/tmp/jemalloc.persistent.XXXXXX";
+	int fd = mkstemp(path);
+	if (fd == -1) {
+		return -1;
+	}
+	unlink(path);
+	assert_d_eq(ftruncate(fd, (off_t)FILE_SZ), 0,
+	    "Unexpected ftruncate() failure");
+	return fd;
+}
+
+static int
+arena_create_persistent(int fd, unsigned *arena_ind) {
+	size_t sz = sizeof(*arena_ind);
+	return mallctl("arenas.create_persistent", (void *)arena_ind, &sz,
+	    (void *)&fd, sizeof(fd));
+}
+
+static int
+arena_cmd(unsigned arena_ind, const char *name) {
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.%s", arena_ind, name);
+	return mallctl(cmd, NULL, NULL, NULL, 0);
+}
+
+static void *
+root_get(unsigned arena_ind) {
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.persistent_root",
+	    arena_ind);
+	void *root;
+	size_t sz = sizeof(root);
+	assert_d_eq(mallctl(cmd, (void *)&root, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return root;
+}
+
+static int
+root_set(unsigned arena_ind, void *root) {
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.persistent_root",
+	    arena_ind);
+	return mallctl(cmd, NULL, NULL, (void *)&root, sizeof(root));
+}
+
+/* Builds a list of small nodes, each with a large buffer, in the arena. */
+static node_t *
+list_build(unsigned arena_ind) {
+	int flags = flags_base | MALLOCX_ARENA(arena_ind);
+	node_t *head = NULL;
+	for (unsigned i = 0; i < NNODES; i++) {
+		node_t *node = (node_t *)mallocx(sizeof(node_t), flags);
+		if (node == NULL) {
+			return NULL;
+		}
+		node->val = i;
+		node->large = NULL;
+		if (i % 8 == 0) {
+			node->large = (unsigned char *)mallocx(LARGE_SZ, flags);
+			if (node->large == NULL) {
+				return NULL;
+			}
+			memset(node->large, (int)i, LARGE_SZ);
+		}
+		node->next = head;
+		head = node;
+	}
+	return head;
+}
+
+static bool
+list_check(node_t *head) {
+	unsigned n = NNODES;
+	for (node_t *node = head; node != NULL; node = node->next) {
+		n--;
+		if (node->val != n) {
+			return false;
+		}
+		if ((node->large != NULL) != (n % 8 == 0)) {
+			return false;
+		}
+		if (node->large != NULL && (node->large[0] != (unsigned char)n
+		    || node->large[LARGE_SZ - 1] != (unsigned char)n)) {
+			return false;
+		}
+	}
+	return n == 0;
+}
+
+static void
+list_free(unsigned arena_ind, node_t *head) {
+	int flags = flags_base | MALLOCX_ARENA(arena_ind);
+	while (head != NULL) {
+		node_t *next = head->next;
+		if (head->large != NULL) {
+			dallocx(head->large, flags);
+		}
+		dallocx(head, flags);
+		head = next;
+	}
+}
+
+/* Attaches the arena in fd, and checks and frees the list it holds. */
+static void
+list_attach_check(int fd) {
+	unsigned arena_ind;
+	assert_d_eq(arena_create_persistent(fd, &arena_ind), 0,
+	    "Persisted arena should be attached");
+	node_t *head = (node_t *)root_get(arena_ind);
+	assert_ptr_not_null(head, "The root should be persisted");
+	assert_true(list_check(head), "The list should be persisted");
+
+	unsigned lookup_ind;
+	size_t sz = sizeof(lookup_ind);
+	assert_d_eq(mallctl("arenas.lookup", (void *)&lookup_ind, &sz,
+	    (void *)&head, sizeof(head)), 0, "Unexpected mallctl() failure");
+	assert_u_eq(lookup_ind, arena_ind,
+	    "Persisted objects should belong to the attached arena");
+
+	/* The attached arena is fully usable. */
+	list_free(arena_ind, head);
+	head = list_build(arena_ind);
+	assert_ptr_not_null(head, "Unexpected mallocx() failure");
+	assert_true(list_check(head), "Unexpected list contents");
+	list_free(arena_ind, head);
+
+	/* Destroying the arena empties the file. */
+	assert_d_eq(arena_cmd(arena_ind, "destroy"), 0,
+	    "Unexpected mallctl() failure");
+	assert_d_eq(arena_create_persistent(fd, &arena_ind), 0,
+	    "Unexpected mallctl() failure");
+	assert_ptr_null(root_get(arena_ind),
+	    "A new arena should start without a root");
+	assert_d_eq(arena_cmd(arena_ind, "destroy"), 0,
+	    "Unexpected mallctl() failure");
+}
+
+TEST_BEGIN(test_persistent_reattach) {
+	int fd = persistent_file();
+	test_skip_if(fd == -1);
+	unsigned arena_ind;
+	int err = arena_create_persistent(fd, &arena_ind);
+	if (err == EAGAIN || err == ENOENT) {
+		/* Unsupported, or heap profiling is enabled. */
+		close(fd);
+		test_skip_if(true);
+	}
+	assert_d_eq(err, 0, "Unexpected mallctl() failure");
+
+	assert_ptr_null(root_get(arena_ind), "The root should start as NULL");
+	node_t *head = list_build(arena_ind);
+	assert_ptr_not_null(head, "Unexpected mallocx() failure");
+	assert_d_eq(root_set(arena_ind, head), 0,
+	    "Unexpected mallctl() failure");
+	assert_d_eq(arena_cmd(arena_ind, "quiesce"), 0,
+	    "Unexpected mallctl() failure");
+	assert_d_eq(root_set(arena_ind, NULL), EFAULT,
+	    "The quiesced arena should be gone");
+
+	list_attach_check(fd);
+	close(fd);
+}
+TEST_END
+
+/* Finds the bounds of the mapping that contains addr. */
+static bool
+mapping_get(void *addr, uintptr_t *r_start, uintptr_t *r_end) {
+	FILE *maps = fopen("/proc/self/maps", "r");
+	if (maps == NULL) {
+		return true;
+	}
+	bool err = true;
+	char line[512];
+	while (err && fgets(line, sizeof(line), maps) != NULL) {
+		unsigned long start, end;
+		if (sscanf(line, "%lx-%lx", &start, &end) == 2 &&
+		    (uintptr_t)addr >= start && (uintptr_t)addr < end) {
+			*r_start = (uintptr_t)start;
+			*r_end = (uintptr_t)end;
+			err = false;
+		}
+	}
+	fclose(maps);
+	return err;
+}
+
+TEST_BEGIN(test_persistent_reattach_index) {
+	int fd = persistent_file();
+	test_skip_if(fd == -1);
+	unsigned arena_ind;
+	int err = arena_create_persistent(fd, &arena_ind);
+	if (err == EAGAIN || err == ENOENT) {
+		close(fd);
+		test_skip_if(true);
+	}
+	assert_d_eq(err, 0, "Unexpected mallctl() failure");
+
+	node_t *head = list_build(arena_ind);
+	assert_ptr_not_null(head, "Unexpected mallocx() failure");
+	assert_d_eq(root_set(arena_ind, head), 0,
+	    "Unexpected mallctl() failure");
+	uintptr_t start, end;
+	bool no_maps = mapping_get(head, &start, &end);
+	assert_d_eq(arena_cmd(arena_ind, "quiesce"), 0,
+	    "Unexpected mallctl() failure");
+	if (no_maps) {
+		close(fd);
+		test_skip("/proc/self/maps unavailable");
+	}
+
+	/*
+	 * Take the index, so that the arena is attached at another one.  Keep
+	 * the new arena from mapping its memory where the file has to go.
+	 */
+	void *reserved = mmap((void *)start, end - start, PROT_NONE,
+	    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	assert_ptr_eq(reserved, (void *)start,
+	    "The window of the quiesced arena should be free");
+	unsigned plain_ind;
+	size_t sz = sizeof(plain_ind);
+	assert_d_eq(mallctl("arenas.create", (void *)&plain_ind, &sz, NULL, 0),
+	    0, "Unexpected mallctl() failure");
+	assert_u_eq(plain_ind, arena_ind,
+	    "Expected the quiesced arena index to be reused");
+	assert_d_eq(munmap(reserved, end - start), 0,
+	    "Unexpected munmap() failure");
+
+	list_attach_check(fd);
+	assert_d_eq(arena_cmd(plain_ind, "destroy"), 0,
+	    "Unexpected mallctl() failure");
+	close(fd);
+}
+TEST_END
+
+TEST_BEGIN(test_persistent_fork) {
+	int fd = persistent_file();
+	test_skip_if(fd == -1);
+	unsigned arena_ind;
+	int err = arena_create_persistent(fd, &arena_ind);
+	if (err == EAGAIN || err == ENOENT) {
+		close(fd);
+		test_skip_if(true);
+	}
+	assert_d_eq(err, 0, "Unexpected mallctl() failure");
+	/* Start over, so that the arena is created by the child. */
+	assert_d_eq(arena_cmd(arena_ind, "destroy"), 0,
+	    "Unexpected mallctl() failure");
+
+	pid_t pid = fork();
+	assert_d_ne(pid, -1, "Unexpected fork() failure");
+	if (pid == 0) {
+		if (arena_create_persistent(fd, &arena_ind) != 0) {
+			_exit(1);
+		}
+		node_t *head = list_build(arena_ind);
+		if (head == NULL || root_set(arena_ind, head) != 0 ||
+		    arena_cmd(arena_ind, "quiesce") != 0) {
+			_exit(1);
+		}
+		_exit(0);
+	}
+	int status;
+	assert_d_eq(waitpid(pid, &status, 0), pid,
+	    "Unexpected waitpid() failure");
+	assert_true(WIFEXITED(status) && WEXITSTATUS(status) == 0,
+	    "The child failed to persist its arena");
+
+	list_attach_check(fd);
+	close(fd);
+}
+TEST_END
+
+TEST_BEGIN(test_persistent_errors) {
+	unsigned arena_ind;
+	size_t sz = sizeof(arena_ind);
+	assert_d_eq(mallctl("arenas.create_persistent", (void *)&arena_ind,
+	    &sz, NULL, 0), EINVAL, "A file descriptor should be required");
+
+	assert_d_eq(mallctl("arenas.create", (void *)&arena_ind, &sz, NULL, 0),
+	    0, "Unexpected mallctl() failure");
+	assert_d_eq(arena_cmd(arena_ind, "quiesce"), ENOENT,
+	    "Only persistent arenas can be quiesced");
+	assert_d_eq(root_set(arena_ind, NULL), ENOENT,
+	    "Only persistent arenas have a root");
+	assert_d_eq(arena_cmd(arena_ind, "destroy"), 0,
+	    "Unexpected mallctl() failure");
+
+	int fd = persistent_file();
+	test_skip_if(fd == -1);
+	int err = arena_create_persistent(fd, &arena_ind);
+	if (err == EAGAIN || err == ENOENT) {
+		close(fd);
+		test_skip_if(true);
+	}
+	assert_d_eq(err, 0, "Unexpected mallctl() failure");
+	unsigned arena_ind2;
+	assert_d_eq(arena_create_persistent(fd, &arena_ind2), EFAULT,
+	    "An attached arena should not be attached twice");
+	assert_d_eq(arena_cmd(arena_ind, "quiesce"), 0,
+	    "Unexpected mallctl() failure");
+
+	/* A file from an incompatible build is rejected. */
+	uint32_t version, bad_version = UINT32_MAX;
+	assert_zd_eq(pread(fd, &version, sizeof(version), 8), sizeof(version),
+	    "Unexpected pread() failure");
+	assert_zd_eq(pwrite(fd, &bad_version, sizeof(bad_version), 8),
+	    sizeof(bad_version), "Unexpected pwrite() failure");
+	assert_d_eq(arena_create_persistent(fd, &arena_ind), EINVAL,
+	    "Incompatible files should be rejected");
+	assert_zd_eq(pwrite(fd, &version, sizeof(version), 8),
+	    sizeof(version), "Unexpected pwrite() failure");
+
+	assert_d_eq(arena_create_persistent(fd, &arena_ind), 0,
+	    "Unexpected mallctl() failure");
+	assert_d_eq(arena_cmd(arena_ind, "destroy"), 0,
+	    "Unexpected mallctl() failure");
+	close(fd);
+}
+TEST_END
+
+int
+main(void) {
+	return test_no_reentrancy(
+	    test_persistent_reattach,
+	    test_persistent_reattach_index,
+	    test_persistent_fork,
+	    test_persistent_errors);
+}
@@ -0,0 +1,185 @@
+#include "test/jemalloc_test.h"
+
+#define SZ	(ZU(1) << 20)
+
+static uint64_t
+get_arena_u64_stat(unsigned arena_ind, const char *name) {
+	uint64_t epoch = 1;
+	assert_d_eq(mallctl("epoch", NULL, NULL, (void *)&epoch,
+	    sizeof(epoch)), 0, "Unexpected mallctl() failure");
+
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "stats.arenas.%u.%s", arena_ind,
+	    name);
+	uint64_t val;
+	size_t sz = sizeof(val);
+	assert_d_eq(mallctl(cmd, (void *)&val, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return val;
+}
+
+static size_t
+get_arena_pdirty(unsigned arena_ind) {
+	uint64_t epoch = 1;
+	assert_d_eq(mallctl("epoch", NULL, NULL, (void *)&epoch,
+	    sizeof(epoch)), 0, "Unexpected mallctl() failure");
+
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "stats.arenas.%u.pdirty", arena_ind);
+	size_t val;
+	size_t sz = sizeof(val);
+	assert_d_eq(mallctl(cmd, (void *)&val, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return val;
+}
+
+static void
+set_arena_bool(unsigned arena_ind, const char *name, bool val) {
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.%s", arena_ind, name);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&val, sizeof(val)), 0,
+	    "Unexpected mallctl() failure");
+}
+
+static bool
+get_arena_bool(unsigned arena_ind, const char *name) {
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.%s", arena_ind, name);
+	bool val;
+	size_t sz = sizeof(val);
+	assert_d_eq(mallctl(cmd, (void *)&val, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return val;
+}
+
+static unsigned
+do_arena_create(void) {
+	unsigned arena_ind;
+	size_t sz = sizeof(arena_ind);
+	assert_d_eq(mallctl("arenas.create", (void *)&arena_ind, &sz, NULL, 0),
+	    0, "Unexpected mallctl() failure");
+	return arena_ind;
+}
+
+static void
+do_arena_destroy(unsigned arena_ind) {
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.destroy", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+}
+
+static size_t
+nresident(void *ptr, size_t size) {
+	size_t npages;
+	if (pages_nresident((void *)PAGE_ADDR2BASE(ptr), PAGE_CEILING(size),
+	    &npages)) {
+		return SIZE_MAX;
+	}
+	return npages;
+}
+
+TEST_BEGIN(test_prefault_ctl) {
+	unsigned arena_ind = do_arena_create();
+	assert_false(get_arena_bool(arena_ind, "prefault"),
+	    "Prefaulting should be off by default");
+	assert_false(get_arena_bool(arena_ind, "mlock"),
+	    "Locking should be off by default");
+	set_arena_bool(arena_ind, "prefault", true);
+	assert_true(get_arena_bool(arena_ind, "prefault"),
+	    "Unexpected arena.<i>.prefault");
+	do_arena_destroy(arena_ind);
+
+	/* Options passed to arenas.create are in effect from the start. */
+	arena_config_t config = {NULL, true, false, false, -1};
+	unsigned ind;
+	size_t sz = sizeof(ind);
+	assert_d_eq(mallctl("arenas.create", (void *)&ind, &sz,
+	    (void *)&config, sizeof(config)), 0,
+	    "Unexpected mallctl() failure");
+	assert_true(get_arena_bool(ind, "prefault"),
+	    "Unexpected arena.<i>.prefault");
+	assert_false(get_arena_bool(ind, "mlock"), "Unexpected arena.<i>.mlock");
+	do_arena_destroy(ind);
+	arena_ind = do_arena_create();
+	assert_false(get_arena_bool(arena_ind, "prefault"),
+	    "Options should only apply to the arena they were passed for");
+	do_arena_destroy(arena_ind);
+
+	bool t = true;
+	assert_d_eq(mallctl("arena.0.prefault", NULL, NULL, (void *)&t, 1 +
+	    sizeof(t)), EINVAL, "Wrong size should be rejected");
+}
+TEST_END
+
+TEST_BEGIN(test_prefault) {
+	unsigned arena_ind = do_arena_create();
+	set_arena_bool(arena_ind, "prefault", true);
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+
+	void *p = mallocx(SZ, flags);
+	assert_ptr_not_null(p, "Unexpected mallocx() failure");
+	size_t npages = nresident(p, SZ);
+	if (npages != SIZE_MAX) {
+		assert_zu_eq(npages, PAGE_CEILING(SZ) >> LG_PAGE,
+		    "Prefaulted memory should be resident before first use");
+	}
+	if (config_stats) {
+		assert_u64_ge(get_arena_u64_stat(arena_ind, "prefaulted"), SZ,
+		    "Prefaulted bytes should be counted");
+	}
+	dallocx(p, flags);
+	do_arena_destroy(arena_ind);
+}
+TEST_END
+
+TEST_BEGIN(test_mlock) {
+	test_skip_if(!config_stats);
+
+	unsigned arena_ind = do_arena_create();
+	set_arena_bool(arena_ind, "mlock", true);
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+
+	void *p = mallocx(SZ, flags);
+	assert_ptr_not_null(p, "Unexpected mallocx() failure");
+	memset(p, 1, SZ);
+	/* Locking fails past RLIMIT_MEMLOCK, which leaves the pages pageable. */
+	uint64_t mlocked = get_arena_u64_stat(arena_ind, "mlocked");
+	dallocx(p, flags);
+
+	/* Decay never purges a locked arena. */
+	size_t pdirty = get_arena_pdirty(arena_ind);
+	assert_zu_gt(pdirty, 0, "Freed memory should be dirty");
+	char cmd[128];
+	ssize_t decay_ms = 0;
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.dirty_decay_ms",
+	    arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&decay_ms,
+	    sizeof(decay_ms)), 0, "Unexpected mallctl() failure");
+	p = mallocx(SZ, flags);
+	assert_ptr_not_null(p, "Unexpected mallocx() failure");
+	dallocx(p, flags);
+	assert_zu_eq(get_arena_pdirty(arena_ind), pdirty,
+	    "Locked arenas should not be purged by decay");
+
+	/* Explicit purges unlock and purge. */
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.purge", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	assert_zu_eq(get_arena_pdirty(arena_ind), 0,
+	    "Explicit purges should purge locked arenas");
+	if (mlocked > 0) {
+		assert_u64_ge(mlocked, SZ, "Locked bytes should be counted");
+	}
+
+	do_arena_destroy(arena_ind);
+}
+TEST_END
+
+int
+main(void) {
+	return test(
+	    test_prefault_ctl,
+	    test_prefault,
+	    test_mlock);
+}
@@ -0,0 +1,127 @@
+#include "test/jemalloc_test.h"
+
+#include <sys/stat.h>
+
+#define NALLOCS		64
+#define ALLOC_NPAGES	16
+/* Upper bound on how long to wait for the background thread to react. */
+#define WAIT_NS_MAX	(UINT64_C(10) * 1000 * 1000 * 1000)
+#define WAIT_NS_STEP	(10 * 1000 * 1000)
+
+static char fifo_path[PATH_MAX + 1];
+
+static void
+epoch_refresh(void) {
+	uint64_t epoch = 1;
+	assert_d_eq(mallctl("epoch", NULL, NULL, (void *)&epoch,
+	    sizeof(epoch)), 0, "Unexpected mallctl() failure");
+}
+
+static uint64_t
+pressure_events_get(void) {
+	epoch_refresh();
+	uint64_t nevents;
+	size_t sz = sizeof(nevents);
+	assert_d_eq(mallctl("stats.background_thread.pressure_events",
+	    (void *)&nevents, &sz, NULL, 0), 0, "Unexpected mallctl() failure");
+	return nevents;
+}
+
+static size_t
+unpurged_get(unsigned arena_ind) {
+	epoch_refresh();
+	size_t unpurged = 0;
+	const char *names[] = {"pdirty", "pmuzzy"};
+	for (unsigned i = 0; i < sizeof(names)/sizeof(names[0]); i++) {
+		char cmd[128];
+		malloc_snprintf(cmd, sizeof(cmd), "stats.arenas.%u.%s",
+		    arena_ind, names[i]);
+		size_t npages;
+		size_t sz = sizeof(npages);
+		assert_d_eq(mallctl(cmd, (void *)&npages, &sz, NULL, 0), 0,
+		    "Unexpected mallctl() failure");
+		unpurged += npages;
+	}
+	return unpurged;
+}
+
+static void
+background_thread_set(bool enable) {
+	assert_d_eq(mallctl("background_thread", NULL, NULL, (void *)&enable,
+	    sizeof(enable)), 0, "Unexpected mallctl() failure");
+}
+
+static void
+pressure_event_send(int fd) {
+	uint64_t nevents = pressure_events_get();
+	char c = 0;
+	assert_zd_eq(write(fd, &c, 1), 1, "Unexpected write() failure");
+	uint64_t waited;
+	for (waited = 0; pressure_events_get() == nevents && waited <
+	    WAIT_NS_MAX; waited += WAIT_NS_STEP) {
+		mq_nanosleep(WAIT_NS_STEP);
+	}
+	assert_u64_lt(waited, WAIT_NS_MAX, "Pressure event was not observed");
+}
+
+TEST_BEGIN(test_psi_purge) {
+	test_skip_if(!have_background_thread);
+	test_skip_if(!config_stats);
+
+	unsigned arena_ind;
+	size_t sz = sizeof(arena_ind);
+	assert_d_eq(mallctl("arenas.create", (void *)&arena_ind, &sz, NULL, 0),
+	    0, "Unexpected mallctl() failure");
+	char cmd[128];
+	ssize_t decay_ms = 3600 * 1000;
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.dirty_decay_ms", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&decay_ms,
+	    sizeof(decay_ms)), 0, "Unexpected mallctl() failure");
+
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	void *ptrs[NALLOCS];
+	for (unsigned i = 0; i < NALLOCS; i++) {
+		ptrs[i] = mallocx(ALLOC_NPAGES * PAGE, flags);
+		assert_ptr_not_null(ptrs[i], "Unexpected mallocx() failure");
+	}
+	for (unsigned i = 0; i < NALLOCS; i++) {
+		dallocx(ptrs[i], flags);
+	}
+	assert_zu_gt(unpurged_get(arena_ind), 0,
+	    "Freed pages should be retained while decaying");
+
+	/* Stand in for /proc/pressure/memory with a FIFO. */
+	malloc_snprintf(fifo_path, sizeof(fifo_path), "/tmp/jemalloc_psi.%d",
+	    (int)getpid());
+	unlink(fifo_path);
+	assert_d_eq(mkfifo(fifo_path, 0600), 0, "Unexpected mkfifo() failure");
+	int fd = open(fifo_path, O_RDWR | O_NONBLOCK);
+	assert_d_ne(fd, -1, "Unexpected open() failure");
+	opt_psi_purge = true;
+	strncpy(opt_psi_path, fifo_path, sizeof(opt_psi_path) - 1);
+	background_thread_set(true);
+
+	/* Escalate until everything is purged. */
+	for (unsigned i = 0; i < PSI_LEVEL_MAX; i++) {
+		pressure_event_send(fd);
+	}
+	uint64_t waited;
+	for (waited = 0; unpurged_get(arena_ind) > 0 && waited < WAIT_NS_MAX;
+	    waited += WAIT_NS_STEP) {
+		mq_nanosleep(WAIT_NS_STEP);
+	}
+	assert_zu_eq(unpurged_get(arena_ind), 0,
+	    "Sustained pressure should purge all unused pages");
+
+	background_thread_set(false);
+	opt_psi_purge = false;
+	close(fd);
+	unlink(fifo_path);
+}
+TEST_END
+
+int
+main(void) {
+	return test_no_reentrancy(
+	    test_psi_purge);
+}
@@ -0,0 +1,164 @@
+#include "test/jemalloc_test.h"
+
+/* Number of extents freed, and so purged, in each test. */
+#define NEXTENTS	32
+#define EXTENT_NPAGES	4
+
+static unsigned
+arena_create(ssize_t muzzy_decay_ms) {
+	unsigned arena_ind;
+	size_t sz = sizeof(arena_ind);
+	assert_d_eq(mallctl("arenas.create", (void *)&arena_ind, &sz, NULL, 0),
+	    0, "Unexpected mallctl() failure");
+	char cmd[128];
+	ssize_t decay_ms = 10 * 1000;
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.dirty_decay_ms", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&decay_ms,
+	    sizeof(decay_ms)), 0, "Unexpected mallctl() failure");
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.muzzy_decay_ms", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&muzzy_decay_ms,
+	    sizeof(muzzy_decay_ms)), 0, "Unexpected mallctl() failure");
+	return arena_ind;
+}
+
+static uint64_t
+arena_stat_get(unsigned arena_ind, const char *name) {
+	uint64_t epoch = 1;
+	assert_d_eq(mallctl("epoch", NULL, NULL, (void *)&epoch,
+	    sizeof(epoch)), 0, "Unexpected mallctl() failure");
+
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "stats.arenas.%u.%s", arena_ind,
+	    name);
+	uint64_t val;
+	size_t sz = sizeof(val);
+	assert_d_eq(mallctl(cmd, (void *)&val, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return val;
+}
+
+static size_t
+arena_npages_get(unsigned arena_ind, const char *name) {
+	uint64_t epoch = 1;
+	assert_d_eq(mallctl("epoch", NULL, NULL, (void *)&epoch,
+	    sizeof(epoch)), 0, "Unexpected mallctl() failure");
+
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "stats.arenas.%u.%s", arena_ind,
+	    name);
+	size_t val;
+	size_t sz = sizeof(val);
+	assert_d_eq(mallctl(cmd, (void *)&val, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return val;
+}
+
+/*
+ * Leave NEXTENTS dirty extents in the arena, separated by live allocations so
+ * that they cannot coalesce with each other.  The live allocations are
+ * returned in ptrs, and the number of dirty pages is returned.
+ */
+static size_t
+dirty_extents_create(unsigned arena_ind, void **ptrs) {
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	void *freed[NEXTENTS];
+	for (unsigned i = 0; i < NEXTENTS; i++) {
+		freed[i] = mallocx(EXTENT_NPAGES * PAGE, flags);
+		assert_ptr_not_null(freed[i], "Unexpected mallocx() failure");
+		ptrs[i] = mallocx(EXTENT_NPAGES * PAGE, flags);
+		assert_ptr_not_null(ptrs[i], "Unexpected mallocx() failure");
+	}
+	for (unsigned i = 0; i < NEXTENTS; i++) {
+		dallocx(freed[i], flags);
+	}
+	size_t pdirty = arena_npages_get(arena_ind, "pdirty");
+	assert_zu_ge(pdirty, NEXTENTS * EXTENT_NPAGES,
+	    "Freed extents should be dirty");
+	return pdirty;
+}
+
+static void
+dirty_decay_flush(unsigned arena_ind) {
+	char cmd[128];
+	ssize_t decay_ms = 0;
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.dirty_decay_ms", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&decay_ms,
+	    sizeof(decay_ms)), 0, "Unexpected mallctl() failure");
+	assert_zu_eq(arena_npages_get(arena_ind, "pdirty"), 0,
+	    "All dirty pages should have been purged");
+}
+
+static void
+live_extents_destroy(unsigned arena_ind, void **ptrs) {
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	for (unsigned i = 0; i < NEXTENTS; i++) {
+		dallocx(ptrs[i], flags);
+	}
+}
+
+TEST_BEGIN(test_purge_batch_lazy) {
+	test_skip_if(!config_stats);
+	test_skip_if(!pages_can_purge_lazy);
+
+	unsigned arena_ind = arena_create(10 * 1000);
+	void *ptrs[NEXTENTS];
+	size_t pdirty = dirty_extents_create(arena_ind, ptrs);
+
+	uint64_t nmadvise = arena_stat_get(arena_ind, "dirty_nmadvise");
+	uint64_t nsaved = arena_stat_get(arena_ind, "dirty_nmadvise_saved");
+	dirty_decay_flush(arena_ind);
+	nmadvise = arena_stat_get(arena_ind, "dirty_nmadvise") - nmadvise;
+	nsaved = arena_stat_get(arena_ind, "dirty_nmadvise_saved") - nsaved;
+
+	assert_zu_eq(arena_npages_get(arena_ind, "pmuzzy"), pdirty,
+	    "Purged pages should have become muzzy");
+	assert_u64_eq(nmadvise + nsaved, NEXTENTS,
+	    "Every extent should be purged either alone or in a batch");
+	if (pages_purge_batch_enabled(true)) {
+		assert_u64_eq(nsaved, NEXTENTS - 1,
+		    "All extents should have been purged with one call");
+	} else {
+		assert_u64_eq(nsaved, 0, "Batching is unavailable");
+	}
+
+	live_extents_destroy(arena_ind, ptrs);
+}
+TEST_END
+
+TEST_BEGIN(test_purge_batch_forced) {
+	test_skip_if(!config_stats);
+
+	unsigned arena_ind = arena_create(0);
+	void *ptrs[NEXTENTS];
+	dirty_extents_create(arena_ind, ptrs);
+
+	uint64_t nmadvise = arena_stat_get(arena_ind, "dirty_nmadvise");
+	uint64_t nsaved = arena_stat_get(arena_ind, "dirty_nmadvise_saved");
+	dirty_decay_flush(arena_ind);
+	nmadvise = arena_stat_get(arena_ind, "dirty_nmadvise") - nmadvise;
+	nsaved = arena_stat_get(arena_ind, "dirty_nmadvise_saved") - nsaved;
+
+	assert_zu_eq(arena_npages_get(arena_ind, "pmuzzy"), 0,
+	    "Muzzy decay is disabled");
+	assert_u64_eq(nmadvise + nsaved, NEXTENTS,
+	    "Every extent should be purged either alone or in a batch");
+	bool retain;
+	size_t sz = sizeof(retain);
+	assert_d_eq(mallctl("opt.retain", (void *)&retain, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	if (pages_purge_batch_enabled(false) && retain &&
+	    !pages_decommit_enabled()) {
+		assert_u64_eq(nsaved, NEXTENTS - 1,
+		    "All extents should have been purged with one call");
+	}
+
+	live_extents_destroy(arena_ind, ptrs);
+}
+TEST_END
+
+int
+main(void) {
+	return test(
+	    test_purge_batch_lazy,
+	    test_purge_batch_forced);
+}
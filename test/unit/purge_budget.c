@@ -0,0 +1,153 @@
+#include "test/jemalloc_test.h"
+
+#include "jemalloc/internal/purge_budget.h"
+
+#define NEXTENTS	32
+#define EXTENT_NPAGES	16
+
+static void
+epoch_refresh(void) {
+	uint64_t epoch = 1;
+	assert_d_eq(mallctl("epoch", NULL, NULL, (void *)&epoch,
+	    sizeof(epoch)), 0, "Unexpected mallctl() failure");
+}
+
+static size_t
+pdirty_get(unsigned arena_ind) {
+	epoch_refresh();
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "stats.arenas.%u.pdirty", arena_ind);
+	size_t pdirty;
+	size_t sz = sizeof(pdirty);
+	assert_d_eq(mallctl(cmd, (void *)&pdirty, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return pdirty;
+}
+
+static size_t
+debt_get(void) {
+	epoch_refresh();
+	size_t debt;
+	size_t sz = sizeof(debt);
+	assert_d_eq(mallctl("stats.purge_budget.debt", (void *)&debt, &sz,
+	    NULL, 0), 0, "Unexpected mallctl() failure");
+	return debt;
+}
+
+static uint64_t
+u64_stat_get(const char *name) {
+	epoch_refresh();
+	uint64_t val;
+	size_t sz = sizeof(val);
+	assert_d_eq(mallctl(name, (void *)&val, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return val;
+}
+
+static void
+decay_ms_set(unsigned arena_ind, const char *name, ssize_t decay_ms) {
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.%s", arena_ind, name);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&decay_ms,
+	    sizeof(decay_ms)), 0, "Unexpected mallctl() failure");
+}
+
+/*
+ * Leave NEXTENTS dirty extents in a new arena, separated by live allocations
+ * so that they cannot coalesce, and return the arena index.
+ */
+static unsigned
+dirty_arena_create(void **ptrs) {
+	unsigned arena_ind;
+	size_t sz = sizeof(arena_ind);
+	assert_d_eq(mallctl("arenas.create", (void *)&arena_ind, &sz, NULL, 0),
+	    0, "Unexpected mallctl() failure");
+	decay_ms_set(arena_ind, "dirty_decay_ms", 10 * 1000);
+	decay_ms_set(arena_ind, "muzzy_decay_ms", 0);
+
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	void *freed[NEXTENTS];
+	for (unsigned i = 0; i < NEXTENTS; i++) {
+		freed[i] = mallocx(EXTENT_NPAGES * PAGE, flags);
+		assert_ptr_not_null(freed[i], "Unexpected mallocx() failure");
+		ptrs[i] = mallocx(EXTENT_NPAGES * PAGE, flags);
+		assert_ptr_not_null(ptrs[i], "Unexpected mallocx() failure");
+	}
+	for (unsigned i = 0; i < NEXTENTS; i++) {
+		dallocx(freed[i], flags);
+	}
+	assert_zu_ge(pdirty_get(arena_ind), NEXTENTS * EXTENT_NPAGES,
+	    "Freed extents should be dirty");
+	return arena_ind;
+}
+
+static void
+dirty_arena_destroy(unsigned arena_ind, void **ptrs) {
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	for (unsigned i = 0; i < NEXTENTS; i++) {
+		dallocx(ptrs[i], flags);
+	}
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.destroy", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+}
+
+/*
+ * Ask for everything to be purged, and check that the budget held most of it
+ * back.  Then lift the budget and check that the rest gets purged.
+ */
+static void
+throttled_purge_check(unsigned arena_ind, size_t *opt) {
+	uint64_t nthrottled = u64_stat_get("stats.purge_budget.nthrottled");
+	decay_ms_set(arena_ind, "dirty_decay_ms", 0);
+
+	size_t pdirty = pdirty_get(arena_ind);
+	assert_zu_ge(pdirty, (NEXTENTS - 1) * EXTENT_NPAGES,
+	    "At most one extent should have been purged");
+	assert_u64_gt(u64_stat_get("stats.purge_budget.nthrottled"),
+	    nthrottled, "The purge should have been throttled");
+	size_t debt = debt_get();
+	assert_zu_ge(debt, pdirty << LG_PAGE,
+	    "Pages held back should be reported as debt");
+
+	*opt = 0;
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.decay", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	assert_zu_eq(pdirty_get(arena_ind), 0,
+	    "Without a budget, all dirty pages should be purged");
+	assert_zu_le(debt_get(), debt - (pdirty << LG_PAGE),
+	    "Debt should be repaid");
+}
+
+TEST_BEGIN(test_purge_call_max) {
+	test_skip_if(!config_stats);
+
+	void *ptrs[NEXTENTS];
+	unsigned arena_ind = dirty_arena_create(ptrs);
+	opt_purge_call_max = EXTENT_NPAGES * PAGE;
+	throttled_purge_check(arena_ind, &opt_purge_call_max);
+	dirty_arena_destroy(arena_ind, ptrs);
+}
+TEST_END
+
+TEST_BEGIN(test_purge_rate) {
+	test_skip_if(!config_stats);
+
+	void *ptrs[NEXTENTS];
+	unsigned arena_ind = dirty_arena_create(ptrs);
+	/* Purging one extent overdraws the bucket for many seconds. */
+	opt_purge_rate = PAGE;
+	throttled_purge_check(arena_ind, &opt_purge_rate);
+	dirty_arena_destroy(arena_ind, ptrs);
+}
+TEST_END
+
+int
+main(void) {
+	return test(
+	    test_purge_call_max,
+	    test_purge_rate);
+}
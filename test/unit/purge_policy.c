@@ -0,0 +1,208 @@
+#include "test/jemalloc_test.h"
+
+#define NALLOCS		8
+#define ALLOC_NPAGES	16
+
+static unsigned
+do_arena_create(void) {
+	unsigned arena_ind;
+	size_t sz = sizeof(unsigned);
+	assert_d_eq(mallctl("arenas.create", (void *)&arena_ind, &sz, NULL, 0),
+	    0, "Unexpected mallctl() failure");
+
+	size_t mib[3];
+	size_t miblen = sizeof(mib)/sizeof(size_t);
+	ssize_t decay_ms = 10 * 1000;
+	assert_d_eq(mallctlnametomib("arena.0.dirty_decay_ms", mib, &miblen),
+	    0, "Unexpected mallctlnametomib() failure");
+	mib[1] = (size_t)arena_ind;
+	assert_d_eq(mallctlbymib(mib, miblen, NULL, NULL, (void *)&decay_ms,
+	    sizeof(decay_ms)), 0, "Unexpected mallctlbymib() failure");
+
+	return arena_ind;
+}
+
+static void
+do_arena_destroy(unsigned arena_ind) {
+	size_t mib[3];
+	size_t miblen = sizeof(mib)/sizeof(size_t);
+	assert_d_eq(mallctlnametomib("arena.0.destroy", mib, &miblen), 0,
+	    "Unexpected mallctlnametomib() failure");
+	mib[1] = (size_t)arena_ind;
+	assert_d_eq(mallctlbymib(mib, miblen, NULL, NULL, NULL, 0), 0,
+	    "Unexpected mallctlbymib() failure");
+}
+
+static void
+policy_set(unsigned arena_ind, const char *policy) {
+	size_t mib[3];
+	size_t miblen = sizeof(mib)/sizeof(size_t);
+	assert_d_eq(mallctlnametomib("arena.0.purge_policy", mib, &miblen), 0,
+	    "Unexpected mallctlnametomib() failure");
+	mib[1] = (size_t)arena_ind;
+	assert_d_eq(mallctlbymib(mib, miblen, NULL, NULL, (void *)&policy,
+	    sizeof(policy)), 0, "Unexpected mallctlbymib() failure");
+}
+
+static void
+param_set(unsigned arena_ind, const char *name, size_t val) {
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.%s", arena_ind, name);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&val, sizeof(val)), 0,
+	    "Unexpected mallctl() failure");
+}
+
+static size_t
+pdirty_get(unsigned arena_ind) {
+	uint64_t epoch = 1;
+	assert_d_eq(mallctl("epoch", NULL, NULL, (void *)&epoch,
+	    sizeof(epoch)), 0, "Unexpected mallctl() failure");
+
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "stats.arenas.%u.pdirty", arena_ind);
+	size_t pdirty;
+	size_t sz = sizeof(pdirty);
+	assert_d_eq(mallctl(cmd, (void *)&pdirty, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return pdirty;
+}
+
+/* Allocate and free NALLOCS large extents, returning the resulting pdirty. */
+static size_t
+churn(unsigned arena_ind) {
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	void *ptrs[NALLOCS];
+
+	for (unsigned i = 0; i < NALLOCS; i++) {
+		ptrs[i] = mallocx(ALLOC_NPAGES * PAGE, flags);
+		assert_ptr_not_null(ptrs[i], "Unexpected mallocx() failure");
+	}
+	for (unsigned i = 0; i < NALLOCS; i++) {
+		dallocx(ptrs[i], flags);
+	}
+	return pdirty_get(arena_ind);
+}
+
+TEST_BEGIN(test_purge_policy_ctl) {
+	unsigned arena_ind = do_arena_create();
+	size_t mib[3];
+	size_t miblen = sizeof(mib)/sizeof(size_t);
+	assert_d_eq(mallctlnametomib("arena.0.purge_policy", mib, &miblen), 0,
+	    "Unexpected mallctlnametomib() failure");
+	mib[1] = (size_t)arena_ind;
+
+	const char *policy_old, *policy_new = "hybrid";
+	size_t sz = sizeof(policy_old);
+	assert_d_eq(mallctlbymib(mib, miblen, (void *)&policy_old, &sz,
+	    (void *)&policy_new, sizeof(policy_new)), 0,
+	    "Unexpected mallctlbymib() failure");
+	assert_str_eq(policy_old, purge_policy_names[opt_purge_policy],
+	    "Unexpected default purge_policy");
+	assert_d_eq(mallctlbymib(mib, miblen, (void *)&policy_old, &sz, NULL,
+	    0), 0, "Unexpected mallctlbymib() failure");
+	assert_str_eq(policy_old, "hybrid", "Unexpected purge_policy");
+
+	policy_new = "bogus";
+	assert_d_eq(mallctlbymib(mib, miblen, NULL, NULL, (void *)&policy_new,
+	    sizeof(policy_new)), EINVAL, "Invalid policy should be rejected");
+
+	const char *params[] = {"purge_max_dirty", "purge_dirty_ratio",
+	    "purge_floor"};
+	for (unsigned i = 0; i < sizeof(params)/sizeof(params[0]); i++) {
+		char cmd[128];
+		malloc_snprintf(cmd, sizeof(cmd), "arena.%u.%s", arena_ind,
+		    params[i]);
+		size_t val_old, val_new = 12345;
+		sz = sizeof(val_old);
+		assert_d_eq(mallctl(cmd, (void *)&val_old, &sz,
+		    (void *)&val_new, sizeof(val_new)), 0,
+		    "Unexpected mallctl() failure");
+		assert_d_eq(mallctl(cmd, (void *)&val_old, &sz, NULL, 0), 0,
+		    "Unexpected mallctl() failure");
+		assert_zu_eq(val_old, val_new, "Unexpected %s", params[i]);
+	}
+
+	do_arena_destroy(arena_ind);
+}
+TEST_END
+
+TEST_BEGIN(test_purge_policy_smoothstep) {
+	unsigned arena_ind = do_arena_create();
+	policy_set(arena_ind, "smoothstep");
+
+	assert_zu_gt(churn(arena_ind), 0,
+	    "Dirty pages should be retained until they decay");
+
+	do_arena_destroy(arena_ind);
+}
+TEST_END
+
+TEST_BEGIN(test_purge_policy_max_dirty) {
+	unsigned arena_ind = do_arena_create();
+	policy_set(arena_ind, "max_dirty");
+
+	size_t max_npages = ALLOC_NPAGES * 2;
+	param_set(arena_ind, "purge_max_dirty", max_npages * PAGE);
+	assert_zu_le(churn(arena_ind), max_npages,
+	    "Dirty pages should be capped immediately");
+
+	param_set(arena_ind, "purge_max_dirty", 0);
+	assert_zu_eq(pdirty_get(arena_ind), 0,
+	    "Lowering the cap should purge immediately");
+
+	param_set(arena_ind, "purge_max_dirty", SIZE_T_MAX);
+	assert_zu_gt(churn(arena_ind), 0,
+	    "Dirty pages below the cap should be retained");
+
+	do_arena_destroy(arena_ind);
+}
+TEST_END
+
+TEST_BEGIN(test_purge_policy_ratio) {
+	unsigned arena_ind = do_arena_create();
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	policy_set(arena_ind, "ratio");
+
+	/* Keep some pages active so that the ratio has something to scale. */
+	void *p = mallocx(NALLOCS * ALLOC_NPAGES * PAGE, flags);
+	assert_ptr_not_null(p, "Unexpected mallocx() failure");
+
+	param_set(arena_ind, "purge_dirty_ratio", 25);
+	assert_zu_le(churn(arena_ind), NALLOCS * ALLOC_NPAGES / 4 + 1,
+	    "Dirty pages should be capped relative to active pages");
+
+	param_set(arena_ind, "purge_dirty_ratio", 0);
+	assert_zu_eq(pdirty_get(arena_ind), 0,
+	    "A zero ratio should purge all dirty pages");
+
+	dallocx(p, flags);
+	do_arena_destroy(arena_ind);
+}
+TEST_END
+
+TEST_BEGIN(test_purge_policy_floor) {
+	unsigned arena_ind = do_arena_create();
+	policy_set(arena_ind, "max_dirty");
+	param_set(arena_ind, "purge_max_dirty", 0);
+	param_set(arena_ind, "purge_floor", SIZE_T_MAX);
+
+	size_t pdirty = churn(arena_ind);
+	assert_zu_gt(pdirty, 0, "Nothing should be purged below the floor");
+
+	param_set(arena_ind, "purge_floor", 0);
+	assert_zu_eq(pdirty_get(arena_ind), 0,
+	    "Removing the floor should purge down to the cap");
+
+	do_arena_destroy(arena_ind);
+}
+TEST_END
+
+int
+main(void) {
+	return test(
+	    test_purge_policy_ctl,
+	    test_purge_policy_smoothstep,
+	    test_purge_policy_max_dirty,
+	    test_purge_policy_ratio,
+	    test_purge_policy_floor);
+}
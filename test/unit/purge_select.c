@@ -0,0 +1,295 @@
+#include "test/jemalloc_test.h"
+
+#include "jemalloc/internal/cgroup.h"
+
+#include <sys/stat.h>
+
+#define NALLOCS		16
+#define ALLOC_SIZE	(ZU(64) << 10)
+#define LIMIT		(ZU(64) << 20)
+
+static char root[PATH_MAX + 1];
+
+static void
+file_write(const char *dir, const char *name, const char *val) {
+	char path[PATH_MAX + 1];
+	malloc_snprintf(path, sizeof(path), "%s/%s", dir, name);
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	assert_d_ne(fd, -1, "Unexpected open() failure");
+	assert_zd_eq(write(fd, val, strlen(val)), (ssize_t)strlen(val),
+	    "Unexpected write() failure");
+	close(fd);
+}
+
+static void
+file_remove(const char *dir, const char *name) {
+	char path[PATH_MAX + 1];
+	malloc_snprintf(path, sizeof(path), "%s/%s", dir, name);
+	unlink(path);
+}
+
+/* Same limit and usage for cgroup v2 and v1; see test/unit/cgroup.c. */
+static void
+cgroup_set(const char *limit, size_t usage) {
+	char v1[PATH_MAX + 1];
+	malloc_snprintf(v1, sizeof(v1), "%s/memory", root);
+	char usage_str[32];
+	malloc_snprintf(usage_str, sizeof(usage_str), "%zu\n", usage);
+
+	file_write(root, "memory.max", limit);
+	file_write(root, "memory.current", usage_str);
+	file_write(v1, "memory.limit_in_bytes", strcmp(limit, "max\n") == 0 ?
+	    "9223372036854771712\n" : limit);
+	file_write(v1, "memory.usage_in_bytes", usage_str);
+}
+
+static void
+epoch_refresh(void) {
+	uint64_t epoch = 1;
+	assert_d_eq(mallctl("epoch", NULL, NULL, (void *)&epoch,
+	    sizeof(epoch)), 0, "Unexpected mallctl() failure");
+}
+
+static void
+fake_hierarchy_create(void) {
+	malloc_snprintf(root, sizeof(root), "/tmp/jemalloc_cgroup.%d",
+	    (int)getpid());
+	char v1[PATH_MAX + 1];
+	malloc_snprintf(v1, sizeof(v1), "%s/memory", root);
+	assert_d_eq(mkdir(root, 0700), 0, "Unexpected mkdir() failure");
+	assert_d_eq(mkdir(v1, 0700), 0, "Unexpected mkdir() failure");
+	malloc_snprintf(opt_cgroup_root, sizeof(opt_cgroup_root), "%s", root);
+	opt_cgroup_aware = true;
+}
+
+static void
+fake_hierarchy_destroy(void) {
+	cgroup_set("max\n", 0);
+	epoch_refresh();
+	opt_cgroup_aware = false;
+
+	char v1[PATH_MAX + 1];
+	malloc_snprintf(v1, sizeof(v1), "%s/memory", root);
+	file_remove(v1, "memory.limit_in_bytes");
+	file_remove(v1, "memory.usage_in_bytes");
+	file_remove(root, "memory.max");
+	file_remove(root, "memory.current");
+	rmdir(v1);
+	rmdir(root);
+}
+
+static uint64_t
+arena_stat_get(unsigned arena_ind, const char *name) {
+	epoch_refresh();
+
+	char cmd[128];
+	uint64_t val;
+	size_t sz = sizeof(val);
+	malloc_snprintf(cmd, sizeof(cmd), "stats.arenas.%u.%s", arena_ind,
+	    name);
+	assert_d_eq(mallctl(cmd, (void *)&val, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return val;
+}
+
+static void
+decay_ms_set(unsigned arena_ind, const char *name, ssize_t decay_ms) {
+	char cmd[64];
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.%s", arena_ind, name);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&decay_ms,
+	    sizeof(decay_ms)), 0, "Unexpected mallctl() failure");
+}
+
+static void
+purge_select_set(unsigned arena_ind, const char *purge_select) {
+	char cmd[64];
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.purge_select", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&purge_select,
+	    sizeof(purge_select)), 0, "Unexpected mallctl() failure");
+}
+
+/*
+ * Dirty pages are purged right away, by a zero cap rather than a zero decay
+ * time (which purges exhaustively, and therefore forcibly); muzzy pages are
+ * kept.
+ */
+static unsigned
+arena_create(const char *purge_select) {
+	unsigned arena_ind;
+	size_t sz = sizeof(arena_ind);
+	assert_d_eq(mallctl("arenas.create", (void *)&arena_ind, &sz, NULL, 0),
+	    0, "Unexpected mallctl() failure");
+	decay_ms_set(arena_ind, "dirty_decay_ms", 3600 * 1000);
+	decay_ms_set(arena_ind, "muzzy_decay_ms", -1);
+
+	char cmd[64];
+	const char *purge_policy = "max_dirty";
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.purge_policy", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&purge_policy,
+	    sizeof(purge_policy)), 0, "Unexpected mallctl() failure");
+	size_t max_dirty = 0;
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.purge_max_dirty",
+	    arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&max_dirty,
+	    sizeof(max_dirty)), 0, "Unexpected mallctl() failure");
+
+	purge_select_set(arena_ind, purge_select);
+	return arena_ind;
+}
+
+static void
+dirty_pages_purge(unsigned arena_ind) {
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	void *ptrs[NALLOCS];
+	for (unsigned i = 0; i < NALLOCS; i++) {
+		ptrs[i] = mallocx(ALLOC_SIZE, flags);
+		assert_ptr_not_null(ptrs[i], "Unexpected mallocx() failure");
+	}
+	for (unsigned i = 0; i < NALLOCS; i++) {
+		dallocx(ptrs[i], flags);
+	}
+}
+
+TEST_BEGIN(test_purge_select_ctl) {
+	unsigned arena_ind;
+	size_t sz = sizeof(arena_ind);
+	assert_d_eq(mallctl("arenas.create", (void *)&arena_ind, &sz, NULL, 0),
+	    0, "Unexpected mallctl() failure");
+	char cmd[64];
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.purge_select", arena_ind);
+
+	const char *purge_select_old, *purge_select_new = "adaptive";
+	sz = sizeof(purge_select_old);
+	assert_d_eq(mallctl(cmd, (void *)&purge_select_old, &sz,
+	    (void *)&purge_select_new, sizeof(purge_select_new)), 0,
+	    "Unexpected mallctl() failure");
+	assert_str_eq(purge_select_old, purge_select_names[opt_purge_select],
+	    "Unexpected default purge_select");
+	assert_d_eq(mallctl(cmd, (void *)&purge_select_old, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	assert_str_eq(purge_select_old, "adaptive",
+	    "Unexpected purge_select");
+
+	purge_select_new = "never";
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&purge_select_new,
+	    sizeof(purge_select_new)), EINVAL,
+	    "Invalid purge_select should be rejected");
+}
+TEST_END
+
+TEST_BEGIN(test_purge_select_static) {
+	test_skip_if(!config_stats);
+
+	unsigned arena_ind = arena_create("static");
+	dirty_pages_purge(arena_ind);
+	assert_u64_gt(arena_stat_get(arena_ind, "lazy_nselected"), 0,
+	    "Dirty pages should be purged lazily");
+	assert_u64_ge(arena_stat_get(arena_ind, "lazy_purged"),
+	    NALLOCS * ALLOC_SIZE, "Unexpected lazily purged bytes");
+	assert_u64_eq(arena_stat_get(arena_ind, "forced_nselected"), 0,
+	    "Static selection should not purge dirty pages forcibly");
+
+	/* Sampling is left to adaptive selection. */
+	decay_ms_set(arena_ind, "muzzy_decay_ms", 0);
+	assert_u64_eq(arena_stat_get(arena_ind, "lazy_reclaimed"), 0,
+	    "Static selection should not sample lazily purged pages");
+}
+TEST_END
+
+TEST_BEGIN(test_purge_select_adaptive) {
+	test_skip_if(!config_stats);
+
+	unsigned arena_ind = arena_create("adaptive");
+	/* No pressure: same as static selection. */
+	dirty_pages_purge(arena_ind);
+	uint64_t lazy_nselected = arena_stat_get(arena_ind, "lazy_nselected");
+	assert_u64_gt(lazy_nselected, 0,
+	    "Dirty pages should be purged lazily without memory pressure");
+	assert_u64_eq(arena_stat_get(arena_ind, "forced_nselected"), 0,
+	    "Unexpected forced purge without memory pressure");
+	/* Purging the muzzy pages samples how many were reclaimed. */
+	decay_ms_set(arena_ind, "muzzy_decay_ms", 0);
+	assert_u64_le(arena_stat_get(arena_ind, "lazy_reclaimed"),
+	    arena_stat_get(arena_ind, "lazy_purged"),
+	    "Cannot reclaim more than was purged");
+	decay_ms_set(arena_ind, "muzzy_decay_ms", -1);
+
+	fake_hierarchy_create();
+	char limit[32];
+	malloc_snprintf(limit, sizeof(limit), "%zu\n", LIMIT);
+	/* Leave less headroom than opt.cgroup_unpurged_ratio allows for. */
+	cgroup_set(limit, LIMIT - (ZU(1) << 20));
+	epoch_refresh();
+	assert_true(cgroup_headroom_low_get(), "Headroom should be low");
+
+	dirty_pages_purge(arena_ind);
+	uint64_t forced_nselected = arena_stat_get(arena_ind,
+	    "forced_nselected");
+	if (arena_stat_get(arena_ind, "lazy_reclaimed") == 0) {
+		/*
+		 * Nothing was seen reclaimed, so lazy purging cannot help,
+		 * other than to resample.
+		 */
+		assert_u64_gt(forced_nselected, 0,
+		    "Dirty pages should be purged forcibly under pressure");
+		assert_u64_le((arena_stat_get(arena_ind, "lazy_nselected") -
+		    lazy_nselected) * (PURGE_SELECT_RESAMPLE_INTERVAL - 1),
+		    forced_nselected, "Unexpected lazy purge under pressure");
+		assert_u64_ge(arena_stat_get(arena_ind, "forced_purged"),
+		    NALLOCS * ALLOC_SIZE, "Unexpected forcibly purged bytes");
+	}
+
+	fake_hierarchy_destroy();
+	assert_false(cgroup_headroom_low_get(), "Headroom should be restored");
+	dirty_pages_purge(arena_ind);
+	assert_u64_gt(arena_stat_get(arena_ind, "lazy_nselected"),
+	    lazy_nselected, "Lazy purging should resume once pressure clears");
+	assert_u64_eq(arena_stat_get(arena_ind, "forced_nselected"),
+	    forced_nselected, "Unexpected forced purge after pressure cleared");
+}
+TEST_END
+
+TEST_BEGIN(test_purge_select_resample) {
+	test_skip_if(!config_stats);
+
+	unsigned arena_ind = arena_create("adaptive");
+	arena_t *arena = arena_get(tsdn_fetch(), arena_ind, false);
+	fake_hierarchy_create();
+	char limit[32];
+	malloc_snprintf(limit, sizeof(limit), "%zu\n", LIMIT);
+	cgroup_set(limit, LIMIT - (ZU(1) << 20));
+	epoch_refresh();
+	assert_true(cgroup_headroom_low_get(), "Headroom should be low");
+
+	/*
+	 * Without samples, purges are forced, but some must still be lazy so
+	 * that the kernel's reclaim can be sampled again.  Stop right after a
+	 * lazy one, before the next round reuses its (muzzy) pages.
+	 */
+	for (unsigned i = 0; i < 2 * PURGE_SELECT_RESAMPLE_INTERVAL &&
+	    arena_stat_get(arena_ind, "lazy_nselected") == 0; i++) {
+		dirty_pages_purge(arena_ind);
+	}
+	assert_u64_gt(arena_stat_get(arena_ind, "lazy_nselected"), 0,
+	    "Forced purging should periodically purge lazily to resample");
+	assert_u64_ge(arena_stat_get(arena_ind, "forced_nselected"),
+	    PURGE_SELECT_RESAMPLE_INTERVAL - 1,
+	    "Dirty pages should be purged forcibly under pressure");
+	assert_zu_eq(atomic_load_zu(&arena->lazy_nsampled, ATOMIC_RELAXED), 0,
+	    "Nothing should have been sampled yet");
+	decay_ms_set(arena_ind, "muzzy_decay_ms", 0);
+	assert_zu_gt(atomic_load_zu(&arena->lazy_nsampled, ATOMIC_RELAXED), 0,
+	    "Lazily purged pages should have been sampled");
+
+	fake_hierarchy_destroy();
+}
+TEST_END
+
+int
+main(void) {
+	return test(
+	    test_purge_select_ctl,
+	    test_purge_select_static,
+	    test_purge_select_adaptive,
+	    test_purge_select_resample);
+}
@@ -0,0 +1,77 @@
+#include "test/jemalloc_test.h"
+
+#include "jemalloc/internal/extent_mmap.h"
+
+static size_t
+reserve_va_get(void) {
+	size_t reserve_va;
+	size_t sz = sizeof(reserve_va);
+	assert_d_eq(mallctl("opt.reserve_va", (void *)&reserve_va, &sz, NULL,
+	    0), 0, "Unexpected mallctl() failure");
+	return reserve_va;
+}
+
+static unsigned
+arena_lookup(void *ptr) {
+	unsigned arena_ind;
+	size_t sz = sizeof(arena_ind);
+	assert_d_eq(mallctl("arenas.lookup", (void *)&arena_ind, &sz,
+	    (void *)&ptr, sizeof(ptr)), 0, "Unexpected mallctl() failure");
+	return arena_ind;
+}
+
+TEST_BEGIN(test_reserve_va) {
+	test_skip_if(reserve_va_get() == 0);
+	/* The reservation may fail on platforms short of address space. */
+	test_skip_if(extents_rtree.flat_size == 0);
+	assert_zu_ge(extents_rtree.flat_size, reserve_va_get(),
+	    "The whole reservation should be covered by the flat leaf");
+
+	int flags = MALLOCX_ARENA(0) | MALLOCX_TCACHE_NONE;
+	size_t sizes[] = {1, SMALL_MAXCLASS, LARGE_MINCLASS, ZU(4) << 20};
+	for (unsigned i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++) {
+		void *p = mallocx(sizes[i], flags);
+		assert_ptr_not_null(p, "Unexpected mallocx() failure");
+		assert_true(extent_mmap_reserved(p),
+		    "Allocation should come from the reserved region");
+		assert_zu_eq(sallocx(p, flags), sz_s2u(sizes[i]),
+		    "Unexpected sallocx() result");
+		assert_u_eq(arena_lookup(p), 0, "Unexpected arena");
+		dallocx(p, flags);
+	}
+
+	/* Unused parts of the region do not belong to jemalloc. */
+	void *unused = (void *)(extents_rtree.flat_base +
+	    extents_rtree.flat_size - PAGE);
+	assert_zu_eq(ivsalloc(tsdn_fetch(), unused), 0,
+	    "Unused parts of the region should not be owned");
+}
+TEST_END
+
+TEST_BEGIN(test_reserve_va_exhausted) {
+	test_skip_if(reserve_va_get() == 0);
+	test_skip_if(extents_rtree.flat_size == 0);
+
+	/*
+	 * Allocations that do not fit fall back to separate mappings.  Ask for
+	 * zeroed memory, so that junk filling does not touch all of it.
+	 */
+	int flags = MALLOCX_ARENA(0) | MALLOCX_TCACHE_NONE | MALLOCX_ZERO;
+	size_t sz = extents_rtree.flat_size + LARGE_MINCLASS;
+	void *p = mallocx(sz, flags);
+	test_skip_if(p == NULL);
+	assert_false(extent_mmap_reserved(p),
+	    "Allocation should not fit into the reserved region");
+	assert_zu_eq(sallocx(p, flags), sz_s2u(sz),
+	    "Unexpected sallocx() result");
+	assert_u_eq(arena_lookup(p), 0, "Unexpected arena");
+	dallocx(p, flags);
+}
+TEST_END
+
+int
+main(void) {
+	return test(
+	    test_reserve_va,
+	    test_reserve_va_exhausted);
+}
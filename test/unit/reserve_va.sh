@@ -0,0 +1,3 @@
+#!/bin/sh
+
+export MALLOC_CONF="reserve_va:67108864"
@@ -0,0 +1,265 @@
+#include "test/jemalloc_test.h"
+
+const char *malloc_conf = "max_background_threads:1";
+
+#define NALLOCS		16
+#define ALLOC_SIZE	(ZU(1) << 20)
+
+static extent_hooks_t *default_hooks;
+static extent_hooks_t hooks;
+static bool fail_alloc;
+static unsigned ndestroy;
+
+static void *
+hooks_alloc(extent_hooks_t *extent_hooks, void *new_addr, size_t size,
+    size_t alignment, bool *zero, bool *commit, unsigned arena_ind) {
+	if (fail_alloc) {
+		fail_alloc = false;
+		return NULL;
+	}
+	/* The arena may not be initialized yet while its base is mapped. */
+	return default_hooks->alloc(default_hooks, new_addr, size, alignment,
+	    zero, commit, 0);
+}
+
+static void
+hooks_destroy(extent_hooks_t *extent_hooks, void *addr, size_t size,
+    bool committed, unsigned arena_ind) {
+	ndestroy++;
+	default_hooks->destroy(default_hooks, addr, size, committed, arena_ind);
+}
+
+static bool
+hooks_merge(extent_hooks_t *extent_hooks, void *addr_a, size_t size_a,
+    void *addr_b, size_t size_b, bool committed, unsigned arena_ind) {
+	return true;
+}
+
+static bool
+retain_enabled(void) {
+	bool retain;
+	size_t sz = sizeof(retain);
+	assert_d_eq(mallctl("opt.retain", (void *)&retain, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return retain;
+}
+
+static uint64_t
+arena_stat_get(unsigned arena_ind, const char *name, size_t sz) {
+	uint64_t epoch = 1;
+	assert_d_eq(mallctl("epoch", NULL, NULL, (void *)&epoch,
+	    sizeof(epoch)), 0, "Unexpected mallctl() failure");
+
+	char cmd[128];
+	malloc_snprintf(cmd, sizeof(cmd), "stats.arenas.%u.%s", arena_ind,
+	    name);
+	if (sz == sizeof(size_t)) {
+		size_t val;
+		assert_d_eq(mallctl(cmd, (void *)&val, &sz, NULL, 0), 0,
+		    "Unexpected mallctl() failure");
+		return val;
+	}
+	uint64_t val;
+	assert_d_eq(mallctl(cmd, (void *)&val, &sz, NULL, 0), 0,
+	    "Unexpected mallctl() failure");
+	return val;
+}
+
+/* Freed pages are purged right away, and so end up retained. */
+static unsigned
+arena_create(extent_hooks_t *h) {
+	unsigned arena_ind;
+	size_t sz = sizeof(arena_ind);
+	assert_d_eq(mallctl("arenas.create", (void *)&arena_ind, &sz,
+	    (void *)(h != NULL ? &h : NULL), (h != NULL ? sizeof(h) : 0)), 0,
+	    "Unexpected mallctl() failure");
+
+	char cmd[64];
+	ssize_t decay_ms = 0;
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.dirty_decay_ms", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&decay_ms,
+	    sizeof(decay_ms)), 0, "Unexpected mallctl() failure");
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.muzzy_decay_ms", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&decay_ms,
+	    sizeof(decay_ms)), 0, "Unexpected mallctl() failure");
+	return arena_ind;
+}
+
+static void
+retained_fill(unsigned arena_ind) {
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	void *ptrs[NALLOCS];
+	for (unsigned i = 0; i < NALLOCS; i++) {
+		ptrs[i] = mallocx(ALLOC_SIZE, flags);
+		assert_ptr_not_null(ptrs[i], "Unexpected mallocx() failure");
+	}
+	for (unsigned i = 0; i < NALLOCS; i++) {
+		dallocx(ptrs[i], flags);
+	}
+	if (config_stats) {
+		assert_u64_ge(arena_stat_get(arena_ind, "retained",
+		    sizeof(size_t)), NALLOCS * ALLOC_SIZE,
+		    "Freed memory should be retained");
+	}
+}
+
+TEST_BEGIN(test_retain_trim_background) {
+	test_skip_if(!have_background_thread);
+	test_skip_if(!config_stats);
+	test_skip_if(!retain_enabled());
+
+	unsigned arena_ind = arena_create(NULL);
+	retained_fill(arena_ind);
+	size_t retained_peak = arena_stat_get(arena_ind, "retained_peak",
+	    sizeof(size_t));
+	assert_zu_ge(retained_peak, NALLOCS * ALLOC_SIZE,
+	    "Unexpected retained peak");
+
+	opt_retain_trim_threshold = ALLOC_SIZE;
+	bool enable = true;
+	assert_d_eq(mallctl("background_thread", NULL, NULL, (void *)&enable,
+	    sizeof(enable)), 0, "Unexpected mallctl() failure");
+	/* New arenas are visited on the first wakeup. */
+	nstime_t deadline, now;
+	nstime_init(&deadline, 0);
+	nstime_update(&deadline);
+	nstime_iadd(&deadline, 10 * UINT64_C(1000000000));
+	do {
+		usleep(1000);
+		nstime_init(&now, 0);
+		nstime_update(&now);
+	} while (arena_stat_get(arena_ind, "retained_ntrims",
+	    sizeof(uint64_t)) == 0 && nstime_compare(&now, &deadline) < 0);
+	enable = false;
+	assert_d_eq(mallctl("background_thread", NULL, NULL, (void *)&enable,
+	    sizeof(enable)), 0, "Unexpected mallctl() failure");
+	opt_retain_trim_threshold = 0;
+
+	assert_u64_gt(arena_stat_get(arena_ind, "retained_ntrims",
+	    sizeof(uint64_t)), 0, "Retained memory should have been trimmed");
+	assert_u64_le(arena_stat_get(arena_ind, "retained", sizeof(size_t)),
+	    ALLOC_SIZE, "Retained memory should be within the threshold");
+	assert_u64_ge(arena_stat_get(arena_ind, "retained_trimmed",
+	    sizeof(uint64_t)), retained_peak - ALLOC_SIZE,
+	    "Unexpected trimmed bytes");
+	assert_zu_eq(arena_stat_get(arena_ind, "retained_peak",
+	    sizeof(size_t)), retained_peak, "Peak should outlive trimming");
+}
+TEST_END
+
+/*
+ * Arena whose mappings fail on demand.  With no_merge, retained extents stay
+ * no larger than the mappings they came from.
+ */
+static unsigned
+arena_create_failing(bool no_merge) {
+	size_t sz = sizeof(default_hooks);
+	assert_d_eq(mallctl("arena.0.extent_hooks", (void *)&default_hooks,
+	    &sz, NULL, 0), 0, "Unexpected mallctl() failure");
+	memcpy(&hooks, default_hooks, sizeof(hooks));
+	hooks.alloc = hooks_alloc;
+	hooks.destroy = hooks_destroy;
+	hooks.merge = no_merge ? hooks_merge : default_hooks->merge;
+	return arena_create(&hooks);
+}
+
+TEST_BEGIN(test_retain_trim_alloc_failure) {
+	test_skip_if(!retain_enabled());
+
+	unsigned arena_ind = arena_create_failing(true);
+	retained_fill(arena_ind);
+	size_t retained = config_stats ? arena_stat_get(arena_ind, "retained",
+	    sizeof(size_t)) : 0;
+
+	/*
+	 * Too large to be recycled from any one retained extent, so that a new
+	 * mapping is needed.
+	 */
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	fail_alloc = true;
+	ndestroy = 0;
+	void *p = mallocx(NALLOCS / 2 * ALLOC_SIZE, flags);
+	assert_ptr_not_null(p, "Allocation should be retried after trimming");
+	assert_false(fail_alloc, "Mapping should have been attempted");
+	assert_u_gt(ndestroy, 0, "Retained extents should have been unmapped");
+	if (config_stats) {
+		assert_u64_eq(arena_stat_get(arena_ind, "retained_ntrims",
+		    sizeof(uint64_t)), 1, "Unexpected trim count");
+		assert_u64_lt(arena_stat_get(arena_ind, "retained_trimmed",
+		    sizeof(uint64_t)), retained,
+		    "Only what the retry needs should be unmapped");
+	}
+	dallocx(p, flags);
+}
+TEST_END
+
+TEST_BEGIN(test_retain_trim_alloc_failure_large) {
+	test_skip_if(!retain_enabled());
+
+	unsigned arena_ind = arena_create_failing(false);
+	retained_fill(arena_ind);
+
+	/* Unmapping everything retained would not make room for this. */
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	fail_alloc = true;
+	ndestroy = 0;
+	void *p = mallocx(NALLOCS * 4 * ALLOC_SIZE, flags);
+	assert_ptr_not_null(p, "Allocation should be retried");
+	assert_false(fail_alloc, "Mapping should have been attempted");
+	assert_u_eq(ndestroy, 0, "Retained extents should have been kept");
+	dallocx(p, flags);
+}
+TEST_END
+
+static void
+arena_dss_set(unsigned arena_ind, const char *dss) {
+	char cmd[64];
+	malloc_snprintf(cmd, sizeof(cmd), "arena.%u.dss", arena_ind);
+	assert_d_eq(mallctl(cmd, NULL, NULL, (void *)&dss, sizeof(dss)), 0,
+	    "Unexpected mallctl() failure");
+}
+
+TEST_BEGIN(test_retain_trim_dss) {
+	test_skip_if(!have_dss);
+	test_skip_if(!config_stats);
+	test_skip_if(!retain_enabled());
+
+	/* Retain dss extents first, so that they are the least recently used. */
+	unsigned arena_ind = arena_create(NULL);
+	int flags = MALLOCX_ARENA(arena_ind) | MALLOCX_TCACHE_NONE;
+	void *ptrs[NALLOCS];
+	arena_dss_set(arena_ind, "primary");
+	for (unsigned i = 0; i < NALLOCS / 2; i++) {
+		ptrs[i] = mallocx(ALLOC_SIZE, flags);
+		assert_ptr_not_null(ptrs[i], "Unexpected mallocx() failure");
+	}
+	bool in_dss = extent_in_dss(ptrs[0]);
+	arena_dss_set(arena_ind, "disabled");
+	for (unsigned i = NALLOCS / 2; i < NALLOCS; i++) {
+		ptrs[i] = mallocx(ALLOC_SIZE, flags);
+		assert_ptr_not_null(ptrs[i], "Unexpected mallocx() failure");
+	}
+	for (unsigned i = 0; i < NALLOCS; i++) {
+		dallocx(ptrs[i], flags);
+	}
+	test_skip_if(!in_dss);
+
+	tsdn_t *tsdn = tsd_tsdn(tsd_fetch());
+	arena_t *arena = arena_get(tsdn, arena_ind, false);
+	arena_retained_trim(tsdn, arena, ALLOC_SIZE);
+	assert_u64_eq(arena_stat_get(arena_ind, "retained_ntrims",
+	    sizeof(uint64_t)), 1, "The dss should not keep mmap()ed extents "
+	    "from being trimmed");
+	assert_u64_ge(arena_stat_get(arena_ind, "retained_trimmed",
+	    sizeof(uint64_t)), ALLOC_SIZE, "Unexpected trimmed bytes");
+}
+TEST_END
+
+int
+main(void) {
+	return test_no_reentrancy(
+	    test_retain_trim_background,
+	    test_retain_trim_alloc_failure,
+	    test_retain_trim_alloc_failure_large,
+	    test_retain_trim_dss);
+}
@@ -208,6 +208,127 @@ TEST_BEGIN(test_rtree_random) {
 }
 TEST_END
 
+TEST_BEGIN(test_rtree_flat) {
+	tsdn_t *tsdn = tsdn_fetch();
+
+	extent_t extent_a, extent_b;
+	extent_init(&extent_a, NULL, NULL, 0, false, NSIZES, 0,
+	    extent_state_active, false, false, true);
+	extent_init(&extent_b, NULL, NULL, 0, true, 0, 0,
+	    extent_state_active, false, false, true);
+
+	rtree_t *rtree = &test_rtree;
+	rtree_ctx_t rtree_ctx;
+	rtree_ctx_data_init(&rtree_ctx);
+	assert_false(rtree_new(rtree, false), "Unexpected rtree_new() failure");
+
+	/* Keys in a flat range, and keys on either side of it. */
+	uintptr_t base = PAGE << 10;
+	size_t size = PAGE << 8;
+	assert_false(rtree_flat_init(rtree, (void *)base, size),
+	    "Unexpected rtree_flat_init() failure");
+	uintptr_t keys[] = {base - PAGE, base, base + size / 2,
+	    base + size - PAGE, base + size};
+	for (unsigned i = 0; i < sizeof(keys)/sizeof(keys[0]); i++) {
+		bool in_flat = (keys[i] >= base && keys[i] < base + size);
+		rtree_leaf_elm_t *elm = rtree_leaf_elm_lookup(tsdn, rtree,
+		    &rtree_ctx, keys[i], false, true);
+		assert_ptr_not_null(elm, "Unexpected lookup failure");
+		assert_b_eq(elm >= rtree->flat && elm < rtree->flat + (size >>
+		    LG_PAGE), in_flat, "Only keys in range should map to the "
+		    "flat leaf; key=%#"FMTxPTR, keys[i]);
+
+		extent_t *extent = (i % 2 == 0) ? &extent_a : &extent_b;
+		assert_false(rtree_write(tsdn, rtree, &rtree_ctx, keys[i],
+		    extent, extent_szind_get_maybe_invalid(extent),
+		    extent_slab_get(extent)),
+		    "Unexpected rtree_write() failure");
+	}
+	for (unsigned i = 0; i < sizeof(keys)/sizeof(keys[0]); i++) {
+		extent_t *extent = (i % 2 == 0) ? &extent_a : &extent_b;
+		assert_ptr_eq(rtree_extent_read(tsdn, rtree, &rtree_ctx,
+		    keys[i], true), extent,
+		    "rtree_extent_read() should return previously set value");
+		rtree_clear(tsdn, rtree, &rtree_ctx, keys[i]);
+		assert_ptr_null(rtree_extent_read(tsdn, rtree, &rtree_ctx,
+		    keys[i], false), "Cleared keys should read as NULL");
+	}
+
+	rtree_delete(tsdn, rtree);
+}
+TEST_END
+
+TEST_BEGIN(test_rtree_ctx_cache) {
+	/*
+	 * Keys in distinct leaves that all map to the same set, more of them
+	 * than the set and L2 can hold.
+	 */
+#define NLEAVES	(RTREE_CTX_NWAYS + RTREE_CTX_NCACHE_L2 + 1)
+	unsigned ptrbits = ZU(1) << (LG_SIZEOF_PTR+3);
+	unsigned lg_stride = ptrbits - (rtree_levels[RTREE_HEIGHT-1].cumbits -
+	    rtree_levels[RTREE_HEIGHT-1].bits) + RTREE_CTX_LG_NCACHE;
+	test_skip_if(lg_stride >= ptrbits || NLEAVES >= (UINTPTR_MAX >>
+	    lg_stride));
+	uintptr_t stride = (uintptr_t)1 << lg_stride;
+
+	tsdn_t *tsdn = tsdn_fetch();
+
+	extent_t extent;
+	extent_init(&extent, NULL, NULL, 0, false, NSIZES, 0,
+	    extent_state_active, false, false, true);
+
+	rtree_t *rtree = &test_rtree;
+	rtree_ctx_t rtree_ctx;
+	rtree_ctx_data_init(&rtree_ctx);
+	assert_false(rtree_new(rtree, false), "Unexpected rtree_new() failure");
+
+	for (unsigned i = 0; i < NLEAVES; i++) {
+		assert_false(rtree_write(tsdn, rtree, &rtree_ctx, (i + 1) *
+		    stride, &extent, NSIZES, false),
+		    "Unexpected rtree_write() failure");
+	}
+
+	/* Cycling through as many leaves as the set has ways only hits. */
+#ifdef ANDROID_RTREE_CTX_STATS
+	uint64_t nmisses = rtree_ctx.nmisses;
+#endif
+	for (unsigned j = 0; j < 2; j++) {
+		for (unsigned i = NLEAVES - RTREE_CTX_NWAYS; i < NLEAVES; i++) {
+			assert_ptr_eq(rtree_extent_read(tsdn, rtree,
+			    &rtree_ctx, (i + 1) * stride, true), &extent,
+			    "rtree_extent_read() should return previously set "
+			    "value");
+		}
+	}
+#ifdef ANDROID_RTREE_CTX_STATS
+	assert_u64_eq(rtree_ctx.nmisses, nmisses,
+	    "Leaves fitting into a set should hit");
+#endif
+
+	/* Cycling through all of them misses. */
+#ifdef ANDROID_RTREE_CTX_STATS
+	nmisses = rtree_ctx.nmisses;
+#endif
+	for (unsigned j = 0; j < 2; j++) {
+		for (unsigned i = 0; i < NLEAVES; i++) {
+			assert_ptr_eq(rtree_extent_read(tsdn, rtree,
+			    &rtree_ctx, (i + 1) * stride, true), &extent,
+			    "rtree_extent_read() should return previously set "
+			    "value");
+		}
+	}
+#ifdef ANDROID_RTREE_CTX_STATS
+	assert_u64_ge(rtree_ctx.nmisses - nmisses, NLEAVES,
+	    "Leaves exceeding the cache should miss");
+	assert_u64_le(rtree_ctx.nhard, rtree_ctx.nmisses,
+	    "Hard lookups should be misses");
+#endif
+#undef NLEAVES
+
+	rtree_delete(tsdn, rtree);
+}
+TEST_END
+
 int
 main(void) {
 	rtree_node_alloc_orig = rtree_node_alloc;
@@ -223,5 +344,7 @@ main(void) {
 	    test_rtree_read_empty,
 	    test_rtree_extrema,
 	    test_rtree_bits,
-	    test_rtree_random);
+	    test_rtree_random,
+	    test_rtree_flat,
+	    test_rtree_ctx_cache);
 }